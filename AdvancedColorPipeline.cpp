@@ -1,666 +1,516 @@
 //
 // AdvancedColorPipeline.cpp
 //
+// The Windows advanced color path on whole surfaces.  See AdvancedColorPipeline.h.
+//
 
-#include "pch.h"
-
-/*
-
-#include "basicmath.h"
-#include "colorspaces.h"
-
-#define HALF_MAX 65504.0
-
+#include "AdvancedColorPipeline.h"
+#include "ColorSpaces.h"
+#include "SimdMath.h"
+#include "ThreadPool.h"
 
-// TODO: Use real OS enum
-//#define ADOBE_RGB
-#if 0
-typedef enum DXGI_COLOR_SPACE_TYPE {
-	DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P709 = 0,
-	DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709 = 1,
-	DXGI_COLOR_SPACE_RGB_STUDIO_G22_NONE_P709 = 2,
-	DXGI_COLOR_SPACE_RGB_STUDIO_G22_NONE_P2020 = 3,
-	DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_PADOBE = 4,		// hack TODO fix
-	DXGI_COLOR_SPACE_YCBCR_FULL_G22_NONE_P709_X601 = 5,
-	DXGI_COLOR_SPACE_YCBCR_STUDIO_G22_LEFT_P601 = 6,
-	DXGI_COLOR_SPACE_YCBCR_FULL_G22_LEFT_P601 = 7,
-	DXGI_COLOR_SPACE_YCBCR_STUDIO_G22_LEFT_P709 = 8,
-	DXGI_COLOR_SPACE_YCBCR_FULL_G22_LEFT_P709 = 9,
-	DXGI_COLOR_SPACE_YCBCR_STUDIO_G22_LEFT_P2020 = 10,
-	DXGI_COLOR_SPACE_YCBCR_FULL_G22_LEFT_P2020 = 11,
-	DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020 = 12,
-	DXGI_COLOR_SPACE_YCBCR_STUDIO_G2084_LEFT_P2020 = 13,
-	DXGI_COLOR_SPACE_RGB_STUDIO_G2084_NONE_P2020 = 14,
-	DXGI_COLOR_SPACE_YCBCR_STUDIO_G22_TOPLEFT_P2020 = 15,
-	DXGI_COLOR_SPACE_YCBCR_STUDIO_G2084_TOPLEFT_P2020 = 16,
-	DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P2020 = 17,
-	DXGI_COLOR_SPACE_CUSTOM = 0xFFFFFFFF
-} DXGI_COLOR_SPACE_TYPE;
-#endif
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
 
-typedef float3 Image;		// for bring-up
-							// can be 256x1 scanline,  or a real surface someday
+using namespace simd;
 
-typedef struct st2086_struct
+namespace
 {
-	float peakLuminance;				// in cd/m2
-	float frameAverageLuminance;		// CALL or FALL
-	float minLuminance;					// black level
-	float2 r, g, b;						// color primaries in 1931 xy coords
-} st2086;
+	// Rows padded to a whole number of vectors at the widest path.
+	const size_t RowAlign = 16;
 
-//globals:
-const static float defaultSDRBoost = 1.5;
-const static float defaultBrightnessSetting = 1.6666666;
+	void Apply(Image& image, ColorStep step)
+	{
+		ImageConverter steps;
+		steps.Then(step);
+		image.Apply(steps);
+	}
 
-// model state parameters
-st2086 ContentMetadata;					// passed using global instead of an actual argument
-static float GlobalBrightnessSetting;
-static float SDRBoost;
+	// Exposes the scene average to 18% grey, then fits the peaks into the encoding.
+	void MasterAndEncode(Image& image, float maxEncodeLuminance)
+	{
+		// comput average scene luminance
+		float avg = Image_Average(image);
 
+		// rescale image intensity to limited range
+		if (avg > 0.0f)
+			Image_Mult(image, 0.18f / avg);
 
+		// handle any peaks above the range of the encoding format
+		float maxContentLuminance = Image_Peak(image) * 80.0f;
+		Image_ToneMap(image, maxContentLuminance, maxEncodeLuminance);
+	}
+}
 
-st2086 GetDisplayCharacteristics()
-{
-	st2086 dc;
-	dc.minLuminance = 0.0f;
-	dc.minLuminance = 1200.0f;
-	dc.frameAverageLuminance = 600;
+#pragma region Image
 
-	return dc;
+Image::Image(ThreadPool* pool) :
+	m_width(0),
+	m_height(0),
+	m_stride(0),
+	m_source(),
+	m_pool(pool)
+{
 }
 
-void DWM_SetContentMetadata(st2086 in)
+Image::Image(uint32_t width, uint32_t height, ThreadPool* pool) :
+	m_width(width),
+	m_height(height),
+	m_stride((width + RowAlign - 1) / RowAlign * RowAlign),
+	m_source(),
+	m_pool(pool)
 {
-	ContentMetadata = in;
+	Allocate();
 }
 
-st2086 DWM_GetContentMetadata()
+void Image::Allocate()
 {
-	return ContentMetadata;
+	m_stride = (m_width + RowAlign - 1) / RowAlign * RowAlign;
+	m_pixels.assign(3 * m_stride * m_height, 0.0f);
 }
 
-
-float UI_SetSDRBoostSlider(uint sliderPercentage)
+PlanarBuffer Image::Planes() const
 {
-	return SDRBoost = sliderPercentage * 50.0f / 100.0f;
+	float* r = const_cast<float*>(m_pixels.data());
+	size_t plane = m_stride * m_height;
+	PlanarBuffer planes = { r, r + plane, r + 2 * plane, m_width, m_height, m_stride, nullptr };
+	return planes;
 }
 
-// accessor
-float UI_GetSDRBoostSetting()
+ThreadPool* Image::GetPool() const
 {
-	return SDRBoost;
+	return m_pool ? m_pool : &ThreadPool::Default();
 }
 
-float UI_GetGLobalBrightnessSetting()
+void Image::Load(const ImageBuffer& src)
 {
-	return GlobalBrightnessSetting;
+	m_width = src.width;
+	m_height = src.height;
+	m_stride = (m_width + RowAlign - 1) / RowAlign * RowAlign;
+	m_pixels.clear();
+	m_source = src;
+	m_pending = ImageConverter();
 }
 
-// Percentage UI slider
-float UI_GlobalBrightnessSlider(uint sliderPercentage)
+void Image::Fill(float3 color)
 {
-	//	100 % is maxFALL of this power supply in Nits
-	// ideally should be a log scale
-
-	return defaultBrightnessSetting*sliderPercentage / 100.0f;
+	if (m_source.data || m_pixels.size() != 3 * m_stride * m_height)
+		Allocate();
+	m_source.data = nullptr;
+	m_pending = ImageConverter();
+	m_pending.Then(float3x3(0, 0, 0, 0, 0, 0, 0, 0, 0), color);
 }
 
-// Nits brightness slider
-float setNitsBrightness(float nits)
+void Image::Apply(const ImageConverter& steps)
 {
-	float factor = nits / 80.0f;
-	return factor;
+	m_pending.Then(steps);
 }
 
-float Monitor_GetOSDBrightnessSlider(void)
+void Image::Resolve()
 {
-	return 1.0;		// monitors should default to OSD does no change in HDR mode
+	if (m_source.data)
+	{
+		Allocate();
+		m_pending.Convert(m_source, Planes(), GetPool());
+		m_source.data = nullptr;
+	}
+	else if (!m_pending.IsIdentity())
+	{
+		m_pending.Convert(Planes(), Planes(), GetPool());
+	}
+	m_pending = ImageConverter();
 }
 
-
-Image ClassicApp_Render()
+bool Image::Store(const ImageBuffer& dst) const
 {
-	Image image;
-	image = float3(1.0, 1.0, 1.0);
-
-	return image;
+	if (m_source.data)
+		return m_pending.Convert(m_source, dst, GetPool());
+	return m_pending.Convert(Planes(), dst, GetPool());
 }
 
-float Image_Average(Image inImage)
+PlanarBuffer Image::GetPlanes()
 {
-	return inImage.y;
+	Resolve();
+	return Planes();
 }
 
-float Image_Peak(Image inImage)
+float3 Image::GetPixel(uint32_t x, uint32_t y)
 {
-	return inImage.z;
+	PlanarBuffer planes = GetPlanes();
+	size_t i = y * planes.stride + x;
+	return float3(planes.r[i], planes.g[i], planes.b[i]);
 }
 
-Image Image_Mult(Image inImage, float factor)
+size_t Image::GetTileCount() const
 {
-	Image image;
-
-	image.x = inImage.x*factor;
-	image.y = inImage.y*factor;
-	image.z = inImage.z*factor;
-
-	return image;
+	return (size_t)((m_width + TileSize - 1) / TileSize) * ((m_height + TileSize - 1) / TileSize);
 }
 
-Image Image_Apply2084(Image inImage)
+void Image::ForEachTile(const std::function<void(size_t index, const CpuTile& tile)>& fn)
 {
-	Image image;
-
-	image.x = apply2084(inImage.x);
-	image.y = apply2084(inImage.y);
-	image.z = apply2084(inImage.z);
-
-	return image;
+	PlanarBuffer planes = GetPlanes();
+	uint32_t columns = (m_width + TileSize - 1) / TileSize;
+	GetPool()->ParallelFor(0, GetTileCount(), [&](size_t index)
+	{
+		CpuTile tile;
+		tile.x = (int)(index % columns) * TileSize;
+		tile.y = (int)(index / columns) * TileSize;
+		tile.width = std::min(TileSize, (int)m_width - tile.x);
+		tile.height = std::min(TileSize, (int)m_height - tile.y);
+		tile.stride = planes.stride;
+		size_t offset = tile.y * planes.stride + tile.x;
+		tile.r = planes.r + offset;
+		tile.g = planes.g + offset;
+		tile.b = planes.b + offset;
+		fn(index, tile);
+	});
 }
 
-Image Image_Remove2084(Image inImage)
-{
-	Image image;
+#pragma endregion
 
-	image.x = remove2084(inImage.x);
-	image.y = remove2084(inImage.y);
-	image.z = remove2084(inImage.z);
+#pragma region Image stages
 
-	return image;
+void Image_Mult(Image& image, float factor)
+{
+	ImageConverter steps;
+	steps.Scale(factor);
+	image.Apply(steps);
 }
 
-Image Image_Rec2100toRec709(Image inImage)
+void Image_Apply2084(Image& image)
 {
-	Image image;
-
-	image = Rec709ToRec2020(inImage);
-
-	return image;
+	Apply(image, ColorStep::Apply2084);
 }
 
-Image Image_Rec709toRec2100(Image inImage)
+void Image_Remove2084(Image& image)
 {
-	Image image;
-
-	image = Rec709ToRec2020(inImage);
-
-	return image;
+	Apply(image, ColorStep::Remove2084);
 }
 
-Image Image_2020toDCIP3(Image inImage)
+void Image_Rec2100toRec709(Image& image)
 {
-	Image image;
-
-	image = Rec2020toDCIP3(inImage);
-
-	return image;
-
+	Apply(image, ColorStep::Rec2020ToRec709);
 }
 
-Image Image_ToneMap( Image inImage, float inputPeakLuminance, float outputPeakLuminance )
+void Image_Rec709toRec2100(Image& image)
 {
-	return inImage;	// TODO implement this.
+	Apply(image, ColorStep::Rec709ToRec2020);
 }
 
-Image HDRMasterAndEncode(Image inImage)
+void Image_2020toDCIP3(Image& image)
 {
-	Image image;
-
-	// do exposure adjustment
-	// comput average scene luminance
-	float avg = Image_Average(inImage);
-
-	// rescale image intensity to limited range
-	image = Image_Mult( inImage, 0.18f / avg );
-
-	// handle any peaks above the range of the encoding format
-	float maxContentLuminance = Image_Peak(image);
-	float maxEncodeLuminance = 10000.0f;
-	image = Image_ToneMap( image, maxContentLuminance, maxEncodeLuminance);
-
-	return image;
+	Apply(image, ColorStep::Rec2020toDCIP3);
 }
 
-Image SDRMasterAndEncode(Image inImage)
+void Image_ToneMap(Image& image, float inputPeakLuminance, float outputPeakLuminance, ToneCurve curve)
 {
-	Image image;
-
-	// do exposure adjustment
-	// comput average scene luminance
-	float avg = Image_Average(inImage);
-
-	// rescale image intensity to limited range
-	image = Image_Mult( inImage, 0.18f / avg );
+	if (!(inputPeakLuminance > outputPeakLuminance) || outputPeakLuminance <= 0.0f)
+		return;
 
-	// handle any peaks above the range of the encoding format
-	float maxContentLuminance = Image_Peak(image);
-	float maxEncodeLuminance = 80.0f;
-	image = Image_ToneMap(image, maxContentLuminance, maxEncodeLuminance);
-
-	return image;
+	ImageConverter steps;
+	ToneMapCache::Default().Append(steps, curve, inputPeakLuminance, outputPeakLuminance);
+	image.Apply(steps);
 }
 
-Image HDRApp_Render()
+// Per-tile sums in double, added up in tile order so the result does not depend on the
+// thread count.
+float Image_Average(Image& image)
 {
-	Image image;
-
-	image = float3( HALF_MAX, HALF_MAX, HALF_MAX );	// simple test pattern
-//	image = LoadOpenEXRFile();						// get fp16/ACES content
-
-	// determine capabilities of display
-	st2086 displayCharacteristics = GetDisplayCharacteristics();
-
-
-	// define what our content range is
-	st2086 contentMetadata;
-	contentMetadata.peakLuminance = Image_Peak( image );		// this content uses entire range of float16 format
-
+	if (!image.GetWidth() || !image.GetHeight())
+		return 0.0f;
 
-	// TOSO: compensate for brightness setting
-
-
-	// decide if we need to done map:
-
-	// compare peak luminance of content and max capability of display
-	float brightnessDiff = fabs(contentMetadata.peakLuminance - displayCharacteristics.peakLuminance)/
-												displayCharacteristics.peakLuminance;
-	//	if ( PeakLuminance is different enough to matter)
-	if (brightnessDiff > 0.1f)
+	std::vector<double> sums(image.GetTileCount());
+	image.ForEachTile([&](size_t index, const CpuTile& tile)
 	{
-		// Decide whether to tone map ourselves or the hardware
-		if ( false )					// ( if we trust display to tone map!)
+		double sum = 0.0;
+		for (int y = 0; y < tile.height; y++)
 		{
-			// send metadata about content, thus notifiying implementation to handle it
-			DWM_SetContentMetadata(contentMetadata);
+			const float* r = tile.r + y * tile.stride;
+			const float* g = tile.g + y * tile.stride;
+			const float* b = tile.b + y * tile.stride;
+			vfloat row = 0.0f;
+			int x = 0;
+			for (; x + width <= tile.width; x += width)
+				row = row + load(r + x) * vfloat(0.2126f) + load(g + x) * vfloat(0.7152f) + load(b + x) * vfloat(0.0722f);
+			float lanes[width];
+			store(lanes, row);
+			for (int i = 0; i < width; i++)
+				sum += lanes[i];
+			for (; x < tile.width; x++)
+				sum += r[x] * 0.2126f + g[x] * 0.7152f + b[x] * 0.0722f;
 		}
-		else
-		{
-			// We use app code to tone map image to match display's peak luminance
-			image = Image_ToneMap(image, contentMetadata.peakLuminance, displayCharacteristics.peakLuminance);
-			// leave metadata at OS default from boot
-			//		contentMetadata = displayCharacteristics;
-			//		Panel_SetMetadata( contentMetadata );
-		}
-	}
-
-
-#ifdef GAMUT_REMAP
-	if (gamut is different enough)
-		&& (we trust display to gamut map)
-	{
-		st2086 contentMeta;
-		contentMeta = GetDisplayCharacteristics();	// default all fields to current settings
-		contentMeta.peakLumance = HALF_MAX;			// this content uses entire range of float format
-		Panel_SetMetadata(contentMeta);				// tell display panel to handle that
-	}
-	else
-	{
-		// assert default system metadata
-		// Remap to display primaries
-		image = GamutMap(image, PanelGamut);
-	}
-#endif
-
-	return image;						// Image rendered by HDR app
+		sums[index] = sum;
+	});
 
+	double total = 0.0;
+	for (double sum : sums)
+		total += sum;
+	return (float)(total / ((double)image.GetWidth() * image.GetHeight()));
 }
 
-
-Image HDR10App_Render()
+float Image_Peak(Image& image)
 {
-	Image image;
-
-	image = float3(10000.0, 10000.0, 10000.0);			// simple test pattern
-	return image;
-
-#ifdef MORESTUFF
-	// determine capabilities of display
-	GetDisplayCharacteristics();
-
-	// compensate for brightness setting
+	if (!image.GetWidth() || !image.GetHeight())
+		return 0.0f;
 
-	if (gamut is different enough)
-		&& (we trust display to gamut map)
+	std::vector<float> peaks(image.GetTileCount());
+	image.ForEachTile([&](size_t index, const CpuTile& tile)
 	{
-		// send content gamut metadata to output
-		// notifying display to handle it
-	}
-	else
-	{
-		// assert default system metadata
-		// Remap to display primaries
-		image = GamutMap(image, PanelGamut);
-	}
-
-
-	if (PeakLuminance is different enough)
-		&& (we trust display to tone map)
-	{
-		// send metadata about content
-		// notifiying implementation to handle it
-	}
-	else
-	{
-		// Tone map image to peak luminance
-		image = ToneMap(image, PanelPeakLuminance);
-	}
-#endif
-
-}
-
-//compose or flipl
-Image DWM_Present( Image inImage, DXGI_FORMAT format, bool fullscreen, DXGI_COLOR_SPACE_TYPE space, float SDRboost )
-{
-	Image image;				// input image any color space
-	Image linearImage;			// image converted to linear profile
-	Image linear709Image;		// image converted to linear and 709 gamut
-
-	switch ( space )		// depending on the color space
-	{
-	case DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709:					// CCCS
-		if (format == DXGI_FORMAT_R16G16B16A16_FLOAT)
+		vfloat peak = -INFINITY;
+		float tail = -INFINITY;
+		for (int y = 0; y < tile.height; y++)
 		{
-			image = inImage;
+			const float* r = tile.r + y * tile.stride;
+			const float* g = tile.g + y * tile.stride;
+			const float* b = tile.b + y * tile.stride;
+			int x = 0;
+			for (; x + width <= tile.width; x += width)
+				peak = max(peak, max(load(r + x), max(load(g + x), load(b + x))));
+			for (; x < tile.width; x++)
+				tail = std::max(tail, std::max(r[x], std::max(g[x], b[x])));
 		}
-		else
-		{
-			printf("Color Space %s is not supported with Format %s\n", space, format);
-			exit( 1 );
-		}
-		break;
-
-	case DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020:				// HDR10
-		if (format == DXGI_FORMAT_R10G10B10A2_UNORM)
-		{
-			// convert from HDR10 to CCCS for composition
-			// remove PQ/2082 profile curve
-			Image linearImage = Image_Remove2084(inImage);
-
-			// rotate to 709 primaries
-			Image linear709Image = Image_Rec2100toRec709(linearImage);
+		float lanes[width];
+		store(lanes, peak);
+		for (int i = 0; i < width; i++)
+			tail = std::max(tail, lanes[i]);
+		peaks[index] = tail;
+	});
 
-			// output
-			image = linear709Image;
-		}
-		else
-		{
-			printf("Color Space %s is not supported with Format %s\n", space, format);
-			exit(1);
-		}
-		break;
-
-#ifdef ADOBE_RGB
-	case DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_PADOBE:					// Adobe RGB
-		if (format == DXGI_FORMAT_R8G8B8A8_UNORM
-		 || format == DXGI_FORMAT_R10G10B10A2_UNORM)
-
-		{
-			// convert from AdobeRGB to 709 color primaries
-			Image linearAdobeImage = Image_RemoveAdobeProfile(inImage);
-
-			// convert to linear profile
-			Image linear709Image = Image_convertAdobeto709(linearAdobeImage);
+	return *std::max_element(peaks.begin(), peaks.end());
+}
 
-			image = linear709Image*UI_GetSDRBoostSetting();
-		}
-		else
-		{
-			printf("Color Space %s is not supported with Format %s\n", space, format);
-			exit(1);
-		}
-#endif
-		
-	default:														// SDR
-		if (format == DXGI_FORMAT_R8G8B8A8_UNORM			
-		 || format == DXGI_FORMAT_R10G10B10A2_UNORM)
-		{
-			image = inImage*UI_GetSDRBoostSetting();					// apply adjustment to classic content
-		}
-		else
-		{
-			printf("Color Space %s is not supported with Format %s\n", space, format);
-			exit(1);
-		}
-	}
+#pragma endregion
 
-	return image;
+#pragma region Settings
 
+st2086 GetDisplayCharacteristics()
+{
+	st2086 dc;
+	dc.minLuminance = 0.0f;
+	dc.peakLuminance = 1200.0f;
+	dc.frameAverageLuminance = 600.0f;
+	dc.r = primaryR_DCIP3;
+	dc.g = primaryG_DCIP3;
+	dc.b = primaryB_DCIP3;
+	return dc;
 }
 
-Image GPU_Display( Image inImage, bool HDR, float brightnessFactor)
+// Windows maps the SDR content brightness slider linearly onto 80 to 480 nits.
+float UI_SDRBoostSlider(uint32_t sliderPercentage)
 {
-	Image image;
+	return (80.0f + 4.0f * sliderPercentage) / 80.0f;
+}
 
-	image = Image_Mult( inImage, UI_GetGLobalBrightnessSetting() );
+// Percentage UI slider
+float UI_GlobalBrightnessSlider(uint32_t sliderPercentage)
+{
+	//	100 % is maxFALL of this power supply in Nits
+	// ideally should be a log scale
+	return defaultBrightnessSetting * sliderPercentage / 100.0f;
+}
 
-	if ( true )			// if (link is in HDR mode)
-	{
-		// Convert from 709 to 2020 primaries
-		image = Image_Rec709toRec2100(image);
+float Monitor_GetOSDBrightnessSlider()
+{
+	return 1.0f;		// monitors should default to OSD does no change in HDR mode
+}
 
-		// convert from linear to PQ profile
-		image = Image_Apply2084( image );
+#pragma endregion
 
-		// at this point, the image should be in 2084 range
-//		ASSERT(Image_Peak( image )<= 10000.0);
-	}
-	else
-		exit(1);				// this sample shows only HDR mode, not SDR mode
+#pragma region Content
 
-	return image;		// image provided in wire format (HDR10)
+void HDRMasterAndEncode(Image& image)
+{
+	MasterAndEncode(image, 10000.0f);
 }
 
-Image Scaler_Rec2020toPanelPrimaries(Image inImage)
+void SDRMasterAndEncode(Image& image)
 {
-	Image image;
-
-	// For now, assume panel has DCIP3 primaries
-	image = Image_2020toDCIP3(inImage);
+	MasterAndEncode(image, 80.0f);
+}
 
-	return image;
+void ClassicApp_Render(Image& image)
+{
+	image.Fill(float3(1.0f, 1.0f, 1.0f));
 }
 
-Image Scaler_ApplyPanelProfile(Image inImage)
+void HDRApp_Render(Image& image, const st2086& display)
 {
-	Image image;
+	image.Fill(float3(HALF_MAX, HALF_MAX, HALF_MAX));		// simple test pattern
 
-	// for now assume panel has a gamma 4.0
-	image = powf(inImage.x, 1.0 / 4.0);
+	// this content uses entire range of float16 format
+	float contentPeak = Image_Peak(image) * 80.0f;
 
-	return image;
+	// Tone map in the app when the content and display peaks differ enough to matter.
+	// An app that trusts the display would send contentPeak as metadata instead.
+	if (fabsf(contentPeak - display.peakLuminance) / display.peakLuminance > 0.1f)
+		Image_ToneMap(image, contentPeak, display.peakLuminance);
 }
 
-Image Scaler_Scale(Image inImage)
+void HDR10App_Render(Image& image)
 {
-	Image image;
+	image.Fill(float3(1.0f, 1.0f, 1.0f));				// PQ signal of 10,000 nits
+}
 
-	// Scaler knows its own characteristics:
-	st2086 displayCharacteristics = GetDisplayCharacteristics();
+#pragma endregion
 
-	// It also has metadata from input stream:
-	st2086 contentMetadata = DWM_GetContentMetadata();
+#pragma region Display path
 
-	// Apply OSD brightness factor
-	image = inImage * Monitor_GetOSDBrightnessSlider();
+bool DWM_Present(Image& image, ImageFormat format, SwapChainColorSpace colorSpace, float sdrBoost)
+{
+	ImageConverter steps;
+	if (!DWM_GetPresentSteps(format, colorSpace, sdrBoost, steps))
+		return false;
+	image.Apply(steps);
+	return true;
+}
 
-	// convert from PQ to linear
-	image = Image_Remove2084(image);
+bool DWM_GetPresentSteps(ImageFormat format, SwapChainColorSpace colorSpace, float sdrBoost, ImageConverter& result)
+{
+	bool unorm = format == ImageFormat::R8G8B8A8_UNORM || format == ImageFormat::R10G10B10A2_UNORM;
+	ImageConverter steps;
 
-	// if metadata says so, then tone map
-	image = Image_ToneMap(image, contentMetadata.peakLuminance, displayCharacteristics.peakLuminance);
+	switch (colorSpace)
+	{
+	case SwapChainColorSpace::RGB_FULL_G10_NONE_P709:				// CCCS
+		if (format != ImageFormat::R16G16B16A16_FLOAT)
+			return false;
+		break;
 
-	// convert from 2020 primaries to hardware primaries
-	image = Scaler_Rec2020toPanelPrimaries(image);
+	case SwapChainColorSpace::RGB_FULL_G2084_NONE_P2020:			// HDR10
+		if (format != ImageFormat::R10G10B10A2_UNORM)
+			return false;
+		steps.Then(ColorStep::HDR10ToLinear709);
+		break;
 
-#if 0
-	//if gamut is different, then gamut remap
-	if (contentMetadata != displayCharacteristics, )
-		then gamut map
-#endif
+	case SwapChainColorSpace::RGB_FULL_G22_NONE_PADOBE:				// Adobe RGB
+		if (!unorm)
+			return false;
+		steps.Power(563.0f / 256.0f)
+			 .Then(ColorStep::AdobeRGBtoRec2020)
+			 .Then(ColorStep::Rec2020ToRec709)
+			 .Scale(sdrBoost);
+		break;
 
-		// Apply profile curve of this hardware panel
-		image = Scaler_ApplyPanelProfile(image);
+	case SwapChainColorSpace::RGB_FULL_G22_NONE_P709:				// SDR
+		if (!unorm)
+			return false;
+		steps.Then(ColorStep::RemoveSRGBCurve).Scale(sdrBoost);		// apply adjustment to classic content
+		break;
+	}
 
-	return image;			// Image is ready for TCON and driver IC
+	result.Then(steps);
+	return true;
 }
 
-
-Image Panel_Show(Image inImage)
+void GPU_Display(Image& image, bool hdr, float brightnessFactor)
 {
-	Image image;
-
-	image = inImage;
-
-	return image;
+	image.Apply(GPU_GetDisplaySteps(hdr, brightnessFactor));
 }
 
-#if 0
-
-Whatever()
+ImageConverter GPU_GetDisplaySteps(bool hdr, float brightnessFactor)
 {
-	// Copy bits to RT
-	// if no scaling, shader-free path works fine.
-	// Sampler uses degamma mode to convert from sRGB to linear profile
-	// No change to primaries needed
-	// UNORM 1.0 = fp16 1.0
-	if (fullscreen)
-	{
-		flipSRGB(image)
-	}
+	ImageConverter steps;
+	steps.Scale(brightnessFactor);
+	if (hdr)
+		steps.Then(ColorStep::Linear709ToHDR10);		// 709 to 2020 primaries, 80 nits to PQ
 	else
-	{
-		image = ComposeSRGB(image);
-		flipCCCS(Image);
-	}
+		steps.Then(ColorStep::Saturate).Then(ColorStep::ApplySRGBCurve);
+	return steps;
 }
 
-AnotherFun()					// CCCS( image )
+bool Wire_Send(Image& image, const ImageBuffer& wire)
 {
-	// Copy bits to RT
-	// if no scaling, blt works fine.
-	// Sampler uses default/linear mode so that linear data is preserved
-	// No change to primaries needed
-	ComposeCCCS(image);
+	if (wire.format != ImageFormat::R10G10B10A2_UNORM || !image.Store(wire))
+		return false;
+	image.Load(wire);
+	return true;
 }
 
-// inside the display driver.
-Image GPU_DisplayCCCS( Image inImage )
+void Scaler_Rec2020toPanelPrimaries(Image& image)
 {
-	apply brightness scale
-	Convert to 2020/2100 primaries
-	convert to 2084/PQ profile
-	chroma-subsample if HDMI bw requires it at this resolution
-	Encode in 10bit using dithering
-	output to wire
-}
-
-Image HardwareToneMapper( Image inImage )
-{
-	check input metadata
-	check characteristics of this panel.
-	if (these are similar)
-	{
-		return identity;
-	}
-	else
-	{
-		ratio = inputPeakLuminance/PanelPeakLuminance;
-		image = ToneMapByRatio( image, ratio );
-
-	}
+	// For now, assume panel has DCIP3 primaries
+	Image_2020toDCIP3(image);
 }
-#endif
 
-// Routine that takes the image at any point and displays it on our current PC.
-void Image_DebugShow( Image inImage )
+// Drive level = (L / peak)^(1/4), for a panel with gamma 4.0.
+void Scaler_ApplyPanelProfile(Image& image, float panelPeakLuminance)
 {
-	printf( "RGB: %6.4f %6.4f %6.4f\n", inImage.r, inImage.g, inImage.b );
+	ImageConverter steps;
+	steps.Scale(80.0f / panelPeakLuminance).Then(ColorStep::Saturate).Power(1.0f / 4.0f);
+	image.Apply(steps);
 }
 
-
-// Entire display pipeline in compilable code format
-void ACPipeline()
+void Scaler_Scale(Image& image, const st2086& contentMetadata, const st2086& displayCharacteristics,
+				  ToneCurve toneCurve)
 {
-	Image image;
-	DXGI_FORMAT format;
-	DXGI_COLOR_SPACE_TYPE colorSpace;
-	st2086 displayCharacteristics;
-	st2086 contentMetadata;
-
-	// OS Boot Sequence
-	// identify characteristics of display
-	displayCharacteristics = GetDisplayCharacteristics();
+	// convert from PQ to linear CCCS, with the OSD brightness factor
+	Image_Remove2084(image);
+	Image_Mult(image, 125.0f * Monitor_GetOSDBrightnessSlider());
 
-	// on dislpay connection, we set  metadata to default to characteristics of panel
-	DWM_SetContentMetadata(displayCharacteristics);
-	// end OS boot sequence
-
-
-	// Get control inputs from OS UI
-	float SDRboost = UI_GetSDRBoostSetting();
-	float brightnessFactor = UI_GlobalBrightnessSlider(100);
+	// if metadata says so, then tone map
+	Image_ToneMap(image, contentMetadata.peakLuminance, displayCharacteristics.peakLuminance, toneCurve);
 
+	// convert from 2020 primaries to hardware primaries
+	Scaler_Rec2020toPanelPrimaries(image);
 
-	// Select an app and run it
-	switch (1)
-	{
-	case 0:
-		image = ClassicApp_Render();				// sRGB 8-bit app
-		format = DXGI_FORMAT_R8G8B8A8_UNORM;
-		colorSpace = DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P709;
-		break;
+	// Apply profile curve of this hardware panel
+	Scaler_ApplyPanelProfile(image, displayCharacteristics.peakLuminance);
+}
 
-	case 1:											// CCCS: HDR game or image viewer
-		image = HDRApp_Render();
-		format = DXGI_FORMAT_R16G16B16A16_FLOAT;
-		colorSpace = DXGI_COLOR_SPACE_RGB_FULL_G10_NONE_P709;
-		break;
+void Panel_Show(Image& image)
+{
+	(void)image;
+}
 
-	case 2:
-		image = HDR10App_Render();					// HDR10 e.g. Video Player
-		format = DXGI_FORMAT_R10G10B10A2_UNORM;
-		colorSpace = DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020;
-		break;
-#ifdef ADOBE_RGB
-	case 3:
-		image = AdobeApp_Render();					// e.g. Photoshop or Premiere
-		format = DXGI_FORMAT_R10G10B10A2_UNORM;
-		colorSpace = DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_PADOBE;
-		break;
-#endif
-	}
+void Image_DebugShow(Image& image)
+{
+	float3 center = image.GetPixel(image.GetWidth() / 2, image.GetHeight() / 2);
+	printf("%ux%u  average %6.4f  peak %6.4f  center RGB: %6.4f %6.4f %6.4f\n", image.GetWidth(), image.GetHeight(),
+		   Image_Average(image), Image_Peak(image), center.x, center.y, center.z);
+}
 
-	// DWM composes the Window to a canonical color space and format
-	bool fullscreen = false;
-	if (!fullscreen)
-		image = DWM_Present(image, format, fullscreen, colorSpace, SDRboost);	// DWM Compositor
+ACPipelineSettings DefaultACPipelineSettings()
+{
+	ACPipelineSettings settings;
+	settings.colorSpace = SwapChainColorSpace::RGB_FULL_G10_NONE_P709;
+	settings.sdrBoost = defaultSDRBoost;
+	settings.brightnessFactor = 1.0f;
+	settings.hdr = true;
+	settings.external = true;
+	settings.displayCharacteristics = GetDisplayCharacteristics();
 
-																				//	image is now in CCCS encoding:
-																				//		1.0 is 80 nits
-																				//		gamut potentially outside 709 if panel gamut > 709
-																				//		content is tone mapped
-																				//		Peak brightness can be up to 5M nits
+	// on display connection, metadata defaults to the characteristics of the panel
+	settings.contentMetadata = settings.displayCharacteristics;
+	settings.toneCurve = ToneCurve::Profile;
+	return settings;
+}
 
-																				// Display final DWM composed image using GPU display hardware:
-	bool HDR = true;   //  or SDR;
-	image = GPU_Display(image, HDR, brightnessFactor);					// GPU Display Hardware
+bool ACPipeline(const ImageBuffer& app, const ACPipelineSettings& settings, const ImageBuffer& wire,
+				Image* panel, ThreadPool* pool)
+{
+	if (wire.width != app.width || wire.height != app.height)
+		return false;
 
+	// DWM composes the window to CCCS, and the display engine encodes it for the link.
+	// Nothing runs until the wire encode, which does all of it in one pass over app.
+	Image image(pool);
+	image.Load(app);
+	if (!DWM_Present(image, app.format, settings.colorSpace, settings.sdrBoost))
+		return false;
+	GPU_Display(image, settings.hdr, settings.brightnessFactor);
+	if (!Wire_Send(image, wire))
+		return false;
 
-	if (true)				// HDMI or DisplayPort
+	if (panel)
 	{
-//		image = Wire_Send(image);			// Wire protocol
-		image = Scaler_Scale(image);		// DSP in monitor
-		image = Panel_Show(image);			// TCON and Driver IC
+		if (settings.external && settings.hdr)
+			Scaler_Scale(image, settings.contentMetadata, settings.displayCharacteristics, settings.toneCurve);	// DSP in monitor
+		Panel_Show(image);																		// TCON and driver IC
+		image.Resolve();
+		*panel = std::move(image);
 	}
-	else 				// integrated panel
-	{
-//		image = eDP(image);					// Wire Protocol
-		image = Panel_Show(image);			// TCON and driver IC
-	}
-
-	Image_DebugShow(image);
-
-	exit(0);
+	return true;
 }
-*/
\ No newline at end of file
+
+#pragma endregion
@@ -0,0 +1,193 @@
+//
+// AdvancedColorPipeline.h
+//
+// Model of the Windows advanced color path, from an app's swap chain to the panel, on
+// whole surfaces:
+//
+//   app swap chain -> DWM_Present()   composition into CCCS (linear 709, 1.0 = 80 nits)
+//                  -> GPU_Display()   display engine: brightness, BT.2020, PQ (HDR10)
+//                  -> Wire_Send()     10-bit codes on HDMI/DisplayPort
+//                  -> Scaler_Scale()  monitor DSP: PQ decode, tone map, panel primaries
+//                  -> Panel_Show()    TCON and driver IC
+//
+// Each stage works in place on an Image: planar float RGB, split into 64x64 tiles for
+// the parallel passes.  Per-pixel stages are not run when called; they are appended to
+// the image's pending ImageConverter (ImageConvert.h), which folds neighbouring matrices
+// and scales, and the chain runs as one fused pass over the tiles when the pixels are
+// next needed: by a statistic (Image_Average(), Image_Peak()), by GetPlanes(), or by
+// Store() into a swap chain or wire buffer.  Load() is lazy too, so an FP16 frame goes
+// through DWM, the display engine and the wire encode in a single pass over the source.
+//
+// ACPipeline() runs the whole path on one frame.  The wire buffer shows what reaches
+// the cable for any pattern; HeadlessRender --wire does so for every test pattern.
+//
+
+#pragma once
+
+#include <functional>
+#include <stdint.h>
+#include <vector>
+#include "BasicMath.h"
+#include "CpuCanvas.h"
+#include "ImageConvert.h"
+#include "ToneMap.h"
+
+class ThreadPool;
+
+const float HALF_MAX = 65504.0f;
+
+// The DXGI_COLOR_SPACE_TYPE values the model handles, by their DXGI names.
+enum class SwapChainColorSpace
+{
+	RGB_FULL_G22_NONE_P709,			// sRGB, SDR apps
+	RGB_FULL_G10_NONE_P709,			// scRGB, CCCS
+	RGB_FULL_G2084_NONE_P2020,		// HDR10
+	RGB_FULL_G22_NONE_PADOBE,		// Adobe RGB (1998), as an app that color manages itself
+};
+
+// SMPTE ST.2086 mastering metadata, or what a display reports of itself.
+struct st2086
+{
+	float  peakLuminance;			// in cd/m2
+	float  frameAverageLuminance;	// CALL or FALL
+	float  minLuminance;			// black level
+	float2 r, g, b;					// color primaries in 1931 xy coords
+};
+
+const float defaultSDRBoost = 1.5f;
+const float defaultBrightnessSetting = 1.6666666f;
+
+class Image
+{
+public:
+	static constexpr int TileSize = 64;
+
+	// pool == nullptr uses ThreadPool::Default() for every pass over the image.
+	Image(ThreadPool* pool = nullptr);
+	Image(uint32_t width, uint32_t height, ThreadPool* pool = nullptr);		// black
+
+	uint32_t GetWidth() const { return m_width; }
+	uint32_t GetHeight() const { return m_height; }
+
+	// Takes the size and pixels of src.  Nothing is read until the image is next
+	// resolved, so src must stay valid until then.
+	void Load(const ImageBuffer& src);
+
+	// Every pixel to color, dropping what was pending.
+	void Fill(float3 color);
+
+	// Appends per-pixel steps to the pending chain.
+	void Apply(const ImageConverter& steps);
+
+	// Runs the pending chain, if any, into the planes.
+	void Resolve();
+
+	// Writes the image, pending steps included, to dst, which must have the same size.
+	// The image itself is left as it was; with a pending Load() this is a single pass
+	// from the source into dst.
+	bool Store(const ImageBuffer& dst) const;
+
+	// The planes, resolved.  Rows are padded to a whole number of SIMD vectors.
+	PlanarBuffer GetPlanes();
+	float3 GetPixel(uint32_t x, uint32_t y);
+
+	// Calls fn for every 64x64 tile of the resolved planes, in parallel.
+	size_t GetTileCount() const;
+	void ForEachTile(const std::function<void(size_t index, const CpuTile& tile)>& fn);
+
+	ThreadPool* GetPool() const;
+
+private:
+	void Allocate();
+	PlanarBuffer Planes() const;
+
+	uint32_t           m_width;
+	uint32_t           m_height;
+	size_t             m_stride;				// floats between rows
+	std::vector<float> m_pixels;				// the r, g and b planes, one after the other
+	ImageBuffer        m_source;				// pending Load(), or data == nullptr
+	ImageConverter     m_pending;
+	ThreadPool*        m_pool;
+};
+
+// Per-pixel stages, appended to the pending chain.
+void Image_Mult(Image& image, float factor);
+void Image_Apply2084(Image& image);
+void Image_Remove2084(Image& image);
+void Image_Rec2100toRec709(Image& image);
+void Image_Rec709toRec2100(Image& image);
+void Image_2020toDCIP3(Image& image);
+
+// Maps luminance up to inputPeakLuminance into outputPeakLuminance, both in nits, on a
+// linear CCCS image, each channel through curve (ToneMap.h).  Content that already fits,
+// inputPeakLuminance <= outputPeakLuminance, passes through unchanged.
+void Image_ToneMap(Image& image, float inputPeakLuminance, float outputPeakLuminance,
+				   ToneCurve curve = ToneCurve::Profile);
+
+// Statistics of a linear image, in its own units; both resolve the image.  The average
+// is of BT.709 luminance, the peak of the largest channel (as MaxCLL).
+float Image_Average(Image& image);
+float Image_Peak(Image& image);
+
+// Settings and what the OS knows of the display.
+st2086 GetDisplayCharacteristics();
+float UI_SDRBoostSlider(uint32_t sliderPercentage);			// 0..100 -> 80..480 nits SDR white, over 80
+float UI_GlobalBrightnessSlider(uint32_t sliderPercentage);
+float Monitor_GetOSDBrightnessSlider();
+
+// Content creation.
+void HDRMasterAndEncode(Image& image);
+void SDRMasterAndEncode(Image& image);
+void ClassicApp_Render(Image& image);						// sRGB white
+void HDRApp_Render(Image& image, const st2086& display);	// scRGB at HALF_MAX, tone mapped to the display
+void HDR10App_Render(Image& image);							// PQ 10,000 nits
+
+// DWM composes a swap chain of format and colorSpace into CCCS.  False, leaving the
+// image alone, for a combination DXGI does not allow.  DWM_GetPresentSteps() appends
+// the same steps to result instead, for a compositor that runs them per surface
+// (DwmCompositor.h).
+bool DWM_Present(Image& image, ImageFormat format, SwapChainColorSpace colorSpace, float sdrBoost);
+bool DWM_GetPresentSteps(ImageFormat format, SwapChainColorSpace colorSpace, float sdrBoost, ImageConverter& result);
+
+// The display engine: brightness, then HDR10 (BT.2020 primaries, PQ) or, with hdr
+// false, sRGB clipped to [0,1].
+void GPU_Display(Image& image, bool hdr, float brightnessFactor);
+ImageConverter GPU_GetDisplaySteps(bool hdr, float brightnessFactor);
+
+// Quantizes the image to the R10G10B10A2_UNORM codes in wire, and reloads it from them,
+// as the sink receives it.
+bool Wire_Send(Image& image, const ImageBuffer& wire);
+
+// The monitor: PQ to linear, OSD brightness, tone map from the content to the display
+// peak with toneCurve, BT.2020 to the panel primaries (DCI-P3), and the panel's gamma 4 drive curve
+// against its peak.  The result is panel drive levels, 0 to 1.
+void Scaler_Rec2020toPanelPrimaries(Image& image);
+void Scaler_ApplyPanelProfile(Image& image, float panelPeakLuminance);
+void Scaler_Scale(Image& image, const st2086& contentMetadata, const st2086& displayCharacteristics,
+				  ToneCurve toneCurve = ToneCurve::Profile);
+void Panel_Show(Image& image);
+
+// Prints the average, peak and center pixel.
+void Image_DebugShow(Image& image);
+
+struct ACPipelineSettings
+{
+	SwapChainColorSpace colorSpace;					// of the app's swap chain
+	float               sdrBoost;
+	float               brightnessFactor;
+	bool                hdr;						// link mode
+	bool                external;					// HDMI/DisplayPort monitor with a scaler, else eDP
+	st2086              displayCharacteristics;
+	st2086              contentMetadata;
+	ToneCurve           toneCurve;					// of the monitor's scaler
+};
+
+// An FP16 scRGB app on an external HDR10 monitor, at the default SDR boost.
+ACPipelineSettings DefaultACPipelineSettings();
+
+// Runs the app's swap chain through the whole path: one pass from app to wire, and one
+// from wire to panel if panel is not null.  wire receives the link's R10G10B10A2_UNORM
+// codes; panel the drive levels.  False for a format and color space DWM does not take,
+// or a wire buffer of the wrong size or format.
+bool ACPipeline(const ImageBuffer& app, const ACPipelineSettings& settings, const ImageBuffer& wire,
+				Image* panel = nullptr, ThreadPool* pool = nullptr);
@@ -0,0 +1,76 @@
+//
+// BasicMath.cpp
+//
+// Span versions of mul(float3x3, float3).  See BasicMath.h.
+//
+
+#include "BasicMath.h"
+#include "SimdMath.h"
+
+using namespace simd;
+
+namespace
+{
+	// The matrix splatted across the lanes.  Rows are summed x, y, z in that order with
+	// separate multiplies and adds, as the single vector mul().
+	struct MatrixKernel
+	{
+		vfloat m[9];
+
+		explicit MatrixKernel(const float3x3& matrix)
+		{
+			const float* p = &matrix._11;
+			for (int i = 0; i < 9; i++)
+				m[i] = vfloat(p[i]);
+		}
+
+		void operator()(vfloat& x, vfloat& y, vfloat& z) const
+		{
+			vfloat r = x * m[0] + y * m[1] + z * m[2];
+			vfloat g = x * m[3] + y * m[4] + z * m[5];
+			vfloat b = x * m[6] + y * m[7] + z * m[8];
+			x = r;
+			y = g;
+			z = b;
+		}
+	};
+}
+
+void mul(const float3x3& m, const float3* in, float3* out, size_t count)
+{
+	static_assert(sizeof(float3) == 3 * sizeof(float), "float3 must be tightly packed");
+	MatrixKernel kernel(m);
+	ForEach3(&in->x, &out->x, count, kernel);
+}
+
+void mul(const float3x3& m, const float* inR, const float* inG, const float* inB,
+		 float* outR, float* outG, float* outB, size_t count)
+{
+	MatrixKernel kernel(m);
+	size_t i = 0;
+	for (; i + width <= count; i += width)
+	{
+		vfloat x = load(inR + i), y = load(inG + i), z = load(inB + i);
+		kernel(x, y, z);
+		store(outR + i, x);
+		store(outG + i, y);
+		store(outB + i, z);
+	}
+
+	if (i < count)
+	{
+		float r[width] = {}, g[width] = {}, b[width] = {};
+		size_t n = (count - i) * sizeof(float);
+		memcpy(r, inR + i, n);
+		memcpy(g, inG + i, n);
+		memcpy(b, inB + i, n);
+		vfloat x = load(r), y = load(g), z = load(b);
+		kernel(x, y, z);
+		store(r, x);
+		store(g, y);
+		store(b, z);
+		memcpy(outR + i, r, n);
+		memcpy(outG + i, g, n);
+		memcpy(outB + i, b, n);
+	}
+}
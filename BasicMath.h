@@ -13,8 +13,18 @@
 
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <stdlib.h>
+#include <iostream>
 //#include <DirectXMath.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BASICMATH_SSE
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define BASICMATH_NEON
+#include <arm_neon.h>
+#endif
+
 
 // This header defines math and matrix helper functions and structures used 
 // by DirectX SDK samples.
@@ -671,9 +681,9 @@ Matrix3x3<T> inv(Matrix3x3<T> m)
 	double det =  (double) m._11 * ((double)m._22 * (double)m._33 - (double)m._23 * (double)m._32)
 				- (double) m._12 * ((double)m._21 * (double)m._33 - (double)m._23 * (double)m._31)
 				+ (double) m._13 * ((double)m._21 * (double)m._32 - (double)m._22 * (double)m._31);
-	if (abs(det) < 1.0e-9)
+	if (fabs(det) < 1.0e-9)
 	{
-		cerr << "Error: Matrix Not Invertible" << endl;
+		std::cerr << "Error: Matrix Not Invertible" << std::endl;
 		abort();
 	}
 	Matrix3x3<T> ret;
@@ -689,6 +699,105 @@ Matrix3x3<T> inv(Matrix3x3<T> m)
 	return ret;
 }
 
+// float versions of the 3x3 products on SSE or NEON; every color space conversion in
+// ColorSpaces.h goes through them.  The structs keep their layout, since pixel buffers
+// rely on a float3 being three packed floats, so vectors are loaded and stored without
+// touching memory past z.  The products are summed in the same order as above, with
+// separate multiplies and adds, so the results are the same bits as the generic versions
+// unless the compiler contracts them into FMAs.  Whole images go through the span mul().
+#if defined(BASICMATH_SSE) || defined(BASICMATH_NEON)
+
+namespace BasicMathSimd
+{
+#if defined(BASICMATH_SSE)
+	typedef __m128 Vec;
+
+	inline Vec Load3(const float* p)			// x y z 0
+	{
+		return _mm_movelh_ps(_mm_castpd_ps(_mm_load_sd((const double*)p)), _mm_load_ss(p + 2));
+	}
+
+	inline void Store3(float* p, Vec v)
+	{
+		_mm_store_sd((double*)p, _mm_castps_pd(v));
+		_mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+	}
+
+	inline Vec Splat(float s)       { return _mm_set1_ps(s); }
+	inline Vec Add(Vec a, Vec b)    { return _mm_add_ps(a, b); }
+	inline Vec Mul(Vec a, Vec b)    { return _mm_mul_ps(a, b); }
+
+	inline void Columns(const Matrix3x3<float>& m, Vec& c1, Vec& c2, Vec& c3)
+	{
+		Vec c4 = _mm_setzero_ps();
+		c1 = Load3(&m._11);
+		c2 = Load3(&m._21);
+		c3 = Load3(&m._31);
+		_MM_TRANSPOSE4_PS(c1, c2, c3, c4);
+	}
+#else
+	typedef float32x4_t Vec;
+
+	inline Vec Load3(const float* p)			// x y z 0
+	{
+		return vcombine_f32(vld1_f32(p), vld1_lane_f32(p + 2, vdup_n_f32(0.0f), 0));
+	}
+
+	inline void Store3(float* p, Vec v)
+	{
+		vst1_f32(p, vget_low_f32(v));
+		vst1q_lane_f32(p + 2, v, 2);
+	}
+
+	inline Vec Splat(float s)       { return vdupq_n_f32(s); }
+	inline Vec Add(Vec a, Vec b)    { return vaddq_f32(a, b); }
+	inline Vec Mul(Vec a, Vec b)    { return vmulq_f32(a, b); }
+
+	inline void Columns(const Matrix3x3<float>& m, Vec& c1, Vec& c2, Vec& c3)
+	{
+		float32x2x3_t top = vld3_f32(&m._11);		// _11 _21 | _12 _22 | _13 _23
+		c1 = vcombine_f32(top.val[0], vset_lane_f32(m._31, vdup_n_f32(0.0f), 0));
+		c2 = vcombine_f32(top.val[1], vset_lane_f32(m._32, vdup_n_f32(0.0f), 0));
+		c3 = vcombine_f32(top.val[2], vset_lane_f32(m._33, vdup_n_f32(0.0f), 0));
+	}
+#endif
+}
+
+template <>
+inline Vector3<float> mul(Matrix3x3<float> m, Vector3<float> v)
+{
+	using namespace BasicMathSimd;
+	Vec c1, c2, c3;
+	Columns(m, c1, c2, c3);
+	Vector3<float> out;
+	Store3(&out.x, Add(Add(Mul(Splat(v.x), c1), Mul(Splat(v.y), c2)), Mul(Splat(v.z), c3)));
+	return out;
+}
+
+template <>
+inline Vector3<float> mul(Vector3<float> v, Matrix3x3<float> m)
+{
+	using namespace BasicMathSimd;
+	Vector3<float> out;
+	Store3(&out.x, Add(Add(Mul(Splat(v.x), Load3(&m._11)), Mul(Splat(v.y), Load3(&m._21))), Mul(Splat(v.z), Load3(&m._31))));
+	return out;
+}
+
+template <>
+inline Matrix3x3<float> mul(Matrix3x3<float> m1, Matrix3x3<float> m2)
+{
+	using namespace BasicMathSimd;
+	Vec b1 = Load3(&m2._11), b2 = Load3(&m2._21), b3 = Load3(&m2._31);
+	Matrix3x3<float> out;
+	const float* a = &m1._11;
+	float* row = &out._11;
+	for (int i = 0; i < 3; i++, a += 3, row += 3)
+		Store3(row, Add(Add(Add(Splat(0.0f), Mul(Splat(a[0]), b1)), Mul(Splat(a[1]), b2)), Mul(Splat(a[2]), b3)));
+	return out;
+}
+
+#endif
+
 
 // 4x4
 template <class T>
@@ -861,6 +970,13 @@ typedef Vector2<float> half2;
 typedef Vector3<float> half3;
 typedef Vector4<float> half4;
 
+// Span versions of mul(float3x3, float3) for whole images, interleaved and planar, in
+// BasicMath.cpp.  Several pixels at a time on the SimdMath path, summed as the single
+// vector mul().  In-place operation (in == out) is allowed.
+void mul(const float3x3& m, const float3* in, float3* out, size_t count);
+void mul(const float3x3& m, const float* inR, const float* inG, const float* inB,
+		 float* outR, float* outG, float* outB, size_t count);
+
 // TODO: add constructor for D2D_POINT_2F etc.
 
 // Standard Matrix Intializers
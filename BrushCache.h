@@ -0,0 +1,112 @@
+//
+// BrushCache.h
+//
+// Device brushes for the colors and gradients the patterns draw with, created once and
+// reused across frames instead of once per draw call.  Solid brushes are keyed by color,
+// gradients by stop set and back buffer precision.  Each kind is kept in an LruCache of
+// bounded size, so a long session of calibration key presses, each of which brings new
+// colors, does not grow it without limit.
+//
+// The policy is a template over the device so it does not depend on D2D.  Device
+// supplies
+//
+//   typedef ... SolidBrush;
+//   typedef ... GradientBrush;
+//   SolidBrush    CreateSolidBrush(const ColorF& color);
+//   GradientBrush CreateGradientBrush(const GradientStop* stops, size_t count,
+//                                     uint32_t precision);
+//
+// D2DCanvas plugs in its device context; BrushCacheTest.cpp exercises the same code on
+// any platform with a mock device that counts the calls.  The owner calls Clear()
+// whenever the device or the back buffer format changes, since every brush belongs to
+// one device.
+//
+
+#pragma once
+
+#include <array>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "LruCache.h"
+#include "PatternCanvas.h"
+
+struct BrushCacheStats
+{
+	uint64_t solidCreated;
+	uint64_t solidReused;
+	uint64_t gradientCreated;
+	uint64_t gradientReused;
+	uint64_t evicted;			// dropped to stay within capacity
+	uint64_t cleared;			// dropped by Clear()
+};
+
+template <typename Device>
+class BrushCache
+{
+public:
+	typedef typename Device::SolidBrush    SolidBrush;
+	typedef typename Device::GradientBrush GradientBrush;
+
+	explicit BrushCache(Device device, size_t solidCapacity = 256, size_t gradientCapacity = 16)
+		: m_device(device), m_solid(solidCapacity), m_gradient(gradientCapacity), m_stats()
+	{
+	}
+
+	// The returned brush stays valid until the next Get call or Clear().
+	const SolidBrush& GetSolidBrush(const ColorF& color)
+	{
+		SolidKey key;
+		memcpy(key.data(), &color, sizeof(key));
+
+		if (SolidBrush* brush = m_solid.Find(key))
+		{
+			m_stats.solidReused++;
+			return *brush;
+		}
+
+		m_stats.solidCreated++;
+		return m_solid.Insert(key, m_device.CreateSolidBrush(color), &m_stats.evicted);
+	}
+
+	const GradientBrush& GetGradientBrush(const GradientStop* stops, size_t count, uint32_t precision)
+	{
+		// Built in a member so a lookup does not allocate once the cache is warm.
+		m_gradientKey.resize(count * sizeof(GradientStop) / sizeof(uint32_t) + 1);
+		memcpy(m_gradientKey.data(), stops, count * sizeof(GradientStop));
+		m_gradientKey.back() = precision;
+
+		if (GradientBrush* brush = m_gradient.Find(m_gradientKey))
+		{
+			m_stats.gradientReused++;
+			return *brush;
+		}
+
+		m_stats.gradientCreated++;
+		return m_gradient.Insert(m_gradientKey, m_device.CreateGradientBrush(stops, count, precision),
+								 &m_stats.evicted);
+	}
+
+	void Clear()
+	{
+		m_stats.cleared += m_solid.Size() + m_gradient.Size();
+		m_solid.Clear();
+		m_gradient.Clear();
+	}
+
+	size_t Size() const { return m_solid.Size() + m_gradient.Size(); }
+	const BrushCacheStats& GetStats() const { return m_stats; }
+
+private:
+	static_assert(sizeof(ColorF) == 4 * sizeof(uint32_t), "ColorF is keyed by its bits");
+	static_assert(sizeof(GradientStop) % sizeof(uint32_t) == 0, "GradientStop is keyed by its bits");
+
+	typedef std::array<uint32_t, 4> SolidKey;
+	typedef std::vector<uint32_t>   GradientKey;
+
+	Device                               m_device;
+	LruCache<SolidKey, SolidBrush>       m_solid;
+	LruCache<GradientKey, GradientBrush> m_gradient;
+	GradientKey                          m_gradientKey;
+	BrushCacheStats                      m_stats;
+};
@@ -0,0 +1,138 @@
+//
+// BrushCacheTest.cpp
+//
+// Checks the BrushCache policy against a mock device that counts the brushes it is asked
+// to create: a frame drawn again creates nothing, gradients are told apart by precision,
+// the LRU evicts the least recently used brush at capacity, and Clear() drops
+// everything.  Prints one line per check and exits with 1 if any fails, so it can run
+// after every change to BrushCache.h on any platform.  Not part of the app project;
+// build it directly, e.g.
+//
+//   g++ -std=c++17 -O2 BrushCacheTest.cpp -o brushcachetest
+//   cl /std:c++17 /O2 /EHsc BrushCacheTest.cpp /Fe:brushcachetest.exe
+//
+
+#include "BrushCache.h"
+
+#include <stdio.h>
+
+namespace
+{
+	// Brushes are serial numbers; the counts are shared with the test, as the cache keeps
+	// its own copy of the device.
+	struct CountingDevice
+	{
+		typedef int SolidBrush;
+		typedef int GradientBrush;
+
+		SolidBrush CreateSolidBrush(const ColorF&)
+		{
+			return ++*solidCreated;
+		}
+
+		GradientBrush CreateGradientBrush(const GradientStop*, size_t, uint32_t)
+		{
+			return ++*gradientCreated;
+		}
+
+		int* solidCreated;
+		int* gradientCreated;
+	};
+
+	struct Counts
+	{
+		int solid = 0;
+		int gradient = 0;
+
+		CountingDevice Device() { return CountingDevice{ &solid, &gradient }; }
+	};
+
+	int failures = 0;
+
+	void Check(const char* what, bool passed)
+	{
+		printf("%-60s %s\n", what, passed ? "pass" : "FAIL");
+		if (!passed)
+			failures++;
+	}
+
+	const GradientStop Stops[] =
+	{
+		{ 0.0f, ColorF(0.0f, 0.0f, 0.0f) },
+		{ 1.0f, ColorF(1.0f, 1.0f, 1.0f) },
+	};
+
+	// What a pattern draws in a frame: a few solid colors and a gradient.
+	void DrawFrame(BrushCache<CountingDevice>& cache)
+	{
+		for (int i = 0; i < 8; i++)
+			cache.GetSolidBrush(ColorF(i / 8.0f, 0.5f, 0.25f));
+		cache.GetGradientBrush(Stops, 2, 0);
+	}
+
+	void CheckRepeatedFrames()
+	{
+		Counts counts;
+		BrushCache<CountingDevice> cache(counts.Device());
+		for (int frame = 0; frame < 10; frame++)
+			DrawFrame(cache);
+
+		const BrushCacheStats& stats = cache.GetStats();
+		Check("repeated frames create each brush once", counts.solid == 8 && counts.gradient == 1);
+		Check("repeated frames reuse the rest", stats.solidReused == 72 && stats.gradientReused == 9);
+		Check("a cached brush is returned as created",
+			  cache.GetSolidBrush(ColorF(0.0f, 0.5f, 0.25f)) == 1 && cache.GetGradientBrush(Stops, 2, 0) == 1);
+	}
+
+	void CheckGradientKey()
+	{
+		Counts counts;
+		BrushCache<CountingDevice> cache(counts.Device());
+		cache.GetGradientBrush(Stops, 2, 0);
+		cache.GetGradientBrush(Stops, 2, 1);
+		cache.GetGradientBrush(Stops, 1, 0);
+		Check("gradients differ by precision and stop count", counts.gradient == 3);
+		cache.GetGradientBrush(Stops, 2, 1);
+		Check("a gradient is found again by stops and precision", counts.gradient == 3);
+	}
+
+	void CheckEviction()
+	{
+		Counts counts;
+		BrushCache<CountingDevice> cache(counts.Device(), 3, 2);
+		ColorF a(1.0f, 0.0f, 0.0f), b(0.0f, 1.0f, 0.0f), c(0.0f, 0.0f, 1.0f), d(1.0f, 1.0f, 0.0f);
+		cache.GetSolidBrush(a);
+		cache.GetSolidBrush(b);
+		cache.GetSolidBrush(c);
+		cache.GetSolidBrush(a);				// a is now the most recent, b the least
+		cache.GetSolidBrush(d);
+		Check("capacity bounds the cache", cache.Size() == 3 && cache.GetStats().evicted == 1);
+
+		int created = counts.solid;
+		cache.GetSolidBrush(a);
+		cache.GetSolidBrush(c);
+		Check("recently used brushes survive eviction", counts.solid == created);
+		cache.GetSolidBrush(b);
+		Check("the least recently used brush is evicted", counts.solid == created + 1);
+	}
+
+	void CheckClear()
+	{
+		Counts counts;
+		BrushCache<CountingDevice> cache(counts.Device());
+		DrawFrame(cache);
+		cache.Clear();
+		Check("Clear() drops every brush", cache.Size() == 0 && cache.GetStats().cleared == 9);
+		DrawFrame(cache);
+		Check("brushes are created again after Clear()", counts.solid == 16 && counts.gradient == 2);
+	}
+}
+
+int main()
+{
+	CheckRepeatedFrames();
+	CheckGradientKey();
+	CheckEviction();
+	CheckClear();
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,92 @@
+//
+// CodeValues.h
+//
+// Integer code values at a fixed bit depth, in place of the literal 1023.f and 255.f
+// scattered through the tests:
+//
+//   PqCode<10>, PqCode<12>       SMPTE ST.2084, linear 1.0 = 10,000 nits
+//   SrgbCode<8>, SrgbCode<10>    sRGB, linear 1.0 = 80 nits (SDR reference white)
+//
+// Whole codes decode through tables.  The signal table is built at compile time and is
+// exactly code / Max, since float division is correctly rounded; the linear tables are
+// the double precision ones from TransferTables.h, so Linear() and Nits() of a whole code
+// are correctly rounded too, where Remove2084(code / 1023.f) is a few ulp off.  Encoding
+// clamps to the code range and rounds to nearest, halves away from zero, as roundf().
+//
+// The calibration tests step levels that start between codes, so the float overloads
+// take fractional codes and fall back to the scalar curves in ColorSpaces.h.
+//
+
+#pragma once
+
+#include <array>
+#include <stdint.h>
+#include "ColorSpaces.h"
+#include "TransferTables.h"
+
+// The curve and decode table per bit depth.  Only the depths listed have tables.
+template <int Bits> struct PqCurve;
+template <int Bits> struct SrgbCurve;
+
+struct PqCurveBase
+{
+	static constexpr float NitsScale = 10000.0f;
+	static float Encode(float linear) { return Apply2084(linear); }
+	static float Decode(float signal) { return Remove2084(signal); }
+};
+
+struct SrgbCurveBase
+{
+	static constexpr float NitsScale = 80.0f;
+	static float Encode(float linear) { return ApplySRGBCurve(linear); }
+	static float Decode(float signal) { return RemoveSRGBCurve(signal); }
+};
+
+template <> struct PqCurve<10>   : PqCurveBase   { static float DecodeCode(uint32_t code) { return Remove2084_10bit(code); } };
+template <> struct PqCurve<12>   : PqCurveBase   { static float DecodeCode(uint32_t code) { return Remove2084_12bit(code); } };
+template <> struct SrgbCurve<8>  : SrgbCurveBase { static float DecodeCode(uint32_t code) { return RemoveSRGBCurve_8bit(code); } };
+template <> struct SrgbCurve<10> : SrgbCurveBase { static float DecodeCode(uint32_t code) { return RemoveSRGBCurve_10bit(code); } };
+
+template <template <int> class Curve, int Bits>
+class CodeValue
+{
+public:
+	static constexpr uint32_t Max   = (1u << Bits) - 1;
+	static constexpr float    Scale = (float)Max;
+
+	// Code to signal, 0..1.
+	static float Signal(uint32_t code) { return s_signals[code < Max ? code : Max]; }
+	static float Signal(float code) { return code / Scale; }
+
+	// Code to linear light, and to nits.
+	static float Linear(uint32_t code) { return Curve<Bits>::DecodeCode(code); }
+	static float Linear(float code) { return Curve<Bits>::Decode(Signal(code)); }
+	static float Nits(uint32_t code) { return Linear(code) * Curve<Bits>::NitsScale; }
+	static float Nits(float code) { return Linear(code) * Curve<Bits>::NitsScale; }
+
+	// Signal to a fractional code, for labels, and to the nearest whole code.
+	static float Code(float signal) { return signal * Scale; }
+	static uint32_t Round(float signal)
+	{
+		signal = signal > 0.0f ? (signal < 1.0f ? signal : 1.0f) : 0.0f;
+		return (uint32_t)roundf(signal * Scale);
+	}
+
+	// Linear light or nits to the nearest whole code.
+	static uint32_t FromLinear(float linear) { return Round(Curve<Bits>::Encode(linear)); }
+	static uint32_t FromNits(float nits) { return FromLinear(nits / Curve<Bits>::NitsScale); }
+
+private:
+	static constexpr std::array<float, Max + 1> MakeSignals()
+	{
+		std::array<float, Max + 1> table = {};
+		for (uint32_t code = 0; code <= Max; code++)
+			table[code] = (float)code / Scale;
+		return table;
+	}
+
+	static constexpr std::array<float, Max + 1> s_signals = MakeSignals();
+};
+
+template <int Bits> using PqCode   = CodeValue<PqCurve, Bits>;
+template <int Bits> using SrgbCode = CodeValue<SrgbCurve, Bits>;
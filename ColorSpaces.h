@@ -9,10 +9,12 @@
 // 
 //*********************************************************
 
-#include "pch.h"
+#pragma once
+
+#include <algorithm>
 #include <iostream>
 #include <math.h>
-#include "basicmath.h"
+#include "BasicMath.h"
 
 using namespace std;
 
@@ -122,20 +124,23 @@ static const float3x3 matYCbCrtoRGB = float3x3(
 );
 
 // TODO: stealing namespace is bad
-const float gamutVolumeLuv709   = 1487896;
-const float gamutVolumeLuvAdobe = 1978981;
-const float gamutVolumeLuvDCIP3 = 1959840;
-const float gamutVolumeLuv2020  = 2665875;
-const float gamutVooumeAcesCG   = 2090408;
-const float gamutVolumeLuvHuman = 3000000;		// estimate
-const float gamutVolumeLuvACES  = 4200943;
-
-const float gamutVolumeLab709   = 820285;
-const float gamutVolumeLabAdobe = 1195981;
-const float gamutVolumeLabDCIP3 = 1230953;
-const float gamutVolumeLab2020  = 1854871;
-const float gamutVolumeAcesCG   = 2775907;
-const float gamutVolimeLabHuman = 2381085;		// per Bruce Lindbloom
+// gamutVolumeLuv() and gamutVolumeLab() of each gamut with white (0.3127, 0.3290).  The
+// Luv numbers no longer count the L = 0 plane (401 x 401 = 160800 points) that the old
+// sampling loop did; the human estimates predate the solver.
+const float gamutVolumeLuv709    = 1327096;
+const float gamutVolumeLuvAdobe  = 1818181;
+const float gamutVolumeLuvDCIP3  = 1799040;
+const float gamutVolumeLuv2020   = 2505075;
+const float gamutVolumeLuvAcesCG = 2615107;
+const float gamutVolumeLuvHuman  = 3000000;		// estimate
+const float gamutVolumeLuvACES   = 4040143;
+
+const float gamutVolumeLab709    = 820285;
+const float gamutVolumeLabAdobe  = 1195952;
+const float gamutVolumeLabDCIP3  = 1230952;
+const float gamutVolumeLab2020   = 1854870;
+const float gamutVolumeLabAcesCG = 2090407;
+const float gamutVolumeLabHuman  = 2381085;		// per Bruce Lindbloom
 const float gamutVolumeLabACES  = 4306401;
 
 // Gamma ramps and encoding transfer functions
@@ -155,12 +160,12 @@ const float gamutVolumeLabACES  = 4306401;
 // are--the sRGB curve needs to be removed before involving the colors in linear mathematics such
 // as physically based lighting.
 
-float ApplySRGBCurve(float x)
+inline float ApplySRGBCurve(float x)
 {
 	// Approximately pow(x, 1.0 / 2.2)
 	return x < 0.0031308f ? 12.92f * x : 1.055f * pow(x, 1.0f / 2.4f) - 0.055f;
 }
-float3 ApplySRGBCurve(float3 c)				// vector version
+inline float3 ApplySRGBCurve(float3 c)				// vector version
 {
 	c.r = ApplySRGBCurve(c.r);
 	c.g = ApplySRGBCurve(c.g);
@@ -169,12 +174,12 @@ float3 ApplySRGBCurve(float3 c)				// vector version
 	return c;
 }
 
-float RemoveSRGBCurve(float x)
+inline float RemoveSRGBCurve(float x)
 {
 	// Approximately pow(x, 2.2)
 	return x < 0.04045f ? x / 12.92f : pow((x + 0.055f) / 1.055f, 2.4f);
 }
-float3 RemoveSRGBCurve(float3 c)			// vector version
+inline float3 RemoveSRGBCurve(float3 c)			// vector version
 {
 	c.r = RemoveSRGBCurve(c.r);
 	c.g = RemoveSRGBCurve(c.g);
@@ -184,12 +189,12 @@ float3 RemoveSRGBCurve(float3 c)			// vector version
 }
 
 // These functions avoid pow() to efficiently approximate sRGB with an error < 0.4%.
-float ApplySRGBCurve_Fast(float x)
+inline float ApplySRGBCurve_Fast(float x)
 {
 	return x < 0.0031308f ? 12.92f * x : 1.13005f * sqrt(x - 0.00228f) - 0.13448f * x + 0.005719f;
 }
 
-float RemoveSRGBCurve_Fast(float x)
+inline float RemoveSRGBCurve_Fast(float x)
 {
 	return x < 0.04045f ? x / 12.92f : -7.43605f * x - 31.24297f * sqrt(-0.53792f * x + 1.279924f) + 35.34864f;
 }
@@ -197,18 +202,18 @@ float RemoveSRGBCurve_Fast(float x)
 // The OETF recommended for content shown on HDTVs.  This "gamma ramp" may increase contrast as
 // appropriate for viewing in a dark environment.  Always use this curve with Limited RGB as it is
 // used in conjunction with HDTVs.
-float ApplyRec709Curve(float x)
+inline float ApplyRec709Curve(float x)
 {
 	return x < 0.0181f ? 4.5f * x : 1.0993f * pow(x, 0.45f) - 0.0993f;
 }
 
-float RemoveRec709Curve(float x)
+inline float RemoveRec709Curve(float x)
 {
 	return x < 0.08145f ? x / 4.5f : pow((x + 0.0993f) / 1.0993f, 1.0f / 0.45f);
 }
 
 #if 0
-float RemoveSRGB(float c)
+inline float RemoveSRGB(float c)
 {
 	//	c = saturate(c);				// should guarantee unorm range
 	if (c <= 0.04045)
@@ -224,7 +229,7 @@ float RemoveSRGB(float c)
 
 #if 1
 // SMPTE ST 2084 profile (PQ:Preceptual Quantizer):
-float Apply2084(float L)
+inline float Apply2084(float L)
 {
 	float m1 = 2610.0 / 4096.0 / 4;
 	float m2 = 2523.0 / 4096.0 * 128;
@@ -235,7 +240,7 @@ float Apply2084(float L)
 	return powf((c1 + c2 * Lp) / (1 + c3 * Lp), m2);
 }
 
-float Remove2084(float N)
+inline float Remove2084(float N)
 {
 	float m1 = 2610.0 / 4096.0 / 4;
 	float m2 = 2523.0 / 4096.0 * 128;
@@ -249,7 +254,7 @@ float Remove2084(float N)
 }
 
 #else
-float Apply2084(float value)
+inline float Apply2084(float value)
 {
 	// value = saturate(value);       // guarantee unorm range
 	const float c1 = 0.8359375;
@@ -260,7 +265,7 @@ float Apply2084(float value)
 	return powf(num / den, 78.84375);
 };
 
-float Remove2084(float value)
+inline float Remove2084(float value)
 {
 	//	value = saturate(value);       // guarantee unorm range
 	const float c1 = 0.8359375;
@@ -273,7 +278,7 @@ float Remove2084(float value)
 };
 #endif
 
-float3 Apply2084(float3 c)
+inline float3 Apply2084(float3 c)
 {
 	c = saturate(c);
 	return float3( Apply2084(c.x),
@@ -281,14 +286,44 @@ float3 Apply2084(float3 c)
 				   Apply2084(c.z) );
 }
 
-float3 Remove2084(float3 c)
+inline float3 Remove2084(float3 c)
 {
 	return float3( Remove2084(c.x),
 				   Remove2084(c.y),
 				   Remove2084(c.z) );
 }
 
-float3 Rec709ToRec2020(float3 color)		// assuming D65 white
+// The shoulder()/profile() tone curve of ToneSpikeEffect.hlsl.
+// Rational shoulder through (0,0) and (1,1) with slope p at the origin.
+inline float ToneMapShoulder(float p, float x)
+{
+	float k = 1.0f / (p - 1.0f);
+	return x * (k + 1.0f) / (k + x);		// like fewerda
+}
+
+// p = contentMax/panelCapability, input normalized to panel capability.  Identity up to
+// a knee s, shoulder from there to (p, 1), clipped above p.  p < 1 expands instead (ITM).
+inline float ToneMapProfile(float p, float input)
+{
+	if (input > p)
+		return 1.0f;					// hard clip
+
+	// get shift s from excel curve fit
+	float s = 1.0f - logf(p)*0.165f;
+
+	// for inverse tone mapping use different shift
+	if (p < 1.0f)
+		s = p*0.7f;
+
+	// compute tone curve linear slope
+	float m = 1.0f / (p - s);
+
+	if (input <= s)
+		return input;					// do nothing
+	return ToneMapShoulder((p - s) / (1.f - s), m * (input - s)) * (1.f - s) + s;
+}
+
+inline float3 Rec709ToRec2020(float3 color)		// assuming D65 white
 {
 	static const float3x3 conversion =
 	{
@@ -299,7 +334,7 @@ float3 Rec709ToRec2020(float3 color)		// assuming D65 white
 	return mul(conversion, color);
 }
 
-float3 Rec2020ToRec709(float3 color)		// assuming D65 white
+inline float3 Rec2020ToRec709(float3 color)		// assuming D65 white
 {
 	static const float3x3 conversion =
 	{
@@ -310,7 +345,7 @@ float3 Rec2020ToRec709(float3 color)		// assuming D65 white
 	return mul(conversion, color);
 }
 
-float3 RecDCIP3toRec2020(float3 color)		// assuming D65 white
+inline float3 RecDCIP3toRec2020(float3 color)		// assuming D65 white
 {
 	static const float3x3 conversion =
 	{
@@ -321,7 +356,7 @@ float3 RecDCIP3toRec2020(float3 color)		// assuming D65 white
 	return mul(conversion, color);
 }
 
-float3 Rec2020toDCIP3(float3 color)			// assuming D65 white
+inline float3 Rec2020toDCIP3(float3 color)			// assuming D65 white
 {
 	static const float3x3 conversion =
 	{
@@ -332,7 +367,7 @@ float3 Rec2020toDCIP3(float3 color)			// assuming D65 white
 	return mul(conversion, color);
 }
 
-float3 AdobeRGBtoRec2020(float3 color)		// assuming D65 white
+inline float3 AdobeRGBtoRec2020(float3 color)		// assuming D65 white
 {
 	static const float3x3 conversion =
 	{
@@ -343,7 +378,7 @@ float3 AdobeRGBtoRec2020(float3 color)		// assuming D65 white
 	return mul(conversion, color);
 }
 
-float3 Rec2020toAdobeRGB(float3 color)		// assuming D65 white
+inline float3 Rec2020toAdobeRGB(float3 color)		// assuming D65 white
 {
 	static const float3x3 conversion =
 	{
@@ -354,7 +389,7 @@ float3 Rec2020toAdobeRGB(float3 color)		// assuming D65 white
 	return mul(conversion, color);
 }
 
-float3 Rec709toDCIP3(float3 RGB709)
+inline float3 Rec709toDCIP3(float3 RGB709)
 {
 	static const float3x3 ConvMat =
 	{
@@ -365,7 +400,7 @@ float3 Rec709toDCIP3(float3 RGB709)
 	return mul(ConvMat, RGB709);
 }
 
-float3 DCIP3toRec709(float3 RGB709)
+inline float3 DCIP3toRec709(float3 RGB709)
 {
 	static const float3x3 ConvMat =
 	{
@@ -377,7 +412,7 @@ float3 DCIP3toRec709(float3 RGB709)
 }
 
 // called to convert from CCCS to HDMI-friendly format e.g. on present/scan-out
-float3 Linear709ToHDR10(float3 c)
+inline float3 Linear709ToHDR10(float3 c)
 {
 	// Rotate from 709 to 2020 primaries
 	c = mul(mat709to2020, c);
@@ -396,7 +431,7 @@ float3 Linear709ToHDR10(float3 c)
 };
 
 // called to convert HDR10 content into CCCS for composition
-float3 HDR10ToLinear709(float3 c)
+inline float3 HDR10ToLinear709(float3 c)
 {
 	// Remove 2084 profile resulting in photon linear
 	c = saturate(c);
@@ -413,7 +448,7 @@ float3 HDR10ToLinear709(float3 c)
 	return c;
 };
 
-float3 RGBToYCoCg( float3 RGB )
+inline float3 RGBToYCoCg( float3 RGB )
 {
 	float Y  = dot(RGB, float3( 1, 2,  1)) * 0.25f;
 	float Co = dot(RGB, float3( 2, 0, -2)) * 0.25f + (0.5f * 256.0f / 255.0f);
@@ -421,7 +456,7 @@ float3 RGBToYCoCg( float3 RGB )
 	return float3(Y, Co, Cg);
 }
 
-float3 YCoCgToRGB(float3 YCoCg)
+inline float3 YCoCgToRGB(float3 YCoCg)
 {
 	float Y  = YCoCg.x;
 	float Co = YCoCg.y - (0.5f * 256.0f / 255.0f);
@@ -432,7 +467,7 @@ float3 YCoCgToRGB(float3 YCoCg)
 	return float3(R, G, B);
 }
 
-float3 RGBtoYCbCr( float3 rgb)
+inline float3 RGBtoYCbCr( float3 rgb)
 {
 	float Y  = 0.299f * rgb.x + .587f * rgb.y + .114f * rgb.z; // Luminance
 	float Cb = -.169f * rgb.x - .331f * rgb.y + .500f * rgb.z; // Chrominance Blue
@@ -440,7 +475,7 @@ float3 RGBtoYCbCr( float3 rgb)
 	return float3(Y, Cb + 128.f/255.f, Cr + 128.f/255.f);
 }
 
-float3 YCbCrtoRGB(float3 ycc)
+inline float3 YCbCrtoRGB(float3 ycc)
 {
 	float3 c = ycc - float3(0., 128.f / 255.f, 128.f / 255.f);
 
@@ -450,7 +485,7 @@ float3 YCbCrtoRGB(float3 ycc)
 	return float3(R, G, B);
 }
 
-float2 uvtoxy(float2 uv)
+inline float2 uvtoxy(float2 uv)
 {
 	float2 xy;
 
@@ -461,7 +496,7 @@ float2 uvtoxy(float2 uv)
 	return xy;
 }
 
-float2 xytouv(float2 xy)
+inline float2 xytouv(float2 xy)
 {
 	float2 uv;
 	
@@ -474,7 +509,7 @@ float2 xytouv(float2 xy)
 
 // Convert from 1931 CIE Yxy Chromaticities to XYZ color space (Y = 1.0)
 #if 1
-float3 xytoXYZ(float2 xy, float Y)
+inline float3 xytoXYZ(float2 xy, float Y)
 {
 	float3 XYZ = float3(0, Y, 0);	// default to black
 
@@ -487,7 +522,7 @@ float3 xytoXYZ(float2 xy, float Y)
 	return XYZ;
 }
 #else
-float3 xytoXYZ(float2 xy, float w = 1.f)
+inline float3 xytoXYZ(float2 xy, float w = 1.f)
 {
 	return float3(xy.x, xy.y, 1.0f - xy.x - xy.y);
 }
@@ -495,7 +530,7 @@ float3 xytoXYZ(float2 xy, float w = 1.f)
 
 // Convert from 1931 CIE Yxy Chromaticities to linear 709 color space (Y = 1.0)
 // to use with CCCS
-float3 xytosRGB(float2 xy)
+inline float3 xytosRGB(float2 xy)
 {
 	float3 XYZ = xytoXYZ( xy, 1.0f );
 	float3 rgb709 = XYZ * XYZ_to_709RGB; 		// matrix times vector
@@ -505,14 +540,14 @@ float3 xytosRGB(float2 xy)
 	return rgb709 / Y;
 }
 
-float nitstoCCCS(float c)
+inline float nitstoCCCS(float c)
 {
 	return c / 80.0f;
 }
 
 
 // Convert a color in CIE-xyY space to CIE-XYZ space.
-float3 xyYtoXYZ(const float3& xyY)
+inline float3 xyYtoXYZ(const float3& xyY)
 {
     float3 ret;
     ret.x = xyY.z * xyY.x / xyY.y;
@@ -522,7 +557,7 @@ float3 xyYtoXYZ(const float3& xyY)
 }
 
 // Helper for Lab conversions.
-float f(float t)
+inline float f(float t)
 {
     const float delta = 6.0f / 29.0f;
     if (t > pow(delta, 3.0f)) return pow(t, 1.0f / 3.0f);
@@ -530,7 +565,7 @@ float f(float t)
 }
 
 // Helper for Lab conversions.
-float f_inv(float t)
+inline float f_inv(float t)
 {
     const float delta = 6.0f / 29.0f;
     if (t > delta) return pow(t, 3.0f);
@@ -538,7 +573,7 @@ float f_inv(float t)
 }
 
 // Convert a color in CIE-XYZ space to CIE-Lab space.
-float3 XYZ_to_Lab(const float3& color_XYZ, const float3& white_XYZ)
+inline float3 XYZ_to_Lab(const float3& color_XYZ, const float3& white_XYZ)
 {
     float3 ret;
     ret.x = 116.0f * f(color_XYZ.y / white_XYZ.y) - 16.0f;
@@ -548,7 +583,7 @@ float3 XYZ_to_Lab(const float3& color_XYZ, const float3& white_XYZ)
 }
 
 // Convert a color in CIE-Lab space to CIE-XYZ space.
-float3 Lab_to_XYZ(const float3& color_Lab, const float3& white_XYZ)
+inline float3 Lab_to_XYZ(const float3& color_Lab, const float3& white_XYZ)
 {
     float3 ret;
     ret.x = white_XYZ.x * f_inv((color_Lab.x + 16.0f) / 116.0f + color_Lab.y / 500.0f);
@@ -558,7 +593,7 @@ float3 Lab_to_XYZ(const float3& color_Lab, const float3& white_XYZ)
 }
 
 // Convert a color in CIE-XYZ space to CIE-Luv space.
-float3 XYZ_to_Luv(const float3& color_XYZ, const float3& white_XYZ)
+inline float3 XYZ_to_Luv(const float3& color_XYZ, const float3& white_XYZ)
 {
     float3 ret;
     const float delta = 6.0f / 29.0f;
@@ -575,7 +610,7 @@ float3 XYZ_to_Luv(const float3& color_XYZ, const float3& white_XYZ)
 }
 
 // Convert a color in CIE-Luv space to CIE-XYZ space.
-float3 Luv_to_XYZ(const float3& color_Luv, const float3& white_XYZ)
+inline float3 Luv_to_XYZ(const float3& color_Luv, const float3& white_XYZ)
 {
     float3 ret;
     const float delta = 6.0f / 29.0f;
@@ -590,7 +625,7 @@ float3 Luv_to_XYZ(const float3& color_Luv, const float3& white_XYZ)
     return ret;
 }
 // Construct a CIE-XYZ -> linear-RGB transformation matrix.
-float3x3 Make_XYZ_to_RGB_Matrix(const float2& R, const float2& G, const float2& B, const float2& W_xy, const float &Y)
+inline float3x3 Make_XYZ_to_RGB_Matrix(const float2& R, const float2& G, const float2& B, const float2& W_xy, const float &Y)
 {
 	float3x3 mat;
 	mat._11 = R.x / R.y;
@@ -617,123 +652,12 @@ float3x3 Make_XYZ_to_RGB_Matrix(const float2& R, const float2& G, const float2&
 }
 
 // Construct a linear-RGB -> CIE-XYZ transformation matrix.
-float3x3 Make_RGB_to_XYZ_Matrix(const float2& R, const float2& G, const float2& B, const float2& W_xy, const float&Y )
+inline float3x3 Make_RGB_to_XYZ_Matrix(const float2& R, const float2& G, const float2& B, const float2& W_xy, const float&Y )
 {
     float3x3 mat = Make_XYZ_to_RGB_Matrix(R, G, B, W_xy, Y);
     return inv(mat);
 }
 
-void PrintUsage()
-{
-    cout << "Usage: " << "gamut.exe" << " r_x r_y g_x g_y b_x b_y [w_x] [w_y]" << endl;
-    cout << "  r_[x,y]: chromaticity of red primary" << endl;
-    cout << "  g_[x,y]: chromaticity of green primary" << endl;
-    cout << "  b_[x,y]: chromaticity of blue primary" << endl;
-    cout << "  w_[x,y]: chromaticity of white point (default: D65 <0.3127, 0.3290>)" << endl;
-}
-
-
-float gamutVolumeLab( const float2& red_xy, const float2 green_xy, const float2& blue_xy, const float2& white_xy )
-{
-	const float Y = 100.0;
-	float3 white_XYZ = xytoXYZ(white_xy, Y );
-	float3x3 RGBXYZ = Make_RGB_to_XYZ_Matrix(red_xy, green_xy, blue_xy, white_xy, Y);
-	float3x3 XYZRGB = Make_XYZ_to_RGB_Matrix(red_xy, green_xy, blue_xy, white_xy, Y);
-
-	unsigned long long hits = 0;
-	for (int L = 0; L <= 100; L++)
-	{
-		for (int a = -200; a <= 200; a++)
-		{
-			for (int b = -200; b <= 200; b++)
-			{
-				float Ld = (float)L;
-				float ad = (float)a;
-				float bd = (float)b;
-				float3 testColor_Lab{ Ld, ad, bd };
-				float3 testColor_XYZ = Lab_to_XYZ(testColor_Lab, white_XYZ);
-				float3 testColor_RGB = mul(XYZRGB, testColor_XYZ);
-				if (testColor_RGB.x < 0.0f || testColor_RGB.x > 1.0f) continue;
-				if (testColor_RGB.y < 0.0f || testColor_RGB.y > 1.0f) continue;
-				if (testColor_RGB.z < 0.0f || testColor_RGB.z > 1.0f) continue;
-				hits++;
-			}
-		}
-	}
-	return (float) hits;		// return volume
-}
-
-float gamutVolumeLuv(const float2& red_xy, const float2 green_xy, const float2& blue_xy, const float2& white_xy)
-{
-	const float Y = 100.0;
-	float3 white_XYZ = xytoXYZ(white_xy, Y) ;
-	float3x3 RGBXYZ = Make_RGB_to_XYZ_Matrix(red_xy, green_xy, blue_xy, white_xy, Y );
-	float3x3 XYZRGB = Make_XYZ_to_RGB_Matrix(red_xy, green_xy, blue_xy, white_xy, Y );
-
-	unsigned long long hits = 0;
-	for (int L = 0; L <= 100; L++)
-	{
-		for (int u = -200; u <= 200; u++)
-		{
-			for (int v = -200; v <= 200; v++)
-			{
-				float Ld = (float)L;
-				float ud = (float)u;
-				float vd = (float)v;
-				float3 testColor_Luv{ Ld, ud, vd };
-				float3 testColor_XYZ = Luv_to_XYZ(testColor_Luv, white_XYZ);
-				float3 testColor_RGB = mul(XYZRGB, testColor_XYZ);
-				if (testColor_RGB.x < 0.0f || testColor_RGB.x > 1.0f) continue;
-				if (testColor_RGB.y < 0.0f || testColor_RGB.y > 1.0f) continue;
-				if (testColor_RGB.z < 0.0f || testColor_RGB.z > 1.0f) continue;
-				hits++;
-			}
-		}
-	}
-	return (float) hits;		// return volume
-}
-
-#if 0
-int main(int argc, char* argv[])
-{
-    float2 red_xy, green_xy, blue_xy, white_xy;
-    if (argc == 7 || argc == 9)
-    {
-        red_xy.x = atof(argv[1]);
-        red_xy.y = atof(argv[2]);
-        green_xy.x = atof(argv[3]);
-        green_xy.y = atof(argv[4]);
-        blue_xy.x = atof(argv[5]);
-        blue_xy.y = atof(argv[6]);
-        if (argc == 9)
-        {
-            white_xy.x = atof(argv[7]);
-            white_xy.y = atof(argv[8]);
-        }
-        else
-        {
-            // cout << "Warning: using D65 white point <0.3127, 0.3290>" << endl;
-            white_xy.x = 0.3127;
-            white_xy.y = 0.3290;
-        }
-    }
-    else
-    {
-        PrintUsage();
-        exit(-1);
-    }
-
-	unsigned long long volumeLuv = gamutVolumeLuv(red_xy, green_xy, blue_xy, white_xy);
-	unsigned long long volumeLab = gamutVolumeLab(red_xy, green_xy, blue_xy, white_xy);
-
-    cout << "Lab Volume: " << volumeLab << endl;
-    cout << "Luv Volume: " << volumeLuv << endl;
-
-    return 0;
-}
-#endif
-
-
 struct Triangle
 {
 	float2 a;
@@ -747,15 +671,20 @@ struct Polygon6
 	int numPoints;
 };
 
+// Signed distance (scaled by |ab|) of point p from the line ab; >= 0 is the "left" side.
+inline float ClipDistance(float2 a, float2 b, float2 p)
+{
+	return (b.y - a.y) * p.x - (b.x - a.x) * p.y + b.x * a.y - b.y * a.x;
+}
+
 // Check whether point p is on the "left" side of the line ab extended to infinity.
-bool ClipCheck(float2 a, float2 b, float2 p)
+inline bool ClipCheck(float2 a, float2 b, float2 p)
 {
-	float val = (b.y - a.y) * p.x - (b.x - a.x) * p.y + b.x * a.y - b.y * a.x;
-	return val >= 0;
+	return ClipDistance(a, b, p) >= 0;
 }
 
 // Return intersection point of lines ab and cd.
-float2 Intersect(float2 a, float2 b, float2 c, float2 d)
+inline float2 Intersect(float2 a, float2 b, float2 c, float2 d)
 {
 	float2 r{};
 	r.x = ((a.x*b.y - a.y*b.x)*(c.x - d.x) - (a.x - b.x)*(c.x*d.y - c.y*d.x)) / ((a.x - b.x) * (c.y - d.y) - (a.y - b.y) * (c.x - d.x));
@@ -765,7 +694,7 @@ float2 Intersect(float2 a, float2 b, float2 c, float2 d)
 
 // Intersects two clockwise triangles to generate a clockwise Polygon with up to six sides.
 // Uses Sutherland-Hodgman algorithm with p as subject and q as clip.
-Polygon6 Intersect(const Triangle& p, const Triangle& q)
+inline Polygon6 Intersect(const Triangle& p, const Triangle& q)
 {
 	Polygon6 r = {};
 	r.points[0] = p.a;
@@ -779,36 +708,37 @@ Polygon6 Intersect(const Triangle& p, const Triangle& q)
 		Polygon6 t = r;
 		r.numPoints = 0;
 		float2 s = t.points[t.numPoints - 1];
+		float ds = ClipDistance(clipA, clipB, s);
 		for (int j = 0; j < t.numPoints; j++)
 		{
+			// Crossings are placed along se by the ratio of the distances rather than by
+			// intersecting the two lines, which is 0/0 when an edge lies on the clip line
+			// (e.g. a panel with exactly the sRGB primaries measured against sRGB).
 			float2 e = t.points[j];
-			if (ClipCheck(clipA, clipB, e))
+			float de = ClipDistance(clipA, clipB, e);
+			if (de >= 0)
 			{
-				if (!ClipCheck(clipA, clipB, s))
+				if (ds < 0)
 				{
-					r.points[r.numPoints++] = Intersect(s, e, clipA, clipB);
+					r.points[r.numPoints++] = s + (e - s) * (ds / (ds - de));
 				}
 				r.points[r.numPoints++] = e;
 			}
-			else if (ClipCheck(clipA, clipB, s))
+			else if (ds >= 0)
 			{
-				r.points[r.numPoints++] = Intersect(s, e, clipA, clipB);
+				r.points[r.numPoints++] = s + (e - s) * (ds / (ds - de));
 			}
 			s = e;
+			ds = de;
 		}
 	}
 
-	float2 c = r.points[0];
-	std::sort(&r.points[0], &r.points[r.numPoints], [c](const float2& a, const float2& b) {
-		float det = (a.x - c.x) * (b.y - c.y) - (b.x - c.x) * (a.y - c.y);
-		return det < 0;
-	});
-
+	// The clip emits vertices in boundary order already, so no sort is needed.
 	return r;
 }
 
 // Calculate the area of a convex clockwise polygon.
-float Area(const Polygon6& p)
+inline float Area(const Polygon6& p)
 {
 	float sum = 0;
 	int numTris = p.numPoints - 2;
@@ -826,13 +756,13 @@ float Area(const Polygon6& p)
 #if 0
 typedef float2[3] triangle2D;
 
-float areaOfTriangle2D(triangle2D tri)
+inline float areaOfTriangle2D(triangle2D tri)
 {
 	return cross(tri[1] - tri[0], tri[2] - tri[0])*0.5f;
 }
 
 
-float2 baryTriangle2D(triangle2D tri, float3 pt)
+inline float2 baryTriangle2D(triangle2D tri, float3 pt)
 {
 	// Compute vectors        
 	float2 v0 = tri[2] - tri[0];
@@ -855,13 +785,13 @@ float2 baryTriangle2D(triangle2D tri, float3 pt)
 }
 
 
-bool pointInTriangle2D(triangle2D tri, float3 pt)
+inline bool pointInTriangle2D(triangle2D tri, float3 pt)
 {
 	float2 bary = baryTriangle2D(tri, pt);
 	return (bary.x >= 0) && (bary.y >= 0) && (bary.x + bary.y < 1.0f);
 }
 
-float sdfTriangle2D(triangle2D tri)
+inline float sdfTriangle2D(triangle2D tri)
 {
 
 
@@ -871,7 +801,7 @@ float sdfTriangle2D(triangle2D tri)
 
 // Computes area of gamut triangle inputs are in xy,
 // but math and output are in uv 
-float ComputeGamutArea(float2 r, float2 g, float2 b)
+inline float ComputeGamutArea(float2 r, float2 g, float2 b)
 {
 	// Convert from 1931 xy to 1976 uv coordinates:
 	float2 red_uv, grn_uv, blu_uv;
@@ -887,7 +817,7 @@ float ComputeGamutArea(float2 r, float2 g, float2 b)
 
 // compute proportion of triangle2 that is covered by triangle 1
 // inputs are xy chromatiticies, but math and output are in uv 
-float ComputeGamutCoverage(float2 r1, float2 g1, float2 b1, float2 r2, float2 g2, float2 b2)
+inline float ComputeGamutCoverage(float2 r1, float2 g1, float2 b1, float2 r2, float2 g2, float2 b2)
 {
 	Triangle tri1, tri2;
 
@@ -906,27 +836,3 @@ float ComputeGamutCoverage(float2 r1, float2 g1, float2 b1, float2 r2, float2 g2
 
 	return area / ComputeGamutArea(r2, g2, b2);	// return as fraction of tri2
 }
-
-// Shape of human visual gamut in xy 1931 chromaticities
-#if 0
-const vec2 aa = vec2(0.174112257, 0.004963727); // 380.0
-const vec2 ab = vec2(0.150985408, 0.022740193); // 455.0
-const vec2 ac = vec2(0.135502671, 0.039879121); // 465.0
-const vec2 ad = vec2(0.124118477, 0.057802513); // 470.0
-const vec2 ae = vec2(0.109594324, 0.086842511); // 475.0
-const vec2 af = vec2(0.091293516, 0.132702055); // 480.0
-const vec2 ag = vec2(0.068705910, 0.200723220); // 485.0
-const vec2 ah = vec2(0.045390735, 0.294975965); // 490.0
-const vec2 ai = vec2(0.023459943, 0.412703479); // 495.0
-const vec2 aj = vec2(0.008168028, 0.538423071); // 500.0
-const vec2 ak = vec2(0.003858521, 0.654823151); // 505.0
-const vec2 al = vec2(0.013870246, 0.750186428); // 510.0
-const vec2 am = vec2(0.038851802, 0.812016021); // 515.0
-const vec2 an = vec2(0.074302424, 0.833803082); // 520.0
-const vec2 ao = vec2(0.114160721, 0.826206968); // 525.0
-const vec2 ap = vec2(0.154722061, 0.805863545); // 530.0
-const vec2 aq = vec2(0.192876183, 0.781629131); // 535.0
-const vec2 ar = vec2(0.229619673, 0.754329090); // 540.0
-const vec2 as = vec2(0.265775085, 0.724323925); // 545.0
-const vec2 at = vec2(0.736842105, 0.263157895); // 780.0
-#endif
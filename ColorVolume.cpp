@@ -0,0 +1,482 @@
+//
+// ColorVolume.cpp
+//
+// ICtCp grid sweep for color volume coverage.  See ColorVolume.h.
+//
+
+#include "ColorVolume.h"
+#include "SimdMath.h"
+#include "ThreadPool.h"
+
+#include <math.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+	// BT.2124: delta-E ITP = 720 * |(dI, dT, dP)|, so 1 JND is 1/720 in I, T and P.
+	const double JND = 1.0 / 720.0;
+
+	// Rows of the I, T sweep handed to a task together.
+	const int RowsPerTile = 16;
+
+	// Points along a row classified together before falling back to point by point.
+	// A multiple of every SIMD width.
+	const int ChunkPoints = 32;
+
+	// Decode table: PQ signal to linear over [0, DecodeRange], linearly interpolated.
+	// Signals past the end are outside every volume (they decode above 10,000 nits
+	// in LMS, which no RGB cube within the PQ range reaches).
+	const int    DecodeSegments = 1 << 14;
+	const double DecodeRange    = 1.25;
+
+	const int MaxVolumes = 8;		// display plus references tested per sweep
+
+	// ST.2084 in double, as Apply2084()/Remove2084() in ColorSpaces.h.
+	const double m1 = 2610.0 / 4096.0 / 4.0;
+	const double m2 = 2523.0 / 4096.0 * 128.0;
+	const double c1 = 3424.0 / 4096.0;
+	const double c2 = 2413.0 / 4096.0 * 32.0;
+	const double c3 = 2392.0 / 4096.0 * 32.0;
+
+	double PQEncode(double L)
+	{
+		double Lp = pow(L > 0.0 ? L : 0.0, m1);
+		return pow((c1 + c2 * Lp) / (1.0 + c3 * Lp), m2);
+	}
+
+	double PQDecode(double N)
+	{
+		double Np = pow(N, 1.0 / m2);
+		double num = Np - c1 > 0.0 ? Np - c1 : 0.0;
+		return pow(num / (c2 - c3 * Np), 1.0 / m1);
+	}
+
+	struct Mat3
+	{
+		double m[3][3];
+
+		void Apply(const double in[3], double out[3]) const
+		{
+			for (int i = 0; i < 3; i++)
+				out[i] = m[i][0] * in[0] + m[i][1] * in[1] + m[i][2] * in[2];
+		}
+	};
+
+	Mat3 Mul(const Mat3& a, const Mat3& b)
+	{
+		Mat3 r;
+		for (int i = 0; i < 3; i++)
+			for (int j = 0; j < 3; j++)
+				r.m[i][j] = a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j] + a.m[i][2] * b.m[2][j];
+		return r;
+	}
+
+	Mat3 Inverse(const Mat3& a)
+	{
+		const double (*m)[3] = a.m;
+		double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+				   - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+				   + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+		Mat3 r;
+		r.m[0][0] = (m[1][1] * m[2][2] - m[1][2] * m[2][1]) / det;
+		r.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) / det;
+		r.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) / det;
+		r.m[1][0] = (m[1][2] * m[2][0] - m[1][0] * m[2][2]) / det;
+		r.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) / det;
+		r.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) / det;
+		r.m[2][0] = (m[1][0] * m[2][1] - m[1][1] * m[2][0]) / det;
+		r.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) / det;
+		r.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) / det;
+		return r;
+	}
+
+	// RGB to XYZ for the given primaries, with white at Y = 1.
+	Mat3 RGBtoXYZ(const float2& r, const float2& g, const float2& b, const float2& w)
+	{
+		const float2* p[3] = { &r, &g, &b };
+		Mat3 P;
+		for (int j = 0; j < 3; j++)
+		{
+			P.m[0][j] = p[j]->x / p[j]->y;
+			P.m[1][j] = 1.0;
+			P.m[2][j] = (1.0 - p[j]->x - p[j]->y) / p[j]->y;
+		}
+		double W[3] = { w.x / w.y, 1.0, (1.0 - w.x - w.y) / w.y };
+		double S[3];
+		Inverse(P).Apply(W, S);
+		for (int i = 0; i < 3; i++)
+			for (int j = 0; j < 3; j++)
+				P.m[i][j] *= S[j];
+		return P;
+	}
+
+	// BT.2100 ICtCp: BT.2020 RGB -> LMS, then PQ, then L'M'S' -> ICtCp.
+	const Mat3 RGB2020toLMS = { {
+		{ 1688.0 / 4096.0, 2146.0 / 4096.0,  262.0 / 4096.0 },
+		{  683.0 / 4096.0, 2951.0 / 4096.0,  462.0 / 4096.0 },
+		{   99.0 / 4096.0,  309.0 / 4096.0, 3688.0 / 4096.0 },
+	} };
+
+	const Mat3 LMStoICtCp = { {
+		{  2048.0 / 4096.0,   2048.0 / 4096.0,     0.0 / 4096.0 },
+		{  6610.0 / 4096.0, -13613.0 / 4096.0,  7003.0 / 4096.0 },
+		{ 17933.0 / 4096.0, -17390.0 / 4096.0,  -543.0 / 4096.0 },
+	} };
+
+	Mat3 XYZtoLMS()
+	{
+		Mat3 toXYZ = RGBtoXYZ(float2(0.708f, 0.292f), float2(0.170f, 0.797f), float2(0.131f, 0.046f),
+							  float2(0.3127f, 0.3290f));
+		return Mul(RGB2020toLMS, Inverse(toXYZ));
+	}
+
+	// One volume in the form the sweep tests: rgb = A * LMS + offset, inside if all of
+	// rgb is in [0, 1].  LMS is linear with 1.0 = 10,000 nits.
+	struct VolumeTest
+	{
+		Mat3   A;
+		double offset;
+	};
+
+	VolumeTest MakeVolumeTest(const ColorVolume& v)
+	{
+		double lo = v.minNits / 10000.0;
+		double range = (v.maxNits - v.minNits) / 10000.0;
+		Mat3 toXYZ = RGBtoXYZ(v.red, v.green, v.blue, v.white);
+		VolumeTest t;
+		t.A = Mul(Inverse(toXYZ), Inverse(XYZtoLMS()));
+		for (int i = 0; i < 3; i++)
+			for (int j = 0; j < 3; j++)
+				t.A.m[i][j] /= range;
+
+		// Black is lo at the white chromaticity, i.e. rgb = lo/range on every channel.
+		t.offset = -lo / range;
+		return t;
+	}
+
+	// Forward map of one RGB cube point to (I, T, P).
+	void ToITP(const ColorVolume& v, const Mat3& toLMS, const double rgb[3], double itp[3])
+	{
+		double lo = v.minNits / 10000.0;
+		double range = (v.maxNits - v.minNits) / 10000.0;
+		double drive[3], lms[3];
+		for (int i = 0; i < 3; i++)
+			drive[i] = lo + range * rgb[i];
+		toLMS.Apply(drive, lms);
+		for (int i = 0; i < 3; i++)
+			lms[i] = PQEncode(lms[i]);
+		LMStoICtCp.Apply(lms, itp);
+		itp[1] *= 0.5;
+	}
+
+	// Bounding box of a volume in (I, T, P).  The volume is the image of the RGB cube, so
+	// its extent is the extent of the image of the cube's faces, sampled densely here.
+	void ExtendBounds(const ColorVolume& v, double lo[3], double hi[3])
+	{
+		const int n = 64;
+		Mat3 cubeToLMS = Mul(XYZtoLMS(), RGBtoXYZ(v.red, v.green, v.blue, v.white));
+		for (int face = 0; face < 6; face++)
+		{
+			int axis = face / 2;
+			for (int a = 0; a <= n; a++)
+			{
+				for (int b = 0; b <= n; b++)
+				{
+					double rgb[3];
+					rgb[axis] = face & 1;
+					rgb[(axis + 1) % 3] = (double)a / n;
+					rgb[(axis + 2) % 3] = (double)b / n;
+					double itp[3];
+					ToITP(v, cubeToLMS, rgb, itp);
+					for (int i = 0; i < 3; i++)
+					{
+						lo[i] = itp[i] < lo[i] ? itp[i] : lo[i];
+						hi[i] = itp[i] > hi[i] ? itp[i] : hi[i];
+					}
+				}
+			}
+		}
+	}
+
+	struct DecodeTable
+	{
+		std::vector<float> value;		// DecodeSegments + 2 entries, the last a copy for the lerp
+		float scale;					// segments per unit signal
+
+		DecodeTable() : value(DecodeSegments + 2), scale((float)(DecodeSegments / DecodeRange))
+		{
+			for (int i = 0; i <= DecodeSegments; i++)
+				value[i] = (float)PQDecode(i * DecodeRange / DecodeSegments);
+			value[DecodeSegments + 1] = value[DecodeSegments];
+		}
+	};
+
+	const DecodeTable& Decode()
+	{
+		static const DecodeTable table;
+		return table;
+	}
+
+	using namespace simd;
+
+	struct Sweep
+	{
+		int         volumes;			// display first, then the references
+		VolumeTest  tests[MaxVolumes];
+		Mat3        toLMSp;				// (I, Ct, Cp) -> L'M'S'
+		double      step;				// grid step in I, T and P
+		int         iBegin, iEnd;		// grid index ranges, end exclusive
+		int         tBegin, tEnd;
+		int         pBegin, pEnd;
+	};
+
+	// Per-tile counts: [0, volumes) inside each volume, [volumes, 2 * volumes) inside both
+	// that volume and the display.
+	typedef uint64_t TileCounts[2 * MaxVolumes];
+
+	inline vfloat DecodeLane(const DecodeTable& table, vfloat signal, vmask& valid)
+	{
+		vfloat x = abs(signal) * vfloat(table.scale);
+		valid = valid & (x <= vfloat((float)DecodeSegments));
+		x = min(x, vfloat((float)DecodeSegments));
+		vint idx = toint(x);
+		vfloat frac = x - tofloat(idx);
+		vfloat a = gather(table.value.data(), idx);
+		vfloat b = gather(table.value.data() + 1, idx);
+		vfloat linear = mad(b - a, frac, a);
+		return select(signal < vfloat(0.0f), -linear, linear);
+	}
+
+	// Scalar version of DecodeLane() for the chunk bounds; same table, so it brackets the
+	// per-point values.  Returns false past the end of the table.
+	inline bool DecodeBound(const DecodeTable& table, float signal, float& linear)
+	{
+		float x = fabsf(signal) * table.scale;
+		if (x > (float)DecodeSegments)
+			return false;
+		int idx = (int)x;
+		float frac = x - (float)idx;
+		float a = table.value[idx], b = table.value[idx + 1];
+		linear = a + (b - a) * frac;
+		linear = signal < 0.0f ? -linear : linear;
+		return true;
+	}
+
+	enum class ChunkState { Outside, Inside, Mixed };
+
+	// Interval test of an LMS box against one volume.  The per-point path and this one
+	// round differently, so only clear-cut results count; the rest go point by point.
+	inline ChunkState Classify(const VolumeTest& t, const float lo[3], const float hi[3])
+	{
+		const double margin = 1e-5;
+		bool inside = true;
+		for (int ch = 0; ch < 3; ch++)
+		{
+			double rmin = t.offset, rmax = t.offset;
+			for (int c = 0; c < 3; c++)
+			{
+				double a = t.A.m[ch][c];
+				rmin += a * (a > 0.0 ? lo[c] : hi[c]);
+				rmax += a * (a > 0.0 ? hi[c] : lo[c]);
+			}
+			if (rmax < -margin || rmin > 1.0 + margin)
+				return ChunkState::Outside;
+			if (rmin < margin || rmax > 1.0 - margin)
+				inside = false;
+		}
+		return inside ? ChunkState::Inside : ChunkState::Mixed;
+	}
+
+	void SweepRow(const Sweep& s, const DecodeTable& table, int iI, int iT, TileCounts& counts)
+	{
+		// Along a row only P changes, and L'M'S' is linear in (I, Ct, Cp).
+		double I = iI * s.step, Ct = 2.0 * iT * s.step;
+		float baseS[3], slopeS[3];
+		vfloat base[3], slope[3];
+		for (int c = 0; c < 3; c++)
+		{
+			baseS[c] = (float)(s.toLMSp.m[c][0] * I + s.toLMSp.m[c][1] * Ct);
+			slopeS[c] = (float)(s.toLMSp.m[c][2] * s.step);
+			base[c] = vfloat(baseS[c]);
+			slope[c] = vfloat(slopeS[c]);
+		}
+
+		vfloat A[MaxVolumes][9], offset[MaxVolumes];
+		for (int v = 0; v < s.volumes; v++)
+		{
+			for (int k = 0; k < 9; k++)
+				A[v][k] = vfloat((float)s.tests[v].A.m[k / 3][k % 3]);
+			offset[v] = vfloat((float)s.tests[v].offset);
+		}
+
+		// Per-lane counts stay far below 2^24, so float accumulation is exact.
+		vfloat inside[MaxVolumes], shared[MaxVolumes];
+		for (int v = 0; v < s.volumes; v++)
+			inside[v] = shared[v] = vfloat(0.0f);
+
+		const vfloat zero(0.0f), one(1.0f);
+		vfloat last((float)(s.pEnd - 1));
+		for (int chunk = s.pBegin; chunk < s.pEnd; chunk += ChunkPoints)
+		{
+			int chunkEnd = chunk + ChunkPoints < s.pEnd ? chunk + ChunkPoints : s.pEnd;
+
+			// L'M'S' is monotonic along the row and the decode per channel, so the LMS of
+			// the chunk lies in the box spanned by its end points.  Most chunks are then
+			// wholly inside or outside every volume and are counted without visiting points.
+			float lo[3], hi[3];
+			bool bounded = true;
+			for (int c = 0; c < 3 && bounded; c++)
+			{
+				float e0 = 0.0f, e1 = 0.0f;
+				bounded = DecodeBound(table, (float)chunk * slopeS[c] + baseS[c], e0) &&
+						  DecodeBound(table, (float)(chunkEnd - 1) * slopeS[c] + baseS[c], e1);
+				lo[c] = e0 < e1 ? e0 : e1;
+				hi[c] = e0 < e1 ? e1 : e0;
+			}
+			if (bounded)
+			{
+				ChunkState state[MaxVolumes];
+				bool mixed = false;
+				for (int v = 0; v < s.volumes && !mixed; v++)
+				{
+					state[v] = Classify(s.tests[v], lo, hi);
+					mixed = state[v] == ChunkState::Mixed;
+				}
+				if (!mixed)
+				{
+					uint64_t n = chunkEnd - chunk;
+					for (int v = 0; v < s.volumes; v++)
+					{
+						if (state[v] == ChunkState::Inside)
+						{
+							counts[v] += n;
+							if (state[0] == ChunkState::Inside)
+								counts[s.volumes + v] += n;
+						}
+					}
+					continue;
+				}
+			}
+
+			for (int p = chunk; p < chunkEnd; p += width)
+			{
+				vfloat iP = vfloat((float)p) + ramp();
+				vmask valid = iP <= last;
+				vfloat lms[3];
+				for (int c = 0; c < 3; c++)
+					lms[c] = DecodeLane(table, mad(iP, slope[c], base[c]), valid);
+
+				vmask inDisplay = valid;
+				for (int v = 0; v < s.volumes; v++)
+				{
+					vmask in = valid;
+					for (int ch = 0; ch < 3; ch++)
+					{
+						vfloat rgb = mad(A[v][3 * ch], lms[0], mad(A[v][3 * ch + 1], lms[1], mad(A[v][3 * ch + 2], lms[2], offset[v])));
+						in = in & (rgb >= zero) & (rgb <= one);
+					}
+					if (v == 0)
+						inDisplay = in;
+					inside[v] = inside[v] + select(in, one, zero);
+					shared[v] = shared[v] + select(in & inDisplay, one, zero);
+				}
+			}
+		}
+
+		for (int v = 0; v < s.volumes; v++)
+		{
+			float lanes[width];
+			store(lanes, inside[v]);
+			for (int l = 0; l < width; l++)
+				counts[v] += (uint64_t)lanes[l];
+			store(lanes, shared[v]);
+			for (int l = 0; l < width; l++)
+				counts[s.volumes + v] += (uint64_t)lanes[l];
+		}
+	}
+
+	int FloorIndex(double x, double step) { return (int)floor(x / step); }
+	int CeilIndex(double x, double step)  { return (int)ceil(x / step); }
+}
+
+void ComputeColorVolumeCoverage(const ColorVolume& display, const ColorVolume* references, size_t count,
+								ColorVolumeCoverage* results, float step, ThreadPool* pool)
+{
+	if (!pool)
+		pool = &ThreadPool::Default();
+
+	// References are taken MaxVolumes - 1 at a time; normally there are one or two.
+	if (count > MaxVolumes - 1)
+	{
+		ComputeColorVolumeCoverage(display, references, MaxVolumes - 1, results, step, pool);
+		ComputeColorVolumeCoverage(display, references + MaxVolumes - 1, count - (MaxVolumes - 1),
+								   results + MaxVolumes - 1, step, pool);
+		return;
+	}
+
+	Sweep s;
+	s.volumes = (int)count + 1;
+	s.step = step * JND;
+	s.tests[0] = MakeVolumeTest(display);
+	for (size_t i = 0; i < count; i++)
+		s.tests[i + 1] = MakeVolumeTest(references[i]);
+	s.toLMSp = Inverse(LMStoICtCp);
+
+	// Grid extent: the union of the bounding boxes, padded a couple of steps.
+	double lo[3] = { 1e9, 1e9, 1e9 }, hi[3] = { -1e9, -1e9, -1e9 };
+	ExtendBounds(display, lo, hi);
+	for (size_t i = 0; i < count; i++)
+		ExtendBounds(references[i], lo, hi);
+	s.iBegin = FloorIndex(lo[0], s.step) - 2;
+	s.iEnd   = CeilIndex(hi[0], s.step) + 3;
+	s.tBegin = FloorIndex(lo[1], s.step) - 2;
+	s.tEnd   = CeilIndex(hi[1], s.step) + 3;
+	s.pBegin = FloorIndex(lo[2], s.step) - 2;
+	s.pEnd   = CeilIndex(hi[2], s.step) + 3;
+	if (s.iBegin < 0)
+		s.iBegin = 0;
+
+	const DecodeTable& table = Decode();
+
+	// Tiles of RowsPerTile consecutive T rows in one I plane.  Per-tile sums keep the
+	// totals independent of scheduling.
+	int rowsI = s.iEnd - s.iBegin;
+	int tilesT = (s.tEnd - s.tBegin + RowsPerTile - 1) / RowsPerTile;
+	std::vector<uint64_t> tiles((size_t)rowsI * tilesT * 2 * MaxVolumes, 0);
+	pool->ParallelFor(0, (size_t)rowsI * tilesT, [&](size_t tile)
+	{
+		int iI = s.iBegin + (int)(tile / tilesT);
+		int t0 = s.tBegin + (int)(tile % tilesT) * RowsPerTile;
+		int t1 = t0 + RowsPerTile < s.tEnd ? t0 + RowsPerTile : s.tEnd;
+		TileCounts counts = {};
+		for (int iT = t0; iT < t1; iT++)
+			SweepRow(s, table, iI, iT, counts);
+		memcpy(&tiles[tile * 2 * MaxVolumes], counts, sizeof(counts));
+	});
+
+	uint64_t totals[2 * MaxVolumes] = {};
+	for (size_t tile = 0; tile < tiles.size(); tile += 2 * MaxVolumes)
+		for (int k = 0; k < 2 * MaxVolumes; k++)
+			totals[k] += tiles[tile + k];
+
+	double cube = (double)step * step * step;
+	for (size_t i = 0; i < count; i++)
+	{
+		ColorVolumeCoverage& r = results[i];
+		r.displaySamples   = totals[0];
+		r.referenceSamples = totals[i + 1];
+		r.sharedSamples    = totals[s.volumes + i + 1];
+		r.displayVolume    = (double)r.displaySamples * cube;
+		r.referenceVolume  = (double)r.referenceSamples * cube;
+		r.coverage         = r.referenceSamples ? (double)r.sharedSamples / r.referenceSamples : 0.0;
+	}
+}
+
+ColorVolumeCoverage ComputeColorVolumeCoverage(const ColorVolume& display, const ColorVolume& reference,
+											   float step, ThreadPool* pool)
+{
+	ColorVolumeCoverage result;
+	ComputeColorVolumeCoverage(display, &reference, 1, &result, step, pool);
+	return result;
+}
@@ -0,0 +1,156 @@
+//
+// CompositionTool.cpp
+//
+// Reproduces FullFrameSDRWhiteWithHDR as DWM composes it, with DwmCompositor: an SDR
+// desktop of full frame white at an SDR white level, under an HDR10 window of 10% of the
+// screen at an HDR level, both on an HDR10 link.  Reports the codes that reach the link
+// for each, with the nits they stand for, and the time of a full composition against
+// that of a frame in which only the window presents.  Not part of the app project; build
+// it directly, e.g.
+//
+//   g++ -std=c++17 -O2 -mavx2 -mfma -pthread CompositionTool.cpp DwmCompositor.cpp AdvancedColorPipeline.cpp ImageConvert.cpp ThreadPool.cpp ToneMap.cpp TransferBatch.cpp TransferTables.cpp -o compose
+//   cl /std:c++17 /O2 /arch:AVX2 /EHsc /constexpr:steps100000000 CompositionTool.cpp DwmCompositor.cpp AdvancedColorPipeline.cpp ImageConvert.cpp ThreadPool.cpp ToneMap.cpp TransferBatch.cpp TransferTables.cpp /Fe:compose.exe
+//
+// Usage: compose [--size WxH] [--threads N] [--sdr nits] [--hdr nits] [--opacity x] [--frames N]
+//
+// --opacity below 1 blends the window over the desktop, as a translucent window.
+//
+
+#include "ColorSpaces.h"
+#include "DwmCompositor.h"
+#include "ThreadPool.h"
+#include "TransferTables.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+	struct Options
+	{
+		uint32_t width = 3840;
+		uint32_t height = 2160;
+		unsigned threads = 0;
+		float    sdrNits = 240.0f;				// the pattern's locked SDR background
+		float    hdrNits = 1000.0f;
+		float    opacity = 1.0f;
+		unsigned frames = 60;
+	};
+
+	double Milliseconds(std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	void PrintCode(const char* name, uint32_t pixel)
+	{
+		uint32_t code = pixel & 1023;
+		printf("  %-8s wire code %4u  %8.2f nits\n", name, code, Remove2084_10bit(code) * 10000.0f);
+	}
+
+	int Run(const Options& options)
+	{
+		ThreadPool pool(options.threads);
+		uint32_t width = options.width, height = options.height;
+
+		// Full frame white in an 8-bit sRGB surface, and the HDR level in an HDR10 one
+		// whose area is a tenth of the screen, centered, as the pattern draws it.
+		std::vector<uint32_t> desktop((size_t)width * height, 0xffffffffu);
+		uint32_t windowWidth = (uint32_t)(width * sqrtf(0.1f)), windowHeight = (uint32_t)(height * sqrtf(0.1f));
+		uint32_t code = (uint32_t)lroundf(Apply2084(options.hdrNits / 10000.0f) * 1023.0f);
+		std::vector<uint32_t> window((size_t)windowWidth * windowHeight, code | code << 10 | code << 20 | 3u << 30);
+
+		ImageBuffer desktopBuffer = { desktop.data(), width, height, width * sizeof(uint32_t), ImageFormat::R8G8B8A8_UNORM };
+		ImageBuffer windowBuffer = { window.data(), windowWidth, windowHeight, windowWidth * sizeof(uint32_t), ImageFormat::R10G10B10A2_UNORM };
+		CompositionLayer sdr = MakeCompositionLayer(desktopBuffer, SwapChainColorSpace::RGB_FULL_G22_NONE_P709);
+		sdr.sdrWhiteLevel = options.sdrNits;
+		CompositionLayer hdr = MakeCompositionLayer(windowBuffer, SwapChainColorSpace::RGB_FULL_G2084_NONE_P2020,
+													(int32_t)(width - windowWidth) / 2, (int32_t)(height - windowHeight) / 2);
+		if (options.opacity < 1.0f)
+		{
+			hdr.alphaMode = LayerAlphaMode::Straight;
+			hdr.opacity = options.opacity;
+		}
+
+		DwmCompositor compositor(width, height, &pool);
+		compositor.AddLayer(sdr);
+		compositor.AddLayer(hdr);
+
+		std::vector<uint32_t> wire((size_t)width * height);
+		ImageBuffer wireBuffer = { wire.data(), width, height, width * sizeof(uint32_t), ImageFormat::R10G10B10A2_UNORM };
+
+		auto start = std::chrono::high_resolution_clock::now();
+		int tiles = compositor.Compose(wireBuffer);
+		double full = Milliseconds(start);
+
+		// The app presents its whole window every frame; the desktop stays put.
+		int windowTiles = 0;
+		start = std::chrono::high_resolution_clock::now();
+		for (unsigned frame = 0; frame < options.frames; frame++)
+		{
+			compositor.Invalidate(1);
+			windowTiles = compositor.Compose(wireBuffer);
+		}
+		double held = options.frames ? Milliseconds(start) / options.frames : 0.0;
+
+		printf("%ux%u desktop, SDR white at %.0f nits, %ux%u HDR10 window at %.0f nits", width, height, options.sdrNits,
+			   windowWidth, windowHeight, options.hdrNits);
+		if (options.opacity < 1.0f)
+			printf(", opacity %.2f", options.opacity);
+		printf(", %u threads\n", pool.Size());
+		printf("  full composition   %8.2f ms  %5d tiles\n", full, tiles);
+		printf("  window present     %8.2f ms  %5d tiles\n", held, windowTiles);
+		PrintCode("desktop", wire[0]);
+		PrintCode("window", wire[(size_t)(height / 2) * width + width / 2]);
+		return 0;
+	}
+
+	void PrintUsage()
+	{
+		fprintf(stderr,
+				"usage: compose [--size WxH] [--threads N] [--sdr nits] [--hdr nits] [--opacity x] [--frames N]\n"
+				"  --size     desktop size (default 3840x2160)\n"
+				"  --threads  worker count including the caller (default: one per hardware thread)\n"
+				"  --sdr      SDR white level of the desktop in nits (default 240)\n"
+				"  --hdr      level of the HDR10 window in nits (default 1000)\n"
+				"  --opacity  window opacity, 0 to 1 (default 1)\n"
+				"  --frames   frames in which the window presents (default 60)\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		unsigned w, h;
+		if (!strcmp(arg, "--size") && hasValue && sscanf(argv[i + 1], "%ux%u", &w, &h) == 2 && w > 0 && h > 0)
+		{
+			options.width = w;
+			options.height = h;
+			i++;
+		}
+		else if (!strcmp(arg, "--threads") && hasValue)
+			options.threads = (unsigned)atoi(argv[++i]);
+		else if (!strcmp(arg, "--sdr") && hasValue)
+			options.sdrNits = (float)atof(argv[++i]);
+		else if (!strcmp(arg, "--hdr") && hasValue)
+			options.hdrNits = (float)atof(argv[++i]);
+		else if (!strcmp(arg, "--opacity") && hasValue)
+			options.opacity = (float)atof(argv[++i]);
+		else if (!strcmp(arg, "--frames") && hasValue)
+			options.frames = (unsigned)atoi(argv[++i]);
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+	return Run(options);
+}
@@ -0,0 +1,544 @@
+//
+// CpuCanvas.cpp
+//
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <wchar.h>
+
+#include "ColorSpaces.h"
+#include "CpuCanvas.h"
+#include "SimdMath.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	const int TileSize = 64;		// pixels; a multiple of every SIMD width
+
+	// Fraction of the pixel span [p, p + 1) that lies inside [lo, hi).
+	inline float Overlap(float p, float lo, float hi)
+	{
+		return std::min(std::max(std::min(p + 1.0f, hi) - std::max(p, lo), 0.0f), 1.0f);
+	}
+
+	// Coverage of each pixel column (or row) of a tile by the span [lo, hi).
+	inline void SpanCoverage(float* coverage, int origin, float lo, float hi)
+	{
+		for (int i = 0; i < TileSize; i++)
+			coverage[i] = Overlap((float)(origin + i), lo, hi);
+	}
+
+	// dst = lerp(dst, color, coverage) over one row of the tile.
+	inline void BlendRow(float* r, float* g, float* b, const float* coverage, float scale, const ColorF& color)
+	{
+		using namespace simd;
+
+		vfloat cr = color.r, cg = color.g, cb = color.b, s = scale;
+		for (int x = 0; x < TileSize; x += width)
+		{
+			vfloat w = load(coverage + x) * s;
+			store(r + x, lerp(load(r + x), cr, w));
+			store(g + x, lerp(load(g + x), cg, w));
+			store(b + x, lerp(load(b + x), cb, w));
+		}
+	}
+
+	// Stops are sRGB-encoded and interpolated as such, then linearized, as the app's
+	// gradient brush converts from D2D1_COLOR_SPACE_SRGB to D2D1_COLOR_SPACE_SCRGB.
+	ColorF GradientColor(const GradientStop* stops, size_t count, float t)
+	{
+		ColorF c = stops[count - 1].color;
+		if (t <= stops[0].position)
+		{
+			c = stops[0].color;
+		}
+		else
+		{
+			for (size_t i = 1; i < count; i++)
+			{
+				if (t < stops[i].position)
+				{
+					const GradientStop& a = stops[i - 1];
+					const GradientStop& b = stops[i];
+					float f = (t - a.position) / (b.position - a.position);
+					c = ColorF(a.color.r + (b.color.r - a.color.r) * f,
+							   a.color.g + (b.color.g - a.color.g) * f,
+							   a.color.b + (b.color.b - a.color.b) * f,
+							   a.color.a + (b.color.a - a.color.a) * f);
+					break;
+				}
+			}
+		}
+		return ColorF(RemoveSRGBCurve(c.r), RemoveSRGBCurve(c.g), RemoveSRGBCurve(c.b), c.a);
+	}
+
+	// The app's text formats at 96 DPI, in DIPs: the mean advance of a glyph, the line
+	// spacing and baseline DirectWrite uses for the font, and its capital and x-heights.
+	struct FontMetrics
+	{
+		float advance;
+		float lineHeight;
+		float baseline;			// below the top of the line
+		float capHeight;
+		float xHeight;
+	};
+
+	FontMetrics GetFontMetrics(TextStyle style)
+	{
+		switch (style)
+		{
+		case TextStyle::Large:		return { 12.0f, 31.9f, 25.9f, 16.8f, 12.0f };		// Segoe UI 24
+		case TextStyle::Monospace:	return { 9.9f, 21.1f, 16.9f, 11.5f, 8.5f };		// Consolas 18
+		default:					return { 7.0f, 18.6f, 15.1f, 9.8f, 7.0f };		// Segoe UI 14
+		}
+	}
+
+	inline bool IsShortGlyph(wchar_t c)
+	{
+		return c >= L'a' && c <= L'z' && !wcschr(L"bdfhiklt", c);
+	}
+}
+
+CpuCanvas::CpuCanvas(uint32_t width, uint32_t height, ThreadPool* pool) :
+	m_width(width),
+	m_height(height),
+	m_pool(pool ? pool : &ThreadPool::Default()),
+	m_pixels((size_t)width * height * 4, 0)
+{
+}
+
+void CpuCanvas::RegisterEffect(PatternEffect effect, EffectKernel kernel)
+{
+	m_effects[effect] = kernel;
+}
+
+void CpuCanvas::SetImage(const std::wstring& filename, uint32_t width, uint32_t height, const float* rgba)
+{
+	Image& image = m_images[filename];
+	image.width = width;
+	image.height = height;
+	image.rgba.assign(rgba, rgba + (size_t)width * height * 4);
+}
+
+RectF CpuCanvas::GetLogicalSize() const
+{
+	return RectF(0.0f, 0.0f, (float)m_width, (float)m_height);
+}
+
+RectF CpuCanvas::GetOutputSize() const
+{
+	return RectF(0.0f, 0.0f, (float)m_width, (float)m_height);
+}
+
+float CpuCanvas::GetDpi() const
+{
+	return 96.0f;
+}
+
+void CpuCanvas::BeginDraw()
+{
+	m_commands.clear();
+	m_stops.clear();
+	m_text.clear();
+}
+
+// Clips the extent to the target and keeps the command if anything is left.
+void CpuCanvas::Record(Command& command, float left, float top, float right, float bottom)
+{
+	command.bounds[0] = (int)std::max(floorf(left), 0.0f);
+	command.bounds[1] = (int)std::max(floorf(top), 0.0f);
+	command.bounds[2] = (int)std::min(ceilf(right), (float)m_width);
+	command.bounds[3] = (int)std::min(ceilf(bottom), (float)m_height);
+
+	if (command.bounds[0] < command.bounds[2] && command.bounds[1] < command.bounds[3])
+		m_commands.push_back(command);
+}
+
+void CpuCanvas::FillRectangle(const RectF& rect, const ColorF& color)
+{
+	Command command = {};
+	command.type = CommandType::Fill;
+	command.rect = rect;
+	command.color = color;
+	Record(command, rect.left, rect.top, rect.right, rect.bottom);
+}
+
+// The stroke is centered on the outline, as in D2D.
+void CpuCanvas::DrawRectangle(const RectF& rect, const ColorF& color, float strokeWidth)
+{
+	float h = strokeWidth * 0.5f;
+	Command command = {};
+	command.type = CommandType::Stroke;
+	command.rect = rect;
+	command.color = color;
+	command.strokeWidth = strokeWidth;
+	Record(command, rect.left - h, rect.top - h, rect.right + h, rect.bottom + h);
+}
+
+void CpuCanvas::DrawEllipse(const EllipseF& ellipse, const ColorF& color, float strokeWidth)
+{
+	float h = strokeWidth * 0.5f + 1.0f;
+	Command command = {};
+	command.type = CommandType::Ellipse;
+	command.ellipse = ellipse;
+	command.color = color;
+	command.strokeWidth = strokeWidth;
+	Record(command, ellipse.point.x - ellipse.radiusX - h, ellipse.point.y - ellipse.radiusY - h,
+		   ellipse.point.x + ellipse.radiusX + h, ellipse.point.y + ellipse.radiusY + h);
+}
+
+void CpuCanvas::FillLinearGradient(const RectF& rect, PointF start, PointF end,
+								   const GradientStop* stops, size_t count)
+{
+	if (count == 0)
+		return;
+
+	Command command = {};
+	command.type = CommandType::Gradient;
+	command.rect = rect;
+	command.start = start;
+	command.end = end;
+	command.firstStop = m_stops.size();
+	command.stopCount = count;
+	m_stops.insert(m_stops.end(), stops, stops + count);
+	Record(command, rect.left, rect.top, rect.right, rect.bottom);
+}
+
+// There is no font rasterizer, so each glyph is filled as a box on the baseline, capital
+// height or x-height, at a fixed advance.  Lines break at '\n' and wrap between words at
+// the layout width as DirectWrite wraps them, so the boxes land about where the glyphs
+// would and text changes show up in the image.
+void CpuCanvas::DrawString(const std::wstring& text, TextStyle style, const RectF& textPos, const ColorF& color)
+{
+	TextRun run = { text, style, textPos, color };
+	m_text.push_back(run);
+
+	const FontMetrics metrics = GetFontMetrics(style);
+	const wchar_t* breaks = L" \t\r\n";
+	float lineTop = textPos.top;
+	float x = 0.0f;
+	for (size_t i = 0; i < text.size();)
+	{
+		wchar_t c = text[i];
+		if (wcschr(breaks, c))
+		{
+			if (c == L'\n')
+			{
+				lineTop += metrics.lineHeight;
+				x = 0.0f;
+			}
+			else if (c != L'\r')
+			{
+				x += metrics.advance * (c == L'\t' ? 4.0f : 1.0f);
+			}
+			i++;
+			continue;
+		}
+
+		size_t end = std::min(text.find_first_of(breaks, i), text.size());
+		if (x > 0.0f && x + (end - i) * metrics.advance > textPos.right)
+		{
+			lineTop += metrics.lineHeight;
+			x = 0.0f;
+		}
+
+		float baseline = lineTop + metrics.baseline;
+		for (; i < end; i++, x += metrics.advance)
+		{
+			float left = textPos.left + x + metrics.advance * 0.15f;
+			float height = IsShortGlyph(text[i]) ? metrics.xHeight : metrics.capHeight;
+			FillRectangle(RectF(left, baseline - height, left + metrics.advance * 0.7f, baseline), color);
+		}
+	}
+}
+
+bool CpuCanvas::DrawEffect(PatternEffect effect, const EffectConstants& constants)
+{
+	if (m_effects.find(effect) == m_effects.end())
+		return false;
+
+	Command command = {};
+	command.type = CommandType::Effect;
+	command.effect = effect;
+	command.constants = constants;
+	Record(command, 0.0f, 0.0f, (float)m_width, (float)m_height);
+	return true;
+}
+
+// Centered at 1:1.  The offset is rounded to whole pixels, which is exact whenever the
+// image and target sizes have the same parity (all the shipped images on even targets).
+bool CpuCanvas::DrawImage(const std::wstring& filename)
+{
+	auto it = m_images.find(filename);
+	if (it == m_images.end())
+		return false;
+
+	const Image& image = it->second;
+	float dX = floorf(((float)m_width - (float)image.width) / 2.0f + 0.5f);
+	float dY = floorf(((float)m_height - (float)image.height) / 2.0f + 0.5f);
+
+	Command command = {};
+	command.type = CommandType::Image;
+	command.rect = RectF(dX, dY, dX + image.width, dY + image.height);
+	command.image = &image;
+	Record(command, command.rect.left, command.rect.top, command.rect.right, command.rect.bottom);
+	return true;
+}
+
+void CpuCanvas::EndDraw()
+{
+	int tilesX = (int)(m_width + TileSize - 1) / TileSize;
+	int tilesY = (int)(m_height + TileSize - 1) / TileSize;
+
+	m_pool->ParallelFor(0, (size_t)tilesX * tilesY, [&](size_t i)
+	{
+		thread_local std::vector<float> scratch;
+		scratch.resize(3 * TileSize * TileSize);
+		RenderTile((int)(i % tilesX) * TileSize, (int)(i / tilesX) * TileSize, scratch.data());
+	});
+}
+
+void CpuCanvas::RenderTile(int tileX, int tileY, float* scratch)
+{
+	using namespace simd;
+
+	CpuTile tile;
+	tile.x = tileX;
+	tile.y = tileY;
+	tile.width = std::min(TileSize, (int)m_width - tileX);
+	tile.height = std::min(TileSize, (int)m_height - tileY);
+	tile.stride = TileSize;
+	tile.r = scratch;
+	tile.g = scratch + TileSize * TileSize;
+	tile.b = scratch + 2 * TileSize * TileSize;
+
+	memset(scratch, 0, 3 * TileSize * TileSize * sizeof(float));
+
+	// Everything under the last opaque fill or effect covering the whole tile is hidden;
+	// nested boxes and full-screen backgrounds make that the common case.
+	auto coversTile = [&](const Command& command)
+	{
+		return command.type == CommandType::Effect ||
+			(command.type == CommandType::Fill && command.color.a >= 1.0f &&
+			 command.rect.left <= tileX && command.rect.right >= tileX + tile.width &&
+			 command.rect.top <= tileY && command.rect.bottom >= tileY + tile.height);
+	};
+
+	size_t first = m_commands.size();
+	while (first > 0 && !coversTile(m_commands[first - 1]))
+		first--;
+	if (first > 0)
+		first--;
+
+	for (size_t i = first; i < m_commands.size(); i++)
+	{
+		const Command& command = m_commands[i];
+		if (command.bounds[0] < tileX + tile.width && command.bounds[2] > tileX &&
+			command.bounds[1] < tileY + tile.height && command.bounds[3] > tileY)
+		{
+			ApplyCommand(command, tile);
+		}
+	}
+
+	// Half conversion and RGBA interleave, one row at a time.  Alpha is always 1.
+	for (int y = 0; y < tile.height; y++)
+	{
+		const size_t o = (size_t)y * TileSize;
+		int32_t rg[TileSize], ba[TileSize];
+		for (int x = 0; x < TileSize; x += width)
+		{
+			storei(rg + x, tohalf(load(tile.r + o + x)) | shl<16>(tohalf(load(tile.g + o + x))));
+			storei(ba + x, tohalf(load(tile.b + o + x)) | vint(0x3C000000));
+		}
+
+		uint32_t packed[2 * TileSize];
+		for (int x = 0; x < TileSize; x++)
+		{
+			packed[2 * x]     = (uint32_t)rg[x];
+			packed[2 * x + 1] = (uint32_t)ba[x];
+		}
+
+		uint16_t* row = m_pixels.data() + ((size_t)(tileY + y) * m_width + tileX) * 4;
+		memcpy(row, packed, (size_t)tile.width * 4 * sizeof(uint16_t));
+	}
+}
+
+void CpuCanvas::ApplyCommand(const Command& command, const CpuTile& tile) const
+{
+	using namespace simd;
+
+	const float x0 = (float)tile.x;
+	const float y0 = (float)tile.y;
+
+	switch (command.type)
+	{
+	case CommandType::Fill:
+	{
+		const RectF& rc = command.rect;
+		float covX[TileSize];
+		SpanCoverage(covX, tile.x, rc.left, rc.right);
+		for (int y = 0; y < tile.height; y++)
+		{
+			float covY = Overlap(y0 + y, rc.top, rc.bottom);
+			if (covY > 0.0f)
+			{
+				size_t o = y * tile.stride;
+				BlendRow(tile.r + o, tile.g + o, tile.b + o, covX, covY * command.color.a, command.color);
+			}
+		}
+		break;
+	}
+
+	case CommandType::Stroke:
+	{
+		// Area between the outline grown and shrunk by half the stroke.
+		const RectF& rc = command.rect;
+		float h = command.strokeWidth * 0.5f;
+		bool hollow = rc.right - rc.left > command.strokeWidth && rc.bottom - rc.top > command.strokeWidth;
+
+		float outerX[TileSize], innerX[TileSize], coverage[TileSize];
+		SpanCoverage(outerX, tile.x, rc.left - h, rc.right + h);
+		SpanCoverage(innerX, tile.x, rc.left + h, rc.right - h);
+		for (int y = 0; y < tile.height; y++)
+		{
+			float outerY = Overlap(y0 + y, rc.top - h, rc.bottom + h);
+			float innerY = hollow ? Overlap(y0 + y, rc.top + h, rc.bottom - h) : 0.0f;
+			if (outerY <= 0.0f)
+				continue;
+
+			for (int x = 0; x < TileSize; x += width)
+				store(coverage + x, load(outerX + x) * vfloat(outerY) - load(innerX + x) * vfloat(innerY));
+
+			size_t o = y * tile.stride;
+			BlendRow(tile.r + o, tile.g + o, tile.b + o, coverage, command.color.a, command.color);
+		}
+		break;
+	}
+
+	case CommandType::Ellipse:
+	{
+		// Coverage falls off with the distance from the pixel center to the outline,
+		// approximated to first order as f / |grad f| for f = (x/rx)^2 + (y/ry)^2 - 1.
+		const EllipseF& e = command.ellipse;
+		vfloat irx2 = 1.0f / std::max(e.radiusX * e.radiusX, 1e-6f);
+		vfloat iry2 = 1.0f / std::max(e.radiusY * e.radiusY, 1e-6f);
+		vfloat halfWidth = command.strokeWidth * 0.5f + 0.5f;
+
+		float coverage[TileSize];
+		for (int y = 0; y < tile.height; y++)
+		{
+			vfloat dy = vfloat(y0 + y + 0.5f - e.point.y);
+			vfloat dy2 = dy * dy * iry2;
+			vfloat gy = dy * iry2;
+			for (int x = 0; x < TileSize; x += width)
+			{
+				vfloat dx = vfloat(x0 + x + 0.5f - e.point.x) + ramp();
+				vfloat f = mad(dx * dx, irx2, dy2) - vfloat(1.0f);
+				vfloat gx = dx * irx2;
+				vfloat grad = vfloat(2.0f) * sqrt(mad(gx, gx, gy * gy));
+				vfloat dist = abs(f) / max(grad, vfloat(1e-12f));
+				store(coverage + x, saturate(halfWidth - dist));
+			}
+
+			size_t o = y * tile.stride;
+			BlendRow(tile.r + o, tile.g + o, tile.b + o, coverage, command.color.a, command.color);
+		}
+		break;
+	}
+
+	case CommandType::Gradient:
+	{
+		const RectF& rc = command.rect;
+		const GradientStop* stops = &m_stops[command.firstStop];
+		float ax = command.end.x - command.start.x;
+		float ay = command.end.y - command.start.y;
+		float len2 = ax * ax + ay * ay;
+		if (len2 <= 0.0f)
+			break;
+
+		float covX[TileSize];
+		SpanCoverage(covX, tile.x, rc.left, rc.right);
+
+		if (ay == 0.0f)
+		{
+			// Horizontal axis: one color per column, shared by every row.
+			float cr[TileSize], cg[TileSize], cb[TileSize], ca[TileSize];
+			for (int x = 0; x < TileSize; x++)
+			{
+				float t = (x0 + x + 0.5f - command.start.x) * ax / len2;
+				ColorF c = GradientColor(stops, command.stopCount, t);
+				cr[x] = c.r;
+				cg[x] = c.g;
+				cb[x] = c.b;
+				ca[x] = c.a * covX[x];
+			}
+
+			for (int y = 0; y < tile.height; y++)
+			{
+				float covY = Overlap(y0 + y, rc.top, rc.bottom);
+				if (covY <= 0.0f)
+					continue;
+
+				size_t o = y * tile.stride;
+				for (int x = 0; x < TileSize; x += width)
+				{
+					vfloat w = load(ca + x) * vfloat(covY);
+					store(tile.r + o + x, lerp(load(tile.r + o + x), load(cr + x), w));
+					store(tile.g + o + x, lerp(load(tile.g + o + x), load(cg + x), w));
+					store(tile.b + o + x, lerp(load(tile.b + o + x), load(cb + x), w));
+				}
+			}
+		}
+		else
+		{
+			for (int y = 0; y < tile.height; y++)
+			{
+				float covY = Overlap(y0 + y, rc.top, rc.bottom);
+				if (covY <= 0.0f)
+					continue;
+
+				size_t o = y * tile.stride;
+				for (int x = 0; x < tile.width; x++)
+				{
+					float t = ((x0 + x + 0.5f - command.start.x) * ax + (y0 + y + 0.5f - command.start.y) * ay) / len2;
+					ColorF c = GradientColor(stops, command.stopCount, t);
+					float w = c.a * covX[x] * covY;
+					tile.r[o + x] += (c.r - tile.r[o + x]) * w;
+					tile.g[o + x] += (c.g - tile.g[o + x]) * w;
+					tile.b[o + x] += (c.b - tile.b[o + x]) * w;
+				}
+			}
+		}
+		break;
+	}
+
+	case CommandType::Effect:
+		m_effects.at(command.effect)(command.constants, tile);
+		break;
+
+	case CommandType::Image:
+	{
+		// Source-over with premultiplied alpha.
+		const Image& image = *command.image;
+		int left = (int)command.rect.left;
+		int top = (int)command.rect.top;
+		int xBegin = std::max(command.bounds[0], tile.x), xEnd = std::min(command.bounds[2], tile.x + tile.width);
+		int yBegin = std::max(command.bounds[1], tile.y), yEnd = std::min(command.bounds[3], tile.y + tile.height);
+		for (int y = yBegin; y < yEnd; y++)
+		{
+			const float* src = &image.rgba[((size_t)(y - top) * image.width + (xBegin - left)) * 4];
+			size_t o = (y - tile.y) * tile.stride;
+			for (int x = xBegin; x < xEnd; x++, src += 4)
+			{
+				size_t i = o + (x - tile.x);
+				float k = 1.0f - src[3];
+				tile.r[i] = src[0] + tile.r[i] * k;
+				tile.g[i] = src[1] + tile.g[i] * k;
+				tile.b[i] = src[2] + tile.b[i] * k;
+			}
+		}
+		break;
+	}
+	}
+}
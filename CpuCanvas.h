@@ -0,0 +1,138 @@
+//
+// CpuCanvas.h
+//
+// PatternCanvas rendered on the CPU into an FP16 scRGB framebuffer, the same format as
+// the app's swap chain, so test patterns can be generated headless (CI, image diffs,
+// timing) without D3D or D2D.  At 96 DPI one DIP is one pixel, as in the app.
+//
+// Drawing calls between BeginDraw() and EndDraw() are only recorded.  EndDraw() splits
+// the target into 64x64 tiles and hands them to a ThreadPool; each tile is cleared to
+// black in a planar float scratch buffer, every command that touches it is applied in
+// order, and the result is converted to half once and written out.  The framebuffer is
+// therefore touched once per frame no matter how many primitives overlap.
+//
+// Edges are antialiased analytically (area coverage for rectangles, distance to the
+// outline for ellipses), approximating D2D's per-primitive antialiasing.  Text is drawn
+// as one box per glyph where DirectWrite would lay it out, and the runs are kept for
+// inspection through GetText().  Custom effects run through kernels registered with
+// RegisterEffect(), and images must be supplied as pixels with SetImage(); without them
+// DrawEffect()/DrawImage() return false, as the app does for a missing .cso or .png.
+//
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <stdint.h>
+#include <vector>
+#include "PatternCanvas.h"
+
+class ThreadPool;
+
+// A rectangle of the target in planar float scRGB, handed to effect kernels.
+struct CpuTile
+{
+	int    x;				// target pixel of element 0
+	int    y;
+	int    width;
+	int    height;
+	size_t stride;			// floats between rows
+	float* r;
+	float* g;
+	float* b;
+};
+
+class CpuCanvas : public PatternCanvas
+{
+public:
+	// Fills tile with the effect output; generator effects cover the whole target.
+	typedef std::function<void(const EffectConstants& constants, const CpuTile& tile)> EffectKernel;
+
+	struct TextRun
+	{
+		std::wstring text;
+		TextStyle    style;
+		RectF        textPos;
+		ColorF       color;
+	};
+
+	// pool == nullptr uses ThreadPool::Default().
+	CpuCanvas(uint32_t width, uint32_t height, ThreadPool* pool = nullptr);
+
+	void RegisterEffect(PatternEffect effect, EffectKernel kernel);
+
+	// Premultiplied linear scRGB RGBA, width * height * 4 floats, copied.
+	void SetImage(const std::wstring& filename, uint32_t width, uint32_t height, const float* rgba);
+
+	void BeginDraw();
+	void EndDraw();
+
+	// R16G16B16A16_FLOAT pixels of the last EndDraw(), rows of GetRowPitch() bytes.
+	const uint16_t* GetPixels() const { return m_pixels.data(); }
+	size_t GetRowPitch() const { return m_width * 4 * sizeof(uint16_t); }
+	uint32_t GetWidth() const { return m_width; }
+	uint32_t GetHeight() const { return m_height; }
+	const std::vector<TextRun>& GetText() const { return m_text; }
+
+	virtual RectF GetLogicalSize() const override;
+	virtual RectF GetOutputSize() const override;
+	virtual float GetDpi() const override;
+
+	virtual void FillRectangle(const RectF& rect, const ColorF& color) override;
+	virtual void DrawRectangle(const RectF& rect, const ColorF& color, float strokeWidth = 1.0f) override;
+	virtual void DrawEllipse(const EllipseF& ellipse, const ColorF& color, float strokeWidth = 1.0f) override;
+	virtual void FillLinearGradient(const RectF& rect, PointF start, PointF end,
+									const GradientStop* stops, size_t count) override;
+	virtual void DrawString(const std::wstring& text, TextStyle style, const RectF& textPos, const ColorF& color) override;
+	virtual bool DrawEffect(PatternEffect effect, const EffectConstants& constants) override;
+	virtual bool DrawImage(const std::wstring& filename) override;
+
+private:
+	enum class CommandType
+	{
+		Fill,
+		Stroke,
+		Ellipse,
+		Gradient,
+		Effect,
+		Image,
+	};
+
+	struct Image
+	{
+		uint32_t           width;
+		uint32_t           height;
+		std::vector<float> rgba;
+	};
+
+	struct Command
+	{
+		CommandType     type;
+		int             bounds[4];		// pixels touched: left, top, right, bottom (exclusive)
+		RectF           rect;			// Fill, Stroke, Gradient; Image: placement
+		ColorF          color;
+		float           strokeWidth;
+		EllipseF        ellipse;
+		PointF          start;			// Gradient axis
+		PointF          end;
+		size_t          firstStop;		// into m_stops
+		size_t          stopCount;
+		EffectConstants constants;
+		PatternEffect   effect;
+		const Image*    image;
+	};
+
+	void Record(Command& command, float left, float top, float right, float bottom);
+	void RenderTile(int tileX, int tileY, float* scratch);
+	void ApplyCommand(const Command& command, const CpuTile& tile) const;
+
+	uint32_t                             m_width;
+	uint32_t                             m_height;
+	ThreadPool*                          m_pool;
+	std::vector<uint16_t>                m_pixels;
+	std::vector<Command>                 m_commands;
+	std::vector<GradientStop>            m_stops;
+	std::vector<TextRun>                 m_text;
+	std::map<PatternEffect, EffectKernel> m_effects;
+	std::map<std::wstring, Image>        m_images;
+};
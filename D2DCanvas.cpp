@@ -0,0 +1,334 @@
+//
+// D2DCanvas.cpp
+//
+
+#include "pch.h"
+
+#include <vector>
+
+#include "D2DCanvas.h"
+#include "BandedGradientEffect.h"
+#include "SineSweepEffect.h"
+#include "ToneSpikeEffect.h"
+
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+	inline D2D1_RECT_F ToD2D(const RectF& r)
+	{
+		return D2D1::RectF(r.left, r.top, r.right, r.bottom);
+	}
+
+	inline D2D1_POINT_2F ToD2D(PointF p)
+	{
+		return D2D1::Point2F(p.x, p.y);
+	}
+
+	inline D2D1_COLOR_F ToD2D(const ColorF& c)
+	{
+		return D2D1::ColorF(c.r, c.g, c.b, c.a);
+	}
+
+	D2D1_BUFFER_PRECISION GetBufferPrecision(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_B8G8R8A8_UNORM:
+			return D2D1_BUFFER_PRECISION_8BPC_UNORM;
+
+		case DXGI_FORMAT_R16G16B16A16_UNORM:
+			return D2D1_BUFFER_PRECISION_16BPC_UNORM;
+
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+			return D2D1_BUFFER_PRECISION_16BPC_FLOAT;
+
+		default:
+			DX::ThrowIfFailed(E_INVALIDARG);
+			return D2D1_BUFFER_PRECISION_UNKNOWN;
+		}
+	}
+}
+
+D2DBrushDevice::SolidBrush D2DBrushDevice::CreateSolidBrush(const ColorF& color)
+{
+	SolidBrush brush;
+	DX::ThrowIfFailed(ctx->CreateSolidColorBrush(ToD2D(color), &brush));
+	return brush;
+}
+
+// The end points are set by each draw.
+D2DBrushDevice::GradientBrush D2DBrushDevice::CreateGradientBrush(const GradientStop* stops, size_t count,
+																  uint32_t precision)
+{
+	std::vector<D2D1_GRADIENT_STOP> gradientStops(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		gradientStops[i].position = stops[i].position;
+		gradientStops[i].color = ToD2D(stops[i].color);
+	}
+
+	ComPtr<ID2D1GradientStopCollection1> stopCollection;
+	DX::ThrowIfFailed(ctx->CreateGradientStopCollection(
+		gradientStops.data(),
+		static_cast<UINT32>(gradientStops.size()),
+		D2D1_COLOR_SPACE_SRGB, // TODO: Why must I convert from sRGB to scRGB?
+		D2D1_COLOR_SPACE_SCRGB,
+		static_cast<D2D1_BUFFER_PRECISION>(precision),
+		D2D1_EXTEND_MODE_CLAMP,
+		D2D1_COLOR_INTERPOLATION_MODE_PREMULTIPLIED, // No alpha, doesn't matter
+		&stopCollection));
+
+	GradientBrush gradientBrush;
+	DX::ThrowIfFailed(ctx->CreateLinearGradientBrush(
+		D2D1::LinearGradientBrushProperties(D2D1::Point2F(), D2D1::Point2F()),
+		stopCollection.Get(),
+		&gradientBrush));
+	return gradientBrush;
+}
+
+D2DCanvas::D2DCanvas(DX::DeviceResources* deviceResources)
+	: m_deviceResources(deviceResources), m_ctx(deviceResources->GetD2DDeviceContext()),
+	m_brushes(D2DBrushDevice{ deviceResources->GetD2DDeviceContext() })
+{
+	auto dwFactory = m_deviceResources->GetDWriteFactory();
+
+	DX::ThrowIfFailed(dwFactory->CreateTextFormat(
+		L"Segoe UI",
+		nullptr,
+		DWRITE_FONT_WEIGHT_NORMAL,
+		DWRITE_FONT_STYLE_NORMAL,
+		DWRITE_FONT_STRETCH_NORMAL,
+		14.0f,
+		L"en-US",
+		&m_smallFormat));
+
+	DX::ThrowIfFailed(dwFactory->CreateTextFormat(
+		L"Consolas",
+		nullptr,
+		DWRITE_FONT_WEIGHT_NORMAL,
+		DWRITE_FONT_STYLE_NORMAL,
+		DWRITE_FONT_STRETCH_NORMAL,
+		18.0f,
+		L"en-US",
+		&m_monospaceFormat));
+
+	DX::ThrowIfFailed(dwFactory->CreateTextFormat(
+		L"Segoe UI",
+		nullptr,
+		DWRITE_FONT_WEIGHT_NORMAL,
+		DWRITE_FONT_STYLE_NORMAL,
+		DWRITE_FONT_STRETCH_NORMAL,
+		24.0f,
+		L"en-US",
+		&m_largeFormat));
+}
+
+void D2DCanvas::LoadImageResource(const std::wstring& filename)
+{
+	auto wicFactory = m_deviceResources->GetWicImagingFactory();
+
+	ComPtr<IWICBitmapDecoder> decoder;
+	HRESULT hr = wicFactory->CreateDecoderFromFilename(
+		DX::GetAbsolutePath(filename).c_str(),
+		nullptr,
+		GENERIC_READ,
+		WICDecodeMetadataCacheOnDemand,
+		&decoder);
+
+	if FAILED(hr)
+	{
+		if (HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND) == hr)
+		{
+			m_images.erase(filename);
+			return;
+		}
+		else
+		{
+			DX::ThrowIfFailed(hr);
+		}
+	}
+
+	ComPtr<IWICBitmapFrameDecode> frame;
+	DX::ThrowIfFailed(decoder->GetFrame(0, &frame));
+
+	// Always convert to FP16 for JXR support. We ignore color profiles in this tool.
+	WICPixelFormatGUID outFmt = GUID_WICPixelFormat64bppPRGBAHalf;
+
+	ComPtr<IWICFormatConverter> converter;
+	DX::ThrowIfFailed(wicFactory->CreateFormatConverter(&converter));
+	DX::ThrowIfFailed(converter->Initialize(
+		frame.Get(),
+		outFmt,
+		WICBitmapDitherTypeNone,
+		nullptr,
+		0.0f,
+		WICBitmapPaletteTypeCustom));
+
+	ImageResource image;
+	DX::ThrowIfFailed(converter.As(&image.wicSource));
+	DX::ThrowIfFailed(m_ctx->CreateImageSourceFromWic(image.wicSource.Get(), &image.d2dSource));
+
+	m_images[filename] = image;
+}
+
+void D2DCanvas::LoadEffectResource(PatternEffect effect)
+{
+	CLSID clsid = {};
+	switch (effect)
+	{
+	case PatternEffect::SineSweep:
+		clsid = CLSID_CustomSineSweepEffect;
+		break;
+	case PatternEffect::ToneSpike:
+		clsid = CLSID_CustomToneSpikeEffect;
+		break;
+	case PatternEffect::BandedGradient:
+		clsid = CLSID_CustomBandedGradientEffect;
+		break;
+	default:
+		DX::ThrowIfFailed(E_INVALIDARG);
+		break;
+	}
+
+	try
+	{
+		ComPtr<ID2D1Effect> d2dEffect;
+		DX::ThrowIfFailed(m_ctx->CreateEffect(clsid, &d2dEffect));
+		m_effects[effect] = d2dEffect;
+	}
+	catch (std::exception)
+	{
+		// Most likely caused by a missing cso file. Continue on.
+		m_effects.erase(effect);
+	}
+}
+
+RectF D2DCanvas::GetLogicalSize() const
+{
+	auto r = m_deviceResources->GetLogicalSize();
+	return RectF(r.left, r.top, r.right, r.bottom);
+}
+
+RectF D2DCanvas::GetOutputSize() const
+{
+	auto r = m_deviceResources->GetOutputSize();
+	return RectF((float)r.left, (float)r.top, (float)r.right, (float)r.bottom);
+}
+
+float D2DCanvas::GetDpi() const
+{
+	return m_deviceResources->GetDpi();
+}
+
+void D2DCanvas::ClearBrushCache()
+{
+	m_brushes.Clear();
+}
+
+ID2D1SolidColorBrush* D2DCanvas::GetBrush(const ColorF& color)
+{
+	return m_brushes.GetSolidBrush(color).Get();
+}
+
+IDWriteTextFormat* D2DCanvas::GetTextFormat(TextStyle style) const
+{
+	switch (style)
+	{
+	case TextStyle::Small:
+		return m_smallFormat.Get();
+	case TextStyle::Monospace:
+		return m_monospaceFormat.Get();
+	default:
+		return m_largeFormat.Get();
+	}
+}
+
+void D2DCanvas::FillRectangle(const RectF& rect, const ColorF& color)
+{
+	m_ctx->FillRectangle(ToD2D(rect), GetBrush(color));
+}
+
+void D2DCanvas::DrawRectangle(const RectF& rect, const ColorF& color, float strokeWidth)
+{
+	m_ctx->DrawRectangle(ToD2D(rect), GetBrush(color), strokeWidth);
+}
+
+void D2DCanvas::DrawEllipse(const EllipseF& ellipse, const ColorF& color, float strokeWidth)
+{
+	D2D1_ELLIPSE e = { ToD2D(ellipse.point), ellipse.radiusX, ellipse.radiusY };
+	m_ctx->DrawEllipse(e, GetBrush(color), strokeWidth);
+}
+
+void D2DCanvas::FillLinearGradient(const RectF& rect, PointF start, PointF end,
+								   const GradientStop* stops, size_t count)
+{
+	auto& gradientBrush = m_brushes.GetGradientBrush(stops, count,
+		GetBufferPrecision(m_deviceResources->GetBackBufferFormat()));
+	gradientBrush->SetStartPoint(ToD2D(start));
+	gradientBrush->SetEndPoint(ToD2D(end));
+
+	m_ctx->FillRectangle(ToD2D(rect), gradientBrush.Get());
+}
+
+void D2DCanvas::DrawString(const std::wstring& text, TextStyle style, const RectF& textPos, const ColorF& color)
+{
+	auto fact = m_deviceResources->GetDWriteFactory();
+	ComPtr<IDWriteTextLayout> layout;
+	DX::ThrowIfFailed(fact->CreateTextLayout(
+		text.c_str(),
+		(unsigned int)text.length(),
+		GetTextFormat(style),
+		textPos.right,
+		textPos.bottom,
+		&layout));
+
+	m_ctx->DrawTextLayout(D2D1::Point2F(textPos.left, textPos.top), layout.Get(), GetBrush(color));
+}
+
+bool D2DCanvas::DrawEffect(PatternEffect effect, const EffectConstants& constants)
+{
+	auto it = m_effects.find(effect);
+	if (it == m_effects.end())
+		return false;
+
+	ID2D1Effect* d2dEffect = it->second.Get();
+	switch (effect)
+	{
+	case PatternEffect::BandedGradient:
+		DX::ThrowIfFailed(d2dEffect->SetValueByName(L"OutputSize", ToD2D(constants.outputSize)));
+		break;
+
+	case PatternEffect::SineSweep:
+	case PatternEffect::ToneSpike:
+		DX::ThrowIfFailed(d2dEffect->SetValueByName(L"Center", ToD2D(constants.center)));
+		DX::ThrowIfFailed(d2dEffect->SetValueByName(L"InitialWavelength", constants.initialWavelength));
+		DX::ThrowIfFailed(d2dEffect->SetValueByName(L"WavelengthHalvingDistance", constants.wavelengthHalvingDistance));
+		DX::ThrowIfFailed(d2dEffect->SetValueByName(L"WhiteLevelMultiplier", constants.whiteLevelMultiplier));
+		break;
+
+	default:
+		break;
+	}
+
+	m_ctx->DrawImage(d2dEffect);
+	return true;
+}
+
+bool D2DCanvas::DrawImage(const std::wstring& filename)
+{
+	auto it = m_images.find(filename);
+	if (it == m_images.end())
+		return false;
+
+	// Center the image, draw at 1.0x (pixel) zoom.
+	auto targetSize = m_deviceResources->GetOutputSize();
+	unsigned int width, height;
+	DX::ThrowIfFailed(it->second.wicSource->GetSize(&width, &height));
+
+	float dX = (targetSize.right - targetSize.left - static_cast<float>(width)) / 2.0f;
+	float dY = (targetSize.bottom - targetSize.top - static_cast<float>(height)) / 2.0f;
+
+	m_ctx->DrawImage(it->second.d2dSource.Get(), D2D1::Point2F(dX, dY));
+	return true;
+}
@@ -0,0 +1,77 @@
+//
+// D2DCanvas.h
+//
+// PatternCanvas on the app's D2D device context.  Owns the text formats, the custom
+// effect instances, the decoded test images and the brushes (BrushCache); everything is
+// created on the current device, so the canvas is rebuilt when the device is lost.
+//
+
+#pragma once
+
+#include <map>
+#include "BrushCache.h"
+#include "DeviceResources.h"
+#include "PatternCanvas.h"
+
+// Creates the brushes BrushCache holds, on the canvas's device context.
+struct D2DBrushDevice
+{
+	typedef Microsoft::WRL::ComPtr<ID2D1SolidColorBrush>		SolidBrush;
+	typedef Microsoft::WRL::ComPtr<ID2D1LinearGradientBrush>	GradientBrush;
+
+	SolidBrush CreateSolidBrush(const ColorF& color);
+	// precision is a D2D1_BUFFER_PRECISION.
+	GradientBrush CreateGradientBrush(const GradientStop* stops, size_t count, uint32_t precision);
+
+	ID2D1DeviceContext2* ctx;
+};
+
+class D2DCanvas : public PatternCanvas
+{
+public:
+	D2DCanvas(DX::DeviceResources* deviceResources);
+
+	// A missing file leaves the image or effect unavailable, so DrawImage()/DrawEffect()
+	// return false for it; any other failure throws.
+	void LoadImageResource(const std::wstring& filename);
+	void LoadEffectResource(PatternEffect effect);
+
+	// Drops every cached brush.  Gradients depend on the back buffer precision, so this
+	// is called whenever the swap chain is resized or changes format.
+	void ClearBrushCache();
+	const BrushCacheStats& GetBrushCacheStats() const { return m_brushes.GetStats(); }
+
+	virtual RectF GetLogicalSize() const override;
+	virtual RectF GetOutputSize() const override;
+	virtual float GetDpi() const override;
+
+	virtual void FillRectangle(const RectF& rect, const ColorF& color) override;
+	virtual void DrawRectangle(const RectF& rect, const ColorF& color, float strokeWidth = 1.0f) override;
+	virtual void DrawEllipse(const EllipseF& ellipse, const ColorF& color, float strokeWidth = 1.0f) override;
+	virtual void FillLinearGradient(const RectF& rect, PointF start, PointF end,
+									const GradientStop* stops, size_t count) override;
+	virtual void DrawString(const std::wstring& text, TextStyle style, const RectF& textPos, const ColorF& color) override;
+	virtual bool DrawEffect(PatternEffect effect, const EffectConstants& constants) override;
+	virtual bool DrawImage(const std::wstring& filename) override;
+
+private:
+	struct ImageResource
+	{
+		Microsoft::WRL::ComPtr<IWICBitmapSource>		wicSource;		// FP16 premultiplied RGBA
+		Microsoft::WRL::ComPtr<ID2D1ImageSourceFromWic>	d2dSource;
+	};
+
+	ID2D1SolidColorBrush* GetBrush(const ColorF& color);
+	IDWriteTextFormat* GetTextFormat(TextStyle style) const;
+
+	DX::DeviceResources*									m_deviceResources;
+	ID2D1DeviceContext2*									m_ctx;
+
+	Microsoft::WRL::ComPtr<IDWriteTextFormat>				m_smallFormat;
+	Microsoft::WRL::ComPtr<IDWriteTextFormat>				m_largeFormat;
+	Microsoft::WRL::ComPtr<IDWriteTextFormat>				m_monospaceFormat;
+
+	std::map<std::wstring, ImageResource>					m_images;
+	std::map<PatternEffect, Microsoft::WRL::ComPtr<ID2D1Effect>>	m_effects;
+	BrushCache<D2DBrushDevice>								m_brushes;
+};
@@ -0,0 +1,221 @@
+//
+// DisplayList.cpp
+//
+
+#include "DisplayList.h"
+
+namespace
+{
+	RectF Offset(const RectF& rect, PointF offset)
+	{
+		return RectF(rect.left + offset.x, rect.top + offset.y, rect.right + offset.x, rect.bottom + offset.y);
+	}
+}
+
+DisplayList::DisplayList() :
+	m_target(nullptr),
+	m_offset(0.0f, 0.0f)
+{
+}
+
+void DisplayList::Record(PatternCanvas* target)
+{
+	Clear();
+	m_target = target;
+	m_offset = PointF(0.0f, 0.0f);
+}
+
+void DisplayList::EndRecord()
+{
+	m_target = nullptr;
+}
+
+void DisplayList::Clear()
+{
+	m_commands.clear();
+	m_strings.clear();
+	m_points.clear();
+	m_stops.clear();
+	m_constants.clear();
+}
+
+void DisplayList::Replay(PatternCanvas* target, const JitterSource& jitter) const
+{
+	PointF offset(0.0f, 0.0f);
+	for (auto& command : m_commands)
+	{
+		if (command.op == Op::BeginJitter)
+			offset = jitter ? jitter(command.arg != 0) : PointF(0.0f, 0.0f);
+		else if (command.op == Op::EndJitter)
+			offset = PointF(0.0f, 0.0f);
+		else
+			Execute(target, command, offset);
+	}
+}
+
+void DisplayList::BeginJitter(bool enabled, PointF offset)
+{
+	Command command = {};
+	command.op = Op::BeginJitter;
+	command.arg = enabled;
+	Add(command);
+	m_offset = offset;
+}
+
+void DisplayList::EndJitter()
+{
+	Command command = {};
+	command.op = Op::EndJitter;
+	Add(command);
+	m_offset = PointF(0.0f, 0.0f);
+}
+
+RectF DisplayList::GetLogicalSize() const
+{
+	return m_target ? m_target->GetLogicalSize() : RectF(0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+RectF DisplayList::GetOutputSize() const
+{
+	return m_target ? m_target->GetOutputSize() : RectF(0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+float DisplayList::GetDpi() const
+{
+	return m_target ? m_target->GetDpi() : 96.0f;
+}
+
+void DisplayList::FillRectangle(const RectF& rect, const ColorF& color)
+{
+	Command command = {};
+	command.op = Op::FillRectangle;
+	command.rect = rect;
+	command.color = color;
+	Add(command);
+}
+
+void DisplayList::DrawRectangle(const RectF& rect, const ColorF& color, float strokeWidth)
+{
+	Command command = {};
+	command.op = Op::DrawRectangle;
+	command.rect = rect;
+	command.color = color;
+	command.strokeWidth = strokeWidth;
+	Add(command);
+}
+
+void DisplayList::DrawEllipse(const EllipseF& ellipse, const ColorF& color, float strokeWidth)
+{
+	Command command = {};
+	command.op = Op::DrawEllipse;
+	command.rect = RectF(ellipse.point.x, ellipse.point.y, ellipse.radiusX, ellipse.radiusY);
+	command.color = color;
+	command.strokeWidth = strokeWidth;
+	Add(command);
+}
+
+void DisplayList::FillLinearGradient(const RectF& rect, PointF start, PointF end,
+									 const GradientStop* stops, size_t count)
+{
+	Command command = {};
+	command.op = Op::FillLinearGradient;
+	command.rect = rect;
+	command.index = (uint32_t)m_points.size();
+	command.index2 = (uint32_t)m_stops.size();
+	command.count = (uint32_t)count;
+	m_points.push_back(start);
+	m_points.push_back(end);
+	m_stops.insert(m_stops.end(), stops, stops + count);
+	Add(command);
+}
+
+void DisplayList::DrawString(const std::wstring& text, TextStyle style, const RectF& textPos, const ColorF& color)
+{
+	Command command = {};
+	command.op = Op::DrawString;
+	command.arg = (uint8_t)style;
+	command.index = (uint32_t)m_strings.size();
+	command.rect = textPos;
+	command.color = color;
+	m_strings.push_back(text);
+	Add(command);
+}
+
+bool DisplayList::DrawEffect(PatternEffect effect, const EffectConstants& constants)
+{
+	Command command = {};
+	command.op = Op::DrawEffect;
+	command.arg = (uint8_t)effect;
+	command.index = (uint32_t)m_constants.size();
+	m_constants.push_back(constants);
+	m_commands.push_back(command);
+	return m_target ? Execute(m_target, command, m_offset) : true;
+}
+
+bool DisplayList::DrawImage(const std::wstring& filename)
+{
+	Command command = {};
+	command.op = Op::DrawImage;
+	command.index = (uint32_t)m_strings.size();
+	m_strings.push_back(filename);
+	m_commands.push_back(command);
+	return m_target ? Execute(m_target, command, m_offset) : true;
+}
+
+void DisplayList::Add(const Command& command)
+{
+	m_commands.push_back(command);
+	if (m_target)
+		Execute(m_target, command, m_offset);
+}
+
+// Effects and images cover the target and are not moved by jitter.
+bool DisplayList::Execute(PatternCanvas* target, const Command& command, PointF offset) const
+{
+	switch (command.op)
+	{
+	case Op::FillRectangle:
+		target->FillRectangle(Offset(command.rect, offset), command.color);
+		break;
+	case Op::DrawRectangle:
+		target->DrawRectangle(Offset(command.rect, offset), command.color, command.strokeWidth);
+		break;
+	case Op::DrawEllipse:
+	{
+		EllipseF ellipse =
+		{
+			PointF(command.rect.left + offset.x, command.rect.top + offset.y),
+			command.rect.right,
+			command.rect.bottom
+		};
+		target->DrawEllipse(ellipse, command.color, command.strokeWidth);
+		break;
+	}
+	case Op::FillLinearGradient:
+	{
+		PointF start = m_points[command.index];
+		PointF end = m_points[command.index + 1];
+		target->FillLinearGradient(Offset(command.rect, offset),
+								   PointF(start.x + offset.x, start.y + offset.y),
+								   PointF(end.x + offset.x, end.y + offset.y),
+								   m_stops.data() + command.index2, command.count);
+		break;
+	}
+	case Op::DrawString:
+	{
+		// { left, top, width, height }: only the origin moves.
+		RectF textPos = command.rect;
+		textPos.left += offset.x;
+		textPos.top += offset.y;
+		target->DrawString(m_strings[command.index], (TextStyle)command.arg, textPos, command.color);
+		break;
+	}
+	case Op::DrawEffect:
+		return target->DrawEffect((PatternEffect)command.arg, m_constants[command.index]);
+	case Op::DrawImage:
+		return target->DrawImage(m_strings[command.index]);
+	default:
+		break;
+	}
+	return true;
+}
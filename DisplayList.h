@@ -0,0 +1,103 @@
+//
+// DisplayList.h
+//
+// A PatternCanvas that records the calls a test pattern makes so the frame can be drawn
+// again without running the pattern code: no string formatting, color math or brush
+// setup, just the primitives.  Most patterns are held unchanged for minutes while they
+// are measured, so TestPatterns records a frame once and replays it until a key press,
+// a resize or a new output description makes it stale.
+//
+// Recording draws through to the target as it goes, so the frame being recorded is
+// presented too and DrawEffect()/DrawImage() report what the target really has.
+// Replay() issues the same calls in the same order.
+//
+// A few patterns move their patch by a random offset every frame to spread burn-in.  The
+// calls between BeginJitter() and EndJitter() are recorded without that offset and moved
+// by a fresh one, from the caller's JitterSource, each time they are drawn.
+//
+
+#pragma once
+
+#include <functional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "PatternCanvas.h"
+
+class DisplayList : public PatternCanvas
+{
+public:
+	// Returns the offset for one jittered group; enabled is what BeginJitter() was given.
+	typedef std::function<PointF(bool enabled)> JitterSource;
+
+	DisplayList();
+
+	// Drops the recorded calls and starts recording onto target.
+	void Record(PatternCanvas* target);
+	void EndRecord();
+	bool IsRecording() const { return m_target != nullptr; }
+
+	void Clear();
+	bool IsEmpty() const { return m_commands.empty(); }
+	size_t GetCommandCount() const { return m_commands.size(); }
+
+	// Draws the recorded calls on target.
+	void Replay(PatternCanvas* target, const JitterSource& jitter) const;
+
+	// While recording: the calls up to EndJitter() are moved by offset now, and by
+	// jitter(enabled) on every replay.
+	void BeginJitter(bool enabled, PointF offset);
+	void EndJitter();
+
+	// Sizes are the target's.
+	virtual RectF GetLogicalSize() const override;
+	virtual RectF GetOutputSize() const override;
+	virtual float GetDpi() const override;
+
+	virtual void FillRectangle(const RectF& rect, const ColorF& color) override;
+	virtual void DrawRectangle(const RectF& rect, const ColorF& color, float strokeWidth = 1.0f) override;
+	virtual void DrawEllipse(const EllipseF& ellipse, const ColorF& color, float strokeWidth = 1.0f) override;
+	virtual void FillLinearGradient(const RectF& rect, PointF start, PointF end,
+									const GradientStop* stops, size_t count) override;
+	virtual void DrawString(const std::wstring& text, TextStyle style, const RectF& textPos, const ColorF& color) override;
+	virtual bool DrawEffect(PatternEffect effect, const EffectConstants& constants) override;
+	virtual bool DrawImage(const std::wstring& filename) override;
+
+private:
+	enum class Op : uint8_t
+	{
+		FillRectangle,
+		DrawRectangle,
+		DrawEllipse,			// rect is { center.x, center.y, radiusX, radiusY }
+		FillLinearGradient,		// start and end in m_points[index], stops in m_stops[index2]
+		DrawString,				// text in m_strings[index]
+		DrawEffect,				// constants in m_constants[index]
+		DrawImage,				// filename in m_strings[index]
+		BeginJitter,
+		EndJitter,
+	};
+
+	struct Command
+	{
+		Op       op;
+		uint8_t  arg;			// TextStyle, PatternEffect, or jitter enabled
+		uint32_t index;
+		uint32_t index2;
+		uint32_t count;
+		float    strokeWidth;
+		RectF    rect;
+		ColorF   color;
+	};
+
+	void Add(const Command& command);
+	bool Execute(PatternCanvas* target, const Command& command, PointF offset) const;
+
+	std::vector<Command>         m_commands;
+	std::vector<std::wstring>    m_strings;
+	std::vector<PointF>          m_points;
+	std::vector<GradientStop>    m_stops;
+	std::vector<EffectConstants> m_constants;
+
+	PatternCanvas*               m_target;			// while recording
+	PointF                       m_offset;			// of the open jitter group while recording
+};
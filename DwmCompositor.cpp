@@ -0,0 +1,324 @@
+//
+// DwmCompositor.cpp
+//
+// Tiled multi-surface composition into CCCS.  See DwmCompositor.h.
+//
+
+#include "DwmCompositor.h"
+#include "SimdMath.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace simd;
+
+namespace
+{
+	const int TileSize  = Image::TileSize;
+	const int SpanRows  = 16;			// rows per work item
+	const int SpanTiles = 16;			// most dirty tiles side by side in one
+
+	PixelRect Intersect(const PixelRect& a, const PixelRect& b)
+	{
+		PixelRect r = { std::max(a.left, b.left), std::max(a.top, b.top),
+						std::min(a.right, b.right), std::min(a.bottom, b.bottom) };
+		return r;
+	}
+
+	bool IsEmpty(const PixelRect& r)
+	{
+		return r.left >= r.right || r.top >= r.bottom;
+	}
+
+	bool Contains(const PixelRect& outer, const PixelRect& inner)
+	{
+		return outer.left <= inner.left && outer.top <= inner.top && outer.right >= inner.right && outer.bottom >= inner.bottom;
+	}
+
+	bool IsOpaque(const CompositionLayer& layer)
+	{
+		return layer.alphaMode == LayerAlphaMode::Ignore && layer.opacity >= 1.0f;
+	}
+
+	// The part of planes at (x, y), width by height.
+	PlanarBuffer SubPlanes(const PlanarBuffer& planes, int32_t x, int32_t y, int32_t width, int32_t height)
+	{
+		size_t offset = (size_t)y * planes.stride + x;
+		PlanarBuffer sub = { planes.r + offset, planes.g + offset, planes.b + offset, (uint32_t)width, (uint32_t)height,
+							 planes.stride, planes.a ? planes.a + offset : nullptr };
+		return sub;
+	}
+
+	ImageBuffer SubImage(const ImageBuffer& image, int32_t x, int32_t y, int32_t width, int32_t height)
+	{
+		ImageBuffer sub = { (uint8_t*)image.data + (size_t)y * image.pitch + (size_t)x * ImageFormatSize(image.format),
+							(uint32_t)width, (uint32_t)height, image.pitch, image.format };
+		return sub;
+	}
+
+	// dst = src * s + dst * (1 - k), where k is the layer's coverage, alpha times opacity,
+	// and s is k for straight alpha and the opacity alone for premultiplied.
+	void Blend(const PlanarBuffer& src, const PlanarBuffer& dst, LayerAlphaMode mode, float opacity)
+	{
+		bool alpha = mode != LayerAlphaMode::Ignore;
+		bool straight = mode == LayerAlphaMode::Straight;
+		vfloat vopacity = opacity;
+		for (uint32_t y = 0; y < src.height; y++)
+		{
+			size_t s = y * src.stride, d = y * dst.stride;
+			uint32_t x = 0;
+			for (; x + width <= src.width; x += width)
+			{
+				vfloat k = alpha ? load(src.a + s + x) * vopacity : vopacity;
+				vfloat scale = straight ? k : vopacity;
+				vfloat keep = vfloat(1.0f) - k;
+				store(dst.r + d + x, load(src.r + s + x) * scale + load(dst.r + d + x) * keep);
+				store(dst.g + d + x, load(src.g + s + x) * scale + load(dst.g + d + x) * keep);
+				store(dst.b + d + x, load(src.b + s + x) * scale + load(dst.b + d + x) * keep);
+			}
+			for (; x < src.width; x++)
+			{
+				float k = alpha ? src.a[s + x] * opacity : opacity;
+				float scale = straight ? k : opacity;
+				dst.r[d + x] = src.r[s + x] * scale + dst.r[d + x] * (1.0f - k);
+				dst.g[d + x] = src.g[s + x] * scale + dst.g[d + x] * (1.0f - k);
+				dst.b[d + x] = src.b[s + x] * scale + dst.b[d + x] * (1.0f - k);
+			}
+		}
+	}
+}
+
+CompositionLayer MakeCompositionLayer(const ImageBuffer& surface, SwapChainColorSpace colorSpace, int32_t x, int32_t y)
+{
+	CompositionLayer layer;
+	layer.surface = surface;
+	layer.colorSpace = colorSpace;
+	layer.x = x;
+	layer.y = y;
+	layer.sdrWhiteLevel = 80.0f * defaultSDRBoost;
+	layer.alphaMode = LayerAlphaMode::Ignore;
+	layer.opacity = 1.0f;
+	return layer;
+}
+
+DwmCompositor::DwmCompositor(uint32_t width, uint32_t height, ThreadPool* pool) :
+	m_dirty((size_t)((width + TileSize - 1) / TileSize) * ((height + TileSize - 1) / TileSize), 1),
+	m_columns((width + TileSize - 1) / TileSize),
+	m_background(0.0f, 0.0f, 0.0f),
+	m_display(GPU_GetDisplaySteps(true, 1.0f)),
+	m_lastWire(nullptr),
+	m_frame(width, height, pool),
+	m_pool(pool ? pool : &ThreadPool::Default()),
+	m_stats()
+{
+}
+
+#pragma region Layers
+
+bool DwmCompositor::AddLayer(const CompositionLayer& layer)
+{
+	Layer entry = {};
+	entry.layer = layer;
+	if (!DWM_GetPresentSteps(layer.surface.format, layer.colorSpace, layer.sdrWhiteLevel / 80.0f, entry.steps))
+		return false;
+	m_layers.push_back(entry);
+	MarkDirty(GetRect(entry));
+	return true;
+}
+
+bool DwmCompositor::SetLayer(size_t index, const CompositionLayer& layer)
+{
+	Layer entry = {};
+	entry.layer = layer;
+	if (index >= m_layers.size() ||
+		!DWM_GetPresentSteps(layer.surface.format, layer.colorSpace, layer.sdrWhiteLevel / 80.0f, entry.steps))
+		return false;
+	MarkDirty(GetRect(m_layers[index]));
+	m_layers[index] = entry;
+	MarkDirty(GetRect(entry));
+	return true;
+}
+
+void DwmCompositor::RemoveLayer(size_t index)
+{
+	if (index >= m_layers.size())
+		return;
+	MarkDirty(GetRect(m_layers[index]));
+	m_layers.erase(m_layers.begin() + index);
+}
+
+void DwmCompositor::Invalidate(size_t index, const PixelRect& dirty)
+{
+	if (index >= m_layers.size())
+		return;
+	const CompositionLayer& layer = m_layers[index].layer;
+	PixelRect surface = { 0, 0, (int32_t)layer.surface.width, (int32_t)layer.surface.height };
+	PixelRect rect = Intersect(dirty, surface);
+	PixelRect desktop = { rect.left + layer.x, rect.top + layer.y, rect.right + layer.x, rect.bottom + layer.y };
+	MarkDirty(desktop);
+}
+
+void DwmCompositor::Invalidate(size_t index)
+{
+	if (index < m_layers.size())
+		MarkDirty(GetRect(m_layers[index]));
+}
+
+void DwmCompositor::InvalidateAll()
+{
+	std::fill(m_dirty.begin(), m_dirty.end(), (uint8_t)1);
+}
+
+void DwmCompositor::SetBackground(float3 color)
+{
+	m_background = color;
+	InvalidateAll();
+}
+
+void DwmCompositor::SetOutput(bool hdr, float brightnessFactor)
+{
+	m_display = GPU_GetDisplaySteps(hdr, brightnessFactor);
+	InvalidateAll();
+}
+
+size_t DwmCompositor::GetDirtyTileCount() const
+{
+	return (size_t)std::count(m_dirty.begin(), m_dirty.end(), (uint8_t)1);
+}
+
+PixelRect DwmCompositor::GetRect(const Layer& entry) const
+{
+	const CompositionLayer& layer = entry.layer;
+	PixelRect rect = { layer.x, layer.y, layer.x + (int32_t)layer.surface.width, layer.y + (int32_t)layer.surface.height };
+	return rect;
+}
+
+void DwmCompositor::MarkDirty(const PixelRect& rect)
+{
+	PixelRect desktop = { 0, 0, (int32_t)GetWidth(), (int32_t)GetHeight() };
+	PixelRect clipped = Intersect(rect, desktop);
+	if (IsEmpty(clipped))
+		return;
+
+	for (int32_t ty = clipped.top / TileSize; ty <= (clipped.bottom - 1) / TileSize; ty++)
+		for (int32_t tx = clipped.left / TileSize; tx <= (clipped.right - 1) / TileSize; tx++)
+			m_dirty[(size_t)ty * m_columns + tx] = 1;
+}
+
+#pragma endregion
+
+#pragma region Composition
+
+int DwmCompositor::Compose(const ImageBuffer& wire)
+{
+	if (wire.data && (wire.format != ImageFormat::R10G10B10A2_UNORM || wire.width != GetWidth() || wire.height != GetHeight()))
+		return -1;
+	if (wire.data != m_lastWire)
+		InvalidateAll();
+	m_lastWire = wire.data;
+
+	// Runs of dirty tiles in a tile row, cut into strips of SpanRows.  A 64x64 tile of a
+	// 4K frame spans 64 rows of four planes 15 KB apart, which the caches and TLB handle
+	// far worse than a short, wide strip.
+	std::vector<PixelRect> spans;
+	int32_t frameWidth = (int32_t)GetWidth(), frameHeight = (int32_t)GetHeight();
+	size_t tiles = 0;
+	for (size_t row = 0; row < m_dirty.size() / m_columns; row++)
+	{
+		const uint8_t* dirty = &m_dirty[row * m_columns];
+		for (uint32_t first = 0; first < m_columns; )
+		{
+			if (!dirty[first])
+			{
+				first++;
+				continue;
+			}
+			uint32_t last = first + 1;
+			while (last < m_columns && dirty[last] && last - first < SpanTiles)
+				last++;
+			tiles += last - first;
+
+			int32_t top = (int32_t)row * TileSize, bottom = std::min(top + TileSize, frameHeight);
+			for (int32_t y = top; y < bottom; y += SpanRows)
+			{
+				PixelRect span = { (int32_t)first * TileSize, y, std::min((int32_t)last * TileSize, frameWidth), std::min(y + SpanRows, bottom) };
+				spans.push_back(span);
+			}
+			first = last;
+		}
+	}
+
+	PlanarBuffer frame = m_frame.GetPlanes();
+	std::atomic<uint64_t> passes(0), occluded(0);
+	m_pool->ParallelFor(0, spans.size(), [&](size_t i)
+	{
+		bool skipped = false;
+		passes += ComposeSpan(spans[i], frame, wire, &skipped);
+		if (skipped)
+			occluded++;
+	});
+
+	std::fill(m_dirty.begin(), m_dirty.end(), (uint8_t)0);
+	m_stats.frames++;
+	m_stats.tilesComposed += tiles;
+	m_stats.layerPasses += passes;
+	m_stats.spansOccluded += occluded;
+	return (int)tiles;
+}
+
+// Starts at the topmost opaque layer that covers the whole span, or the background, and
+// blends each layer above it over what is there.  An opaque layer converts straight into
+// the frame; others through a scratch span that keeps their alpha.
+size_t DwmCompositor::ComposeSpan(const PixelRect& span, const PlanarBuffer& frame, const ImageBuffer& wire, bool* occluded)
+{
+	PlanarBuffer out = SubPlanes(frame, span.left, span.top, span.right - span.left, span.bottom - span.top);
+
+	size_t base = m_layers.size();
+	while (base > 0 && !(IsOpaque(m_layers[base - 1].layer) && Contains(GetRect(m_layers[base - 1]), span)))
+		base--;
+	if (base > 0)
+		base--;
+	else
+	{
+		for (uint32_t row = 0; row < out.height; row++)
+		{
+			std::fill(out.r + row * out.stride, out.r + row * out.stride + out.width, m_background.x);
+			std::fill(out.g + row * out.stride, out.g + row * out.stride + out.width, m_background.y);
+			std::fill(out.b + row * out.stride, out.b + row * out.stride + out.width, m_background.z);
+		}
+	}
+	*occluded = base > 0;
+
+	std::vector<float> scratch;
+	size_t passes = 0;
+	for (size_t i = base; i < m_layers.size(); i++)
+	{
+		const Layer& entry = m_layers[i];
+		PixelRect part = Intersect(GetRect(entry), span);
+		if (IsEmpty(part) || entry.layer.opacity <= 0.0f)
+			continue;
+
+		int32_t w = part.right - part.left, h = part.bottom - part.top;
+		ImageBuffer src = SubImage(entry.layer.surface, part.left - entry.layer.x, part.top - entry.layer.y, w, h);
+		PlanarBuffer dst = SubPlanes(frame, part.left, part.top, w, h);
+		if (IsOpaque(entry.layer))
+			entry.steps.Convert(src, dst, m_pool);
+		else
+		{
+			size_t plane = (size_t)w * h;
+			scratch.resize(4 * plane);
+			float* p = scratch.data();
+			PlanarBuffer layer = { p, p + plane, p + 2 * plane, (uint32_t)w, (uint32_t)h, (size_t)w, p + 3 * plane };
+			entry.steps.Convert(src, layer, m_pool);
+			Blend(layer, dst, entry.layer.alphaMode, std::min(entry.layer.opacity, 1.0f));
+		}
+		passes++;
+	}
+
+	if (wire.data)
+		m_display.Convert(out, SubImage(wire, span.left, span.top, out.width, out.height), m_pool);
+	return passes;
+}
+
+#pragma endregion
@@ -0,0 +1,139 @@
+//
+// DwmCompositor.h
+//
+// A model of DWM composing several surfaces at once: swap chains and SDR windows, each
+// in its own format and DXGI color space, placed on the desktop and stacked bottom to
+// top.  Every layer is linearized into CCCS with the steps of DWM_Present()
+// (AdvancedColorPipeline.h), SDR layers at their own SDR white level, then blended over
+// the layers below it in linear light, and the display engine steps of GPU_Display()
+// encode the result for the link.  With an SDR desktop at 240 nits and an HDR10 window
+// at the panel peak, this is FullFrameSDRWhiteWithHDR as the OS composes it.
+//
+// The desktop is cut into 64x64 tiles, and only dirty tiles are recomposed: those under
+// the dirty rectangles of a present, or under a layer that was added, moved, removed or
+// changed.  A static desktop with a small animated window therefore costs the window's
+// tiles per frame, not the screen.  Dirty tiles are composed in parallel, as strips of
+// up to 16 neighbouring tiles by 16 rows.  Each strip starts from the topmost opaque
+// layer that covers it, and runs each layer's fused converter only over the part of the
+// layer inside it.
+//
+// Surfaces are not scaled (DXGI_SCALING_NONE): a layer covers its surface's size from
+// its position, clipped to the desktop.  Surfaces are read in place and must stay valid
+// while they are layers.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "AdvancedColorPipeline.h"
+#include "ImageConvert.h"
+
+class ThreadPool;
+
+// As DXGI_ALPHA_MODE.  Alpha blends in linear CCCS.
+enum class LayerAlphaMode
+{
+	Ignore,						// opaque
+	Straight,
+	Premultiplied,
+};
+
+// Pixels, right and bottom exclusive, as a RECT.
+struct PixelRect
+{
+	int32_t left;
+	int32_t top;
+	int32_t right;
+	int32_t bottom;
+};
+
+struct CompositionLayer
+{
+	ImageBuffer         surface;				// swap chain back buffer or window surface
+	SwapChainColorSpace colorSpace;
+	int32_t             x;						// surface's top left on the desktop
+	int32_t             y;
+	float               sdrWhiteLevel;			// in nits, for the SDR color spaces (80 * SDR boost)
+	LayerAlphaMode      alphaMode;
+	float               opacity;				// 0 to 1, on top of alpha
+};
+
+// An opaque layer at (x, y), at the default SDR boost.
+CompositionLayer MakeCompositionLayer(const ImageBuffer& surface, SwapChainColorSpace colorSpace,
+									  int32_t x = 0, int32_t y = 0);
+
+struct CompositorStats
+{
+	uint64_t frames;
+	uint64_t tilesComposed;
+	uint64_t layerPasses;			// a layer's converter run on a strip
+	uint64_t spansOccluded;			// strips that skipped layers below an opaque one
+};
+
+class DwmCompositor
+{
+public:
+	// A black desktop.  pool == nullptr uses ThreadPool::Default().
+	DwmCompositor(uint32_t width, uint32_t height, ThreadPool* pool = nullptr);
+
+	uint32_t GetWidth() const { return m_frame.GetWidth(); }
+	uint32_t GetHeight() const { return m_frame.GetHeight(); }
+
+	// The layer stack, bottom first; a layer's index is its place in it.  AddLayer() and
+	// SetLayer() return false, changing nothing, for a format and color space DWM does
+	// not take.
+	bool AddLayer(const CompositionLayer& layer);
+	bool SetLayer(size_t index, const CompositionLayer& layer);
+	void RemoveLayer(size_t index);
+	size_t GetLayerCount() const { return m_layers.size(); }
+	const CompositionLayer& GetLayer(size_t index) const { return m_layers[index].layer; }
+
+	// The app presented new pixels in dirty, in surface coordinates, as the dirty
+	// rectangles of IDXGISwapChain1::Present1; without one, in the whole surface.
+	void Invalidate(size_t index, const PixelRect& dirty);
+	void Invalidate(size_t index);
+	void InvalidateAll();
+
+	// Desktop color under the layers, in CCCS.
+	void SetBackground(float3 color);
+
+	// Link mode and SDR brightness of the display engine, as GPU_Display().
+	void SetOutput(bool hdr, float brightnessFactor);
+
+	// Recomposes the dirty tiles into the frame, and encodes them into wire, which must be
+	// R10G10B10A2_UNORM of the desktop size, or have null data to compose the frame only.
+	// Tiles that are not dirty are not written, so wire must hold the last frame sent to
+	// it; a different buffer than last time gets every tile.  Returns the number of tiles
+	// composed, or -1 for a wire buffer of the wrong size or format.
+	int Compose(const ImageBuffer& wire);
+
+	// The composed desktop in CCCS, as of the last Compose().  Not to be changed.
+	Image& GetFrame() { return m_frame; }
+
+	size_t GetTileCount() const { return m_dirty.size(); }
+	size_t GetDirtyTileCount() const;
+	const CompositorStats& GetStats() const { return m_stats; }
+
+private:
+	struct Layer
+	{
+		CompositionLayer layer;
+		ImageConverter   steps;			// surface to CCCS
+	};
+
+	void MarkDirty(const PixelRect& rect);				// desktop coordinates
+	PixelRect GetRect(const Layer& layer) const;
+	size_t ComposeSpan(const PixelRect& span, const PlanarBuffer& frame, const ImageBuffer& wire, bool* occluded);
+
+	std::vector<Layer>   m_layers;
+	std::vector<uint8_t> m_dirty;			// per tile
+	uint32_t             m_columns;
+	float3               m_background;
+	ImageConverter       m_display;			// CCCS to the link
+	const void*          m_lastWire;
+	Image                m_frame;
+	ThreadPool*          m_pool;
+	CompositorStats      m_stats;
+};
@@ -0,0 +1,496 @@
+//
+// EffectKernels.cpp
+//
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+#include "ColorSpaces.h"
+#include "CpuCanvas.h"
+#include "EffectKernels.h"
+#include "SimdMath.h"
+#include "ThreadPool.h"
+#include "TransferBatch.h"
+
+using namespace simd;
+
+namespace
+{
+	const uint32_t BandRows = 16;		// rows per ParallelFor index
+
+	// Runs rowFn(y) for every row, in bands across the pool.
+	template <class RowFn>
+	void RenderBands(uint32_t height, ThreadPool* pool, RowFn rowFn)
+	{
+		if (!pool)
+			pool = &ThreadPool::Default();
+
+		uint32_t bands = (height + BandRows - 1) / BandRows;
+		pool->ParallelFor(0, bands, [&](size_t band)
+		{
+			uint32_t end = std::min(height, (uint32_t)(band + 1) * BandRows);
+			for (uint32_t y = (uint32_t)band * BandRows; y < end; y++)
+				rowFn((int)y);
+		});
+	}
+
+	// Stores kernel(px) for count pixels starting at column x, px holding the pixel
+	// centers of one vector.  The ragged tail goes through a padded block.
+	template <class Kernel>
+	inline void StoreRow(int x, size_t count, float* out, Kernel kernel)
+	{
+		vfloat px = vfloat(x + 0.5f) + ramp();
+		size_t i = 0;
+		for (; i + width <= count; i += width, px = px + vfloat((float)width))
+			store(out + i, kernel(px));
+
+		if (i < count)
+		{
+			float tmp[width];
+			store(tmp, kernel(px));
+			memcpy(out + i, tmp, (count - i) * sizeof(float));
+		}
+	}
+
+	// Gray kernels fill r and copy it to g and b.
+	inline void CopyGray(const CpuTile& tile)
+	{
+		for (int y = 0; y < tile.height; y++)
+		{
+			const float* r = tile.r + y * tile.stride;
+			memcpy(tile.g + y * tile.stride, r, tile.width * sizeof(float));
+			memcpy(tile.b + y * tile.stride, r, tile.width * sizeof(float));
+		}
+	}
+}
+
+#pragma region SineSweep
+
+void SineSweepRow(const SineSweepConstants& constants, int x, int y, size_t count, float* out)
+{
+	const float PI = 3.141592653589f;
+	vfloat cx = constants.center[0];
+	vfloat dy = vfloat(y + 0.5f - constants.center[1]);
+	vfloat dy2 = dy * dy;
+	vfloat invHalving = 1.0f / constants.wavelengthHalvingDistance;
+	vfloat invWavelength = 1.0f / constants.initialWavelength;
+	vfloat white = constants.whiteLevelMultiplier;
+
+	// Same order of operations as the shader, so the float rounding of the sine argument
+	// (which dominates the error far from the center) matches it.
+	auto kernel = [&](vfloat px)
+	{
+		vfloat dx = px - cx;
+		vfloat dist = sqrt(dx * dx + dy2);
+		vfloat multiplier = exp2(dist * invHalving);
+		vfloat val = sin(invWavelength * dist * vfloat(2.0f) * vfloat(PI) * multiplier);
+		val = (val + vfloat(1.0f)) * vfloat(0.5f);
+		val = pow(val, vfloat(2.2f));
+		return val * white;
+	};
+
+	StoreRow(x, count, out, kernel);
+}
+
+void RenderSineSweep(const SineSweepConstants& constants, float* out, uint32_t width, uint32_t height,
+					 size_t stride, ThreadPool* pool)
+{
+	RenderBands(height, pool, [&](int y)
+	{
+		SineSweepRow(constants, 0, y, width, out + y * stride);
+	});
+}
+
+void SineSweepKernel(const EffectConstants& constants, const CpuTile& tile)
+{
+	SineSweepConstants c = {};
+	c.dpi = 96.0f;
+	c.center[0] = constants.center.x;
+	c.center[1] = constants.center.y;
+	c.initialWavelength = constants.initialWavelength;
+	c.wavelengthHalvingDistance = constants.wavelengthHalvingDistance;
+	c.whiteLevelMultiplier = constants.whiteLevelMultiplier;
+
+	for (int y = 0; y < tile.height; y++)
+		SineSweepRow(c, tile.x, tile.y + y, tile.width, tile.r + y * tile.stride);
+	CopyGray(tile);
+}
+
+#pragma endregion
+
+#pragma region ToneSpike
+
+void ToneSpikeRow(const ToneSpikeConstants& constants, int x, int y, size_t count, float* r, float* g, float* b)
+{
+	const float PI = 3.141592653589f;
+	float rArea = sqrtf(constants.center[0] * constants.center[1] * 4.0f / PI);
+	vfloat cx = constants.center[0];
+	vfloat dy = vfloat(y + 0.5f - constants.center[1]);
+	vfloat dy2 = dy * dy;
+
+	// PQ signal: a ramp from the perimeter of the equal-area circle up to the center,
+	// 10 codes (8-bit) lower on alternate spokes.
+	StoreRow(x, count, r, [&](vfloat px)
+	{
+		vfloat dx = px - cx;
+		vfloat radius = sqrt(dx * dx + dy2);
+		vfloat theta = atan2(dy, -dx) + vfloat(PI);
+		vfloat v = vfloat(1.12f) * (vfloat(rArea) - radius) / vfloat(rArea);
+		v = select(sin(theta * vfloat(48.0f)) > vfloat(0.0f), v - vfloat(10.f / 255.0f), v);
+		return saturate(v);
+	});
+
+	Remove2084(r, r, count);							// apply EOTF
+
+	// The bottom half is tone mapped to the white level, as a panel would.
+	if (y + 0.5f > constants.center[1])
+	{
+		// p is ContentPeak over DisplayCapability
+		float white = constants.whiteLevelMultiplier;
+		float p = 10000.f / white;
+		float s = p < 1.0f ? p * 0.7f : 1.0f - logf(p) * 0.165f;
+		float m = 1.0f / (p - s);
+		float k = 1.0f / ((p - s) / (1.f - s) - 1.0f);
+
+		ForEach(r, r, count, [&](vfloat v)
+		{
+			v = v * vfloat(10000.f) / vfloat(white);		// normalize by display capability
+
+			// ToneMapProfile(p, v); the unused branches may be inf or NaN when p == 1.
+			vfloat t = vfloat(m) * (v - vfloat(s));
+			vfloat shoulder = t * vfloat(k + 1.0f) / (vfloat(k) + t) * vfloat(1.f - s) + vfloat(s);
+			vfloat mapped = select(v <= vfloat(s), v, shoulder);
+			mapped = select(v > vfloat(p), vfloat(1.0f), mapped);
+
+			return mapped * vfloat(white) / vfloat(10000.f);	// un-normalize back into nits
+		});
+	}
+
+	ForEach(r, r, count, [](vfloat v) { return v * vfloat(10000.0f / 80.0f); });	// for float16 CCCS range
+	ForEach(r, g, count, [](vfloat c) { return c * vfloat(0.5f); });
+	memset(b, 0, count * sizeof(float));
+}
+
+void RenderToneSpike(const ToneSpikeConstants& constants, float* r, float* g, float* b,
+					 uint32_t width, uint32_t height, size_t stride, ThreadPool* pool)
+{
+	RenderBands(height, pool, [&](int y)
+	{
+		ToneSpikeRow(constants, 0, y, width, r + y * stride, g + y * stride, b + y * stride);
+	});
+}
+
+void ToneSpikeKernel(const EffectConstants& constants, const CpuTile& tile)
+{
+	ToneSpikeConstants c = {};
+	c.dpi = 96.0f;
+	c.center[0] = constants.center.x;
+	c.center[1] = constants.center.y;
+	c.initialWavelength = constants.initialWavelength;
+	c.wavelengthHalvingDistance = constants.wavelengthHalvingDistance;
+	c.whiteLevelMultiplier = constants.whiteLevelMultiplier;
+
+	for (int y = 0; y < tile.height; y++)
+	{
+		size_t o = y * tile.stride;
+		ToneSpikeRow(c, tile.x, tile.y + y, tile.width, tile.r + o, tile.g + o, tile.b + o);
+	}
+}
+
+#pragma endregion
+
+#pragma region BandedGradient
+
+const GradientBand ShaderGradientBands[5] =
+{
+	{ 0.0f, 0.2f, GradientQuantizer::Bits6 },
+	{ 0.2f, 0.4f, GradientQuantizer::None },
+	{ 0.4f, 0.6f, GradientQuantizer::Bits8 },
+	{ 0.6f, 0.8f, GradientQuantizer::None },
+	{ 0.8f, 1.0f, GradientQuantizer::Bits10 },
+};
+
+const GradientBand DitheredGradientBands[5] =
+{
+	{ 0.0f, 0.2f, GradientQuantizer::Bits6 },
+	{ 0.2f, 0.4f, GradientQuantizer::Bits6Plus2 },
+	{ 0.4f, 0.6f, GradientQuantizer::Bits8 },
+	{ 0.6f, 0.8f, GradientQuantizer::None },
+	{ 0.8f, 1.0f, GradientQuantizer::Bits10 },
+};
+
+const GradientBand ExtendedGradientBands[7] =
+{
+	{ 0.0f / 7, 1.0f / 7, GradientQuantizer::Bits6 },
+	{ 1.0f / 7, 2.0f / 7, GradientQuantizer::Bits6Plus2 },
+	{ 2.0f / 7, 3.0f / 7, GradientQuantizer::Bits6BlueNoise },
+	{ 3.0f / 7, 4.0f / 7, GradientQuantizer::Bits8 },
+	{ 4.0f / 7, 5.0f / 7, GradientQuantizer::Bits10 },
+	{ 5.0f / 7, 6.0f / 7, GradientQuantizer::Bits12 },
+	{ 6.0f / 7, 7.0f / 7, GradientQuantizer::None },
+};
+
+namespace
+{
+	const int NoiseSize = 64;		// blue-noise tile; a power of two
+	const int Chunk = 64;			// pixels quantized per pass over the outputs
+
+	// Binary pattern on the noise torus with its Gaussian energy field, for
+	// void-and-cluster.  The tightest cluster is the set pixel with the most energy,
+	// the largest void the empty one with the least.
+	struct NoisePattern
+	{
+		std::vector<uint8_t> on;
+		std::vector<float>   energy;
+		const float*         kernel;
+
+		void Toggle(int i)
+		{
+			float sign = on[i] ? -1.0f : 1.0f;
+			on[i] ^= 1;
+			int ix = i % NoiseSize, iy = i / NoiseSize;
+			for (int y = 0; y < NoiseSize; y++)
+			{
+				const float* k = kernel + ((y - iy) & (NoiseSize - 1)) * NoiseSize;
+				float* e = &energy[y * NoiseSize];
+				for (int x = 0; x < NoiseSize; x++)
+					e[x] += sign * k[(x - ix) & (NoiseSize - 1)];
+			}
+		}
+
+		int Find(uint8_t state, bool highest) const
+		{
+			int best = -1;
+			for (int i = 0; i < NoiseSize * NoiseSize; i++)
+			{
+				if (on[i] == state && (best < 0 || (highest ? energy[i] > energy[best] : energy[i] < energy[best])))
+					best = i;
+			}
+			return best;
+		}
+	};
+
+	// 64x64 blue-noise threshold map in (0, 1), by Ulichney's void-and-cluster with a
+	// sigma 1.5 Gaussian.  Deterministic, built on first use.
+	const float* BlueNoise()
+	{
+		static const std::vector<float> noise = []
+		{
+			const int N = NoiseSize * NoiseSize;
+			std::vector<float> kernel(N);
+			for (int y = 0; y < NoiseSize; y++)
+			{
+				for (int x = 0; x < NoiseSize; x++)
+				{
+					int dx = std::min(x, NoiseSize - x), dy = std::min(y, NoiseSize - y);
+					kernel[y * NoiseSize + x] = expf(-(float)(dx * dx + dy * dy) / (2.0f * 1.5f * 1.5f));
+				}
+			}
+
+			// Initial pattern: 10% of the pixels at random, then relaxed by moving the
+			// tightest cluster into the largest void until that no longer changes it.
+			NoisePattern initial = { std::vector<uint8_t>(N, 0), std::vector<float>(N, 0.0f), kernel.data() };
+			uint32_t seed = 12345;
+			int ones = 0;
+			while (ones < N / 10)
+			{
+				seed = seed * 1664525u + 1013904223u;
+				int i = (int)(seed >> 20);
+				if (!initial.on[i])
+				{
+					initial.Toggle(i);
+					ones++;
+				}
+			}
+			for (int iteration = 0; iteration < N; iteration++)
+			{
+				int cluster = initial.Find(1, true);
+				initial.Toggle(cluster);
+				int gap = initial.Find(0, false);
+				initial.Toggle(gap);
+				if (gap == cluster)
+					break;
+			}
+
+			// Ranks below the initial pattern come from removing clusters, those above from
+			// filling voids.  Filling the largest void past half way is the same as taking the
+			// tightest cluster of the inverted pattern, so one loop covers both upper phases.
+			std::vector<float> rank(N);
+			NoisePattern p = initial;
+			for (int r = ones - 1; r >= 0; r--)
+			{
+				int i = p.Find(1, true);
+				p.Toggle(i);
+				rank[i] = (float)r;
+			}
+			p = initial;
+			for (int r = ones; r < N; r++)
+			{
+				int i = p.Find(0, false);
+				p.Toggle(i);
+				rank[i] = (float)r;
+			}
+
+			for (float& t : rank)
+				t = (t + 0.5f) / N;
+			return rank;
+		}();
+		return noise.data();
+	}
+
+	GradientQuantizer RowQuantizer(const BandedGradientConstants& constants, const GradientBand* bands,
+								   size_t bandCount, int y)
+	{
+		float pos = (y + 0.5f) / constants.outputSize[1];
+		for (size_t i = 0; i < bandCount; i++)
+		{
+			if (pos >= bands[i].top && pos < bands[i].bottom)
+				return bands[i].quantizer;
+		}
+		return GradientQuantizer::None;
+	}
+
+	inline vfloat Truncate(vfloat c, float levels)
+	{
+		return floor(c * vfloat(levels)) / vfloat(levels);
+	}
+
+	// Code values of Chunk pixels of row y from column x, the shader's c before its
+	// final pow(c, 2.2).
+	void GradientCodes(const BandedGradientConstants& constants, GradientQuantizer quantizer,
+					   int x, int y, float* code)
+	{
+		const float* noiseRow = BlueNoise() + (y & (NoiseSize - 1)) * NoiseSize;
+		vfloat px = vfloat(x + 0.5f) + ramp();
+		for (int i = 0; i < Chunk; i += width, px = px + vfloat((float)width))
+		{
+			vfloat c = px / vfloat(constants.outputSize[0]);	// gradient from zero to 12.5% on right hand side
+			c = pow(c, vfloat(0.45454f));						// preshape with gamma of 2.2 for now.
+			c = c * vfloat(0.25f);								// use only bottom quarter of range
+
+			switch (quantizer)
+			{
+			case GradientQuantizer::Bits6:
+				c = Truncate(c, 64.0f);
+				break;
+
+			case GradientQuantizer::Bits6Plus2:
+			{
+				// 2x2 ordered dither: 0.75 0.25 on even rows, 0.00 0.50 on odd ones.
+				c = Truncate(c, 256.0f);
+				vmask oddColumn = px - vfloat(2.0f) * floor(px * vfloat(0.5f)) > vfloat(1.0f);
+				vfloat d = (y & 1) ? select(oddColumn, vfloat(0.50f), vfloat(0.00f))
+								   : select(oddColumn, vfloat(0.25f), vfloat(0.75f));
+				c = Truncate(c + d / vfloat(64.0f), 64.0f);
+				break;
+			}
+
+			case GradientQuantizer::Bits6BlueNoise:
+			{
+				vfloat t = gather(noiseRow, toint(px) & vint(NoiseSize - 1));
+				c = floor(mad(c, vfloat(64.0f), t)) / vfloat(64.0f);
+				break;
+			}
+
+			case GradientQuantizer::Bits8:
+				c = Truncate(c, 256.0f);
+				break;
+
+			case GradientQuantizer::Bits10:
+				c = Truncate(c, 1024.0f);
+				break;
+
+			case GradientQuantizer::Bits12:
+				c = Truncate(c, 4096.0f);
+				break;
+
+			default:
+				break;
+			}
+
+			store(code + i, c);
+		}
+	}
+}
+
+void BandedGradientRow(const BandedGradientConstants& constants, const GradientBand* bands, size_t bandCount,
+					   int x, int y, size_t count, float* out)
+{
+	GradientQuantizer quantizer = RowQuantizer(constants, bands, bandCount, y);
+	for (size_t i = 0; i < count; i += Chunk)
+	{
+		float code[Chunk];
+		GradientCodes(constants, quantizer, x + (int)i, y, code);
+		for (int j = 0; j < Chunk; j += width)
+			store(code + j, pow(load(code + j), vfloat(2.2f)));
+		memcpy(out + i, code, std::min((size_t)Chunk, count - i) * sizeof(float));
+	}
+}
+
+void RenderBandedGradient(const BandedGradientConstants& constants, const GradientBand* bands, size_t bandCount,
+						  const GradientOutputs& outputs, uint32_t width, uint32_t height, ThreadPool* pool)
+{
+	RenderBands(height, pool, [&](int y)
+	{
+		GradientQuantizer quantizer = RowQuantizer(constants, bands, bandCount, y);
+		uint32_t* rgba8 = outputs.rgba8 ? (uint32_t*)((uint8_t*)outputs.rgba8 + y * outputs.rgba8Pitch) : nullptr;
+		uint32_t* rgb10a2 = outputs.rgb10a2 ? (uint32_t*)((uint8_t*)outputs.rgb10a2 + y * outputs.rgb10a2Pitch) : nullptr;
+		uint16_t* rgba16f = outputs.rgba16f ? (uint16_t*)((uint8_t*)outputs.rgba16f + y * outputs.rgba16fPitch) : nullptr;
+
+		for (uint32_t x = 0; x < width; x += Chunk)
+		{
+			size_t n = std::min((uint32_t)Chunk, width - x);
+			float code[Chunk];
+			int32_t words[2 * Chunk];
+			GradientCodes(constants, quantizer, (int)x, y, code);
+
+			if (rgba8)
+			{
+				for (int i = 0; i < Chunk; i += simd::width)
+				{
+					vint q = roundint(load(code + i) * vfloat(255.0f));
+					storei(words + i, q | shl<8>(q) | shl<16>(q) | vint((int32_t)0xFF000000));
+				}
+				memcpy(rgba8 + x, words, n * sizeof(uint32_t));
+			}
+
+			if (rgb10a2)
+			{
+				for (int i = 0; i < Chunk; i += simd::width)
+				{
+					vint q = roundint(load(code + i) * vfloat(1023.0f));
+					storei(words + i, q | shl<10>(q) | shl<20>(q) | vint((int32_t)0xC0000000));
+				}
+				memcpy(rgb10a2 + x, words, n * sizeof(uint32_t));
+			}
+
+			if (rgba16f)
+			{
+				int32_t half[Chunk];
+				for (int i = 0; i < Chunk; i += simd::width)
+					storei(half + i, tohalf(pow(load(code + i), vfloat(2.2f))));
+				for (int i = 0; i < Chunk; i++)
+				{
+					words[2 * i]     = (int32_t)((uint32_t)half[i] | (uint32_t)half[i] << 16);
+					words[2 * i + 1] = half[i] | 0x3C000000;
+				}
+				memcpy(rgba16f + 4 * x, words, n * 4 * sizeof(uint16_t));
+			}
+		}
+	});
+}
+
+void BandedGradientKernel(const EffectConstants& constants, const CpuTile& tile)
+{
+	BandedGradientConstants c = {};
+	c.dpi = 96.0f;
+	c.outputSize[0] = constants.outputSize.x;
+	c.outputSize[1] = constants.outputSize.y;
+
+	for (int y = 0; y < tile.height; y++)
+		BandedGradientRow(c, ShaderGradientBands, 5, tile.x, tile.y + y, tile.width, tile.r + y * tile.stride);
+	CopyGray(tile);
+}
+
+#pragma endregion
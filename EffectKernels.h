@@ -0,0 +1,136 @@
+//
+// EffectKernels.h
+//
+// CPU versions of the custom D2D pixel shaders, so the patterns that use them render
+// headless through CpuCanvas and the shaders have something to be checked against.
+// Each effect takes the constants of its shader's cbuffer, under the same names, and is
+// evaluated a row at a time with SimdMath.  Pixel (x, y) is sampled at its center,
+// (x + 0.5, y + 0.5), which is what D2DGetScenePosition() returns.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+struct CpuTile;
+struct EffectConstants;
+class ThreadPool;
+
+// cbuffer of SineSweepEffect.hlsl.  Distances are in pixels; dpi is unused, as in the shader.
+//
+// Deviation from the shader math evaluated in float with the C runtime's sinf/powf/exp2f,
+// as a fraction of whiteLevelMultiplier: 1.3e-6 while the sine argument is under 16
+// radians, 4.2e-5 under 512, and 6.6e-4 over the whole SharpeningFilter pattern at
+// 7680x4320 (3.3e-4 at 3840x2160), where the argument reaches ~4500 radians and one ulp
+// of the chirp multiplier moves it by ~5e-4 radians.  GPU sin() is no closer there.
+struct SineSweepConstants
+{
+	float dpi;
+	float center[2];
+	float initialWavelength;
+	float wavelengthHalvingDistance;
+	float whiteLevelMultiplier;
+};
+
+// Writes count gray levels of row y, starting at column x.
+void SineSweepRow(const SineSweepConstants& constants, int x, int y, size_t count, float* out);
+
+// Fills a width x height plane whose rows are stride floats apart, in row bands across
+// the pool (nullptr: ThreadPool::Default()).
+void RenderSineSweep(const SineSweepConstants& constants, float* out, uint32_t width, uint32_t height,
+					 size_t stride, ThreadPool* pool = nullptr);
+
+// CpuCanvas::EffectKernel for PatternEffect::SineSweep.
+void SineSweepKernel(const EffectConstants& constants, const CpuTile& tile);
+
+// cbuffer of ToneSpikeEffect.hlsl, the same layout as the sine sweep's.  Only center and
+// whiteLevelMultiplier are used; the latter is the white level in nits that the bottom
+// half is tone mapped to with ToneMapProfile() (ColorSpaces.h).
+//
+// PQ decoding goes through the TransferBatch.h span kernels.  Against the shader math
+// evaluated in float with ColorSpaces.h's scalar Remove2084 and the C runtime's
+// atan2f/sinf, output deviates by at most 4.5e-5 of its value, the Remove2084 span
+// kernel's own bound.  Pixels sitting on a spoke edge can land on the other side of it:
+// 3 of 8.3M at 3840x2160, 15 of 33M at 7680x4320.
+struct ToneSpikeConstants
+{
+	float dpi;
+	float center[2];
+	float initialWavelength;
+	float wavelengthHalvingDistance;
+	float whiteLevelMultiplier;
+};
+
+// Writes count pixels of row y, starting at column x, as planar scRGB.
+void ToneSpikeRow(const ToneSpikeConstants& constants, int x, int y, size_t count, float* r, float* g, float* b);
+
+// Fills width x height planes whose rows are stride floats apart, in row bands across
+// the pool (nullptr: ThreadPool::Default()).
+void RenderToneSpike(const ToneSpikeConstants& constants, float* r, float* g, float* b,
+					 uint32_t width, uint32_t height, size_t stride, ThreadPool* pool = nullptr);
+
+// CpuCanvas::EffectKernel for PatternEffect::ToneSpike.
+void ToneSpikeKernel(const EffectConstants& constants, const CpuTile& tile);
+
+// cbuffer of BandedGradientEffect.hlsl.
+struct BandedGradientConstants
+{
+	float dpi;
+	float outputSize[2];
+};
+
+// How one horizontal band of the gradient is quantized.  The code value is the gamma
+// 2.2 preshaped ramp, 0 to 0.25 across the width; every quantizer truncates, as the
+// shader does.
+enum class GradientQuantizer
+{
+	None,				// the ramp as is ("display-native")
+	Bits6,
+	Bits6Plus2,			// 8-bit, then 6-bit over a 2x2 ordered dither (SHOW_6PLUS2)
+	Bits6BlueNoise,		// 6-bit over a 64x64 blue-noise threshold map
+	Bits8,
+	Bits10,
+	Bits12,
+};
+
+// Rows whose center lies in [top, bottom), as fractions of outputSize.y.
+struct GradientBand
+{
+	float             top;
+	float             bottom;
+	GradientQuantizer quantizer;
+};
+
+// The shader as built: 6-bit, native, 8-bit, native, 10-bit.
+extern const GradientBand ShaderGradientBands[5];
+// The shader with SHOW_6PLUS2 defined: the second band is the 6+2 dither.
+extern const GradientBand DitheredGradientBands[5];
+// Every quantizer in seven equal bands: 6, 6+2, 6 blue noise, 8, 10, 12, native.
+extern const GradientBand ExtendedGradientBands[7];
+
+// Destinations of RenderBandedGradient; any may be null.  Pitches are in bytes.  The
+// UNORM outputs carry the code value itself, as an 8- or 10-bit gamma 2.2 swap chain
+// would (so the 10- and 12-bit bands collapse on the 8-bit one); FP16 carries the
+// shader's output, the code value linearized, in scRGB.  Alpha is 1.
+struct GradientOutputs
+{
+	uint32_t* rgba8;			// R8G8B8A8_UNORM
+	size_t    rgba8Pitch;
+	uint32_t* rgb10a2;			// R10G10B10A2_UNORM
+	size_t    rgb10a2Pitch;
+	uint16_t* rgba16f;			// R16G16B16A16_FLOAT
+	size_t    rgba16fPitch;
+};
+
+// Writes count linear values of row y, starting at column x.
+void BandedGradientRow(const BandedGradientConstants& constants, const GradientBand* bands, size_t bandCount,
+					   int x, int y, size_t count, float* out);
+
+// Renders a width x height gradient into every requested output in a single pass, in
+// row bands across the pool (nullptr: ThreadPool::Default()).
+void RenderBandedGradient(const BandedGradientConstants& constants, const GradientBand* bands, size_t bandCount,
+						  const GradientOutputs& outputs, uint32_t width, uint32_t height, ThreadPool* pool = nullptr);
+
+// CpuCanvas::EffectKernel for PatternEffect::BandedGradient, with ShaderGradientBands.
+void BandedGradientKernel(const EffectConstants& constants, const CpuTile& tile);
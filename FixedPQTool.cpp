@@ -0,0 +1,265 @@
+//
+// FixedPQTool.cpp
+//
+// Command-line front end to FixedPointPQ: writes the decode and encode ROM images for a
+// fixed-point format, compares the integer model against the float paths over every code,
+// and benchmarks it against them.  Not part of the app project; build it directly, e.g.
+//
+//   g++ -std=c++17 -O2 -mavx2 -mfma -pthread FixedPQTool.cpp FixedPointPQ.cpp ThreadPool.cpp TransferBatch.cpp TransferTables.cpp -o fixedpq
+//   cl /std:c++17 /O2 /arch:AVX2 /EHsc /constexpr:steps100000000 FixedPQTool.cpp FixedPointPQ.cpp ThreadPool.cpp TransferBatch.cpp TransferTables.cpp /Fe:fixedpq.exe
+//
+// Usage: fixedpq [compare|rom|bench] [--bits N] [--index-bits N] [--linear-bits N]
+//                [--segment-bits N] [--guard-bits N] [--threads N]
+//                [--rom decode|encode] [--format hex|c|bin] [--out path]
+//
+// compare (the default) exits with 1 if the model is not monotonic or a code the linear
+// format resolves does not survive the integer round trip; without --bits it checks 10
+// and 12 bits.  rom writes
+// one image to --out, or stdout for the text formats.
+//
+
+#include "ColorSpaces.h"
+#include "FixedPointPQ.h"
+#include "ThreadPool.h"
+#include "TransferBatch.h"
+#include "TransferTables.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+	const int Repeats = 200;
+
+	// Runs fn Repeats times and returns nanoseconds per value.
+	template <class Fn>
+	double TimeIt(size_t count, Fn fn)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < Repeats; r++)
+			fn();
+		auto end = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / ((double)count * Repeats);
+	}
+
+	void PrintFormat(const FixedPQ& pq)
+	{
+		const FixedPQFormat& format = pq.GetFormat();
+		printf("%d-bit codes, Q0.%d linear, decode ROM %zu x %d bits, encode ROM %zu x %d bits (%d segment, %d guard bits)\n",
+			   format.codeBits, format.linearBits,
+			   pq.GetRom(FixedPQRom::Decode).size(), pq.GetRomEntryBits(FixedPQRom::Decode),
+			   pq.GetRom(FixedPQRom::Encode).size(), pq.GetRomEntryBits(FixedPQRom::Encode),
+			   format.encodeSegmentBits, format.encodeGuardBits);
+	}
+
+	bool Compare(const FixedPQ& pq, ThreadPool* pool)
+	{
+		FixedPQComparison result;
+		CompareFixedPQ(pq, &result, pool);
+
+		PrintFormat(pq);
+		printf("  decode  %u codes   %7.2f ms  %s\n", pq.GetMaxCode() + 1, result.milliseconds, result.Passed() ? "pass" : "FAIL");
+		printf("    integer vs reference  %8.2f LSB at code %u, %.3g relative above 1 nit\n",
+			   result.decodeError, result.decodeWorstCode, result.decodeRelativeError);
+		printf("    integer vs float      %8.2f LSB   (float vs reference %.2f LSB)\n",
+			   result.decodeFloatError, result.floatDecodeError);
+		printf("    %u non-monotonic, %u codes lost in the integer round trip, %u below the linear resolution\n",
+			   result.decodeNonMonotonic, result.roundTripMisses, result.unresolvedCodes);
+		printf("  encode  %zu samples\n", result.encodeSamples);
+		printf("    integer vs reference  %8.4f codes at linear 0x%08X   (float vs reference %.4f codes)\n",
+			   result.encodeError, result.encodeWorstLinear, result.floatEncodeError);
+		printf("    %u misrounded against the reference, %u differ from the float path, %u non-monotonic\n",
+			   result.encodeMisrounded, result.encodeFloatMismatches, result.encodeNonMonotonic);
+		return result.Passed();
+	}
+
+	void Bench(const FixedPQ& pq)
+	{
+		const uint32_t maxCode = pq.GetMaxCode();
+		const size_t count = (size_t)maxCode + 1;
+		const float toLinear = 1.0f / (float)pq.GetOne();
+		volatile uint32_t sink = 0;
+
+		std::vector<uint16_t> codes(count);
+		std::vector<uint32_t> fixed(count);
+		std::vector<float> signals(count), floats(count);
+		for (size_t c = 0; c < count; c++)
+		{
+			codes[c] = (uint16_t)c;
+			signals[c] = (float)c / (float)maxCode;
+		}
+
+		PrintFormat(pq);
+		printf("PQ decode, every code (%zu values)\n", count);
+		double ns = TimeIt(count, [&] { pq.Decode(codes.data(), fixed.data(), count); });
+		printf("  %-22s %7.2f ns/value\n", "integer", ns);
+		ns = TimeIt(count, [&] { for (size_t c = 0; c < count; c++) floats[c] = Remove2084(signals[c]); });
+		printf("  %-22s %7.2f ns/value\n", "Remove2084 (powf)", ns);
+		ns = TimeIt(count, [&] { Remove2084(signals.data(), floats.data(), count); });
+		printf("  %-22s %7.2f ns/value\n", "Remove2084 span", ns);
+
+		// Encode the decoded codes back, so the inputs are spread as a real signal's are.
+		std::vector<float> linear(count);
+		for (size_t c = 0; c < count; c++)
+			linear[c] = (float)fixed[c] * toLinear;
+
+		printf("PQ encode, every code's linear value (%zu values)\n", count);
+		ns = TimeIt(count, [&] { pq.Encode(fixed.data(), codes.data(), count); });
+		printf("  %-22s %7.2f ns/value\n", "integer", ns);
+		ns = TimeIt(count, [&] { for (size_t c = 0; c < count; c++) floats[c] = Apply2084(linear[c]); });
+		printf("  %-22s %7.2f ns/value\n", "Apply2084 (powf)", ns);
+		ns = TimeIt(count, [&] { Apply2084(linear.data(), floats.data(), count); });
+		printf("  %-22s %7.2f ns/value\n", "Apply2084 span", ns);
+		ns = TimeIt(count, [&] { Apply2084_Table(linear.data(), floats.data(), count); });
+		printf("  %-22s %7.2f ns/value\n", "Apply2084_Table span", ns);
+
+		sink = codes[count / 2] + (uint32_t)floats[count / 2];
+		(void)sink;
+	}
+
+	void Usage()
+	{
+		fprintf(stderr,
+				"usage: fixedpq [compare|rom|bench] [--bits N] [--index-bits N] [--linear-bits N]\n"
+				"               [--segment-bits N] [--guard-bits N] [--threads N]\n"
+				"               [--rom decode|encode] [--format hex|c|bin] [--out path]\n"
+				"  compare         integer model against the float paths and the reference (default)\n"
+				"  rom             write a ROM image\n"
+				"  bench           time the integer model against the float paths\n"
+				"  --bits          code width, 8..16 (default 10 and 12 for compare, else 12)\n"
+				"  --index-bits    log2 of decode ROM segments (default 10, or the code width below that)\n"
+				"  --linear-bits   fraction bits of linear light, 1.0 = 10,000 nits (default 30)\n"
+				"  --segment-bits  log2 of encode ROM segments per octave (default 6)\n"
+				"  --guard-bits    fraction bits of a code in the encode ROM (default 8)\n"
+				"  --threads       worker count including the caller (default: one per hardware thread)\n"
+				"  --rom           which ROM to write (default decode)\n"
+				"  --format        hex for $readmemh, c for an array, bin for raw little-endian (default hex)\n"
+				"  --out           output file (default stdout; required for bin)\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	enum { CompareCommand, RomCommand, BenchCommand } command = CompareCommand;
+	FixedPQFormat format;
+	std::vector<int> bits;
+	int indexBits = 0;
+	unsigned threads = 0;
+	FixedPQRom rom = FixedPQRom::Decode;
+	FixedPQRomFormat romFormat = FixedPQRomFormat::Hex;
+	const char* outPath = nullptr;
+
+	int i = 1;
+	if (i < argc && argv[i][0] != '-')
+	{
+		const char* name = argv[i++];
+		if (!strcmp(name, "compare"))
+			command = CompareCommand;
+		else if (!strcmp(name, "rom"))
+			command = RomCommand;
+		else if (!strcmp(name, "bench"))
+			command = BenchCommand;
+		else
+		{
+			Usage();
+			return 2;
+		}
+	}
+
+	for (; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		if (i + 1 >= argc)
+		{
+			Usage();
+			return 2;
+		}
+		const char* value = argv[++i];
+		if (!strcmp(arg, "--bits"))
+			bits = { atoi(value) };
+		else if (!strcmp(arg, "--index-bits"))
+			indexBits = atoi(value);
+		else if (!strcmp(arg, "--linear-bits"))
+			format.linearBits = atoi(value);
+		else if (!strcmp(arg, "--segment-bits"))
+			format.encodeSegmentBits = atoi(value);
+		else if (!strcmp(arg, "--guard-bits"))
+			format.encodeGuardBits = atoi(value);
+		else if (!strcmp(arg, "--threads"))
+			threads = (unsigned)atoi(value);
+		else if (!strcmp(arg, "--rom") && (!strcmp(value, "decode") || !strcmp(value, "encode")))
+			rom = !strcmp(value, "decode") ? FixedPQRom::Decode : FixedPQRom::Encode;
+		else if (!strcmp(arg, "--format") && !strcmp(value, "hex"))
+			romFormat = FixedPQRomFormat::Hex;
+		else if (!strcmp(arg, "--format") && !strcmp(value, "c"))
+			romFormat = FixedPQRomFormat::C;
+		else if (!strcmp(arg, "--format") && !strcmp(value, "bin"))
+			romFormat = FixedPQRomFormat::Binary;
+		else if (!strcmp(arg, "--out"))
+			outPath = value;
+		else
+		{
+			Usage();
+			return 2;
+		}
+	}
+
+	if (bits.empty())
+		bits = command == CompareCommand ? std::vector<int>{ 10, 12 } : std::vector<int>{ format.codeBits };
+	for (int b : bits)
+	{
+		format.codeBits = b;
+		format.decodeIndexBits = indexBits ? indexBits : std::min(b, 10);
+		if (const char* error = FixedPQFormatError(format))
+		{
+			fprintf(stderr, "fixedpq: %s\n", error);
+			return 2;
+		}
+	}
+
+	if (command == RomCommand)
+	{
+		if (romFormat == FixedPQRomFormat::Binary && !outPath)
+		{
+			Usage();
+			return 2;
+		}
+		FixedPQ pq(format);
+		FILE* out = outPath ? fopen(outPath, romFormat == FixedPQRomFormat::Binary ? "wb" : "w") : stdout;
+		if (!out)
+		{
+			fprintf(stderr, "fixedpq: cannot open %s\n", outPath);
+			return 1;
+		}
+		bool ok = pq.WriteRom(rom, romFormat, out);
+		if (out != stdout)
+			ok = fclose(out) == 0 && ok;
+		if (!ok)
+			fprintf(stderr, "fixedpq: write failed\n");
+		return ok ? 0 : 1;
+	}
+
+	if (command == BenchCommand)
+	{
+		Bench(FixedPQ(format));
+		return 0;
+	}
+
+	std::unique_ptr<ThreadPool> pool(new ThreadPool(threads));
+	printf("%u threads, %s\n", pool->Size(), TransferBatchPath());
+
+	bool passed = true;
+	for (int b : bits)
+	{
+		format.codeBits = b;
+		format.decodeIndexBits = indexBits ? indexBits : std::min(b, 10);
+		passed = Compare(FixedPQ(format), pool.get()) && passed;
+	}
+	printf("%s\n", passed ? "all formats pass" : "FAILED");
+	return passed ? 0 : 1;
+}
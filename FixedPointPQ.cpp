@@ -0,0 +1,362 @@
+//
+// FixedPointPQ.cpp
+//
+// Integer PQ model, ROM images and comparison.  See FixedPointPQ.h.
+//
+
+#include "ColorSpaces.h"
+#include "FixedPointPQ.h"
+#include "ThreadPool.h"
+#include "TransferBatch.h"
+#include "TransferTables.h"
+
+#include <algorithm>
+#include <chrono>
+#include <math.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace
+{
+	const size_t BlockSize = 4096;				// codes or samples per task
+	const int    SamplesPerSegment = 8;			// encode samples along each ROM segment
+	const double RelativeFloor = 1e-4;			// 1 nit
+
+	// Position of the highest set bit; x != 0.
+	int HighestBit(uint32_t x)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse(&index, x);
+		return (int)index;
+#else
+		return 31 - __builtin_clz(x);
+#endif
+	}
+
+	// a + (b - a) * frac / 2^shift, rounded half up.  b >= a, as both ROMs are increasing.
+	uint32_t Lerp(uint32_t a, uint32_t b, uint32_t frac, int shift)
+	{
+		if (shift == 0)
+			return a;
+		uint64_t step = (uint64_t)(b - a) * frac + (1ull << (shift - 1));
+		return a + (uint32_t)(step >> shift);
+	}
+
+	uint32_t RoundHalfUp(double value)
+	{
+		return (uint32_t)floor(value + 0.5);
+	}
+
+	const char* RomName(FixedPQRom rom)
+	{
+		return rom == FixedPQRom::Decode ? "decode" : "encode";
+	}
+
+	uint32_t Crc32(uint32_t crc, uint8_t byte)
+	{
+		crc ^= byte;
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+		return crc;
+	}
+}
+
+const char* FixedPQFormatError(const FixedPQFormat& format)
+{
+	if (format.codeBits < 8 || format.codeBits > 16)
+		return "code bits must be 8..16";
+	if (format.decodeIndexBits < 1 || format.decodeIndexBits > format.codeBits)
+		return "decode index bits must be 1..code bits";
+	if (format.linearBits < 16 || format.linearBits > 31)
+		return "linear bits must be 16..31";
+	if (format.encodeSegmentBits < 0 || format.encodeSegmentBits > 8)
+		return "encode segment bits must be 0..8";
+	if (format.encodeGuardBits < 0 || format.encodeGuardBits > 12)
+		return "encode guard bits must be 0..12";
+	return nullptr;
+}
+
+FixedPQ::FixedPQ() :
+	m_maxCode(0),
+	m_one(0)
+{
+}
+
+FixedPQ::FixedPQ(const FixedPQFormat& format) :
+	m_format(format),
+	m_maxCode(0),
+	m_one(0)
+{
+	if (FixedPQFormatError(format))
+		return;
+
+	m_maxCode = (1u << format.codeBits) - 1;
+	m_one = 1u << format.linearBits;
+	const double maxCode = (double)m_maxCode;
+	const double one = (double)m_one;
+
+	// Decode entry i sits at code i << (codeBits - decodeIndexBits).  The last one is one
+	// past the top code, so the top segment interpolates without a special case; it is put
+	// on the line through the top code rather than on the curve, which is too steep there
+	// to interpolate, so that the top code decodes to 1.0.
+	const int decodeShift = format.codeBits - format.decodeIndexBits;
+	const size_t last = (size_t)1 << format.decodeIndexBits;
+	const double width = (double)(1u << decodeShift);
+	m_decode.resize(last + 1);
+	for (size_t i = 0; i < last; i++)
+		m_decode[i] = RoundHalfUp(Remove2084Reference((double)(i << decodeShift) / maxCode) * one);
+	double below = Remove2084Reference((double)((last - 1) << decodeShift) / maxCode) * one;
+	m_decode[last] = decodeShift ? RoundHalfUp(below + (one - below) * width / (width - 1.0)) : m_one;
+
+	// Encode entry j sits at 2^(k - linearBits) * (1 + m / 2^encodeSegmentBits), with k and
+	// m the top and bottom bits of j.  The last entry is 1.0 itself.
+	const int segments = 1 << format.encodeSegmentBits;
+	const double signalScale = maxCode * (double)(1u << format.encodeGuardBits);
+	m_encode.resize((size_t)format.linearBits * segments + 1);
+	for (size_t j = 0; j < m_encode.size(); j++)
+	{
+		int k = (int)(j / segments);
+		double x = ldexp(1.0 + (double)(j % segments) / segments, k - format.linearBits);
+		m_encode[j] = RoundHalfUp(Apply2084Reference(x) * signalScale);
+	}
+}
+
+uint32_t FixedPQ::Decode(uint32_t code) const
+{
+	code = code < m_maxCode ? code : m_maxCode;
+	const int shift = m_format.codeBits - m_format.decodeIndexBits;
+	uint32_t i = code >> shift;
+	return Lerp(m_decode[i], m_decode[i + (shift > 0)], code & ((1u << shift) - 1), shift);
+}
+
+uint32_t FixedPQ::EncodeSignal(uint32_t linear) const
+{
+	if (linear == 0)
+		return 0;
+	if (linear >= m_one)
+		return m_encode.back();
+
+	// The octave is the leading one; the next encodeSegmentBits bits pick the segment and
+	// any below that interpolate.  Octaves narrower than a segment hit entries exactly.
+	const int k = HighestBit(linear);
+	const int shift = k - m_format.encodeSegmentBits;
+	const uint32_t mantissa = linear - (1u << k);
+	const size_t base = (size_t)k << m_format.encodeSegmentBits;
+	if (shift <= 0)
+		return m_encode[base + (mantissa << -shift)];
+
+	size_t j = base + (mantissa >> shift);
+	return Lerp(m_encode[j], m_encode[j + 1], mantissa & ((1u << shift) - 1), shift);
+}
+
+uint32_t FixedPQ::Encode(uint32_t linear) const
+{
+	const int guard = m_format.encodeGuardBits;
+	uint32_t code = (EncodeSignal(linear) + (guard ? 1u << (guard - 1) : 0u)) >> guard;
+	return code < m_maxCode ? code : m_maxCode;
+}
+
+void FixedPQ::Decode(const uint16_t* codes, uint32_t* linear, size_t count) const
+{
+	for (size_t i = 0; i < count; i++)
+		linear[i] = Decode(codes[i]);
+}
+
+void FixedPQ::Encode(const uint32_t* linear, uint16_t* codes, size_t count) const
+{
+	for (size_t i = 0; i < count; i++)
+		codes[i] = (uint16_t)Encode(linear[i]);
+}
+
+int FixedPQ::GetRomEntryBits(FixedPQRom rom) const
+{
+	const std::vector<uint32_t>& entries = GetRom(rom);
+	uint32_t top = entries.empty() ? 0 : *std::max_element(entries.begin(), entries.end());
+	return top ? HighestBit(top) + 1 : 1;
+}
+
+uint32_t FixedPQ::GetRomChecksum(FixedPQRom rom) const
+{
+	const int bytes = GetRomEntryBits(rom) <= 16 ? 2 : 4;
+	uint32_t crc = 0xFFFFFFFFu;
+	for (uint32_t entry : GetRom(rom))
+	{
+		for (int b = 0; b < bytes; b++)
+			crc = Crc32(crc, (uint8_t)(entry >> (8 * b)));
+	}
+	return ~crc;
+}
+
+bool FixedPQ::WriteRom(FixedPQRom rom, FixedPQRomFormat format, FILE* file) const
+{
+	const std::vector<uint32_t>& entries = GetRom(rom);
+	const int bits = GetRomEntryBits(rom);
+	bool ok = true;
+
+	if (format == FixedPQRomFormat::Binary)
+	{
+		const int bytes = bits <= 16 ? 2 : 4;
+		for (uint32_t entry : entries)
+		{
+			uint8_t le[4] = { (uint8_t)entry, (uint8_t)(entry >> 8), (uint8_t)(entry >> 16), (uint8_t)(entry >> 24) };
+			ok = ok && fwrite(le, 1, bytes, file) == (size_t)bytes;
+		}
+		return ok;
+	}
+
+	char layout[96];
+	if (rom == FixedPQRom::Decode)
+		snprintf(layout, sizeof(layout), "%d index bits", m_format.decodeIndexBits);
+	else
+		snprintf(layout, sizeof(layout), "%d segment bits per octave, %d guard bits",
+				 m_format.encodeSegmentBits, m_format.encodeGuardBits);
+	ok = fprintf(file, "// ST.2084 %s ROM: %zu x %d-bit entries, %d-bit codes, Q0.%d linear, %s, CRC-32 0x%08X\n",
+				 RomName(rom), entries.size(), bits, m_format.codeBits, m_format.linearBits, layout,
+				 GetRomChecksum(rom)) > 0;
+
+	if (format == FixedPQRomFormat::Hex)
+	{
+		const int digits = (bits + 3) / 4;
+		for (uint32_t entry : entries)
+			ok = ok && fprintf(file, "%0*X\n", digits, entry) > 0;
+		return ok;
+	}
+
+	const int digits = bits <= 16 ? 4 : 8;
+	ok = ok && fprintf(file, "static const uint%d_t PQ%sRom[%zu] =\n{", bits <= 16 ? 16 : 32,
+					   rom == FixedPQRom::Decode ? "Decode" : "Encode", entries.size()) > 0;
+	for (size_t i = 0; i < entries.size(); i++)
+		ok = ok && fprintf(file, "%s0x%0*X,", i % 8 ? " " : "\n\t", digits, entries[i]) > 0;
+	ok = ok && fprintf(file, "\n};\n") > 0;
+	return ok;
+}
+
+bool FixedPQComparison::Passed() const
+{
+	return decodeNonMonotonic == 0 && encodeNonMonotonic == 0 && roundTripMisses == 0;
+}
+
+void CompareFixedPQ(const FixedPQ& pq, FixedPQComparison* comparison, ThreadPool* pool)
+{
+	if (!pool)
+		pool = &ThreadPool::Default();
+
+	auto start = std::chrono::steady_clock::now();
+	const FixedPQFormat& format = pq.GetFormat();
+	const uint32_t maxCode = pq.GetMaxCode();
+	const double one = (double)pq.GetOne();
+	const float toLinear = 1.0f / (float)pq.GetOne();			// a power of two, exact
+
+	*comparison = FixedPQComparison();
+	comparison->format = format;
+
+	// Decode: every code through the integer model, the float span kernel and the reference.
+	const size_t codeCount = (size_t)maxCode + 1;
+	std::vector<uint16_t> codes(codeCount);
+	std::vector<uint32_t> fixed(codeCount);
+	std::vector<float> signals(codeCount), floats(codeCount);
+	std::vector<double> reference(codeCount);
+	std::vector<uint8_t> missed(codeCount), unresolved(codeCount);
+	pool->ParallelFor(0, (codeCount + BlockSize - 1) / BlockSize, [&](size_t block)
+	{
+		size_t first = block * BlockSize;
+		size_t count = std::min(BlockSize, codeCount - first);
+		for (size_t c = first; c < first + count; c++)
+		{
+			codes[c] = (uint16_t)c;
+			signals[c] = (float)c / (float)maxCode;
+			reference[c] = Remove2084Reference((double)c / maxCode);
+		}
+		pq.Decode(&codes[first], &fixed[first], count);
+		Remove2084(&signals[first], &floats[first], count);
+		// Near black an LSB of the linear format is a good part of a code.  Where the exact
+		// value, rounded, or an LSB either side of it encodes to another code, the format
+		// cannot hold the code through interpolation, and it is not counted as a miss.
+		for (size_t c = first; c < first + count; c++)
+		{
+			double rounded = RoundHalfUp(reference[c] * one);
+			unresolved[c] = false;
+			for (double lsb = -1.0; lsb <= 1.0; lsb++)
+				unresolved[c] |= RoundHalfUp(Apply2084Reference(std::max(rounded + lsb, 0.0) / one) * maxCode) != c;
+			missed[c] = !unresolved[c] && pq.Encode(fixed[c]) != c;
+		}
+	});
+
+	for (size_t c = 0; c < codeCount; c++)
+	{
+		double exact = reference[c] * one;
+		double error = fabs((double)fixed[c] - exact);
+		if (error > comparison->decodeError)
+		{
+			comparison->decodeError = error;
+			comparison->decodeWorstCode = (uint32_t)c;
+		}
+		comparison->decodeFloatError = std::max(comparison->decodeFloatError, fabs((double)fixed[c] - floats[c] * one));
+		comparison->floatDecodeError = std::max(comparison->floatDecodeError, fabs(floats[c] * one - exact));
+		if (reference[c] >= RelativeFloor)
+			comparison->decodeRelativeError = std::max(comparison->decodeRelativeError, error / exact);
+		comparison->decodeNonMonotonic += c > 0 && fixed[c] < fixed[c - 1];
+		comparison->roundTripMisses += missed[c];
+		comparison->unresolvedCodes += unresolved[c];
+	}
+
+	// Encode samples: spread along every octave, SamplesPerSegment to a ROM segment where
+	// the octave is wide enough, then the linear value nearest each code's center.
+	std::vector<uint32_t> linear;
+	const uint64_t perOctave = (uint64_t)SamplesPerSegment << format.encodeSegmentBits;
+	for (int k = 0; k < format.linearBits; k++)
+	{
+		uint64_t width = 1ull << k;
+		uint64_t n = std::min(width, perOctave);
+		for (uint64_t i = 0; i < n; i++)
+			linear.push_back((uint32_t)(width + width * i / n));
+	}
+	linear.push_back(pq.GetOne());
+	for (uint32_t c = 1; c < maxCode; c++)
+		linear.push_back(RoundHalfUp(Remove2084Reference((double)c / maxCode) * one));
+	std::sort(linear.begin(), linear.end());
+	linear.erase(std::unique(linear.begin(), linear.end()), linear.end());
+
+	const size_t sampleCount = linear.size();
+	const double guardScale = 1.0 / (double)(1u << format.encodeGuardBits);
+	std::vector<uint32_t> fixedSignals(sampleCount);
+	std::vector<uint16_t> fixedCodes(sampleCount);
+	std::vector<float> inputs(sampleCount), floatSignals(sampleCount);
+	std::vector<double> referenceSignals(sampleCount);
+	pool->ParallelFor(0, (sampleCount + BlockSize - 1) / BlockSize, [&](size_t block)
+	{
+		size_t first = block * BlockSize;
+		size_t count = std::min(BlockSize, sampleCount - first);
+		for (size_t i = first; i < first + count; i++)
+		{
+			fixedSignals[i] = pq.EncodeSignal(linear[i]);
+			inputs[i] = (float)linear[i] * toLinear;
+			referenceSignals[i] = Apply2084Reference(linear[i] / one);
+		}
+		pq.Encode(&linear[first], &fixedCodes[first], count);
+		Apply2084(&inputs[first], &floatSignals[first], count);
+	});
+
+	comparison->encodeSamples = sampleCount;
+	for (size_t i = 0; i < sampleCount; i++)
+	{
+		double exact = referenceSignals[i] * maxCode;
+		double error = fabs(fixedSignals[i] * guardScale - exact);
+		if (error > comparison->encodeError)
+		{
+			comparison->encodeError = error;
+			comparison->encodeWorstLinear = linear[i];
+		}
+		comparison->floatEncodeError = std::max(comparison->floatEncodeError, fabs(floatSignals[i] * (double)maxCode - exact));
+
+		float signal = floatSignals[i] > 0.0f ? (floatSignals[i] < 1.0f ? floatSignals[i] : 1.0f) : 0.0f;
+		uint32_t floatCode = (uint32_t)roundf(signal * (float)maxCode);
+		comparison->encodeMisrounded += fixedCodes[i] != (uint32_t)floor(exact + 0.5);
+		comparison->encodeFloatMismatches += fixedCodes[i] != floatCode;
+		comparison->encodeNonMonotonic += i > 0 && fixedCodes[i] < fixedCodes[i - 1];
+	}
+
+	comparison->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,140 @@
+//
+// FixedPointPQ.h
+//
+// Integer-only ST.2084 (PQ) decode and encode, as a scaler or TCON implements it, so the
+// float paths in ColorSpaces.h can be checked against what the panel firmware computes.
+// Both directions are a ROM lookup plus linear interpolation, with widths set by a
+// FixedPQFormat:
+//
+//   Decode  code (codeBits) -> linear Q0.linearBits, 1.0 = 10,000 nits.  The top
+//           decodeIndexBits of the code index the ROM, the rest interpolate.  With
+//           decodeIndexBits == codeBits it is a plain table.
+//
+//   Encode  linear Q0.linearBits -> code.  Uniform segments are useless near black, so the
+//           ROM is laid out as the float encode table in TransferTables.h: one octave per
+//           leading-one position of the input, 2^encodeSegmentBits segments per octave,
+//           interpolated by the bits below.  Entries hold the code with encodeGuardBits
+//           of fraction, rounded off after the interpolation.
+//
+// Interpolation rounds half up, with 64-bit products; nothing else touches floating point.
+// The ROM entries are generated in double by Apply2084Reference()/Remove2084Reference()
+// (TransferTables.h) and rounded half up, so the images are the same bits on every build
+// and the integer model here matches firmware loaded with them bit for bit.
+//
+// CompareFixedPQ() runs the integer model against the float span kernels (TransferBatch.h)
+// and the double reference over every code, and over every encode segment and the center
+// of every code, in blocks across a ThreadPool.  FixedPQTool.cpp writes the ROM images and
+// runs the comparison and a benchmark.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <vector>
+
+class ThreadPool;
+
+struct FixedPQFormat
+{
+	int codeBits          = 12;		// PQ code width, 8..16
+	int decodeIndexBits   = 10;		// log2 of the decode ROM segments, 1..codeBits
+	int linearBits        = 30;		// fraction bits of linear light, 16..31
+	int encodeSegmentBits = 6;		// log2 of encode ROM segments per octave, 0..8
+	int encodeGuardBits   = 8;		// fraction bits of a code in the encode ROM, 0..12
+};
+
+// nullptr if the format is usable, else what is wrong with it.
+const char* FixedPQFormatError(const FixedPQFormat& format);
+
+enum class FixedPQRom
+{
+	Decode,
+	Encode,
+};
+
+enum class FixedPQRomFormat
+{
+	Hex,			// one entry per line, for Verilog $readmemh
+	C,				// a const array initializer
+	Binary,			// little-endian, 2 or 4 bytes per entry
+};
+
+class FixedPQ
+{
+public:
+	FixedPQ();
+
+	// Builds both ROMs.  An invalid format leaves the model empty.
+	explicit FixedPQ(const FixedPQFormat& format);
+
+	// Code to linear Q0.linearBits.  Codes past the top are clamped.
+	uint32_t Decode(uint32_t code) const;
+
+	// Linear Q0.linearBits to code, and to the code before rounding, with encodeGuardBits
+	// of fraction.  Inputs at or above 1.0 give the top code; 0 gives code 0.
+	uint32_t Encode(uint32_t linear) const;
+	uint32_t EncodeSignal(uint32_t linear) const;
+
+	void Decode(const uint16_t* codes, uint32_t* linear, size_t count) const;
+	void Encode(const uint32_t* linear, uint16_t* codes, size_t count) const;
+
+	const FixedPQFormat& GetFormat() const { return m_format; }
+	uint32_t GetMaxCode() const { return m_maxCode; }
+	uint32_t GetOne() const { return m_one; }			// linear 1.0
+	bool IsEmpty() const { return m_decode.empty(); }
+
+	// ROM contents, and the width an entry needs.
+	const std::vector<uint32_t>& GetRom(FixedPQRom rom) const { return rom == FixedPQRom::Decode ? m_decode : m_encode; }
+	int GetRomEntryBits(FixedPQRom rom) const;
+
+	// CRC-32 (IEEE) of the entries as written by the Binary format, to check a ROM image.
+	uint32_t GetRomChecksum(FixedPQRom rom) const;
+
+	// Writes a ROM image.  The Hex and C formats start with a comment giving the format
+	// and checksum.  Returns false on a write error.
+	bool WriteRom(FixedPQRom rom, FixedPQRomFormat format, FILE* file) const;
+
+private:
+	FixedPQFormat         m_format;
+	uint32_t              m_maxCode;
+	uint32_t              m_one;
+	std::vector<uint32_t> m_decode;		// 2^decodeIndexBits + 1 entries
+	std::vector<uint32_t> m_encode;		// linearBits * 2^encodeSegmentBits + 1 entries
+};
+
+struct FixedPQComparison
+{
+	FixedPQFormat format;
+
+	// Decode of every code.  Errors are in LSBs of the linear format; the relative one
+	// only counts values above 1 nit, where an LSB is small against the value.
+	double   decodeError;				// integer against the double reference
+	uint32_t decodeWorstCode;
+	double   decodeFloatError;			// integer against the Remove2084() span kernel
+	double   floatDecodeError;			// the float kernel against the reference, for scale
+	double   decodeRelativeError;		// integer against the reference, above 1 nit
+	uint32_t decodeNonMonotonic;		// codes decoding below the one before
+	uint32_t roundTripMisses;			// codes that the integer encoder does not return from their integer decode
+	uint32_t unresolvedCodes;			// codes near black within an LSB of the next, not counted above
+
+	// Encode, sampled along every encode ROM segment and at the center of every code.
+	// Errors are in code steps, before rounding.
+	size_t   encodeSamples;
+	double   encodeError;				// EncodeSignal() against the double reference
+	uint32_t encodeWorstLinear;
+	double   floatEncodeError;			// the Apply2084() span kernel against the reference
+	uint32_t encodeMisrounded;			// samples landing on another code than the reference
+	uint32_t encodeFloatMismatches;		// samples landing on another code than the float path
+	uint32_t encodeNonMonotonic;		// samples encoding below the smaller sample before
+
+	double   milliseconds;
+
+	// Monotonic both ways, and every code the linear format resolves survives the integer
+	// round trip.
+	bool Passed() const;
+};
+
+// pool == nullptr uses ThreadPool::Default().
+void CompareFixedPQ(const FixedPQ& pq, FixedPQComparison* comparison, ThreadPool* pool = nullptr);
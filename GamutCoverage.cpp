@@ -0,0 +1,311 @@
+//
+// GamutCoverage.cpp
+//
+// SIMD triangle overlap in uv.  See GamutCoverage.h for the method.
+//
+
+#include "GamutCoverage.h"
+#include "SimdMath.h"
+
+#include <string.h>
+
+using namespace simd;
+
+namespace
+{
+	// Distances to an edge line closer than this (in uv) are treated as on the line, so
+	// that shared vertices and coincident edges are counted once, from the panel side.
+	const float OnEdge = 1e-6f;
+
+	// One triangle per lane, vertices r, g, b.
+	struct Tri
+	{
+		vfloat x[3];
+		vfloat y[3];
+	};
+
+	// Edge lines of a counter-clockwise triangle as nx*x + ny*y + c, positive inside.
+	struct Edges
+	{
+		vfloat nx[3];
+		vfloat ny[3];
+		vfloat c[3];
+	};
+
+	inline vfloat Cross(vfloat ax, vfloat ay, vfloat bx, vfloat by)
+	{
+		return ax * by - ay * bx;
+	}
+
+	// CIE 1931 xy to CIE 1976 uv, as xytouv() in ColorSpaces.h.
+	inline void ToUV(vfloat& x, vfloat& y)
+	{
+		vfloat d = vfloat(-2.0f) * x + vfloat(12.0f) * y + vfloat(3.0f);
+		vfloat u = vfloat(4.0f) * x / d;
+		vfloat v = vfloat(9.0f) * y / d;
+		x = u;
+		y = v;
+	}
+
+	// Twice the signed area, positive for counter-clockwise r, g, b.
+	inline vfloat TwiceArea(const Tri& t)
+	{
+		return Cross(t.x[1] - t.x[0], t.y[1] - t.y[0], t.x[2] - t.x[0], t.y[2] - t.y[0]);
+	}
+
+	// Swaps g and b in lanes where the triangle is clockwise; returns twice the area.
+	inline vfloat MakeCounterClockwise(Tri& t)
+	{
+		vfloat area2 = TwiceArea(t);
+		vmask cw = area2 < vfloat(0.0f);
+		vfloat gx = t.x[1], gy = t.y[1];
+		t.x[1] = select(cw, t.x[2], gx);
+		t.y[1] = select(cw, t.y[2], gy);
+		t.x[2] = select(cw, gx, t.x[2]);
+		t.y[2] = select(cw, gy, t.y[2]);
+		return abs(area2);
+	}
+
+	inline Edges MakeEdges(const Tri& t)
+	{
+		Edges e;
+		for (int i = 0; i < 3; i++)
+		{
+			int j = (i + 1) % 3;
+			vfloat ex = t.x[j] - t.x[i];
+			vfloat ey = t.y[j] - t.y[i];
+			vfloat invLength = vfloat(1.0f) / max(sqrt(ex * ex + ey * ey), vfloat(1e-20f));
+			e.nx[i] = -ey * invLength;
+			e.ny[i] = ex * invLength;
+			e.c[i] = -(e.nx[i] * t.x[i] + e.ny[i] * t.y[i]);
+		}
+		return e;
+	}
+
+	// Signed distances of t's vertices from the other triangle's edge lines, [line][vertex].
+	// Distances within OnEdge are snapped to zero and flagged in on.
+	struct Distances
+	{
+		vfloat d[3][3];
+		vmask  on[3][3];
+	};
+
+	inline Distances MakeDistances(const Tri& t, const Edges& other)
+	{
+		Distances D;
+		for (int l = 0; l < 3; l++)
+		{
+			for (int v = 0; v < 3; v++)
+			{
+				vfloat dist = other.nx[l] * t.x[v] + other.ny[l] * t.y[v] + other.c[l];
+				D.on[l][v] = abs(dist) < vfloat(OnEdge);
+				D.d[l][v] = select(D.on[l][v], vfloat(0.0f), dist);
+			}
+		}
+		return D;
+	}
+
+	// Crossing points of every panel edge with every reference edge line, [panel][reference].
+	// Both passes of ClippedEdgeSum take their clipped endpoints from here, so the two halves
+	// of the boundary meet at bit-identical points and the origin drops out of the integral.
+	// The point is placed along the panel edge rather than by intersecting the two line
+	// equations, which in float lands well off both lines when they are nearly parallel.
+	// A vertex snapped onto the other triangle's line is that line's crossing with both of
+	// the vertex's edges, so it replaces the computed point there.
+	struct Crossings
+	{
+		vfloat x[3][3];
+		vfloat y[3][3];
+	};
+
+	inline Crossings MakeCrossings(const Tri& p, const Distances& pDist, const Tri& q, const Distances& qDist)
+	{
+		Crossings X;
+		for (int i = 0; i < 3; i++)
+		{
+			int j = (i + 1) % 3;
+			for (int l = 0; l < 3; l++)
+			{
+				vfloat t = pDist.d[l][i] / (pDist.d[l][i] - pDist.d[l][j]);
+				X.x[i][l] = p.x[i] + (p.x[j] - p.x[i]) * t;
+				X.y[i][l] = p.y[i] + (p.y[j] - p.y[i]) * t;
+			}
+		}
+
+		// Vertex v starts edge v and ends edge v + 2.
+		for (int v = 0; v < 3; v++)
+		{
+			int w = (v + 2) % 3;
+			for (int l = 0; l < 3; l++)
+			{
+				vmask on = pDist.on[l][v];		// panel vertex v on reference line l
+				X.x[v][l] = select(on, p.x[v], X.x[v][l]);
+				X.y[v][l] = select(on, p.y[v], X.y[v][l]);
+				X.x[w][l] = select(on, p.x[v], X.x[w][l]);
+				X.y[w][l] = select(on, p.y[v], X.y[w][l]);
+			}
+			for (int i = 0; i < 3; i++)
+			{
+				vmask on = qDist.on[i][v];		// reference vertex v on panel line i
+				X.x[i][v] = select(on, q.x[v], X.x[i][v]);
+				X.y[i][v] = select(on, q.y[v], X.y[i][v]);
+				X.x[i][w] = select(on, q.x[v], X.x[i][w]);
+				X.y[i][w] = select(on, q.y[v], X.y[i][w]);
+			}
+		}
+		return X;
+	}
+
+	// Sum over the edges of t of cross(start, end) for the part of the edge inside the other
+	// triangle.  Edges on the other triangle's boundary count as inside for the panel and
+	// outside for the reference, so shared boundary is integrated exactly once.
+	template <bool Panel>
+	inline vfloat ClippedEdgeSum(const Tri& t, const Distances& D, const Crossings& X)
+	{
+		vfloat sum(0.0f);
+		for (int a = 0; a < 3; a++)
+		{
+			int b = (a + 1) % 3;
+			vfloat t0(0.0f), t1(1.0f);
+			vfloat sx = t.x[a], sy = t.y[a];
+			vfloat ex = t.x[b], ey = t.y[b];
+			for (int l = 0; l < 3; l++)
+			{
+				vfloat da = D.d[l][a], db = D.d[l][b];
+				vmask inA  = Panel ? da >= vfloat(0.0f) : da > vfloat(0.0f);
+				vmask inB  = Panel ? db >= vfloat(0.0f) : db > vfloat(0.0f);
+				vmask outA = Panel ? da < vfloat(0.0f)  : da <= vfloat(0.0f);
+				vmask outB = Panel ? db < vfloat(0.0f)  : db <= vfloat(0.0f);
+				vfloat crossing = da / (da - db);
+				vfloat cx = Panel ? X.x[a][l] : X.x[l][a];
+				vfloat cy = Panel ? X.y[a][l] : X.y[l][a];
+
+				// Leaving through this line clips the end, entering clips the start, and an
+				// edge entirely outside is emptied by either.
+				vfloat end = select(outB, select(inA, crossing, vfloat(0.0f)), vfloat(1.0f));
+				vmask clipEnd = end < t1;
+				t1 = select(clipEnd, end, t1);
+				ex = select(clipEnd, cx, ex);
+				ey = select(clipEnd, cy, ey);
+
+				vfloat start = select(outA, select(inB, crossing, vfloat(1.0f)), vfloat(0.0f));
+				vmask clipStart = start > t0;
+				t0 = select(clipStart, start, t0);
+				sx = select(clipStart, cx, sx);
+				sy = select(clipStart, cy, sy);
+			}
+			sum = sum + select(t1 > t0, Cross(sx, sy, ex, ey), vfloat(0.0f));
+		}
+		return sum;
+	}
+
+	// Fraction of q covered by p, both in xy.
+	inline vfloat CoverageKernel(Tri p, Tri q)
+	{
+		// Work relative to q's red primary to keep the cross products well conditioned.
+		for (int v = 0; v < 3; v++)
+		{
+			ToUV(p.x[v], p.y[v]);
+			ToUV(q.x[v], q.y[v]);
+		}
+		vfloat ox = q.x[0], oy = q.y[0];
+		for (int v = 0; v < 3; v++)
+		{
+			p.x[v] = p.x[v] - ox;
+			p.y[v] = p.y[v] - oy;
+			q.x[v] = q.x[v] - ox;
+			q.y[v] = q.y[v] - oy;
+		}
+
+		MakeCounterClockwise(p);
+		vfloat qArea2 = MakeCounterClockwise(q);
+
+		Edges pEdges = MakeEdges(p);
+		Edges qEdges = MakeEdges(q);
+		Distances pDist = MakeDistances(p, qEdges);
+		Distances qDist = MakeDistances(q, pEdges);
+		Crossings X = MakeCrossings(p, pDist, q, qDist);
+		vfloat overlap2 = ClippedEdgeSum<true>(p, pDist, X) + ClippedEdgeSum<false>(q, qDist, X);
+		return overlap2 / qArea2;
+	}
+
+	// Loads lanes [i, i + width) of a triangle set, zero-padding past count.
+	inline Tri LoadTriangles(const GamutTriangles& t, size_t i, size_t count)
+	{
+		const float* planes[6] = { t.rx, t.ry, t.gx, t.gy, t.bx, t.by };
+		vfloat v[6];
+		size_t n = count - i;
+		for (int k = 0; k < 6; k++)
+		{
+			if (n >= (size_t)width)
+			{
+				v[k] = load(planes[k] + i);
+			}
+			else
+			{
+				float tmp[width] = {};
+				memcpy(tmp, planes[k] + i, n * sizeof(float));
+				v[k] = load(tmp);
+			}
+		}
+		Tri r;
+		for (int k = 0; k < 3; k++)
+		{
+			r.x[k] = v[2 * k];
+			r.y[k] = v[2 * k + 1];
+		}
+		return r;
+	}
+
+	inline Tri Broadcast(const float2& r, const float2& g, const float2& b)
+	{
+		Tri t;
+		t.x[0] = r.x; t.y[0] = r.y;
+		t.x[1] = g.x; t.y[1] = g.y;
+		t.x[2] = b.x; t.y[2] = b.y;
+		return t;
+	}
+
+	inline void StoreLanes(float* out, size_t i, size_t count, vfloat value)
+	{
+		size_t n = count - i;
+		if (n >= (size_t)width)
+		{
+			store(out + i, value);
+			return;
+		}
+		float tmp[width];
+		store(tmp, value);
+		memcpy(out + i, tmp, n * sizeof(float));
+	}
+}
+
+void ComputeGamutArea(const GamutTriangles& triangles, float* area, size_t count)
+{
+	for (size_t i = 0; i < count; i += width)
+	{
+		Tri t = LoadTriangles(triangles, i, count);
+		for (int v = 0; v < 3; v++)
+			ToUV(t.x[v], t.y[v]);
+
+		// Same expression as ComputeGamutArea(): cross(b - g, r - g) / 2
+		vfloat a = Cross(t.x[2] - t.x[1], t.y[2] - t.y[1], t.x[0] - t.x[1], t.y[0] - t.y[1]) * vfloat(0.5f);
+		StoreLanes(area, i, count, a);
+	}
+}
+
+void ComputeGamutCoverage(const GamutTriangles& panels, const GamutTriangles& references,
+						  float* coverage, size_t count)
+{
+	for (size_t i = 0; i < count; i += width)
+		StoreLanes(coverage, i, count, CoverageKernel(LoadTriangles(panels, i, count), LoadTriangles(references, i, count)));
+}
+
+void ComputeGamutCoverage(const GamutTriangles& panels,
+						  const float2& refRed, const float2& refGreen, const float2& refBlue,
+						  float* coverage, size_t count)
+{
+	Tri reference = Broadcast(refRed, refGreen, refBlue);
+	for (size_t i = 0; i < count; i += width)
+		StoreLanes(coverage, i, count, CoverageKernel(LoadTriangles(panels, i, count), reference));
+}
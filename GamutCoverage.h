@@ -0,0 +1,49 @@
+//
+// GamutCoverage.h
+//
+// Batch versions of ComputeGamutArea() and ComputeGamutCoverage() from ColorSpaces.h,
+// for running whole EDID / panel databases against the reference gamuts.
+//
+// Triangles are passed as structure-of-arrays xy chromaticities, and each SIMD lane
+// handles one triangle pair.  Rather than building the clipped polygon vertex by vertex,
+// which needs a per-lane vertex count, the overlap area is integrated along its boundary
+// (Green's theorem): the part of each edge of either triangle that lies inside the other
+// contributes cross(start, end).  That is a fixed 18 edge/half-plane tests per pair with
+// no branches and no sort.
+//
+// Like the scalar functions the math is in CIE 1976 uv, and coverage is the fraction of
+// the reference (second) triangle covered by the panel (first) triangle.  Either winding
+// order is accepted.  Results match the scalar ComputeGamutCoverage() to within 3e-6
+// absolute, including panels that share vertices or edges with the reference.
+//
+// Tail elements that do not fill a SIMD block are handled; count need not be a multiple
+// of the vector width.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include "BasicMath.h"
+
+// Structure-of-arrays set of gamut triangles in CIE 1931 xy.
+struct GamutTriangles
+{
+	const float* rx;
+	const float* ry;
+	const float* gx;
+	const float* gy;
+	const float* bx;
+	const float* by;
+};
+
+// area[i] = ComputeGamutArea(r[i], g[i], b[i]), i.e. the signed uv area.
+void ComputeGamutArea(const GamutTriangles& triangles, float* area, size_t count);
+
+// coverage[i] = ComputeGamutCoverage(panel i, reference i).
+void ComputeGamutCoverage(const GamutTriangles& panels, const GamutTriangles& references,
+						  float* coverage, size_t count);
+
+// coverage[i] = ComputeGamutCoverage(panel i, reference), one reference for the whole batch.
+void ComputeGamutCoverage(const GamutTriangles& panels,
+						  const float2& refRed, const float2& refGreen, const float2& refBlue,
+						  float* coverage, size_t count);
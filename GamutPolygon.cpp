@@ -0,0 +1,259 @@
+//
+// GamutPolygon.cpp
+//
+// Spectral locus table and the general polygon clipper.  See GamutPolygon.h.
+//
+
+#include "ColorSpaces.h"
+#include "GamutPolygon.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	// CIE 1931 2-degree observer chromaticity coordinates (CIE 15:2004), 380..700 nm.
+	constexpr double LocusXY[SpectralLocusPoints][2] =
+	{
+		{ 0.17411, 0.00496 },	// 380
+		{ 0.17401, 0.00498 },	// 385
+		{ 0.17380, 0.00492 },	// 390
+		{ 0.17356, 0.00492 },	// 395
+		{ 0.17333, 0.00480 },	// 400
+		{ 0.17302, 0.00478 },	// 405
+		{ 0.17258, 0.00480 },	// 410
+		{ 0.17209, 0.00483 },	// 415
+		{ 0.17141, 0.00510 },	// 420
+		{ 0.17030, 0.00579 },	// 425
+		{ 0.16888, 0.00690 },	// 430
+		{ 0.16690, 0.00856 },	// 435
+		{ 0.16441, 0.01086 },	// 440
+		{ 0.16110, 0.01379 },	// 445
+		{ 0.15664, 0.01771 },	// 450
+		{ 0.15099, 0.02274 },	// 455
+		{ 0.14396, 0.02970 },	// 460
+		{ 0.13550, 0.03988 },	// 465
+		{ 0.12412, 0.05780 },	// 470
+		{ 0.10959, 0.08684 },	// 475
+		{ 0.09129, 0.13270 },	// 480
+		{ 0.06871, 0.20072 },	// 485
+		{ 0.04539, 0.29498 },	// 490
+		{ 0.02346, 0.41270 },	// 495
+		{ 0.00817, 0.53842 },	// 500
+		{ 0.00386, 0.65482 },	// 505
+		{ 0.01387, 0.75019 },	// 510
+		{ 0.03885, 0.81202 },	// 515
+		{ 0.07430, 0.83380 },	// 520
+		{ 0.11416, 0.82621 },	// 525
+		{ 0.15472, 0.80586 },	// 530
+		{ 0.19288, 0.78163 },	// 535
+		{ 0.22962, 0.75433 },	// 540
+		{ 0.26578, 0.72432 },	// 545
+		{ 0.30160, 0.69231 },	// 550
+		{ 0.33736, 0.65885 },	// 555
+		{ 0.37310, 0.62445 },	// 560
+		{ 0.40874, 0.58961 },	// 565
+		{ 0.44406, 0.55471 },	// 570
+		{ 0.47877, 0.52020 },	// 575
+		{ 0.51249, 0.48659 },	// 580
+		{ 0.54479, 0.45443 },	// 585
+		{ 0.57515, 0.42423 },	// 590
+		{ 0.60293, 0.39650 },	// 595
+		{ 0.62704, 0.37249 },	// 600
+		{ 0.64823, 0.35139 },	// 605
+		{ 0.66576, 0.33401 },	// 610
+		{ 0.68008, 0.31975 },	// 615
+		{ 0.69150, 0.30834 },	// 620
+		{ 0.70061, 0.29930 },	// 625
+		{ 0.70792, 0.29203 },	// 630
+		{ 0.71403, 0.28593 },	// 635
+		{ 0.71903, 0.28093 },	// 640
+		{ 0.72303, 0.27695 },	// 645
+		{ 0.72599, 0.27401 },	// 650
+		{ 0.72827, 0.27173 },	// 655
+		{ 0.72997, 0.27003 },	// 660
+		{ 0.73109, 0.26891 },	// 665
+		{ 0.73199, 0.26801 },	// 670
+		{ 0.73272, 0.26728 },	// 675
+		{ 0.73342, 0.26658 },	// 680
+		{ 0.73405, 0.26595 },	// 685
+		{ 0.73439, 0.26561 },	// 690
+		{ 0.73459, 0.26541 },	// 695
+		{ 0.73469, 0.26531 },	// 700
+	};
+
+	constexpr SpectralLocusTable MakeSpectralLocus()
+	{
+		SpectralLocusTable t = {};
+		for (int i = 0; i < SpectralLocusPoints; i++)
+		{
+			double x = LocusXY[i][0];
+			double y = LocusXY[i][1];
+			double d = -2.0 * x + 12.0 * y + 3.0;		// as xytouv()
+			t.x[i] = (float)x;
+			t.y[i] = (float)y;
+			t.u[i] = (float)(4.0 * x / d);
+			t.v[i] = (float)(9.0 * y / d);
+		}
+		return t;
+	}
+
+	// The locus as a uv point list for the clipper, built once.
+	const std::vector<float2>& LocusUV()
+	{
+		static const std::vector<float2> points = []
+		{
+			std::vector<float2> p(SpectralLocusPoints);
+			for (int i = 0; i < SpectralLocusPoints; i++)
+				p[i] = float2(SpectralLocus.u[i], SpectralLocus.v[i]);
+			return p;
+		}();
+		return points;
+	}
+
+	inline float Cross(float2 a, float2 b)
+	{
+		return a.x * b.y - a.y * b.x;
+	}
+
+	// Clips in place, ping-ponging between work and out.  On return out holds the result.
+	void ClipConvex(const float2* subject, size_t subjectCount, const float2* clip, size_t clipCount,
+					std::vector<float2>& work, std::vector<float2>& out)
+	{
+		out.assign(subject, subject + subjectCount);
+		if (clipCount < 3)
+		{
+			out.clear();
+			return;
+		}
+
+		// Inside is the left of each edge for a counter-clockwise clip polygon.
+		float sign = PolygonArea(clip, clipCount) < 0.0f ? -1.0f : 1.0f;
+
+		for (size_t i = 0; i < clipCount && !out.empty(); i++)
+		{
+			float2 a = clip[i];
+			float2 edge = clip[(i + 1) % clipCount] - a;
+
+			work.swap(out);
+			out.clear();
+
+			float2 s = work.back();
+			float ds = sign * Cross(edge, s - a);
+			for (const float2& e : work)
+			{
+				// As in Intersect() in ColorSpaces.h, crossings are placed by the ratio of the
+				// distances, which stays finite when an edge lies along the clip line.
+				float de = sign * Cross(edge, e - a);
+				if (de >= 0)
+				{
+					if (ds < 0)
+						out.push_back(s + (e - s) * (ds / (ds - de)));
+					out.push_back(e);
+				}
+				else if (ds >= 0)
+				{
+					out.push_back(s + (e - s) * (ds / (ds - de)));
+				}
+				s = e;
+				ds = de;
+			}
+		}
+	}
+
+	// Fraction of the uv subject polygon (area subjectArea) covered by the convex uv clip.
+	float Coverage(const float2* subject, size_t subjectCount, float subjectArea,
+				   const float2* clip, size_t clipCount,
+				   std::vector<float2>& work, std::vector<float2>& out)
+	{
+		ClipConvex(subject, subjectCount, clip, clipCount, work, out);
+		return out.size() < 3 ? 0.0f : PolygonArea(out.data(), out.size()) / subjectArea;
+	}
+
+	std::vector<float2> ToUV(const float2* xy, size_t count)
+	{
+		std::vector<float2> uv(count);
+		for (size_t i = 0; i < count; i++)
+			uv[i] = xytouv(xy[i]);
+		return uv;
+	}
+
+	// Coverage of one uv reference by each panel triangle, in blocks of panels that share
+	// their clipper scratch.  referenceArea carries the sign of the reference's winding.
+	void BatchCoverage(const GamutTriangles& panels, const float2* referenceUV, size_t referenceCount,
+					   float referenceArea, float* coverage, size_t count, ThreadPool* pool)
+	{
+		const size_t block = 256;
+		if (!pool)
+			pool = &ThreadPool::Default();
+		pool->ParallelFor(0, (count + block - 1) / block, [&](size_t b)
+		{
+			std::vector<float2> work, out;
+			size_t end = (b + 1) * block < count ? (b + 1) * block : count;
+			for (size_t i = b * block; i < end; i++)
+			{
+				float2 panelUV[3] =
+				{
+					xytouv(float2(panels.rx[i], panels.ry[i])),
+					xytouv(float2(panels.gx[i], panels.gy[i])),
+					xytouv(float2(panels.bx[i], panels.by[i])),
+				};
+				coverage[i] = Coverage(referenceUV, referenceCount, referenceArea, panelUV, 3, work, out);
+			}
+		});
+	}
+}
+
+constexpr SpectralLocusTable SpectralLocus = MakeSpectralLocus();
+
+float PolygonArea(const float2* points, size_t count)
+{
+	// Relative to the first point, which keeps the cross products small.
+	float sum = 0.0f;
+	for (size_t i = 1; i + 1 < count; i++)
+		sum += Cross(points[i] - points[0], points[i + 1] - points[0]);
+	return 0.5f * sum;
+}
+
+void ClipPolygon(const float2* subject, size_t subjectCount,
+				 const float2* clip, size_t clipCount, std::vector<float2>& out)
+{
+	std::vector<float2> work;
+	ClipConvex(subject, subjectCount, clip, clipCount, work, out);
+}
+
+float ComputeLocusArea()
+{
+	static const float area = -PolygonArea(LocusUV().data(), LocusUV().size());		// clockwise
+	return area;
+}
+
+float ComputePolygonCoverage(const float2* panel, size_t panelCount,
+							 const float2* reference, size_t referenceCount)
+{
+	std::vector<float2> panelUV = ToUV(panel, panelCount);
+	std::vector<float2> referenceUV = ToUV(reference, referenceCount);
+	std::vector<float2> work, out;
+	float referenceArea = PolygonArea(referenceUV.data(), referenceCount);
+	return Coverage(referenceUV.data(), referenceCount, referenceArea, panelUV.data(), panelCount, work, out);
+}
+
+float ComputeLocusCoverage(float2 r, float2 g, float2 b)
+{
+	float2 panelUV[3] = { xytouv(r), xytouv(g), xytouv(b) };
+	std::vector<float2> work, out;
+	const std::vector<float2>& locus = LocusUV();
+	return Coverage(locus.data(), locus.size(), -ComputeLocusArea(), panelUV, 3, work, out);
+}
+
+void ComputePolygonCoverage(const GamutTriangles& panels, const float2* reference, size_t referenceCount,
+							float* coverage, size_t count, ThreadPool* pool)
+{
+	std::vector<float2> referenceUV = ToUV(reference, referenceCount);
+	BatchCoverage(panels, referenceUV.data(), referenceCount, PolygonArea(referenceUV.data(), referenceCount),
+				  coverage, count, pool);
+}
+
+void ComputeLocusCoverage(const GamutTriangles& panels, float* coverage, size_t count, ThreadPool* pool)
+{
+	const std::vector<float2>& locus = LocusUV();
+	BatchCoverage(panels, locus.data(), locus.size(), -ComputeLocusArea(), coverage, count, pool);
+}
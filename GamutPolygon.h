@@ -0,0 +1,63 @@
+//
+// GamutPolygon.h
+//
+// Coverage figures for gamuts that are not triangles.  The triangle code in ColorSpaces.h
+// and GamutCoverage.h is built around Polygon6 (two triangles clip to at most six
+// vertices); this handles polygons with any vertex count: the CIE 1931 spectral locus
+// for "% of human vision", panels with more than three primaries, and arbitrary
+// polygonal reference gamuts.
+//
+// Inputs are CIE 1931 xy and, like ComputeGamutCoverage(), the areas are measured in
+// CIE 1976 uv.  A polygon is clipped against a convex polygon exactly (Sutherland-
+// Hodgman), so the results carry only float rounding -- about 1e-6 relative.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+#include "BasicMath.h"
+#include "GamutCoverage.h"
+
+class ThreadPool;
+
+// CIE 1931 2-degree standard observer spectral locus, 380 to 700 nm in 5 nm steps (the
+// chromaticity does not move past 700 nm at five decimals).  The polygon is closed by the
+// line of purples from 700 nm back to 380 nm.  Winding is clockwise in both xy and uv.
+const int SpectralLocusPoints = 65;
+
+struct SpectralLocusTable
+{
+	float x[SpectralLocusPoints];		// CIE 1931 xy
+	float y[SpectralLocusPoints];
+	float u[SpectralLocusPoints];		// CIE 1976 u'v', converted at compile time
+	float v[SpectralLocusPoints];
+};
+extern const SpectralLocusTable SpectralLocus;
+
+// Signed area, positive for counter-clockwise winding.
+float PolygonArea(const float2* points, size_t count);
+
+// Clips subject, a simple polygon with any number of vertices, convex or not, against a
+// convex polygon.  Either may have either winding.  out receives the intersection (empty
+// if they do not overlap) in the subject's winding.  Both must be in the same space.
+void ClipPolygon(const float2* subject, size_t subjectCount,
+				 const float2* clip, size_t clipCount, std::vector<float2>& out);
+
+// Area of the spectral locus in uv.
+float ComputeLocusArea();
+
+// Fraction of the reference polygon covered by the panel polygon, which must be convex
+// (as a gamut of additive primaries always is).  Both in xy.
+float ComputePolygonCoverage(const float2* panel, size_t panelCount,
+							 const float2* reference, size_t referenceCount);
+
+// Fraction of the spectral locus covered by the panel triangle: "% of human vision".
+float ComputeLocusCoverage(float2 r, float2 g, float2 b);
+
+// Batch versions over structure-of-arrays panel triangles (see GamutCoverage.h).  Work is
+// spread over pool, or ThreadPool::Default() when pool is null.
+void ComputeLocusCoverage(const GamutTriangles& panels, float* coverage, size_t count,
+						  ThreadPool* pool = nullptr);
+void ComputePolygonCoverage(const GamutTriangles& panels, const float2* reference, size_t referenceCount,
+							float* coverage, size_t count, ThreadPool* pool = nullptr);
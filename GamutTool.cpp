@@ -0,0 +1,731 @@
+//
+// GamutTool.cpp
+//
+// Command-line gamut analysis.  This is the old gamut.exe main() that used to sit under
+// #if 0 in ColorSpaces.h, grown into a batch tool for panel databases.
+//
+// With primaries on the command line it prints one panel, as before.  Given a CSV or
+// JSONL file (or - for stdin) it reads one panel per row and writes one result row per
+// panel, in input order: uv gamut area, Lab and Luv volume, the ComputeGamutCoverage
+// of sRGB, AdobeRGB, DCI-P3, BT.2020 and ACES AP0, and the coverage of the CIE 1931
+// spectral locus -- the same numbers the PanelCharacteristics pattern shows.
+//
+// Rows are read in blocks; area and coverage for a block go through the SIMD batch
+// kernels in GamutCoverage.h, locus coverage through GamutPolygon.h, the volumes are
+// solved across the ThreadPool, and the block is written out, so memory stays flat
+// however long the input is.  The volume solve dominates, and its cost goes as 1/step^2:
+// at --step 1, the legacy numbers, it is about 2.5 ms per panel, 350 to 450 panels per
+// second per core, or four minutes per 100k panels on one core.  Files therefore default
+// to --step 4: about 5,500 panels per second per core, so 100k panels take under 20 s on
+// one core and a few seconds across a workstation's, with volumes within 1% of the
+// --step 1 ones.  With --no-volume the tool runs at a few hundred thousand panels per
+// second, bound by parsing and formatting.
+//
+// Not part of the app project; build it directly, e.g.
+//
+//   g++ -std=c++17 -O2 -pthread GamutTool.cpp GamutCoverage.cpp GamutPolygon.cpp GamutVolume.cpp ThreadPool.cpp -o gamut
+//   cl /std:c++17 /O2 /EHsc GamutTool.cpp GamutCoverage.cpp GamutPolygon.cpp GamutVolume.cpp ThreadPool.cpp /Fe:gamut.exe
+//
+// Input rows carry id, rx, ry, gx, gy, bx, by and optionally wx, wy (default D65):
+//
+//   CSV    header line naming the columns in any order, or no header and the columns in
+//          that order, with or without the leading id.  Lines starting with # are skipped.
+//   JSONL  one flat object per line, e.g. {"id":"A1","rx":0.68,"ry":0.32,...}
+//
+
+#include "ColorSpaces.h"
+#include "GamutCoverage.h"
+#include "GamutPolygon.h"
+#include "GamutVolume.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <ctype.h>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// Reference gamuts every panel is compared against, in output column order.
+	struct ReferenceGamut
+	{
+		const char* name;
+		float2      r, g, b;
+	};
+
+	const ReferenceGamut ReferenceGamuts[] =
+	{
+		{ "srgb",   primaryR_709,   primaryG_709,   primaryB_709   },
+		{ "adobe",  primaryR_Adobe, primaryG_Adobe, primaryB_Adobe },
+		{ "dcip3",  primaryR_DCIP3, primaryG_DCIP3, primaryB_DCIP3 },
+		{ "bt2020", primaryR_2020,  primaryG_2020,  primaryB_2020  },
+		{ "aces",   primaryR_ACES,  primaryG_ACES,  primaryB_ACES  },
+	};
+	const int NumReferenceGamuts = sizeof(ReferenceGamuts) / sizeof(ReferenceGamuts[0]);
+
+	const size_t BlockRows = 4096;			// rows read, evaluated and written per block
+	const float  BatchStep = 4.0f;			// default volume step for files; see the top
+
+	enum class Format
+	{
+		Auto,
+		Csv,
+		Jsonl,
+	};
+
+	struct Options
+	{
+		Format   inFormat  = Format::Auto;
+		Format   outFormat = Format::Csv;
+		float    step      = 1.0f;
+		bool     volume    = true;
+		unsigned threads   = 0;
+		const char* inPath  = nullptr;
+		const char* outPath = nullptr;
+	};
+
+	struct Panel
+	{
+		std::string id;
+		float2      red, green, blue, white;
+		size_t      line;					// 1-based input line, for diagnostics
+	};
+
+	// Field order of a headerless CSV row, and the keys looked up in a JSONL object.
+	enum Field { Id, Rx, Ry, Gx, Gy, Bx, By, Wx, Wy, NumFields };
+	const char* const FieldNames[NumFields] = { "id", "rx", "ry", "gx", "gy", "bx", "by", "wx", "wy" };
+
+	void PrintUsage()
+	{
+		fprintf(stderr,
+			"Usage: gamut r_x r_y g_x g_y b_x b_y [w_x w_y]\n"
+			"       gamut [options] <panels.csv | panels.jsonl | ->\n"
+			"  r_[x,y]: chromaticity of red primary\n"
+			"  g_[x,y]: chromaticity of green primary\n"
+			"  b_[x,y]: chromaticity of blue primary\n"
+			"  w_[x,y]: chromaticity of white point (default: D65 <0.3127, 0.3290>)\n"
+			"Batch input, one panel per row (white defaults to D65, id to the line number):\n"
+			"  CSV    columns id,rx,ry,gx,gy,bx,by,wx,wy -- a header naming them in any order\n"
+			"         (id, wx, wy optional, others ignored), or no header and that order\n"
+			"  JSONL  one object per line with keys id, rx, ry, gx, gy, bx, by, wx, wy,\n"
+			"         e.g. {\"id\":\"A1\",\"rx\":0.68,\"ry\":0.32,...}\n"
+			"Options:\n"
+			"  --in csv|jsonl    input format (default: from the file extension, csv for stdin)\n"
+			"  --out csv|jsonl   output format (default: csv)\n"
+			"  -o <file>         write results to file instead of stdout\n"
+			"  --step <s>        volume grid spacing in delta-E, 1/64 to 100 (default: 1, the\n"
+			"                    legacy numbers, for one panel; 4 for a file, 16x faster and\n"
+			"                    within 1%% of them)\n"
+			"  --no-volume       skip the Lab/Luv volume columns\n"
+			"  --threads <n>     worker threads (default: one per hardware thread)\n");
+	}
+
+	bool ParseFormat(const char* s, Format& format)
+	{
+		if (!strcmp(s, "csv"))   { format = Format::Csv;   return true; }
+		if (!strcmp(s, "jsonl")) { format = Format::Jsonl; return true; }
+		return false;
+	}
+
+	bool EqualsNoCase(const std::string& a, const char* b)
+	{
+		size_t n = strlen(b);
+		if (a.size() != n)
+			return false;
+		for (size_t i = 0; i < n; i++)
+			if (tolower((unsigned char)a[i]) != tolower((unsigned char)b[i]))
+				return false;
+		return true;
+	}
+
+	bool EndsWith(const char* s, const char* suffix)
+	{
+		size_t n = strlen(s), m = strlen(suffix);
+		return n >= m && !strcmp(s + n - m, suffix);
+	}
+
+	std::string Trim(const std::string& s)
+	{
+		size_t b = 0, e = s.size();
+		while (b < e && isspace((unsigned char)s[b])) b++;
+		while (e > b && isspace((unsigned char)s[e - 1])) e--;
+		if (e - b >= 2 && s[b] == '"' && s[e - 1] == '"') { b++; e--; }
+		return s.substr(b, e - b);
+	}
+
+	bool ParseFloat(const std::string& s, float& value)
+	{
+		if (s.empty())
+			return false;
+		char* end = nullptr;
+		value = strtof(s.c_str(), &end);
+		return *end == '\0';
+	}
+
+	// Twice the signed area of the xy triangle, positive counter-clockwise.
+	float TriangleArea(float2 a, float2 b, float2 c)
+	{
+		return (b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y);
+	}
+
+	// Splits a CSV line on commas, honouring double-quoted fields.
+	std::vector<std::string> SplitCsv(const std::string& line)
+	{
+		std::vector<std::string> fields(1);
+		bool quoted = false;
+		for (char c : line)
+		{
+			if (c == '"')
+				quoted = !quoted;
+			if (c == ',' && !quoted)
+				fields.emplace_back();
+			else
+				fields.back() += c;
+		}
+		for (auto& f : fields)
+			f = Trim(f);
+		return fields;
+	}
+
+	// Fills the chromaticity fields of a panel from a value per Field; missing white is D65.
+	bool MakePanel(const std::string* values, size_t line, Panel& panel, std::string& error)
+	{
+		float v[NumFields];
+		for (int i = Rx; i < NumFields; i++)
+		{
+			if (values[i].empty() && (i == Wx || i == Wy))
+			{
+				v[i] = i == Wx ? 0.3127f : 0.3290f;		// D65, as the original gamut.exe assumed
+				continue;
+			}
+			if (!ParseFloat(values[i], v[i]))
+			{
+				error = std::string("bad or missing ") + FieldNames[i];
+				return false;
+			}
+		}
+		panel.id    = values[Id].empty() ? std::to_string(line) : values[Id];
+		panel.red   = float2(v[Rx], v[Ry]);
+		panel.green = float2(v[Gx], v[Gy]);
+		panel.blue  = float2(v[Bx], v[By]);
+		panel.white = float2(v[Wx], v[Wy]);
+		panel.line  = line;
+
+		const float2* points[] = { &panel.red, &panel.green, &panel.blue, &panel.white };
+		for (const float2* p : points)
+		{
+			if (!(p->x >= 0.0f && p->x <= 1.0f && p->y > 0.0f && p->y <= 1.0f && p->x + p->y <= 1.0f + 1e-5f))
+			{
+				error = "chromaticity outside the xy diagram";
+				return false;
+			}
+		}
+
+		// The volume solve inverts the panel matrix, and inv() aborts on a singular one: the
+		// primaries must span a triangle, with the white inside it.  Same bound as
+		// PanelColorModel's.
+		const float minArea = 1.0e-6f;
+		if (!(TriangleArea(panel.red, panel.green, panel.blue) > minArea))
+		{
+			error = "primaries are degenerate or not in red, green, blue counter-clockwise order";
+			return false;
+		}
+		if (!(TriangleArea(panel.red, panel.green, panel.white) > minArea &&
+			  TriangleArea(panel.green, panel.blue, panel.white) > minArea &&
+			  TriangleArea(panel.blue, panel.red, panel.white) > minArea))
+		{
+			error = "white point is not inside the primaries";
+			return false;
+		}
+		return true;
+	}
+
+	// Streams panels out of a CSV or JSONL file a line at a time.
+	class PanelReader
+	{
+	public:
+		PanelReader(FILE* file, Format format) : m_file(file), m_format(format), m_line(0), m_headerChecked(false)
+		{
+			for (int i = 0; i < NumFields; i++)
+				m_columns[i] = -1;
+		}
+
+		// Reads up to maxRows valid panels.  Rows that fail to parse are reported and skipped.
+		size_t Read(std::vector<Panel>& panels, size_t maxRows, size_t& errors)
+		{
+			panels.clear();
+			std::string line, error;
+			while (panels.size() < maxRows && ReadLine(line))
+			{
+				m_line++;
+				std::string trimmed = Trim(line);
+				if (trimmed.empty() || trimmed[0] == '#')
+					continue;
+
+				std::string values[NumFields];
+				bool ok = m_format == Format::Jsonl ? ParseJson(trimmed, values, error)
+													: ParseCsv(trimmed, values, error);
+				if (ok == false && error.empty())
+					continue;						// header line
+
+				Panel panel;
+				if (ok && MakePanel(values, m_line, panel, error))
+				{
+					panels.push_back(std::move(panel));
+					continue;
+				}
+				fprintf(stderr, "line %zu: %s, skipped\n", m_line, error.c_str());
+				errors++;
+			}
+			return panels.size();
+		}
+
+	private:
+		bool ReadLine(std::string& line)
+		{
+			line.clear();
+			char buffer[512];
+			while (fgets(buffer, sizeof(buffer), m_file))
+			{
+				line += buffer;
+				if (line.back() == '\n')
+					return true;
+			}
+			return !line.empty();
+		}
+
+		// Returns false with an empty error for a header line.
+		bool ParseCsv(const std::string& line, std::string* values, std::string& error)
+		{
+			error.clear();
+			std::vector<std::string> fields = SplitCsv(line);
+
+			if (!m_headerChecked)
+			{
+				// A header names at least one known column, or has no numbers past the id.
+				m_headerChecked = true;
+				bool header = false, numbers = false;
+				std::string unknown;
+				for (size_t c = 0; c < fields.size(); c++)
+				{
+					bool known = false;
+					for (int i = 0; i < NumFields; i++)
+					{
+						if (EqualsNoCase(fields[c], FieldNames[i]))
+						{
+							m_columns[i] = (int)c;
+							header = known = true;
+						}
+					}
+					float value;
+					if (c > 0 && ParseFloat(fields[c], value))
+						numbers = true;
+					if (!known)
+						unknown += (unknown.empty() ? "" : ", ") + fields[c];
+				}
+				if (header || !numbers)
+				{
+					for (int i = Rx; i <= By; i++)
+					{
+						if (m_columns[i] < 0)
+						{
+							std::string message = std::string("header has no ") + FieldNames[i] + " column";
+							if (!unknown.empty())
+								message += " (unrecognised: " + unknown + ")";
+							throw std::runtime_error(message + "; expected id,rx,ry,gx,gy,bx,by,wx,wy");
+						}
+					}
+					return false;
+				}
+			}
+
+			if (m_columns[Rx] >= 0)
+			{
+				for (int i = 0; i < NumFields; i++)
+				{
+					int c = m_columns[i];
+					if (c >= 0 && (size_t)c < fields.size())
+						values[i] = fields[c];
+				}
+				return true;
+			}
+
+			// Headerless: rx..by with optional wx, wy, preceded by an id when the count is odd.
+			size_t n = fields.size();
+			if (n < 6 || n > 9)
+			{
+				error = "expected 6 to 9 columns";
+				return false;
+			}
+			size_t first = (n == 7 || n == 9) ? 1 : 0;
+			if (first)
+				values[Id] = fields[0];
+			for (size_t i = first; i < n; i++)
+				values[Rx + i - first] = fields[i];
+			return true;
+		}
+
+		// Minimal reader for flat objects of string and number members.
+		bool ParseJson(const std::string& line, std::string* values, std::string& error)
+		{
+			error.clear();
+			if (line.front() != '{' || line.back() != '}')
+			{
+				error = "not a JSON object";
+				return false;
+			}
+			for (int i = 0; i < NumFields; i++)
+			{
+				std::string key = std::string("\"") + FieldNames[i] + "\"";
+				size_t pos = line.find(key);
+				if (pos == std::string::npos)
+					continue;
+				pos = line.find_first_not_of(" \t", pos + key.size());
+				if (pos == std::string::npos || line[pos] != ':')
+					continue;
+				pos = line.find_first_not_of(" \t", pos + 1);
+				if (pos == std::string::npos)
+					continue;
+				size_t end;
+				if (line[pos] == '"')
+				{
+					end = line.find('"', pos + 1);
+					if (end == std::string::npos)
+						break;
+					values[i] = line.substr(pos + 1, end - pos - 1);
+				}
+				else
+				{
+					end = line.find_first_of(",}", pos);
+					values[i] = Trim(line.substr(pos, end - pos));
+				}
+			}
+			return true;
+		}
+
+		FILE*  m_file;
+		Format m_format;
+		size_t m_line;
+		bool   m_headerChecked;
+		int    m_columns[NumFields];
+	};
+
+	struct PanelResult
+	{
+		float             area;
+		GamutVolumeResult lab, luv;
+		float             coverage[NumReferenceGamuts];
+		float             locus;
+	};
+
+	// Area and coverage for the whole block go through the SoA kernels in GamutCoverage.h
+	// and GamutPolygon.h;
+	// the volume solves, which dominate, are spread over the pool.
+	void EvaluateBlock(const std::vector<Panel>& panels, std::vector<PanelResult>& results,
+					   const Options& options, ThreadPool& pool)
+	{
+		size_t count = panels.size();
+		results.assign(count, PanelResult());
+
+		std::vector<float> soa(6 * count);
+		float* planes[6];
+		for (int k = 0; k < 6; k++)
+			planes[k] = soa.data() + k * count;
+		for (size_t i = 0; i < count; i++)
+		{
+			planes[0][i] = panels[i].red.x;
+			planes[1][i] = panels[i].red.y;
+			planes[2][i] = panels[i].green.x;
+			planes[3][i] = panels[i].green.y;
+			planes[4][i] = panels[i].blue.x;
+			planes[5][i] = panels[i].blue.y;
+		}
+		GamutTriangles triangles = { planes[0], planes[1], planes[2], planes[3], planes[4], planes[5] };
+
+		std::vector<float> column(count);
+		ComputeGamutArea(triangles, column.data(), count);
+		for (size_t i = 0; i < count; i++)
+			results[i].area = column[i];
+		for (int r = 0; r < NumReferenceGamuts; r++)
+		{
+			const ReferenceGamut& ref = ReferenceGamuts[r];
+			ComputeGamutCoverage(triangles, ref.r, ref.g, ref.b, column.data(), count);
+			for (size_t i = 0; i < count; i++)
+				results[i].coverage[r] = column[i];
+		}
+		ComputeLocusCoverage(triangles, column.data(), count, &pool);
+		for (size_t i = 0; i < count; i++)
+			results[i].locus = column[i];
+
+		if (!options.volume)
+			return;
+
+		auto solve = [&](size_t i)
+		{
+			const Panel& panel = panels[i];
+			results[i].lab = ComputeGamutVolume(GamutVolumeSpace::Lab, panel.red, panel.green, panel.blue, panel.white, options.step, &pool);
+			results[i].luv = ComputeGamutVolume(GamutVolumeSpace::Luv, panel.red, panel.green, panel.blue, panel.white, options.step, &pool);
+		};
+		// A short block (a handful of panels) is better served by letting each volume
+		// solve spread its L planes over the pool than by one thread per panel.
+		if (count < pool.Size())
+		{
+			for (size_t i = 0; i < count; i++)
+				solve(i);
+		}
+		else
+		{
+			pool.ParallelFor(0, count, solve);
+		}
+	}
+
+	void AppendFormat(std::string& out, const char* format, double value)
+	{
+		char buffer[64];
+		snprintf(buffer, sizeof(buffer), format, value);
+		out += buffer;
+	}
+
+	void AppendCsvId(std::string& out, const std::string& id)
+	{
+		if (id.find_first_of(",\"") == std::string::npos)
+		{
+			out += id;
+			return;
+		}
+		out += '"';
+		for (char c : id)
+		{
+			if (c == '"')
+				out += '"';
+			out += c;
+		}
+		out += '"';
+	}
+
+	void AppendJsonString(std::string& out, const std::string& s)
+	{
+		out += '"';
+		for (char c : s)
+		{
+			if (c == '"' || c == '\\')
+				out += '\\';
+			out += c;
+		}
+		out += '"';
+	}
+
+	std::string CsvHeader(const Options& options)
+	{
+		std::string header = "id,area_uv";
+		if (options.volume)
+			header += ",lab_volume,luv_volume";
+		for (const ReferenceGamut& ref : ReferenceGamuts)
+			header += std::string(",coverage_") + ref.name;
+		return header + ",coverage_locus\n";
+	}
+
+	// Formats one output row; coverage is written as a fraction, as ComputeGamutCoverage returns it.
+	void FormatRow(std::string& out, const Panel& panel, const PanelResult& result, const Options& options)
+	{
+		const char* volumeFormat = options.step == 1.0f ? "%.0f" : "%.3f";
+		out.clear();
+		if (options.outFormat == Format::Jsonl)
+		{
+			out += "{\"id\":";
+			AppendJsonString(out, panel.id);
+			AppendFormat(out, ",\"area_uv\":%.6f", result.area);
+			if (options.volume)
+			{
+				out += ",\"lab_volume\":";
+				AppendFormat(out, volumeFormat, result.lab.volume);
+				out += ",\"luv_volume\":";
+				AppendFormat(out, volumeFormat, result.luv.volume);
+			}
+			for (int i = 0; i < NumReferenceGamuts; i++)
+			{
+				out += std::string(",\"coverage_") + ReferenceGamuts[i].name + "\":";
+				AppendFormat(out, "%.6f", result.coverage[i]);
+			}
+			AppendFormat(out, ",\"coverage_locus\":%.6f", result.locus);
+			out += "}\n";
+			return;
+		}
+
+		AppendCsvId(out, panel.id);
+		AppendFormat(out, ",%.6f", result.area);
+		if (options.volume)
+		{
+			out += ',';
+			AppendFormat(out, volumeFormat, result.lab.volume);
+			out += ',';
+			AppendFormat(out, volumeFormat, result.luv.volume);
+		}
+		for (int i = 0; i < NumReferenceGamuts; i++)
+			AppendFormat(out, ",%.6f", result.coverage[i]);
+		AppendFormat(out, ",%.6f", result.locus);
+		out += '\n';
+	}
+
+	int RunBatch(const Options& options)
+	{
+		FILE* in = stdin;
+		if (strcmp(options.inPath, "-"))
+		{
+			in = fopen(options.inPath, "r");
+			if (!in)
+			{
+				fprintf(stderr, "cannot open %s\n", options.inPath);
+				return 1;
+			}
+		}
+		FILE* out = stdout;
+		if (options.outPath)
+		{
+			out = fopen(options.outPath, "w");
+			if (!out)
+			{
+				fprintf(stderr, "cannot create %s\n", options.outPath);
+				return 1;
+			}
+		}
+
+		Format inFormat = options.inFormat;
+		if (inFormat == Format::Auto)
+			inFormat = EndsWith(options.inPath, ".jsonl") || EndsWith(options.inPath, ".json") ? Format::Jsonl : Format::Csv;
+
+		ThreadPool pool(options.threads);
+		PanelReader reader(in, inFormat);
+		std::vector<Panel> panels;
+		std::vector<PanelResult> results;
+		std::vector<std::string> rows(BlockRows);
+		size_t total = 0, errors = 0;
+		auto start = std::chrono::steady_clock::now();
+
+		if (options.outFormat == Format::Csv)
+			fputs(CsvHeader(options).c_str(), out);
+
+		while (true)
+		{
+			try
+			{
+				if (!reader.Read(panels, BlockRows, errors))
+					break;
+			}
+			catch (const std::exception& e)
+			{
+				fprintf(stderr, "%s\n", e.what());
+				return 1;
+			}
+
+			EvaluateBlock(panels, results, options, pool);
+			pool.ParallelFor(0, panels.size(), [&](size_t i)
+			{
+				FormatRow(rows[i], panels[i], results[i], options);
+			}, 256);
+
+			for (size_t i = 0; i < panels.size(); i++)
+				fwrite(rows[i].data(), 1, rows[i].size(), out);
+			fflush(out);
+			total += panels.size();
+		}
+
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		fprintf(stderr, "%zu panels in %.2f s (%.0f panels/s, %u threads), %zu rows skipped\n",
+				total, seconds, seconds > 0.0 ? total / seconds : 0.0, pool.Size(), errors);
+
+		if (in != stdin)
+			fclose(in);
+		if (out != stdout)
+			fclose(out);
+		return errors ? 2 : 0;
+	}
+
+	// The original single-panel mode: primaries (and white) as arguments.
+	int RunSingle(int argc, char* argv[], const Options& options)
+	{
+		std::string values[NumFields];
+		for (int i = 0; i < argc; i++)
+			values[Rx + i] = argv[i];
+
+		Panel panel;
+		std::string error;
+		if (!MakePanel(values, 0, panel, error))
+		{
+			fprintf(stderr, "%s\n", error.c_str());
+			return 1;
+		}
+		std::vector<PanelResult> results;
+		EvaluateBlock(std::vector<Panel>(1, panel), results, options, ThreadPool::Default());
+		const PanelResult& result = results[0];
+
+		if (options.volume)
+		{
+			printf("Lab Volume: %.0f\n", result.lab.volume);
+			printf("Luv Volume: %.0f\n", result.luv.volume);
+		}
+		printf("Gamut area (uv): %f\n", result.area);
+		for (int i = 0; i < NumReferenceGamuts; i++)
+			printf("%% %s coverage: %f\n", ReferenceGamuts[i].name, result.coverage[i] * 100.f);
+		printf("%% Human eye coverage: %f\n", result.locus * 100.f);
+		return 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	std::vector<char*> positional;
+	bool stepGiven = false;
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (!strcmp(arg, "--in") && hasValue && ParseFormat(argv[i + 1], options.inFormat))
+			i++;
+		else if (!strcmp(arg, "--out") && hasValue && ParseFormat(argv[i + 1], options.outFormat))
+			i++;
+		else if (!strcmp(arg, "-o") && hasValue)
+			options.outPath = argv[++i];
+		else if (!strcmp(arg, "--step") && hasValue)
+		{
+			options.step = (float)atof(argv[++i]);
+			stepGiven = true;
+		}
+		else if (!strcmp(arg, "--threads") && hasValue)
+			options.threads = (unsigned)atoi(argv[++i]);
+		else if (!strcmp(arg, "--no-volume"))
+			options.volume = false;
+		else if (arg[0] == '-' && arg[1] != '\0' && !isdigit((unsigned char)arg[1]) && arg[1] != '.')
+		{
+			PrintUsage();
+			return 1;
+		}
+		else
+			positional.push_back(argv[i]);
+	}
+
+	bool batch = positional.size() == 1;
+	if (batch && !stepGiven)
+		options.step = BatchStep;
+	if (!(options.step >= 1.0f / 64.0f && options.step <= 100.0f))
+	{
+		fprintf(stderr, "--step must be in [1/64, 100]\n");
+		return 1;
+	}
+
+	if (batch)
+	{
+		options.inPath = positional[0];
+		return RunBatch(options);
+	}
+	if (positional.size() == 6 || positional.size() == 8)
+		return RunSingle((int)positional.size(), positional.data(), options);
+
+	PrintUsage();
+	return 1;
+}
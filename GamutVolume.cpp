@@ -0,0 +1,224 @@
+//
+// GamutVolume.cpp
+//
+// Scanline-interval solver for Lab/Luv gamut volume.  See GamutVolume.h.
+//
+
+#include "GamutVolume.h"
+#include "ColorSpaces.h"
+#include "ThreadPool.h"
+
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	const double delta = 6.0 / 29.0;
+	const double Inf = std::numeric_limits<double>::infinity();
+
+	// Lab companding, same piecewise definition as f()/f_inv() in ColorSpaces.h.
+	// Both are monotonic over the whole real line and exact inverses of each other.
+	double LabF(double t)
+	{
+		return t > delta * delta * delta ? cbrt(t) : t / (3.0 * delta * delta) + 4.0 / 29.0;
+	}
+
+	double LabFInv(double t)
+	{
+		return t > delta ? t * t * t : 3.0 * delta * delta * (t - 4.0 / 29.0);
+	}
+
+	struct Interval
+	{
+		double lo;
+		double hi;
+		bool Empty() const { return !(lo <= hi); }
+	};
+
+	// Narrow [range] to the values of s for which 0 <= base + slope * s <= 1.
+	void ClipToUnit(Interval& range, double base, double slope)
+	{
+		if (slope == 0.0)
+		{
+			if (base < 0.0 || base > 1.0)
+				range.lo = Inf, range.hi = -Inf;
+			return;
+		}
+		double s0 = (0.0 - base) / slope;
+		double s1 = (1.0 - base) / slope;
+		if (s0 > s1) std::swap(s0, s1);
+		range.lo = std::max(range.lo, s0);
+		range.hi = std::min(range.hi, s1);
+	}
+
+	// Number of grid points origin + j*step (0 <= j < count) that fall in [lo, hi].
+	uint64_t CountGridPoints(double lo, double hi, double origin, double step, int count)
+	{
+		if (!(lo <= hi))
+			return 0;
+		double jlo = ceil((lo - origin) / step);
+		double jhi = floor((hi - origin) / step);
+		jlo = std::max(jlo, 0.0);
+		jhi = std::min(jhi, (double)(count - 1));
+		return jhi >= jlo ? (uint64_t)(jhi - jlo + 1) : 0;
+	}
+
+	// Finer steps than this run for minutes and, below about 1e-7, overflow the counts.
+	const float MinStep = 1.0f / 64.0f;
+
+	// Determinant of the primaries' matrix as Make_XYZ_to_RGB_Matrix() builds it, for
+	// the same test inv() makes: collinear primaries or a zero y would abort the process
+	// there.  Not finite when a y is zero.
+	double PrimaryDeterminant(const float2& R, const float2& G, const float2& B)
+	{
+		float3x3 m;
+		m._11 = R.x / R.y;
+		m._12 = G.x / G.y;
+		m._13 = B.x / B.y;
+		m._21 = m._22 = m._23 = 1.0f;
+		m._31 = (1.0f - R.x - R.y) / R.y;
+		m._32 = (1.0f - G.x - G.y) / G.y;
+		m._33 = (1.0f - B.x - B.y) / B.y;
+		return (double)m._11 * ((double)m._22 * m._33 - (double)m._23 * m._32)
+			 - (double)m._12 * ((double)m._21 * m._33 - (double)m._23 * m._31)
+			 + (double)m._13 * ((double)m._21 * m._32 - (double)m._22 * m._31);
+	}
+
+	struct Setup
+	{
+		double M[3][3];			// XYZ -> RGB
+		double W[3];			// white XYZ, Y = 100
+		double step;
+		int    countL;			// grid points along L
+		int    countAB;			// grid points along a/b (u/v)
+	};
+
+	// Grid points with this L and a whose b lands inside the RGB cube.
+	uint64_t CountRowLab(const Setup& s, double L, double a)
+	{
+		double fy = (L + 16.0) / 116.0;
+		double X = s.W[0] * LabFInv(fy + a / 500.0);
+		double Y = s.W[1] * LabFInv(fy);
+
+		// RGB is affine in Z along the row; solve for the Z range in the cube.
+		Interval Z = { -Inf, Inf };
+		for (int i = 0; i < 3; i++)
+			ClipToUnit(Z, s.M[i][0] * X + s.M[i][1] * Y, s.M[i][2]);
+		if (Z.Empty())
+			return 0;
+
+		// Z = Wz * f_inv(fy - b/200) decreases with b, so the Z range maps to one b range.
+		double bLo = 200.0 * (fy - LabF(Z.hi / s.W[2]));
+		double bHi = 200.0 * (fy - LabF(Z.lo / s.W[2]));
+		return CountGridPoints(bLo, bHi, -200.0, s.step, s.countAB);
+	}
+
+	// Grid points with this L and u whose v lands inside the RGB cube.
+	uint64_t CountRowLuv(const Setup& s, double L, double u)
+	{
+		const double* W = s.W;
+		double denomW = W[0] + 15.0 * W[1] + 3.0 * W[2];
+		double un = 4.0 * W[0] / denomW;
+		double vn = 9.0 * W[1] / denomW;
+
+		double fy = (L + 16.0) / 116.0;
+		double Y = L <= 8.0 ? W[1] * L * (delta / 2.0) * (delta / 2.0) * (delta / 2.0)
+							: W[1] * fy * fy * fy;
+		double up = u / (13.0 * L) + un;
+
+		// With w = 1/v':  X = (9 Y u'/4) w,  Z = (Y (12 - 3u')/4) w - 5Y,
+		// so RGB is affine in w along the row.
+		double Xw = 9.0 * Y * up / 4.0;
+		double Zw = Y * (12.0 - 3.0 * up) / 4.0;
+		Interval w = { -Inf, Inf };
+		for (int i = 0; i < 3; i++)
+			ClipToUnit(w, s.M[i][1] * Y - 5.0 * Y * s.M[i][2], s.M[i][0] * Xw + s.M[i][2] * Zw);
+		if (w.Empty())
+			return 0;
+
+		// Map back through v' = 1/w, v = 13 L (v' - vn).  An interval straddling w = 0
+		// becomes the two outer rays in v'.
+		auto toV = [&](double vp) { return 13.0 * L * (vp - vn); };
+		if (w.lo > 0.0 || w.hi < 0.0)
+			return CountGridPoints(toV(1.0 / w.hi), toV(1.0 / w.lo), -200.0, s.step, s.countAB);
+
+		uint64_t n = 0;
+		if (w.lo < 0.0)
+			n += CountGridPoints(-Inf, toV(1.0 / w.lo), -200.0, s.step, s.countAB);
+		if (w.hi > 0.0)
+			n += CountGridPoints(toV(1.0 / w.hi), Inf, -200.0, s.step, s.countAB);
+		return n;
+	}
+}
+
+GamutVolumeResult ComputeGamutVolume(GamutVolumeSpace space,
+									 const float2& red_xy, const float2& green_xy, const float2& blue_xy,
+									 const float2& white_xy, float step, ThreadPool* pool)
+{
+	// Also false for NaN; a tiny step would size the grid from an overflowing count.
+	if (!(step >= MinStep && step < std::numeric_limits<float>::infinity()))
+		throw std::invalid_argument("Gamut volume step must be at least 1/64 and finite");
+	double det = PrimaryDeterminant(red_xy, green_xy, blue_xy);
+	if (!(fabs(det) >= 1.0e-9 && fabs(det) < Inf))
+		throw std::invalid_argument("Gamut volume primaries are collinear or have a y of zero");
+	if (!(white_xy.y > 0.0f))
+		throw std::invalid_argument("Gamut volume white point must have a positive y");
+
+	const float Y = 100.0f;
+	float3 white_XYZ = xytoXYZ(white_xy, Y);
+	float3x3 XYZRGB = Make_XYZ_to_RGB_Matrix(red_xy, green_xy, blue_xy, white_xy, Y);
+
+	Setup s;
+	for (int i = 0; i < 3; i++)
+		for (int j = 0; j < 3; j++)
+			s.M[i][j] = XYZRGB[i][j];
+	s.W[0] = white_XYZ.x;
+	s.W[1] = white_XYZ.y;
+	s.W[2] = white_XYZ.z;
+	s.step = step;
+	s.countL = (int)lround(100.0 / step) + 1;
+	s.countAB = (int)lround(400.0 / step) + 1;
+
+	if (!pool)
+		pool = &ThreadPool::Default();
+
+	// One task per L plane; per-plane sums keep the total independent of scheduling.
+	std::vector<uint64_t> planes(s.countL, 0);
+	pool->ParallelFor(0, s.countL, [&](size_t iL)
+	{
+		double L = iL * s.step;
+		uint64_t hits = 0;
+
+		if (space == GamutVolumeSpace::Luv && iL == 0)
+		{
+			// Luv is undefined at L = 0 except for black itself.
+			hits = CountGridPoints(0.0, 0.0, -200.0, s.step, s.countAB) ? 1 : 0;
+		}
+		else
+		{
+			for (int ia = 0; ia < s.countAB; ia++)
+			{
+				double a = -200.0 + ia * s.step;
+				hits += space == GamutVolumeSpace::Lab ? CountRowLab(s, L, a) : CountRowLuv(s, L, a);
+			}
+		}
+		planes[iL] = hits;
+	});
+
+	GamutVolumeResult result = {};
+	for (uint64_t hits : planes)
+		result.samples += hits;
+	result.volume = (double)result.samples * step * step * step;
+	return result;
+}
+
+float gamutVolumeLab(const float2& red_xy, const float2 green_xy, const float2& blue_xy, const float2& white_xy)
+{
+	return (float)ComputeGamutVolume(GamutVolumeSpace::Lab, red_xy, green_xy, blue_xy, white_xy).samples;
+}
+
+float gamutVolumeLuv(const float2& red_xy, const float2 green_xy, const float2& blue_xy, const float2& white_xy)
+{
+	return (float)ComputeGamutVolume(GamutVolumeSpace::Luv, red_xy, green_xy, blue_xy, white_xy).samples;
+}
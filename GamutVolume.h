@@ -0,0 +1,51 @@
+//
+// GamutVolume.h
+//
+// Analytic gamut volume in CIE Lab / Luv, replacing the brute-force sampling loops that
+// gamutVolumeLab() and gamutVolumeLuv() used to run.
+//
+// The volume is still defined as the number of grid points (L in 0..100, a/b or u/v in
+// -200..200) whose color lies inside the RGB cube, so the numbers stay comparable with
+// the gamutVolume* constants.  Rather than testing every point, each (L, a) row solves
+// for the single interval of b that maps inside the cube and counts the grid points in
+// it.  That is O(L*a) instead of O(L*a*b), in double precision, spread over a ThreadPool.
+//
+// Agreement with the old float sampling loops is within 0.001% for sRGB, Adobe, DCI-P3
+// and BT.2020 and 0.03% for ACES AP0; the only differences are boundary points where
+// the float code rounded the other way.  A unit-step evaluation takes a few ms.
+// One deliberate difference: at L = 0 the Luv loop divided by L and counted the NaNs as
+// hits, a spurious 401x401 plane.  Here L = 0 contributes only the black point.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include "BasicMath.h"
+
+class ThreadPool;
+
+enum class GamutVolumeSpace
+{
+	Lab,
+	Luv,
+};
+
+struct GamutVolumeResult
+{
+	uint64_t samples;		// grid points inside the gamut
+	double   volume;		// samples * step^3, i.e. volume in cubic delta-E units
+};
+
+// step is the grid spacing in delta-E units; it should divide 100 and 200 evenly
+// (1.0 matches the legacy numbers, 0.25 is used for the fleet reports).  Throws
+// std::invalid_argument unless step is finite and at least 1/64, and for primaries that
+// inv() could not invert (collinear, or a y of zero) or a white point with y <= 0.
+// pool == nullptr uses ThreadPool::Default().
+GamutVolumeResult ComputeGamutVolume(GamutVolumeSpace space,
+									 const float2& red_xy, const float2& green_xy, const float2& blue_xy,
+									 const float2& white_xy, float step = 1.0f, ThreadPool* pool = nullptr);
+
+// Unit-step sample counts, the legacy interface compared against the gamutVolume*
+// constants in ColorSpaces.h.
+float gamutVolumeLab(const float2& red_xy, const float2 green_xy, const float2& blue_xy, const float2& white_xy);
+float gamutVolumeLuv(const float2& red_xy, const float2 green_xy, const float2& blue_xy, const float2& white_xy);
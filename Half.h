@@ -0,0 +1,66 @@
+//
+// Half.h
+//
+// Scalar IEEE 754 half conversions, for code that handles one FP16 value at a time: the
+// PQ code table search, the sweep's reference decode and benchmark setup.  The vector
+// kernels use tohalf()/fromhalf() in SimdMath.h, which follow the same steps lane by
+// lane; HalfTest checks that the two agree bit for bit on every half.
+//
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+// float -> half bits.  Round to nearest even, exact subnormals, overflow to infinity and
+// NaN to a quiet NaN.
+inline uint16_t FloatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint32_t sign = (bits >> 16) & 0x8000;
+	float a = fabsf(value);
+
+	if (!(a <= INFINITY))
+		return (uint16_t)(sign | 0x7E00);
+	if (a >= 65520.0f)
+		return (uint16_t)(sign | 0x7C00);
+
+	uint32_t abits;
+	if (a < 6.103515625e-05f)
+	{
+		// Adding 0.5, whose ulp is 2^-24, makes the FPU round to the half step.
+		float biased = a + 0.5f;
+		memcpy(&abits, &biased, sizeof(abits));
+		return (uint16_t)(sign | (abits - 0x3F000000));
+	}
+
+	memcpy(&abits, &a, sizeof(abits));
+	uint32_t odd = (abits >> 13) & 1;
+	return (uint16_t)(sign | ((abits + ((uint32_t)(15 - 127) << 23) + 0xFFF + odd) >> 13));
+}
+
+// half bits -> float.  Exact for every half, subnormals, infinities and NaNs included.
+inline float HalfToFloat(uint16_t half)
+{
+	uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+	uint32_t exponent = (half >> 10) & 0x1F;
+	uint32_t mantissa = half & 0x3FF;
+
+	uint32_t bits;
+	if (exponent == 0)
+	{
+		float a = (float)mantissa * 5.9604644775390625e-08f;		// 2^-24
+		memcpy(&bits, &a, sizeof(bits));
+		bits |= sign;
+	}
+	else if (exponent == 0x1F)
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	else
+		bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
@@ -0,0 +1,254 @@
+//
+// HalfPQSweep.cpp
+//
+// Exhaustive FP16 to HDR10 sweep.  See HalfPQSweep.h.
+//
+
+#include "ColorSpaces.h"
+#include "Half.h"
+#include "HalfPQSweep.h"
+#include "SimdMath.h"
+#include "ThreadPool.h"
+
+#include <chrono>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+	const int HalfCount = 1 << 16;
+	const int BlockSize = 1024;					// halves per task, a multiple of every SIMD width
+
+	const uint16_t PositiveInfinity = 0x7C00;
+	const uint16_t NegativeZero     = 0x8000;
+	const uint16_t NegativeInfinity = 0xFC00;
+
+	// ST.2084 in double, as Apply2084() in ColorSpaces.h.
+	double Apply2084Double(double L)
+	{
+		const double m1 = 2610.0 / 4096.0 / 4.0;
+		const double m2 = 2523.0 / 4096.0 * 128.0;
+		const double c1 = 3424.0 / 4096.0;
+		const double c2 = 2413.0 / 4096.0 * 32.0;
+		const double c3 = 2392.0 / 4096.0 * 32.0;
+		double Lp = pow(L, m1);
+		return pow((c1 + c2 * Lp) / (1.0 + c3 * Lp), m2);
+	}
+
+	float3 Input(HalfPQInput input, float value)
+	{
+		switch (input)
+		{
+		case HalfPQInput::Red:   return float3(value, 0.0f, 0.0f);
+		case HalfPQInput::Green: return float3(0.0f, value, 0.0f);
+		case HalfPQInput::Blue:  return float3(0.0f, 0.0f, value);
+		default:                 return float3(value, value, value);
+		}
+	}
+
+	bool IsNaN(uint16_t half)
+	{
+		return (half & 0x7C00) == 0x7C00 && (half & 0x03FF) != 0;
+	}
+
+	uint32_t Bits(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		return bits;
+	}
+
+	// What each half scans out as.
+	struct Sample
+	{
+		uint16_t code[3];
+		bool     nan;				// any channel's signal is NaN
+		bool     misrounded[3];
+		float    error[3];			// code steps against the double evaluation
+	};
+
+	struct BlockResult
+	{
+		uint32_t decodeErrors;
+	};
+
+	BlockResult SweepBlock(const HalfPQOptions& options, int first, Sample* samples)
+	{
+		using namespace simd;
+
+		const float maxCode = (float)((1u << options.bits) - 1);
+		float3x3 rotation = mat709to2020;
+		BlockResult result = {};
+
+		// Decode the block with the vector path, and re-encode it to check the pair.
+		alignas(32) float values[BlockSize];
+		alignas(32) int32_t reencoded[BlockSize];
+		for (int i = 0; i < BlockSize; i += width)
+		{
+			vint half = vint(first + i) + toint(ramp());
+			vfloat value = fromhalf(half);
+			store(values + i, value);
+			storei(reencoded + i, tohalf(value));
+		}
+
+		for (int i = 0; i < BlockSize; i++)
+		{
+			uint16_t half = (uint16_t)(first + i);
+			Sample& sample = samples[i];
+
+			bool nan = IsNaN(half);
+			if (Bits(values[i]) != Bits(HalfToFloat(half)) || (!nan && (uint16_t)reencoded[i] != half))
+				result.decodeErrors++;
+
+			float3 in = Input(options.input, values[i]);
+			float3 out = options.rotate ? Linear709ToHDR10(in) : Apply2084(in * 0.008f);
+			const float input[3] = { in.x, in.y, in.z };
+			const float signal[3] = { out.x, out.y, out.z };
+
+			// The same formula in double, from the same float matrix.
+			double ref[3];
+			for (int c = 0; c < 3; c++)
+			{
+				double linear = options.rotate ?
+					(double)rotation[c][0] * input[0] + (double)rotation[c][1] * input[1] + (double)rotation[c][2] * input[2] :
+					(double)input[c];
+				linear = linear * 0.008;
+				linear = linear > 1.0 ? 1.0 : (linear < 0.0 ? 0.0 : linear);
+				ref[c] = nan ? 0.0 : Apply2084Double(linear);
+			}
+
+			sample.nan = false;
+			for (int c = 0; c < 3; c++)
+			{
+				float s = signal[c];
+				if (!(s == s))
+				{
+					sample.nan = true;
+					sample.code[c] = 0;
+					sample.misrounded[c] = false;
+					sample.error[c] = 0.0f;
+					continue;
+				}
+				sample.code[c] = (uint16_t)roundf(s * maxCode);
+				sample.misrounded[c] = sample.code[c] != (uint16_t)llround(ref[c] * maxCode);
+				sample.error[c] = (float)fabs(((double)s - ref[c]) * maxCode);
+			}
+		}
+		return result;
+	}
+}
+
+bool HalfPQReport::Passed() const
+{
+	for (auto& channel : channels)
+	{
+		if (!channel.gaps.empty() || !channel.nonMonotonic.empty())
+			return false;
+	}
+	return halfDecodeErrors == 0 && badNegatives == 0 && badInfinities == 0;
+}
+
+void SweepHalfToPQ(const HalfPQOptions& options, HalfPQReport* report, ThreadPool* pool)
+{
+	if (!pool)
+		pool = &ThreadPool::Default();
+
+	auto start = std::chrono::steady_clock::now();
+	const uint32_t maxCode = (1u << options.bits) - 1;
+
+	std::vector<Sample> samples(HalfCount);
+	std::vector<BlockResult> blocks(HalfCount / BlockSize);
+	pool->ParallelFor(0, blocks.size(), [&](size_t block)
+	{
+		int first = (int)block * BlockSize;
+		blocks[block] = SweepBlock(options, first, samples.data() + first);
+	});
+
+	report->options = options;
+	report->halfDecodeErrors = 0;
+	for (auto& block : blocks)
+		report->halfDecodeErrors += block.decodeErrors;
+
+	// Non-negative finite halves, 0 up to 65504, are in value order as integers.
+	for (int c = 0; c < 3; c++)
+	{
+		HalfPQChannel& channel = report->channels[c];
+		channel.ranges.assign(maxCode + 1, HalfPQCodeRange());
+		channel.gaps.clear();
+		channel.nonMonotonic.clear();
+		channel.lowest = maxCode;
+		channel.highest = 0;
+		channel.worstError = 0.0;
+		channel.worstHalf = 0;
+		channel.misrounded = 0;
+
+		uint32_t previous = 0;
+		for (uint32_t half = 0; half < PositiveInfinity; half++)
+		{
+			const Sample& sample = samples[half];
+			uint32_t code = sample.code[c];
+
+			HalfPQCodeRange& range = channel.ranges[code];
+			if (range.count++ == 0)
+				range.first = (uint16_t)half;
+			range.last = (uint16_t)half;
+
+			if (half > 0 && code < previous)
+				channel.nonMonotonic.push_back((uint16_t)half);
+			previous = code;
+
+			channel.lowest = std::min(channel.lowest, code);
+			channel.highest = std::max(channel.highest, code);
+		}
+
+		for (uint32_t code = channel.lowest; code <= channel.highest; code++)
+		{
+			if (channel.ranges[code].count == 0)
+				channel.gaps.push_back(code);
+		}
+
+		for (uint32_t half = 0; half < (uint32_t)HalfCount; half++)
+		{
+			const Sample& sample = samples[half];
+			if (IsNaN((uint16_t)half) || sample.nan)
+				continue;
+			channel.misrounded += sample.misrounded[c];
+			if (sample.error[c] > channel.worstError)
+			{
+				channel.worstError = sample.error[c];
+				channel.worstHalf = (uint16_t)half;
+			}
+		}
+	}
+
+	// Everything at or below -0 lands on code 0, +infinity on the top code of every channel
+	// the input drives.
+	report->badNegatives = 0;
+	report->badInfinities = 0;
+	report->nanSignals = 0;
+	for (uint32_t half = 0; half < (uint32_t)HalfCount; half++)
+	{
+		const Sample& sample = samples[half];
+		if (IsNaN((uint16_t)half))
+		{
+			report->nanSignals += sample.nan;
+			continue;
+		}
+		bool negative = half >= NegativeZero && half <= NegativeInfinity;
+		for (int c = 0; c < 3; c++)
+		{
+			if (negative && sample.code[c] != 0)
+			{
+				report->badNegatives++;
+				break;
+			}
+			if (half == PositiveInfinity && report->channels[c].highest > 0 && sample.code[c] != maxCode)
+			{
+				report->badInfinities++;
+				break;
+			}
+		}
+	}
+
+	report->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
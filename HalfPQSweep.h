@@ -0,0 +1,83 @@
+//
+// HalfPQSweep.h
+//
+// Exhaustive check of the scRGB FP16 to HDR10 path.  Every one of the 65,536 half values
+// is decoded (SIMD, and cross-checked against the scalar decode and re-encode), pushed
+// through Linear709ToHDR10() from ColorSpaces.h, or through the same scaling and PQ curve
+// without the 709 to 2020 rotation, and quantized to 10 or 12 bits.  From that the sweep
+// builds the inverse map, the range of halves that lands on each code, and reports what
+// has bitten us before:
+//
+//   gaps             codes between the lowest and highest reached that no half lands on
+//   non-monotonic    a half landing on a lower code than the next smaller half
+//   worst error      the float pipeline against a double precision evaluation of the same
+//                    formula, in code steps, and the halves whose code differs from it
+//   negative / inf   negative halves must give code 0, and +infinity the top code on
+//                    every channel the input reaches
+//
+// NaNs are counted but not failed: saturate() passes them through, unlike the GPU's.
+//
+// Halves are processed in blocks across a ThreadPool; the sweep takes a few tens of
+// milliseconds, so it can gate any change to the color math.  PQVerify.cpp is the
+// command-line front end.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+class ThreadPool;
+
+// Which channels the half is written to before the conversion.
+enum class HalfPQInput
+{
+	Gray,
+	Red,
+	Green,
+	Blue,
+};
+
+struct HalfPQOptions
+{
+	int         bits;			// 10 or 12
+	bool        rotate;			// Linear709ToHDR10(); false: input already in BT.2020 primaries
+	HalfPQInput input;
+};
+
+// The halves that land on one code, in the order of the values they encode.
+struct HalfPQCodeRange
+{
+	uint16_t first;			// smallest half
+	uint16_t last;			// largest half
+	uint32_t count;			// 0: a gap if the code lies inside the reached range
+};
+
+struct HalfPQChannel
+{
+	std::vector<HalfPQCodeRange> ranges;		// indexed by code
+	uint32_t                     lowest;		// codes reached by the non-negative finite halves
+	uint32_t                     highest;
+	std::vector<uint32_t>        gaps;
+	std::vector<uint16_t>        nonMonotonic;	// halves that land below their predecessor
+	double                       worstError;	// code steps against the double evaluation
+	uint16_t                     worstHalf;
+	uint32_t                     misrounded;	// halves landing on another code than the double evaluation
+};
+
+struct HalfPQReport
+{
+	HalfPQOptions options;
+	HalfPQChannel channels[3];				// BT.2020 R, G, B as scanned out
+	uint32_t      halfDecodeErrors;			// SIMD decode disagreeing with the scalar one or not re-encoding
+	uint32_t      badNegatives;				// negative halves not landing on code 0
+	uint32_t      badInfinities;			// +infinity not landing on the top code of a driven channel
+	uint32_t      nanSignals;				// NaN halves giving a NaN signal
+	double        milliseconds;
+
+	// No gaps, no non-monotonic steps, no decode, negative or infinity errors.
+	bool Passed() const;
+};
+
+// pool == nullptr uses ThreadPool::Default().
+void SweepHalfToPQ(const HalfPQOptions& options, HalfPQReport* report, ThreadPool* pool = nullptr);
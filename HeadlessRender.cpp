@@ -0,0 +1,998 @@
+//
+// HeadlessRender.cpp
+//
+// Renders every test pattern on the CPU (CpuCanvas) for a synthetic HDR10 panel and
+// reports the time and a hash of the FP16 framebuffer for each, at 3840x2160 and
+// 7680x4320 by default.  Needs no GPU or window, so it runs on build machines and lets
+// pattern changes be caught as image diffs.  With --dump each frame is also written as
+// raw R16G16B16A16_FLOAT, rows packed, one file per pattern.
+//
+// Custom effects run through the CPU kernels in EffectKernels.h.  Text is drawn as glyph
+// boxes (CpuCanvas.h), and the patterns' .png images are loaded from --assets, the
+// current directory by default, as the app loads them from next to its executable; a
+// pattern whose image is missing renders the app's "missing file" title instead.
+//
+// Not part of the app project; build it directly, e.g.
+//
+//   g++ -std=c++17 -O2 -mavx2 -mfma -pthread HeadlessRender.cpp AdvancedColorPipeline.cpp CpuCanvas.cpp DisplayList.cpp EffectKernels.cpp ImageConvert.cpp TestPatterns.cpp ThreadPool.cpp ToneMap.cpp TransferBatch.cpp TransferTables.cpp VirtualPanel.cpp PanelThermal.cpp PanelColorModel.cpp PQCodeTable.cpp GamutPolygon.cpp -o headless
+//   cl /std:c++17 /O2 /arch:AVX2 /EHsc /constexpr:steps100000000 HeadlessRender.cpp AdvancedColorPipeline.cpp CpuCanvas.cpp DisplayList.cpp EffectKernels.cpp ImageConvert.cpp TestPatterns.cpp ThreadPool.cpp ToneMap.cpp TransferBatch.cpp TransferTables.cpp VirtualPanel.cpp PanelThermal.cpp PanelColorModel.cpp PQCodeTable.cpp GamutPolygon.cpp /Fe:headless.exe
+//
+// With --frames N each pattern is held for N frames at 60 Hz, as the app holds it while
+// it is measured; frames after the first replay the pattern's display list, and their
+// mean time is reported next to the first frame's.  The hash is of the last frame.
+//
+// With --wire the last frame also goes through the advanced color path
+// (AdvancedColorPipeline.h) to the HDR10 codes on the link, and the time and a hash of
+// those codes follow; --dump then writes them too, as raw R10G10B10A2_UNORM.
+//
+// With --tonemap curve (profile, aces or bt2390) the link codes go on through the
+// monitor, for content mastered to 10,000 nits, as its scaler would tone map them to the
+// panel peak with that curve (ToneMap.h); the mean and peak panel drive levels follow.
+// ToneMapSpike and the Calibrate* patterns then show where a panel should start to roll
+// off and where it clips.
+//
+// With --panel ZXxZY the last frame is also shown on a virtual local-dimming panel of ZX
+// by ZY zones (VirtualPanel.h) with the synthetic panel's luminances, and the time, the
+// nits at the center and on average, and the scale the power limit put on the backlight
+// follow.  The ActiveDimming, DualCornerBox and StaticContrastRatio patterns then show
+// the blooming and ABL a real panel of that kind would.
+//
+// With --soak list the patterns are not timed; instead the list (names as printed, each
+// with an optional :seconds, else held for its own timer or 60 s) is played in virtual
+// time at the first size, each frame shown on the virtual panel (96x54 zones unless
+// --panel says otherwise) to find its load, and the thermal model of PanelThermal.h
+// predicts the luminance at the center over the whole sequence.  Patterns other than
+// WarmUp and Cooldown must hold what they draw there, less --tolerance (default 0.05).
+// --sweep name=from:to:count reruns it for count values of one thermal setting (ambient,
+// idle, power, rled, tled, rchassis, tchassis, derate or floor) across the threads, e.g.
+//
+//   headless --size 1920x1080 --soak WarmUp,LongDurationWhite --sweep rchassis=0.3:0.8:11
+//
+// A soak exits with 1 when the default thermal settings fail the sequence.
+//
+// Usage: headless [--size WxH]... [--threads N] [--peak nits] [--frames N] [--wire] [--tonemap curve] [--panel ZXxZY] [--dump dir] [--assets dir]
+//        headless [--size WxH] [--threads N] [--peak nits] [--panel ZXxZY] --soak list [--tolerance x] [--interval s] [--sweep name=from:to:count] [--assets dir]
+//
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "AdvancedColorPipeline.h"
+#include "CodeValues.h"
+#include "ColorSpaces.h"
+#include "CpuCanvas.h"
+#include "EffectKernels.h"
+#include "SimdMath.h"
+#include "TestPatterns.h"
+#include "ThreadPool.h"
+#include "PanelThermal.h"
+#include "VirtualPanel.h"
+
+namespace
+{
+	// In TestPatterns::TestPattern order.
+	const char* PatternNames[] =
+	{
+		"StartOfTest", "ConnectionProperties", "PanelCharacteristics", "ResetInstructions",
+		"PQLevelsInNits", "WarmUp", "TenPercentPeak", "TenPercentPeakMAX", "FlashTest",
+		"FlashTestMAX", "LongDurationWhite", "FullFramePeak", "DualCornerBox",
+		"StaticContrastRatio", "ActiveDimming", "ActiveDimmingDark", "ActiveDimmingSplit",
+		"ColorPatches10", "ColorPatches", "BitDepthPrecision", "RiseFallTime", "ProfileCurve",
+		"EndOfMandatoryTests", "SharpeningFilter", "ToneMapSpike", "TextQuality",
+		"OnePixelLinesBW", "OnePixelLinesRG", "ColorPatches709", "FullFrameSDRWhite",
+		"FullFrameSDRWhiteWithHDR", "CalibrateMaxEffectiveValue",
+		"CalibrateMaxEffectiveFullFrameValue", "CalibrateMinEffectiveValue", "StaticGradient",
+		"AnimatedGrayGradient", "AnimatedColorGradient", "BlackLevelHdrCorners",
+		"BlackLevelSdrTunnel", "ColorPatchesMAX", "EndOfTest", "Cooldown",
+	};
+	const int PatternCount = (int)TestPatterns::TestPattern::Cooldown + 1;
+	static_assert(sizeof(PatternNames) / sizeof(PatternNames[0]) == PatternCount, "PatternNames");
+
+	// A pattern of a --soak sequence, and how long to hold it (0 for its own timer).
+	struct SoakStep
+	{
+		int   pattern;
+		float seconds;
+	};
+
+	// The thermal settings --sweep can vary.
+	struct SweepParameter
+	{
+		const char*                   name;
+		float PanelThermalSettings::* member;
+	};
+
+	struct Options
+	{
+		std::vector<std::pair<uint32_t, uint32_t>> sizes;
+		unsigned    threads = 0;
+		float       peak = 1000.0f;
+		unsigned    frames = 1;
+		bool        wire = false;
+		bool        toneMap = false;
+		ToneCurve   toneCurve = ToneCurve::Profile;
+		uint32_t    zonesX = 0;					// no virtual panel
+		uint32_t    zonesY = 0;
+		const char* dumpDir = nullptr;
+		const char* assetDir = ".";
+		std::vector<SoakStep> soak;
+		float       tolerance = 0.05f;
+		float       soakInterval = 60.0f;
+		const SweepParameter* sweep = nullptr;
+		float       sweepFrom = 0.0f;
+		float       sweepTo = 0.0f;
+		unsigned    sweepCount = 0;
+	};
+
+	// LSB-first bits of a deflate stream; reads past the end return zeros and set overrun.
+	struct BitReader
+	{
+		const uint8_t* data;
+		size_t         size;
+		size_t         pos;
+		uint32_t       bits;
+		int            count;
+		bool           overrun;
+
+		uint32_t Read(int n)
+		{
+			while (count < n)
+			{
+				if (pos < size)
+					bits |= (uint32_t)data[pos++] << count;
+				else
+					overrun = true;
+				count += 8;
+			}
+			uint32_t value = bits & ((1u << n) - 1);
+			bits >>= n;
+			count -= n;
+			return value;
+		}
+	};
+
+	// A canonical Huffman code as the number of codes of each length and the symbols in
+	// code order (RFC 1951 3.2.2).
+	struct Huffman
+	{
+		uint16_t counts[16];
+		uint16_t symbols[288];
+	};
+
+	bool BuildHuffman(Huffman& code, const uint8_t* lengths, int n)
+	{
+		memset(code.counts, 0, sizeof(code.counts));
+		for (int i = 0; i < n; i++)
+			code.counts[lengths[i]]++;
+		code.counts[0] = 0;
+
+		int left = 1;
+		uint16_t offsets[16] = {};
+		for (int length = 1; length < 16; length++)
+		{
+			left = 2 * left - code.counts[length];
+			if (left < 0)
+				return false;				// over-subscribed
+			if (length < 15)
+				offsets[length + 1] = offsets[length] + code.counts[length];
+		}
+		for (int i = 0; i < n; i++)
+		{
+			if (lengths[i])
+				code.symbols[offsets[lengths[i]]++] = (uint16_t)i;
+		}
+		return true;
+	}
+
+	// One symbol a bit at a time, or -1 for a code the table does not have.
+	int DecodeSymbol(BitReader& in, const Huffman& code)
+	{
+		int bits = 0, first = 0, index = 0;
+		for (int length = 1; length < 16; length++)
+		{
+			bits |= (int)in.Read(1);
+			int count = code.counts[length];
+			if (bits - first < count)
+				return code.symbols[index + bits - first];
+			index += count;
+			first = (first + count) << 1;
+			bits <<= 1;
+		}
+		return -1;
+	}
+
+	// Appends the data of a zlib stream (RFC 1950, 1951) to out; false if it is malformed.
+	bool Inflate(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+	{
+		static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+		static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+		static const uint16_t distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+		static const uint8_t distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+		static const uint8_t lengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+		if (size < 2 || (data[0] & 0x0F) != 8 || (data[0] << 8 | data[1]) % 31 != 0)
+			return false;
+
+		BitReader in = { data + 2, size - 2, 0, 0, 0, false };
+		for (bool last = false; !last;)
+		{
+			last = in.Read(1) != 0;
+			uint32_t type = in.Read(2);
+			if (type == 0)
+			{
+				// Stored: the rest of the current byte is dropped.
+				in.bits = 0;
+				in.count = 0;
+				if (in.size - in.pos < 4)
+					return false;
+				size_t length = in.data[in.pos] | in.data[in.pos + 1] << 8;
+				if ((length ^ 0xFFFF) != (size_t)(in.data[in.pos + 2] | in.data[in.pos + 3] << 8) ||
+					in.size - in.pos - 4 < length)
+					return false;
+				out.insert(out.end(), in.data + in.pos + 4, in.data + in.pos + 4 + length);
+				in.pos += 4 + length;
+				continue;
+			}
+
+			Huffman literals, distances;
+			uint8_t lengths[288 + 32] = {};
+			if (type == 1)
+			{
+				for (int i = 0; i < 288; i++)
+					lengths[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+				for (int i = 0; i < 30; i++)
+					lengths[288 + i] = 5;
+				BuildHuffman(literals, lengths, 288);
+				BuildHuffman(distances, lengths + 288, 30);
+			}
+			else if (type == 2)
+			{
+				int literalCount = (int)in.Read(5) + 257;
+				int distanceCount = (int)in.Read(5) + 1;
+				int lengthCount = (int)in.Read(4) + 4;
+				if (literalCount > 286 || distanceCount > 30)
+					return false;
+
+				uint8_t codeLengths[19] = {};
+				for (int i = 0; i < lengthCount; i++)
+					codeLengths[lengthOrder[i]] = (uint8_t)in.Read(3);
+				Huffman lengthCode;
+				if (!BuildHuffman(lengthCode, codeLengths, 19))
+					return false;
+
+				int total = literalCount + distanceCount;
+				for (int i = 0; i < total;)
+				{
+					int symbol = DecodeSymbol(in, lengthCode);
+					if (symbol < 0)
+						return false;
+					if (symbol < 16)
+					{
+						lengths[i++] = (uint8_t)symbol;
+						continue;
+					}
+
+					uint8_t value = 0;
+					int repeat;
+					if (symbol == 16)
+					{
+						if (i == 0)
+							return false;
+						value = lengths[i - 1];
+						repeat = 3 + (int)in.Read(2);
+					}
+					else
+					{
+						repeat = symbol == 17 ? 3 + (int)in.Read(3) : 11 + (int)in.Read(7);
+					}
+					if (i + repeat > total)
+						return false;
+					while (repeat--)
+						lengths[i++] = value;
+				}
+				if (!BuildHuffman(literals, lengths, literalCount) ||
+					!BuildHuffman(distances, lengths + literalCount, distanceCount))
+					return false;
+			}
+			else
+			{
+				return false;
+			}
+
+			for (;;)
+			{
+				int symbol = DecodeSymbol(in, literals);
+				if (symbol < 0 || in.overrun)
+					return false;
+				if (symbol < 256)
+				{
+					out.push_back((uint8_t)symbol);
+					continue;
+				}
+				if (symbol == 256)
+					break;
+
+				symbol -= 257;
+				if (symbol >= 29)
+					return false;
+				size_t length = lengthBase[symbol] + in.Read(lengthExtra[symbol]);
+				int d = DecodeSymbol(in, distances);
+				if (d < 0 || d >= 30)
+					return false;
+				size_t distance = distanceBase[d] + in.Read(distanceExtra[d]);
+				if (distance > out.size())
+					return false;
+				size_t from = out.size() - distance;
+				for (size_t k = 0; k < length; k++)
+					out.push_back(out[from + k]);
+			}
+		}
+		return !in.overrun;
+	}
+
+	uint32_t ReadBigEndian(const uint8_t* p)
+	{
+		return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+	}
+
+	// An 8-bit, non-interlaced PNG (gray, RGB or palette, with or without alpha) as
+	// premultiplied linear scRGB, as the app's WIC conversion to 64bppPRGBAHalf gives it:
+	// the sRGB curve is removed and color profiles are ignored.  That covers the shipped
+	// images; anything else returns false, and its pattern shows the "missing" error.
+	bool LoadPng(const char* path, uint32_t* width, uint32_t* height, std::vector<float>* rgba)
+	{
+		FILE* file = fopen(path, "rb");
+		if (!file)
+			return false;
+		std::vector<uint8_t> data;
+		uint8_t buffer[65536];
+		for (size_t read; (read = fread(buffer, 1, sizeof(buffer), file)) > 0;)
+			data.insert(data.end(), buffer, buffer + read);
+		fclose(file);
+
+		static const uint8_t signature[8] = { 137, 'P', 'N', 'G', 13, 10, 26, 10 };
+		if (data.size() < sizeof(signature) || memcmp(data.data(), signature, sizeof(signature)))
+			return false;
+
+		int depth = 0, colorType = -1, interlace = 0;
+		uint8_t palette[256][4];
+		memset(palette, 255, sizeof(palette));
+		std::vector<uint8_t> compressed;
+		for (size_t pos = sizeof(signature); data.size() - pos >= 12;)
+		{
+			uint32_t length = ReadBigEndian(&data[pos]);
+			if (length > data.size() - pos - 12)
+				return false;
+			const char* type = (const char*)&data[pos + 4];
+			const uint8_t* chunk = &data[pos + 8];
+			if (!memcmp(type, "IHDR", 4) && length >= 13)
+			{
+				*width = ReadBigEndian(chunk);
+				*height = ReadBigEndian(chunk + 4);
+				depth = chunk[8];
+				colorType = chunk[9];
+				interlace = chunk[12];
+			}
+			else if (!memcmp(type, "PLTE", 4))
+			{
+				for (uint32_t i = 0; i < length / 3 && i < 256; i++)
+					memcpy(palette[i], chunk + 3 * i, 3);
+			}
+			else if (!memcmp(type, "tRNS", 4) && colorType == 3)
+			{
+				for (uint32_t i = 0; i < length && i < 256; i++)
+					palette[i][3] = chunk[i];
+			}
+			else if (!memcmp(type, "IDAT", 4))
+			{
+				compressed.insert(compressed.end(), chunk, chunk + length);
+			}
+			else if (!memcmp(type, "IEND", 4))
+			{
+				break;
+			}
+			pos += length + 12;
+		}
+
+		static const int channelCount[7] = { 1, 0, 3, 1, 2, 0, 4 };
+		if (depth != 8 || interlace != 0 || colorType < 0 || colorType > 6 || !channelCount[colorType] ||
+			*width == 0 || *height == 0 || *width > 65536 || *height > 65536)
+			return false;
+		const size_t channels = channelCount[colorType];
+		const size_t rowBytes = *width * channels;
+
+		std::vector<uint8_t> raw;
+		raw.reserve((rowBytes + 1) * *height);
+		if (!Inflate(compressed.data(), compressed.size(), raw) || raw.size() < (rowBytes + 1) * *height)
+			return false;
+
+		float linear[256];
+		for (int i = 0; i < 256; i++)
+			linear[i] = RemoveSRGBCurve(i / 255.0f);
+
+		rgba->resize((size_t)*width * *height * 4);
+		std::vector<uint8_t> above(rowBytes, 0);
+		for (uint32_t y = 0; y < *height; y++)
+		{
+			// Undo the row's filter against the row above, already unfiltered.
+			uint8_t* row = &raw[y * (rowBytes + 1) + 1];
+			uint8_t filter = row[-1];
+			for (size_t i = 0; i < rowBytes; i++)
+			{
+				int a = i >= channels ? row[i - channels] : 0;
+				int b = above[i];
+				int c = i >= channels ? above[i - channels] : 0;
+				int predicted;
+				switch (filter)
+				{
+				case 0: predicted = 0; break;
+				case 1: predicted = a; break;
+				case 2: predicted = b; break;
+				case 3: predicted = (a + b) / 2; break;
+				case 4:
+				{
+					int pa = abs(b - c), pb = abs(a - c), pc = abs(a + b - 2 * c);
+					predicted = pa <= pb && pa <= pc ? a : pb <= pc ? b : c;
+					break;
+				}
+				default: return false;
+				}
+				row[i] = (uint8_t)(row[i] + predicted);
+			}
+			memcpy(above.data(), row, rowBytes);
+
+			float* out = rgba->data() + (size_t)y * *width * 4;
+			for (uint32_t x = 0; x < *width; x++, out += 4)
+			{
+				const uint8_t* p = row + x * channels;
+				uint8_t rgb[3], alpha = 255;
+				switch (colorType)
+				{
+				case 0: rgb[0] = rgb[1] = rgb[2] = p[0]; break;
+				case 2: memcpy(rgb, p, 3); break;
+				case 3: memcpy(rgb, palette[p[0]], 3); alpha = palette[p[0]][3]; break;
+				case 4: rgb[0] = rgb[1] = rgb[2] = p[0]; alpha = p[1]; break;
+				default: memcpy(rgb, p, 3); alpha = p[3]; break;
+				}
+				float a = alpha / 255.0f;
+				out[0] = linear[rgb[0]] * a;
+				out[1] = linear[rgb[1]] * a;
+				out[2] = linear[rgb[2]] * a;
+				out[3] = a;
+			}
+		}
+		return true;
+	}
+
+	// The state Game sets up from DXGI in CreateDeviceDependentResources, for a
+	// DCI-P3 panel in HDR10 mode.
+	class HeadlessPatterns : public TestPatterns
+	{
+	public:
+		HeadlessPatterns(float peakNits) : TestPatterns(L"DisplayHDR Compliance Tests (headless)")
+		{
+			wcscpy(m_outputDesc.DeviceName, L"\\\\.\\DISPLAY1");
+			m_outputDesc.BitsPerColor = 10;
+			m_outputDesc.ColorSpace = ColorSpace_HDR10;
+			m_outputDesc.RedPrimary[0] = primaryR_DCIP3.x;
+			m_outputDesc.RedPrimary[1] = primaryR_DCIP3.y;
+			m_outputDesc.GreenPrimary[0] = primaryG_DCIP3.x;
+			m_outputDesc.GreenPrimary[1] = primaryG_DCIP3.y;
+			m_outputDesc.BluePrimary[0] = primaryB_DCIP3.x;
+			m_outputDesc.BluePrimary[1] = primaryB_DCIP3.y;
+			m_outputDesc.WhitePoint[0] = D6500White.x;
+			m_outputDesc.WhitePoint[1] = D6500White.y;
+			m_outputDesc.MinLuminance = 0.05f;
+			m_outputDesc.MaxLuminance = peakNits;
+			m_outputDesc.MaxFullFrameLuminance = peakNits * 0.6f;
+
+			m_rawOutDesc.MaxLuminance = m_outputDesc.MaxLuminance;
+			m_rawOutDesc.MaxFullFrameLuminance = m_outputDesc.MaxFullFrameLuminance;
+			m_rawOutDesc.MinLuminance = m_outputDesc.MinLuminance;
+			m_maxPQCode = PqCode<10>::FromNits(m_rawOutDesc.MaxLuminance);
+			UpdatePanelColorModel();
+
+			m_testingTier = GetTestingTier();
+			InitEffectiveValues();
+			m_activeDimming50PQValue = 113 * 4;
+			m_activeDimming05PQValue = 64 * 4;
+		}
+
+		// The virtual panel for the raw luminances the patterns were set up for.
+		VirtualPanelSettings GetPanelSettings(uint32_t zonesX, uint32_t zonesY) const
+		{
+			return MakeVirtualPanelSettings(m_rawOutDesc.MaxLuminance, m_rawOutDesc.MaxFullFrameLuminance,
+											m_rawOutDesc.MinLuminance, zonesX, zonesY);
+		}
+
+		float GetTestTimeRemaining() const { return m_testTimeRemainingSec; }
+		bool IsFlashOn() const { return m_flashOn != 0.0f; }
+
+		// Registers the patterns' images found in dir with the canvas, as Game loads them
+		// from next to the executable.  Returns the number that could not be loaded.
+		int LoadImages(CpuCanvas& canvas, const char* dir) const
+		{
+			int missing = 0;
+			for (auto& entry : m_testPatternResources)
+			{
+				const std::wstring& name = entry.second.imageFilename;
+				if (name.empty())
+					continue;
+
+				std::string path = std::string(dir) + "/" + std::string(name.begin(), name.end());
+				uint32_t width = 0, height = 0;
+				std::vector<float> rgba;
+				if (LoadPng(path.c_str(), &width, &height, &rgba))
+					canvas.SetImage(name, width, height, rgba.data());
+				else
+					missing++;
+			}
+			return missing;
+		}
+	};
+
+	const uint64_t FnvOffset = 0xcbf29ce484222325ull;
+	const uint64_t FnvPrime = 0x100000001b3ull;
+	const size_t HashBlock = 256 * 1024;			// bytes per ParallelFor index
+
+	// FNV-1a over a buffer, a 64-bit word at a time.
+	uint64_t HashWords(const uint8_t* p, size_t size)
+	{
+		uint64_t hash = FnvOffset;
+		size_t i = 0;
+		for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+		{
+			uint64_t word;
+			memcpy(&word, p + i, sizeof(word));
+			hash = (hash ^ word) * FnvPrime;
+		}
+		for (; i < size; i++)
+			hash = (hash ^ p[i]) * FnvPrime;
+		return hash;
+	}
+
+	// Each block of the buffer hashed in parallel, then the blocks' hashes in order.
+	uint64_t Hash(const void* data, size_t size, ThreadPool& pool)
+	{
+		const uint8_t* p = (const uint8_t*)data;
+		std::vector<uint64_t> blocks((size + HashBlock - 1) / HashBlock);
+		pool.ParallelFor(0, blocks.size(), [&](size_t i)
+		{
+			blocks[i] = HashWords(p + i * HashBlock, std::min(HashBlock, size - i * HashBlock));
+		});
+		return HashWords((const uint8_t*)blocks.data(), blocks.size() * sizeof(uint64_t));
+	}
+
+	uint64_t HashPixels(const CpuCanvas& canvas, ThreadPool& pool)
+	{
+		return Hash(canvas.GetPixels(), canvas.GetRowPitch() * canvas.GetHeight(), pool);
+	}
+
+	bool Dump(const void* data, size_t size, const char* dir, uint32_t width, uint32_t height, int pattern,
+			  const char* extension)
+	{
+		char path[1024];
+		snprintf(path, sizeof(path), "%s/%ux%u_%02d_%s.%s", dir, width, height, pattern, PatternNames[pattern],
+				 extension);
+
+		FILE* file = fopen(path, "wb");
+		if (!file)
+			return false;
+		bool ok = fwrite(data, 1, size, file) == size;
+		return fclose(file) == 0 && ok;
+	}
+
+	// Returns the number of patterns that failed to render.
+	int RenderAll(const Options& options, ThreadPool& pool, uint32_t width, uint32_t height)
+	{
+		HeadlessPatterns patterns(options.peak);
+		CpuCanvas canvas(width, height, &pool);
+		canvas.RegisterEffect(PatternEffect::SineSweep, SineSweepKernel);
+		canvas.RegisterEffect(PatternEffect::ToneSpike, ToneSpikeKernel);
+		canvas.RegisterEffect(PatternEffect::BandedGradient, BandedGradientKernel);
+		if (int missing = patterns.LoadImages(canvas, options.assetDir))
+			fprintf(stderr, "%d pattern images not found in %s\n", missing, options.assetDir);
+		patterns.UpdateTextLayout(canvas.GetLogicalSize());
+
+		// The swap chain is FP16 scRGB, on the same panel the patterns were set up for.
+		ACPipelineSettings settings = DefaultACPipelineSettings();
+		settings.displayCharacteristics.peakLuminance = options.peak;
+		settings.displayCharacteristics.frameAverageLuminance = options.peak * 0.6f;
+		settings.contentMetadata = settings.displayCharacteristics;
+		if (options.toneMap)
+		{
+			settings.contentMetadata.peakLuminance = 10000.0f;
+			settings.toneCurve = options.toneCurve;
+		}
+		Image panel(&pool);
+		std::vector<uint32_t> wire(options.wire ? (size_t)width * height : 0);
+		ImageBuffer wireBuffer = { wire.data(), width, height, width * sizeof(uint32_t), ImageFormat::R10G10B10A2_UNORM };
+		ImageBuffer app = { nullptr, width, height, canvas.GetRowPitch(), ImageFormat::R16G16B16A16_FLOAT };
+
+		// FP16 scRGB is already CCCS, as DWM would hand it to the panel.
+		VirtualPanel virtualPanel(patterns.GetPanelSettings(options.zonesX, options.zonesY), &pool);
+		Image shown(&pool);
+
+		printf("%ux%u\n", width, height);
+
+		int failures = 0;
+		double total = 0.0;
+		for (int i = 0; i < PatternCount; i++)
+		{
+			patterns.SetTestPattern((TestPatterns::TestPattern)i);
+
+			double first = 0.0;
+			double held = 0.0;
+			bool failed = false;
+			for (unsigned frame = 0; frame < options.frames && !failed; frame++)
+			{
+				patterns.UpdateTestPattern(frame / 60.0f, frame ? 1.0f / 60.0f : 0.0f);
+
+				auto start = std::chrono::high_resolution_clock::now();
+				try
+				{
+					canvas.BeginDraw();
+					patterns.RenderTestPattern(&canvas);
+					canvas.EndDraw();
+				}
+				catch (const std::exception& e)
+				{
+					printf("  %-36s failed: %s\n", PatternNames[i], e.what());
+					failures++;
+					failed = true;
+				}
+				double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+				(frame ? held : first) += ms;
+			}
+			if (failed)
+				continue;
+			total += first + held;
+
+			if (options.frames > 1)
+				printf("  %-36s %8.2f ms %8.2f ms  %016llx", PatternNames[i], first, held / (options.frames - 1),
+					   (unsigned long long)HashPixels(canvas, pool));
+			else
+				printf("  %-36s %8.2f ms  %016llx", PatternNames[i], first, (unsigned long long)HashPixels(canvas, pool));
+
+			if (options.wire)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				app.data = const_cast<uint16_t*>(canvas.GetPixels());
+				ACPipeline(app, settings, wireBuffer, options.toneMap ? &panel : nullptr, &pool);
+				double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+				printf("  wire %8.2f ms  %016llx", ms, (unsigned long long)Hash(wire.data(), wire.size() * sizeof(uint32_t), pool));
+				if (options.toneMap)
+					printf("  panel %6.4f %6.4f", Image_Average(panel), Image_Peak(panel));
+			}
+			if (options.zonesX)
+			{
+				app.data = const_cast<uint16_t*>(canvas.GetPixels());
+				shown.Load(app);
+				shown.Resolve();
+				auto start = std::chrono::high_resolution_clock::now();
+				virtualPanel.Show(shown, shown);
+				double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+				printf("  zones %8.2f ms  %8.2f %8.2f nits  x%5.3f", ms, shown.GetPixel(width / 2, height / 2).y * 80.0f,
+					   Image_Average(shown) * 80.0f, virtualPanel.GetPowerScale());
+			}
+			printf("\n");
+
+			bool dumped = !options.dumpDir ||
+				(Dump(canvas.GetPixels(), canvas.GetRowPitch() * height, options.dumpDir, width, height, i, "rgba16f") &&
+				 (!options.wire || Dump(wire.data(), wire.size() * sizeof(uint32_t), options.dumpDir, width, height, i, "rgb10a2")));
+			if (!dumped)
+			{
+				fprintf(stderr, "Cannot write to %s\n", options.dumpDir);
+				failures++;
+			}
+		}
+
+		printf("  %-36s %8.2f ms\n", "total", total);
+		printf("  display lists: %llu hits, %llu misses\n", (unsigned long long)patterns.GetDisplayListHits(),
+			   (unsigned long long)patterns.GetDisplayListMisses());
+		return failures;
+	}
+
+	const SweepParameter SweepParameters[] =
+	{
+		{ "ambient",  &PanelThermalSettings::ambientTemperature },
+		{ "idle",     &PanelThermalSettings::idlePower },
+		{ "power",    &PanelThermalSettings::fullFramePower },
+		{ "rled",     &PanelThermalSettings::ledResistance },
+		{ "tled",     &PanelThermalSettings::ledTimeConstant },
+		{ "rchassis", &PanelThermalSettings::chassisResistance },
+		{ "tchassis", &PanelThermalSettings::chassisTimeConstant },
+		{ "derate",   &PanelThermalSettings::derateStart },
+		{ "floor",    &PanelThermalSettings::derateFloor },
+	};
+
+	// WarmUp and Cooldown only bring the panel to temperature; the others are measured.
+	bool IsMeasured(int pattern)
+	{
+		return pattern != (int)TestPatterns::TestPattern::WarmUp && pattern != (int)TestPatterns::TestPattern::Cooldown;
+	}
+
+	// What the current frame asks of the panel: its APL, and the nits at the center before
+	// the power limit, with the zones' shortfall on small windows.  requested is the
+	// center as drawn, in nits.
+	PanelLoad MeasureLoad(CpuCanvas& canvas, VirtualPanel& panel, Image& shown, float* requested)
+	{
+		ImageBuffer app = { const_cast<uint16_t*>(canvas.GetPixels()), canvas.GetWidth(), canvas.GetHeight(),
+							canvas.GetRowPitch(), ImageFormat::R16G16B16A16_FLOAT };
+		shown.Load(app);
+		uint32_t x = canvas.GetWidth() / 2, y = canvas.GetHeight() / 2;
+		float3 drawn = shown.GetPixel(x, y);
+		*requested = std::max(std::max(drawn.x, drawn.y), drawn.z) * 80.0f;
+
+		panel.Show(shown, shown);
+		float3 center = shown.GetPixel(x, y);
+		PanelLoad load;
+		load.averageDrive = panel.GetAverageDrive();
+		load.spotLuminance = std::max(std::max(center.x, center.y), center.z) * 80.0f / panel.GetPowerScale();
+		return load;
+	}
+
+	// Plays the --soak sequence in virtual time, each pattern's frame rendered once and again
+	// whenever its flash state changes, then runs the thermal model over it, and the sweep.
+	int RunSoak(const Options& options, ThreadPool& pool)
+	{
+		uint32_t width = options.sizes.front().first, height = options.sizes.front().second;
+		HeadlessPatterns patterns(options.peak);
+		CpuCanvas canvas(width, height, &pool);
+		canvas.RegisterEffect(PatternEffect::SineSweep, SineSweepKernel);
+		canvas.RegisterEffect(PatternEffect::ToneSpike, ToneSpikeKernel);
+		canvas.RegisterEffect(PatternEffect::BandedGradient, BandedGradientKernel);
+		if (int missing = patterns.LoadImages(canvas, options.assetDir))
+			fprintf(stderr, "%d pattern images not found in %s\n", missing, options.assetDir);
+		patterns.UpdateTextLayout(canvas.GetLogicalSize());
+
+		uint32_t zonesX = options.zonesX ? options.zonesX : 96, zonesY = options.zonesY ? options.zonesY : 54;
+		VirtualPanelSettings panelSettings = patterns.GetPanelSettings(zonesX, zonesY);
+		VirtualPanel panel(panelSettings, &pool);
+		PanelThermalSettings thermal = MakePanelThermalSettings(panelSettings);
+		Image shown(&pool);
+
+		printf("soak at %ux%u on %ux%u zones, %.0f nits peak, %.0f full frame\n", width, height, zonesX, zonesY,
+			   panelSettings.maxLuminance, panelSettings.maxFullFrameLuminance);
+
+		std::vector<LoadSegment> segments;
+		float total = 0.0f;
+		for (const SoakStep& step : options.soak)
+		{
+			patterns.SetTestPattern((TestPatterns::TestPattern)step.pattern);
+			patterns.UpdateTestPattern(total, 0.0f);
+			float seconds = step.seconds > 0.0f ? step.seconds : std::max(patterns.GetTestTimeRemaining(), 60.0f);
+
+			LoadSegment segment = {};
+			bool flashOn = patterns.IsFlashOn();
+			for (float t = 0.0f;;)
+			{
+				canvas.BeginDraw();
+				patterns.RenderTestPattern(&canvas);
+				canvas.EndDraw();
+				float requested;
+				segment.load = MeasureLoad(canvas, panel, shown, &requested);
+				// A level past what the power limit allows at its APL cannot be required.
+				requested = std::min(requested, GetPowerLimit(panelSettings, segment.load.averageDrive));
+				segment.requiredLuminance = IsMeasured(step.pattern) ? requested * (1.0f - options.tolerance) : 0.0f;
+
+				// Until the frame changes or the pattern's time is up.
+				float begin = t;
+				while (t < seconds && patterns.IsFlashOn() == flashOn)
+				{
+					t += thermal.timeStep;
+					patterns.UpdateTestPattern(total + t, thermal.timeStep);
+				}
+				segment.duration = std::min(t, seconds) - begin;
+				segments.push_back(segment);
+				if (t >= seconds)
+					break;
+				flashOn = patterns.IsFlashOn();
+			}
+
+			printf("  %-36s %6.0f s  APL %5.3f  spot %7.1f nits", PatternNames[step.pattern], seconds,
+				   segment.load.averageDrive, segment.load.spotLuminance);
+			if (segment.requiredLuminance > 0.0f)
+				printf("  needs %7.1f", segment.requiredLuminance);
+			printf("\n");
+			total += seconds;
+		}
+
+		std::vector<ThermalSample> curve;
+		auto start = std::chrono::high_resolution_clock::now();
+		ThermalSummary summary = SimulatePanelThermal(thermal, segments, &curve, options.soakInterval);
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		printf("  %8s %9s %8s %8s %6s\n", "time s", "nits", "LED C", "case C", "limit");
+		for (const ThermalSample& sample : curve)
+			printf("  %8.0f %9.1f %8.1f %8.1f %6.3f\n", sample.time, sample.luminance, sample.ledTemperature,
+				   sample.chassisTemperature, sample.thermalScale);
+		printf("  %.0f s simulated in %.3f ms: ", total, ms);
+		if (summary.failTime < 0.0f)
+			printf("holds, lowest %.3f of required\n", summary.minimumMargin);
+		else
+			printf("fails at %.0f s, lowest %.3f of required\n", summary.failTime, summary.minimumMargin);
+
+		if (!options.sweep)
+			return summary.failTime < 0.0f ? 0 : 1;
+
+		// One variant per value, evenly from sweepFrom to sweepTo.
+		std::vector<PanelThermalSettings> variants(options.sweepCount, thermal);
+		for (unsigned i = 0; i < options.sweepCount; i++)
+		{
+			float f = options.sweepCount > 1 ? (float)i / (options.sweepCount - 1) : 0.0f;
+			variants[i].*options.sweep->member = options.sweepFrom + (options.sweepTo - options.sweepFrom) * f;
+		}
+		start = std::chrono::high_resolution_clock::now();
+		std::vector<ThermalSummary> results = SweepPanelThermal(variants, segments, &pool);
+		ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		printf("  %-10s %9s %9s %8s %8s %8s\n", options.sweep->name, "start", "final", "lowest", "fails s", "LED C");
+		for (unsigned i = 0; i < options.sweepCount; i++)
+		{
+			const ThermalSummary& result = results[i];
+			printf("  %10.3f %9.1f %9.1f %8.3f ", variants[i].*options.sweep->member, result.startLuminance,
+				   result.finalLuminance, result.minimumMargin);
+			if (result.failTime < 0.0f)
+				printf("%8s", "-");
+			else
+				printf("%8.0f", result.failTime);
+			printf(" %8.1f\n", result.peakLedTemperature);
+		}
+		printf("  %u variants in %.2f ms\n", options.sweepCount, ms);
+		return summary.failTime < 0.0f ? 0 : 1;
+	}
+
+	// name[:seconds],...
+	bool ParseSoak(const char* list, std::vector<SoakStep>* steps)
+	{
+		steps->clear();
+		while (*list)
+		{
+			const char* end = strchr(list, ',');
+			size_t length = end ? (size_t)(end - list) : strlen(list);
+			const char* colon = (const char*)memchr(list, ':', length);
+			size_t nameLength = colon ? (size_t)(colon - list) : length;
+
+			SoakStep step = { -1, colon ? (float)atof(colon + 1) : 0.0f };
+			for (int i = 0; i < PatternCount; i++)
+			{
+				if (strlen(PatternNames[i]) == nameLength && !strncmp(PatternNames[i], list, nameLength))
+					step.pattern = i;
+			}
+			if (step.pattern < 0 || step.seconds < 0.0f)
+				return false;
+			steps->push_back(step);
+			list += length + (end ? 1 : 0);
+		}
+		return !steps->empty();
+	}
+
+	// name=from:to:count
+	bool ParseSweep(const char* text, Options* options)
+	{
+		const char* equals = strchr(text, '=');
+		if (!equals)
+			return false;
+		for (const SweepParameter& parameter : SweepParameters)
+		{
+			if (strlen(parameter.name) == (size_t)(equals - text) && !strncmp(parameter.name, text, equals - text))
+			{
+				options->sweep = &parameter;
+				return sscanf(equals + 1, "%f:%f:%u", &options->sweepFrom, &options->sweepTo, &options->sweepCount) == 3 &&
+					options->sweepCount > 0;
+			}
+		}
+		return false;
+	}
+
+	bool ParseToneCurve(const char* name, ToneCurve* curve)
+	{
+		for (ToneCurve c : { ToneCurve::Profile, ToneCurve::ACESFilmic, ToneCurve::BT2390 })
+		{
+			if (!strcmp(name, GetToneCurveName(c)))
+			{
+				*curve = c;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void PrintUsage()
+	{
+		fprintf(stderr,
+				"usage: headless [--size WxH]... [--threads N] [--peak nits] [--frames N] [--wire] [--tonemap curve] [--panel ZXxZY] [--dump dir] [--assets dir]\n"
+				"  --size     target size, repeatable (default 3840x2160 and 7680x4320)\n"
+				"  --threads  worker count including the caller (default: one per hardware thread)\n"
+				"  --peak     panel MaxLuminance in nits (default 1000)\n"
+				"  --frames   frames to hold each pattern for (default 1)\n"
+				"  --wire     also run each frame through the advanced color path to HDR10 link codes\n"
+				"  --tonemap  with --wire, tone map the codes to the panel: profile, aces or bt2390\n"
+				"  --panel    also show each frame on a virtual local-dimming panel of ZX by ZY zones\n"
+				"  --dump     write each frame to dir as raw R16G16B16A16_FLOAT (and the link codes)\n"
+				"  --assets   directory of the patterns' .png images (default: the current directory)\n"
+				"usage: headless [--size WxH] [--threads N] [--peak nits] [--panel ZXxZY] --soak list [--tolerance x] [--interval s] [--sweep name=from:to:count] [--assets dir]\n"
+				"  --soak      play patterns (name[:seconds],...) in virtual time through the thermal model\n"
+				"  --tolerance fraction below the drawn level a measured pattern may sag (default 0.05)\n"
+				"  --interval  seconds between printed samples of the luminance curve (default 60)\n"
+				"  --sweep     rerun for count values of a thermal setting from..to, in parallel\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		unsigned w, h;
+		if (!strcmp(arg, "--size") && hasValue && sscanf(argv[i + 1], "%ux%u", &w, &h) == 2 && w > 0 && h > 0)
+		{
+			options.sizes.push_back(std::make_pair(w, h));
+			i++;
+		}
+		else if (!strcmp(arg, "--threads") && hasValue)
+			options.threads = (unsigned)atoi(argv[++i]);
+		else if (!strcmp(arg, "--peak") && hasValue)
+			options.peak = (float)atof(argv[++i]);
+		else if (!strcmp(arg, "--frames") && hasValue && atoi(argv[i + 1]) > 0)
+			options.frames = (unsigned)atoi(argv[++i]);
+		else if (!strcmp(arg, "--wire"))
+			options.wire = true;
+		else if (!strcmp(arg, "--tonemap") && hasValue && ParseToneCurve(argv[i + 1], &options.toneCurve))
+		{
+			options.toneMap = true;
+			i++;
+		}
+		else if (!strcmp(arg, "--panel") && hasValue && sscanf(argv[i + 1], "%ux%u", &w, &h) == 2 && w > 0 && h > 0)
+		{
+			options.zonesX = w;
+			options.zonesY = h;
+			i++;
+		}
+		else if (!strcmp(arg, "--soak") && hasValue && ParseSoak(argv[i + 1], &options.soak))
+			i++;
+		else if (!strcmp(arg, "--tolerance") && hasValue)
+			options.tolerance = (float)atof(argv[++i]);
+		else if (!strcmp(arg, "--interval") && hasValue && atof(argv[i + 1]) > 0.0)
+			options.soakInterval = (float)atof(argv[++i]);
+		else if (!strcmp(arg, "--sweep") && hasValue && ParseSweep(argv[i + 1], &options))
+			i++;
+		else if (!strcmp(arg, "--dump") && hasValue)
+			options.dumpDir = argv[++i];
+		else if (!strcmp(arg, "--assets") && hasValue)
+			options.assetDir = argv[++i];
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if (options.sizes.empty() && !options.soak.empty())
+		options.sizes.push_back(std::make_pair(1920u, 1080u));
+	if (options.sizes.empty())
+	{
+		options.sizes.push_back(std::make_pair(3840u, 2160u));
+		options.sizes.push_back(std::make_pair(7680u, 4320u));
+	}
+
+	ThreadPool pool(options.threads);
+	printf("%u threads, %s\n", pool.Size(), simd::PathName());
+	if (!options.soak.empty())
+		return RunSoak(options, pool);
+
+	int failures = 0;
+	for (auto& size : options.sizes)
+		failures += RenderAll(options, pool, size.first, size.second);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,682 @@
+//
+// ImageConvert.cpp
+//
+// Fused, tiled image conversion.  See ImageConvert.h.
+//
+
+#include "ImageConvert.h"
+#include "ColorSpaces.h"
+#include "SimdMath.h"
+#include "ThreadPool.h"
+#include "TransferBatch.h"
+#include "TransferTables.h"
+
+#include <algorithm>
+#include <string.h>
+
+using namespace simd;
+
+namespace
+{
+	const uint32_t TileRows = 16;			// rows per ParallelFor index
+	const int      Chunk    = 256;			// pixels per pass; a multiple of every SIMD width
+
+	// One chunk of pixels, planar.
+	struct Planes
+	{
+		float r[Chunk];
+		float g[Chunk];
+		float b[Chunk];
+		float a[Chunk];
+	};
+
+	void Identity(double matrix[9], double offset[3])
+	{
+		for (int i = 0; i < 9; i++)
+			matrix[i] = i % 4 == 0 ? 1.0 : 0.0;
+		offset[0] = offset[1] = offset[2] = 0.0;
+	}
+
+	// The matrix of a linear per-pixel function, column by column from the unit vectors.
+	// mul() of a unit vector adds exact zeros to one element, so the columns are the
+	// function's own constants.
+	void MatrixOf(float3 (*fn)(float3), double matrix[9])
+	{
+		float3 x = fn(float3(1.0f, 0.0f, 0.0f));
+		float3 y = fn(float3(0.0f, 1.0f, 0.0f));
+		float3 z = fn(float3(0.0f, 0.0f, 1.0f));
+		const double m[9] = { x.x, y.x, z.x, x.y, y.y, z.y, x.z, y.z, z.z };
+		memcpy(matrix, m, sizeof(m));
+	}
+
+	void MatrixOf(float3x3 conversion, double scale, double matrix[9])
+	{
+		const float* p = &conversion._11;
+		for (int i = 0; i < 9; i++)
+			matrix[i] = p[i] * scale;
+	}
+
+	// ApplySRGBCurve()/RemoveSRGBCurve() on one vector.  The pow() side is clamped to 0,
+	// where the scalar function takes the linear segment anyway.
+	inline vfloat ApplySRGBKernel(vfloat x)
+	{
+		vfloat curve = vfloat(1.055f) * pow(max(x, vfloat(0.0f)), vfloat(1.0f / 2.4f)) - vfloat(0.055f);
+		return select(x < vfloat(0.0031308f), vfloat(12.92f) * x, curve);
+	}
+
+	inline vfloat RemoveSRGBKernel(vfloat x)
+	{
+		vfloat curve = pow(max((x + vfloat(0.055f)) / vfloat(1.055f), vfloat(0.0f)), vfloat(2.4f));
+		return select(x < vfloat(0.04045f), x / vfloat(12.92f), curve);
+	}
+
+	// count is a whole number of vectors.
+	template <class Kernel>
+	void EachPlane(float* r, float* g, float* b, size_t count, Kernel kernel)
+	{
+		for (size_t i = 0; i < count; i += width)
+		{
+			store(r + i, kernel(load(r + i)));
+			store(g + i, kernel(load(g + i)));
+			store(b + i, kernel(load(b + i)));
+		}
+	}
+
+	// Rows summed x, y, z then the offset, as ImageConverter::Convert(float3).
+	void Affine(const float m[12], float* r, float* g, float* b, size_t count)
+	{
+		vfloat m0 = m[0], m1 = m[1], m2 = m[2], m3 = m[3], m4 = m[4], m5 = m[5];
+		vfloat m6 = m[6], m7 = m[7], m8 = m[8], o0 = m[9], o1 = m[10], o2 = m[11];
+		for (size_t i = 0; i < count; i += width)
+		{
+			vfloat x = load(r + i), y = load(g + i), z = load(b + i);
+			store(r + i, x * m0 + y * m1 + z * m2 + o0);
+			store(g + i, x * m3 + y * m4 + z * m5 + o1);
+			store(b + i, x * m6 + y * m7 + z * m8 + o2);
+		}
+	}
+
+	// CurveTable::operator() on one vector, as EncodeTableLookup.
+	inline vfloat CurveKernel(const CurveTable& curve, vfloat x)
+	{
+		const float* samples = curve.GetSamples();
+		vint bits = asint(clamp(x, vfloat(CurveTable::Low()), vfloat(1.0f)));
+		vint idx = shr<EncodeTableShift>(bits) - vint((127 - CurveTable::Octaves) << EncodeTableSegmentBits);
+		vfloat frac = tofloat(bits & vint((1 << EncodeTableShift) - 1)) * vfloat(1.0f / (1 << EncodeTableShift));
+		vfloat a = gather(samples, idx);
+		vfloat b = gather(samples + 1, idx);
+		return select(x < vfloat(CurveTable::Low()), x * vfloat(curve.GetSlope()), mad(b - a, frac, a));
+	}
+
+	inline vfloat Unorm(vint code, float max)
+	{
+		return tofloat(code) / vfloat(max);
+	}
+
+	inline vint ToUnorm(vfloat x, float max)
+	{
+		return roundint(saturate(x) * vfloat(max));
+	}
+
+	// Source row to planes.  count <= Chunk; the planes are padded to whole vectors with
+	// zeros so the stages never see stale values.  With pq set, 10-bit codes are decoded
+	// straight to linear through PQ10ToLinear, as Remove2084() of the UNORM value.
+	void Decode(ImageFormat format, const uint8_t* src, size_t count, Planes& p, bool pq)
+	{
+		size_t padded = (count + width - 1) / width * width;
+		for (size_t i = count; i < padded; i++)
+			p.r[i] = p.g[i] = p.b[i] = p.a[i] = 0.0f;
+
+		switch (format)
+		{
+		case ImageFormat::R32G32B32A32_FLOAT:
+		{
+			const float* f = (const float*)src;
+			for (size_t i = 0; i < count; i++, f += 4)
+			{
+				p.r[i] = f[0];
+				p.g[i] = f[1];
+				p.b[i] = f[2];
+				p.a[i] = f[3];
+			}
+			break;
+		}
+
+		case ImageFormat::R32G32B32_FLOAT:
+		{
+			const float* f = (const float*)src;
+			for (size_t i = 0; i < count; i++, f += 3)
+			{
+				p.r[i] = f[0];
+				p.g[i] = f[1];
+				p.b[i] = f[2];
+				p.a[i] = 1.0f;
+			}
+			break;
+		}
+
+		case ImageFormat::R16G16B16A16_FLOAT:
+		case ImageFormat::R16G16B16A16_UNORM:
+		{
+			int32_t c[4][Chunk];
+			const uint16_t* h = (const uint16_t*)src;
+			for (size_t i = 0; i < count; i++, h += 4)
+			{
+				c[0][i] = h[0];
+				c[1][i] = h[1];
+				c[2][i] = h[2];
+				c[3][i] = h[3];
+			}
+			for (size_t i = count; i < padded; i++)
+				c[0][i] = c[1][i] = c[2][i] = c[3][i] = 0;
+			float* planes[4] = { p.r, p.g, p.b, p.a };
+			bool half = format == ImageFormat::R16G16B16A16_FLOAT;
+			for (int ch = 0; ch < 4; ch++)
+				for (size_t i = 0; i < padded; i += width)
+				{
+					vint code = loadi(c[ch] + i);
+					store(planes[ch] + i, half ? fromhalf(code) : Unorm(code, 65535.0f));
+				}
+			break;
+		}
+
+		case ImageFormat::R10G10B10A2_UNORM:
+		case ImageFormat::R8G8B8A8_UNORM:
+		{
+			int32_t words[Chunk];
+			memcpy(words, src, count * sizeof(uint32_t));
+			for (size_t i = count; i < padded; i++)
+				words[i] = 0;
+			bool rgb10 = format == ImageFormat::R10G10B10A2_UNORM;
+			for (size_t i = 0; i < padded; i += width)
+			{
+				vint w = loadi(words + i);
+				if (rgb10 && pq)
+				{
+					store(p.r + i, gather(PQ10ToLinear.data(), w & vint(0x3FF)));
+					store(p.g + i, gather(PQ10ToLinear.data(), shr<10>(w) & vint(0x3FF)));
+					store(p.b + i, gather(PQ10ToLinear.data(), shr<20>(w) & vint(0x3FF)));
+					store(p.a + i, Unorm(shr<30>(w), 3.0f));
+				}
+				else if (rgb10)
+				{
+					store(p.r + i, Unorm(w & vint(0x3FF), 1023.0f));
+					store(p.g + i, Unorm(shr<10>(w) & vint(0x3FF), 1023.0f));
+					store(p.b + i, Unorm(shr<20>(w) & vint(0x3FF), 1023.0f));
+					store(p.a + i, Unorm(shr<30>(w), 3.0f));
+				}
+				else
+				{
+					store(p.r + i, Unorm(w & vint(0xFF), 255.0f));
+					store(p.g + i, Unorm(shr<8>(w) & vint(0xFF), 255.0f));
+					store(p.b + i, Unorm(shr<16>(w) & vint(0xFF), 255.0f));
+					store(p.a + i, Unorm(shr<24>(w), 255.0f));
+				}
+			}
+			break;
+		}
+		}
+	}
+
+	void Decode(const PlanarBuffer& src, uint32_t x, uint32_t y, size_t count, Planes& p, bool)
+	{
+		size_t offset = y * src.stride + x;
+		memcpy(p.r, src.r + offset, count * sizeof(float));
+		memcpy(p.g, src.g + offset, count * sizeof(float));
+		memcpy(p.b, src.b + offset, count * sizeof(float));
+		size_t padded = (count + width - 1) / width * width;
+		for (size_t i = count; i < padded; i++)
+			p.r[i] = p.g[i] = p.b[i] = 0.0f;
+		if (src.a)
+			memcpy(p.a, src.a + offset, count * sizeof(float));
+		for (size_t i = src.a ? count : 0; i < padded; i++)
+			p.a[i] = 1.0f;
+	}
+
+	void Decode(const ImageBuffer& src, uint32_t x, uint32_t y, size_t count, Planes& p, bool pq)
+	{
+		Decode(src.format, (const uint8_t*)src.data + y * src.pitch + x * ImageFormatSize(src.format), count, p, pq);
+	}
+
+	// Whether Decode() can take over a leading Remove2084 stage.
+	bool DecodesPQ(const ImageBuffer& src) { return src.format == ImageFormat::R10G10B10A2_UNORM; }
+	bool DecodesPQ(const PlanarBuffer&)    { return false; }
+
+	void Encode(ImageFormat format, const Planes& p, size_t count, uint8_t* dst)
+	{
+		size_t padded = (count + width - 1) / width * width;
+		switch (format)
+		{
+		case ImageFormat::R32G32B32A32_FLOAT:
+		{
+			float* f = (float*)dst;
+			for (size_t i = 0; i < count; i++, f += 4)
+			{
+				f[0] = p.r[i];
+				f[1] = p.g[i];
+				f[2] = p.b[i];
+				f[3] = p.a[i];
+			}
+			break;
+		}
+
+		case ImageFormat::R32G32B32_FLOAT:
+		{
+			float* f = (float*)dst;
+			for (size_t i = 0; i < count; i++, f += 3)
+			{
+				f[0] = p.r[i];
+				f[1] = p.g[i];
+				f[2] = p.b[i];
+			}
+			break;
+		}
+
+		case ImageFormat::R16G16B16A16_FLOAT:
+		case ImageFormat::R16G16B16A16_UNORM:
+		{
+			int32_t c[4][Chunk];
+			const float* planes[4] = { p.r, p.g, p.b, p.a };
+			bool half = format == ImageFormat::R16G16B16A16_FLOAT;
+			for (int ch = 0; ch < 4; ch++)
+				for (size_t i = 0; i < padded; i += width)
+				{
+					vfloat x = load(planes[ch] + i);
+					storei(c[ch] + i, half ? tohalf(x) : ToUnorm(x, 65535.0f));
+				}
+			uint16_t* h = (uint16_t*)dst;
+			for (size_t i = 0; i < count; i++, h += 4)
+			{
+				h[0] = (uint16_t)c[0][i];
+				h[1] = (uint16_t)c[1][i];
+				h[2] = (uint16_t)c[2][i];
+				h[3] = (uint16_t)c[3][i];
+			}
+			break;
+		}
+
+		case ImageFormat::R10G10B10A2_UNORM:
+		{
+			int32_t words[Chunk];
+			for (size_t i = 0; i < padded; i += width)
+			{
+				vint r = ToUnorm(load(p.r + i), 1023.0f);
+				vint g = ToUnorm(load(p.g + i), 1023.0f);
+				vint b = ToUnorm(load(p.b + i), 1023.0f);
+				vint a = ToUnorm(load(p.a + i), 3.0f);
+				storei(words + i, r | shl<10>(g) | shl<20>(b) | shl<30>(a));
+			}
+			memcpy(dst, words, count * sizeof(uint32_t));
+			break;
+		}
+
+		case ImageFormat::R8G8B8A8_UNORM:
+		{
+			int32_t words[Chunk];
+			for (size_t i = 0; i < padded; i += width)
+			{
+				vint r = ToUnorm(load(p.r + i), 255.0f);
+				vint g = ToUnorm(load(p.g + i), 255.0f);
+				vint b = ToUnorm(load(p.b + i), 255.0f);
+				vint a = ToUnorm(load(p.a + i), 255.0f);
+				storei(words + i, r | shl<8>(g) | shl<16>(b) | shl<24>(a));
+			}
+			memcpy(dst, words, count * sizeof(uint32_t));
+			break;
+		}
+		}
+	}
+
+	void Encode(const Planes& p, size_t count, const PlanarBuffer& dst, uint32_t x, uint32_t y)
+	{
+		size_t offset = y * dst.stride + x;
+		memcpy(dst.r + offset, p.r, count * sizeof(float));
+		memcpy(dst.g + offset, p.g, count * sizeof(float));
+		memcpy(dst.b + offset, p.b, count * sizeof(float));
+		if (dst.a)
+			memcpy(dst.a + offset, p.a, count * sizeof(float));
+	}
+
+	void Encode(const Planes& p, size_t count, const ImageBuffer& dst, uint32_t x, uint32_t y)
+	{
+		Encode(dst.format, p, count, (uint8_t*)dst.data + y * dst.pitch + x * ImageFormatSize(dst.format));
+	}
+
+	// First and one past the last byte a buffer touches.
+	void Extent(const ImageBuffer& image, const uint8_t** begin, const uint8_t** end)
+	{
+		*begin = (const uint8_t*)image.data;
+		*end = *begin;
+		if (image.width && image.height)
+			*end += (image.height - 1) * image.pitch + image.width * ImageFormatSize(image.format);
+	}
+}
+
+size_t ImageFormatSize(ImageFormat format)
+{
+	switch (format)
+	{
+	case ImageFormat::R16G16B16A16_FLOAT: return 8;
+	case ImageFormat::R32G32B32A32_FLOAT: return 16;
+	case ImageFormat::R32G32B32_FLOAT:    return 12;
+	case ImageFormat::R10G10B10A2_UNORM:  return 4;
+	case ImageFormat::R16G16B16A16_UNORM: return 8;
+	case ImageFormat::R8G8B8A8_UNORM:     return 4;
+	}
+	return 0;
+}
+
+ImageConverter::ImageConverter()
+{
+}
+
+ImageConverter& ImageConverter::Then(ColorStep step)
+{
+	double matrix[9], offset[3] = { 0.0, 0.0, 0.0 };
+
+	switch (step)
+	{
+	case ColorStep::Rec709ToRec2020:   MatrixOf(Rec709ToRec2020, matrix); break;
+	case ColorStep::Rec2020ToRec709:   MatrixOf(Rec2020ToRec709, matrix); break;
+	case ColorStep::RecDCIP3toRec2020: MatrixOf(RecDCIP3toRec2020, matrix); break;
+	case ColorStep::Rec2020toDCIP3:    MatrixOf(Rec2020toDCIP3, matrix); break;
+	case ColorStep::AdobeRGBtoRec2020: MatrixOf(AdobeRGBtoRec2020, matrix); break;
+	case ColorStep::Rec2020toAdobeRGB: MatrixOf(Rec2020toAdobeRGB, matrix); break;
+	case ColorStep::Rec709toDCIP3:     MatrixOf(Rec709toDCIP3, matrix); break;
+	case ColorStep::DCIP3toRec709:     MatrixOf(DCIP3toRec709, matrix); break;
+
+	case ColorStep::Linear709ToHDR10:
+		MatrixOf(mat709to2020, 0.008f, matrix);
+		AppendAffine(matrix, offset);
+		AppendStage(StageKind::Apply2084);
+		return *this;
+
+	case ColorStep::HDR10ToLinear709:
+		AppendStage(StageKind::Remove2084);
+		MatrixOf(mat2020to709, 125.0f, matrix);
+		break;
+
+	case ColorStep::RGBtoYCbCr:
+	{
+		// As RGBtoYCbCr(): the float constants, then the chroma offsets.
+		const double m[9] = { 0.299f, .587f, .114f, -.169f, -.331f, .500f, 0.500f, -.419f, -.081f };
+		memcpy(matrix, m, sizeof(m));
+		offset[1] = offset[2] = 128.f / 255.f;
+		break;
+	}
+
+	case ColorStep::YCbCrtoRGB:
+	{
+		// As YCbCrtoRGB(): the offsets come off first, so they go through the matrix.
+		const double m[9] = { 1.0, 0.0, 1.400f, 1.0, -0.343f, -0.711f, 1.0, 1.765f, 0.0 };
+		memcpy(matrix, m, sizeof(m));
+		double chroma = 128.f / 255.f;
+		for (int row = 0; row < 3; row++)
+			offset[row] = -(m[3 * row + 1] + m[3 * row + 2]) * chroma;
+		break;
+	}
+
+	case ColorStep::Apply2084:       AppendStage(StageKind::Apply2084); return *this;
+	case ColorStep::Remove2084:      AppendStage(StageKind::Remove2084); return *this;
+	case ColorStep::ApplySRGBCurve:  AppendStage(StageKind::ApplySRGB); return *this;
+	case ColorStep::RemoveSRGBCurve: AppendStage(StageKind::RemoveSRGB); return *this;
+	case ColorStep::Saturate:        AppendStage(StageKind::Saturate); return *this;
+	}
+
+	AppendAffine(matrix, offset);
+	return *this;
+}
+
+ImageConverter& ImageConverter::Then(const float3x3& matrix, float3 offset)
+{
+	double m[9], o[3] = { offset.x, offset.y, offset.z };
+	MatrixOf(matrix, 1.0, m);
+	AppendAffine(m, o);
+	return *this;
+}
+
+ImageConverter& ImageConverter::Then(const ImageConverter& next)
+{
+	std::vector<Stage> stages = next.m_stages;			// next may be *this
+	for (const Stage& stage : stages)
+	{
+		if (stage.kind == StageKind::Affine)
+			AppendAffine(stage.matrix, stage.offset);
+		else if (stage.kind == StageKind::Power || stage.kind == StageKind::Curve)
+			m_stages.push_back(stage);
+		else
+			AppendStage(stage.kind);
+	}
+	return *this;
+}
+
+ImageConverter& ImageConverter::Power(float exponent)
+{
+	if (exponent != 1.0f)
+	{
+		Stage stage = {};
+		stage.kind = StageKind::Power;
+		stage.rounded[0] = exponent;
+		m_stages.push_back(stage);
+	}
+	return *this;
+}
+
+ImageConverter& ImageConverter::Curve(std::shared_ptr<const CurveTable> curve)
+{
+	Stage stage = {};
+	stage.kind = StageKind::Curve;
+	stage.curve = std::move(curve);
+	m_stages.push_back(stage);
+	return *this;
+}
+
+ImageConverter& ImageConverter::Scale(float scale)
+{
+	double m[9], o[3];
+	Identity(m, o);
+	m[0] = m[4] = m[8] = scale;
+	AppendAffine(m, o);
+	return *this;
+}
+
+// Folds into a preceding affine stage, composing in double, and drops the result if it
+// comes out as the identity.
+void ImageConverter::AppendAffine(const double matrix[9], const double offset[3])
+{
+	Stage stage = {};
+	stage.kind = StageKind::Affine;
+	memcpy(stage.matrix, matrix, sizeof(stage.matrix));
+	memcpy(stage.offset, offset, sizeof(stage.offset));
+
+	if (!m_stages.empty() && m_stages.back().kind == StageKind::Affine)
+	{
+		const Stage& first = m_stages.back();
+		for (int row = 0; row < 3; row++)
+		{
+			for (int col = 0; col < 3; col++)
+				stage.matrix[3 * row + col] = matrix[3 * row] * first.matrix[col]
+											+ matrix[3 * row + 1] * first.matrix[3 + col]
+											+ matrix[3 * row + 2] * first.matrix[6 + col];
+			stage.offset[row] = matrix[3 * row] * first.offset[0]
+							  + matrix[3 * row + 1] * first.offset[1]
+							  + matrix[3 * row + 2] * first.offset[2] + offset[row];
+		}
+		m_stages.pop_back();
+	}
+
+	for (int i = 0; i < 9; i++)
+		stage.rounded[i] = (float)stage.matrix[i];
+	for (int i = 0; i < 3; i++)
+		stage.rounded[9 + i] = (float)stage.offset[i];
+
+	double identity[9], zero[3];
+	Identity(identity, zero);
+	if (memcmp(stage.matrix, identity, sizeof(identity)) || memcmp(stage.offset, zero, sizeof(zero)))
+		m_stages.push_back(stage);
+}
+
+// The PQ stages clamp as they go, so a Saturate right before one is dropped, as is a
+// second Saturate in a row.
+void ImageConverter::AppendStage(StageKind kind)
+{
+	if (!m_stages.empty() && m_stages.back().kind == StageKind::Saturate &&
+		(kind == StageKind::Apply2084 || kind == StageKind::Remove2084 || kind == StageKind::Saturate))
+		m_stages.pop_back();
+
+	Stage stage = {};
+	stage.kind = kind;
+	m_stages.push_back(stage);
+}
+
+const char* ImageConverter::GetStageName(size_t stage) const
+{
+	if (stage >= m_stages.size())
+		return nullptr;
+
+	switch (m_stages[stage].kind)
+	{
+	case StageKind::Affine:     return "matrix";
+	case StageKind::Apply2084:  return "pq encode";
+	case StageKind::Remove2084: return "pq decode";
+	case StageKind::ApplySRGB:  return "srgb encode";
+	case StageKind::RemoveSRGB: return "srgb decode";
+	case StageKind::Saturate:   return "saturate";
+	case StageKind::Power:      return "power";
+	case StageKind::Curve:      return "curve";
+	}
+	return nullptr;
+}
+
+float3 ImageConverter::Convert(float3 color) const
+{
+	for (const Stage& stage : m_stages)
+	{
+		switch (stage.kind)
+		{
+		case StageKind::Affine:
+		{
+			const float* m = stage.rounded;
+			color = float3(color.x * m[0] + color.y * m[1] + color.z * m[2] + m[9],
+						   color.x * m[3] + color.y * m[4] + color.z * m[5] + m[10],
+						   color.x * m[6] + color.y * m[7] + color.z * m[8] + m[11]);
+			break;
+		}
+		case StageKind::Apply2084:  color = Apply2084(color); break;
+		case StageKind::Remove2084: color = Remove2084(saturate(color)); break;
+		case StageKind::ApplySRGB:  color = ApplySRGBCurve(color); break;
+		case StageKind::RemoveSRGB: color = RemoveSRGBCurve(color); break;
+		case StageKind::Saturate:   color = saturate(color); break;
+		case StageKind::Power:
+			color = float3(powf(std::max(color.x, 0.0f), stage.rounded[0]),
+						   powf(std::max(color.y, 0.0f), stage.rounded[0]),
+						   powf(std::max(color.z, 0.0f), stage.rounded[0]));
+			break;
+		case StageKind::Curve:
+			color = float3((*stage.curve)(color.x), (*stage.curve)(color.y), (*stage.curve)(color.z));
+			break;
+		}
+	}
+	return color;
+}
+
+// count is a whole number of vectors.
+void ImageConverter::Run(float* r, float* g, float* b, size_t count, size_t firstStage) const
+{
+	for (size_t i = firstStage; i < m_stages.size(); i++)
+	{
+		const Stage& stage = m_stages[i];
+		switch (stage.kind)
+		{
+		case StageKind::Affine:     Affine(stage.rounded, r, g, b, count); break;
+		case StageKind::Apply2084:
+			Apply2084_Table(r, r, count);
+			Apply2084_Table(g, g, count);
+			Apply2084_Table(b, b, count);
+			break;
+		case StageKind::Remove2084: Remove2084(r, g, b, r, g, b, count); break;
+		case StageKind::ApplySRGB:  EachPlane(r, g, b, count, ApplySRGBKernel); break;
+		case StageKind::RemoveSRGB: EachPlane(r, g, b, count, RemoveSRGBKernel); break;
+		case StageKind::Saturate:   EachPlane(r, g, b, count, [](vfloat x) { return saturate(x); }); break;
+		case StageKind::Power:
+		{
+			vfloat exponent = stage.rounded[0];
+			EachPlane(r, g, b, count, [&](vfloat x) { return pow(max(x, vfloat(0.0f)), exponent); });
+			break;
+		}
+		case StageKind::Curve:
+		{
+			const CurveTable& curve = *stage.curve;
+			EachPlane(r, g, b, count, [&](vfloat x) { return CurveKernel(curve, x); });
+			break;
+		}
+		}
+	}
+}
+
+// Bands of rows across the pool, each row a chunk at a time: decode, run, encode.  A
+// 10-bit source whose first stage is the PQ decode is decoded through the code table.
+template <class Source, class Destination>
+void ImageConverter::ConvertTiles(const Source& src, const Destination& dst, ThreadPool* pool) const
+{
+	if (!pool)
+		pool = &ThreadPool::Default();
+
+	bool pq = DecodesPQ(src) && !m_stages.empty() && m_stages[0].kind == StageKind::Remove2084;
+	uint32_t tiles = (src.height + TileRows - 1) / TileRows;
+	pool->ParallelFor(0, tiles, [&](size_t tile)
+	{
+		Planes planes;
+		uint32_t end = std::min(src.height, (uint32_t)(tile + 1) * TileRows);
+		for (uint32_t y = (uint32_t)tile * TileRows; y < end; y++)
+		{
+			for (uint32_t x = 0; x < src.width; x += Chunk)
+			{
+				size_t count = std::min((uint32_t)Chunk, src.width - x);
+				Decode(src, x, y, count, planes, pq);
+				Run(planes.r, planes.g, planes.b, (count + width - 1) / width * width, pq ? 1 : 0);
+				Encode(planes, count, dst, x, y);
+			}
+		}
+	});
+}
+
+bool ImageConverter::Convert(const ImageBuffer& src, const ImageBuffer& dst, ThreadPool* pool) const
+{
+	if (src.width != dst.width || src.height != dst.height)
+		return false;
+
+	const uint8_t *srcBegin, *srcEnd, *dstBegin, *dstEnd;
+	Extent(src, &srcBegin, &srcEnd);
+	Extent(dst, &dstBegin, &dstEnd);
+	bool inPlace = src.data == dst.data && src.format == dst.format && src.pitch == dst.pitch;
+	if (!inPlace && srcBegin < dstEnd && dstBegin < srcEnd)
+		return false;
+
+	ConvertTiles(src, dst, pool);
+	return true;
+}
+
+bool ImageConverter::Convert(const ImageBuffer& src, const PlanarBuffer& dst, ThreadPool* pool) const
+{
+	if (src.width != dst.width || src.height != dst.height)
+		return false;
+	ConvertTiles(src, dst, pool);
+	return true;
+}
+
+bool ImageConverter::Convert(const PlanarBuffer& src, const ImageBuffer& dst, ThreadPool* pool) const
+{
+	if (src.width != dst.width || src.height != dst.height)
+		return false;
+	ConvertTiles(src, dst, pool);
+	return true;
+}
+
+bool ImageConverter::Convert(const PlanarBuffer& src, const PlanarBuffer& dst, ThreadPool* pool) const
+{
+	if (src.width != dst.width || src.height != dst.height)
+		return false;
+	ConvertTiles(src, dst, pool);
+	return true;
+}
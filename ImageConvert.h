@@ -0,0 +1,208 @@
+//
+// ImageConvert.h
+//
+// Whole-image color conversion for capture analysis and pattern export.  A conversion is
+// built as a chain of the per-pixel steps in ColorSpaces.h (Rec709ToRec2020(),
+// Linear709ToHDR10(), RGBtoYCbCr(), ...) and compiled into a short program of fused
+// stages: runs of matrices, scales and offsets fold into one affine transform, computed
+// in double, so Rec709ToRec2020 then Rec2020toDCIP3 then a scale is a single 3x3 pass,
+// and the transfer functions (PQ, sRGB) stay as the stages in between.
+//
+// Convert() decodes each tile of the source into planar float, runs the program over it
+// with the SIMD kernels (SimdMath.h, TransferBatch.h), and encodes into the destination,
+// tiles across a ThreadPool.  Source and destination may be any of the formats below,
+// with any pitch, or planar float RGB and optional alpha (the Image of
+// AdvancedColorPipeline.h), and may be
+// the same buffer when they share format and pitch.  Alpha is carried through untouched
+// (1 where the source has none); UNORM destinations clamp to [0,1] and round to nearest.
+//
+// PQ encode goes through the interpolated table of TransferTables.h, several times faster
+// than the pow() kernels and closer to the exact curve, and a PQ decode that directly
+// follows an R10G10B10A2_UNORM source is a lookup of the exact 10-bit code table.  Other
+// PQ decodes and the sRGB curves use the span kernels (TransferBatch.h, SimdMath.h).  Results match the per-pixel functions
+// to float rounding in the folded matrices and the accuracy of the curves: well under a
+// tenth of a 10-bit code on HDR10 output.
+//
+// Curve() adds a 1D curve baked into a CurveTable, run on each channel with the same
+// octave-indexed interpolation as the encode tables; the tone curves of ToneMap.h are
+// applied this way, so a tone map fuses into the surrounding pass like any other stage.
+//
+
+#pragma once
+
+#include <array>
+#include <math.h>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "BasicMath.h"
+#include "TransferTables.h"
+
+class ThreadPool;
+
+enum class ImageFormat
+{
+	R16G16B16A16_FLOAT,			// scRGB swap chains and captures
+	R32G32B32A32_FLOAT,
+	R32G32B32_FLOAT,
+	R10G10B10A2_UNORM,			// HDR10 swap chains
+	R16G16B16A16_UNORM,
+	R8G8B8A8_UNORM,				// SDR swap chains
+};
+
+// Bytes per pixel of a format.
+size_t ImageFormatSize(ImageFormat format);
+
+// A strided view of pixels; pitch is in bytes between rows.
+struct ImageBuffer
+{
+	void*       data;
+	uint32_t    width;
+	uint32_t    height;
+	size_t      pitch;
+	ImageFormat format;
+};
+
+// Planar float RGB; stride is in floats between rows.  The alpha plane is optional: a
+// null one reads as 1 and is not written.
+struct PlanarBuffer
+{
+	float*   r;
+	float*   g;
+	float*   b;
+	uint32_t width;
+	uint32_t height;
+	size_t   stride;
+	float*   a;
+};
+
+// The steps a conversion chain is built from, named for the ColorSpaces.h function each
+// one reproduces.
+enum class ColorStep
+{
+	Rec709ToRec2020,
+	Rec2020ToRec709,
+	RecDCIP3toRec2020,
+	Rec2020toDCIP3,
+	AdobeRGBtoRec2020,
+	Rec2020toAdobeRGB,
+	Rec709toDCIP3,
+	DCIP3toRec709,
+	Linear709ToHDR10,			// scRGB to PQ signal in 2020 primaries
+	HDR10ToLinear709,
+	RGBtoYCbCr,
+	YCbCrtoRGB,
+	Apply2084,					// clamps to [0,1] first
+	Remove2084,					// clamps to [0,1] first
+	ApplySRGBCurve,
+	RemoveSRGBCurve,
+	Saturate,
+};
+
+// A curve on [0,1], sampled like the encode tables of TransferTables.h: 128 segments per
+// octave over the top 16 octaves, interpolated linearly.  Below 2^-16, negative values
+// included, it goes on as a line through the origin; above 1 it holds its value at 1.
+class CurveTable
+{
+public:
+	static const int Octaves = 16;
+
+	// Samples fn(double x) at the segment ends.
+	template <class Fn>
+	explicit CurveTable(Fn fn)
+	{
+		const size_t segments = (size_t)1 << EncodeTableSegmentBits;
+		for (size_t i = 0; i < m_samples.size(); i++)
+		{
+			double x = ldexp(1.0 + (double)(i % segments) / segments, (int)(i / segments) - Octaves);
+			m_samples[i] = (float)fn(x < 1.0 ? x : 1.0);
+		}
+		m_slope = m_samples[0] / Low();
+	}
+
+	float operator()(float x) const
+	{
+		if (x < Low())
+			return x * m_slope;
+		return EncodeTableLookup(m_samples, Octaves, x < 1.0f ? x : 1.0f);
+	}
+
+	static float Low() { return 1.0f / (1 << Octaves); }
+
+	const float* GetSamples() const { return m_samples.data(); }
+	float GetSlope() const { return m_slope; }					// below Low()
+
+private:
+	std::array<float, (Octaves << EncodeTableSegmentBits) + 2> m_samples;
+	float m_slope;
+};
+
+class ImageConverter
+{
+public:
+	// Starts as the identity.
+	ImageConverter();
+
+	// Appends a step, an arbitrary color = mul(matrix, color) + offset, or every stage of
+	// another converter, folding across the join.
+	ImageConverter& Then(ColorStep step);
+	ImageConverter& Then(const float3x3& matrix, float3 offset = float3(0.0f, 0.0f, 0.0f));
+	ImageConverter& Then(const ImageConverter& next);
+	ImageConverter& Scale(float scale);
+
+	// Each channel to pow(max(c, 0), exponent), for gamma curves.
+	ImageConverter& Power(float exponent);
+
+	// Each channel through curve.  The converter keeps a reference to the table.
+	ImageConverter& Curve(std::shared_ptr<const CurveTable> curve);
+
+	bool IsIdentity() const { return m_stages.empty(); }
+
+	// The compiled program, for logs: stage count and e.g. "matrix, pq encode".
+	size_t GetStageCount() const { return m_stages.size(); }
+	const char* GetStageName(size_t stage) const;
+
+	// Runs the program on one color with the scalar ColorSpaces.h functions.
+	float3 Convert(float3 color) const;
+
+	// Converts every pixel of src into dst, which must have the same size.  pool ==
+	// nullptr uses ThreadPool::Default().  Returns false, converting nothing, on a size
+	// mismatch or overlapping buffers that are not exactly the same.  Planar buffers are
+	// not checked for overlap; the same planes as source and destination are fine.
+	bool Convert(const ImageBuffer& src, const ImageBuffer& dst, ThreadPool* pool = nullptr) const;
+	bool Convert(const ImageBuffer& src, const PlanarBuffer& dst, ThreadPool* pool = nullptr) const;
+	bool Convert(const PlanarBuffer& src, const ImageBuffer& dst, ThreadPool* pool = nullptr) const;
+	bool Convert(const PlanarBuffer& src, const PlanarBuffer& dst, ThreadPool* pool = nullptr) const;
+
+private:
+	enum class StageKind
+	{
+		Affine,
+		Apply2084,
+		Remove2084,
+		ApplySRGB,
+		RemoveSRGB,
+		Saturate,
+		Power,
+		Curve,
+	};
+
+	struct Stage
+	{
+		StageKind                         kind;
+		double                            matrix[9];		// Affine only, row major
+		double                            offset[3];
+		float                             rounded[12];		// matrix then offset, as run; the exponent of Power
+		std::shared_ptr<const CurveTable> curve;			// Curve only
+	};
+
+	void AppendAffine(const double matrix[9], const double offset[3]);
+	void AppendStage(StageKind kind);
+	void Run(float* r, float* g, float* b, size_t count, size_t firstStage) const;
+
+	template <class Source, class Destination>
+	void ConvertTiles(const Source& src, const Destination& dst, ThreadPool* pool) const;
+
+	std::vector<Stage> m_stages;
+};
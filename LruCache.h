@@ -0,0 +1,76 @@
+//
+// LruCache.h
+//
+// A map of bounded size that drops the least recently used entry to make room, for the
+// caches that live across frames: device brushes (BrushCache.h) and tone curve tables
+// (ToneMap.h).  Keys are short arrays of 32-bit words, hashed with WordKeyHash.  Not
+// thread safe; an owner shared between threads locks around it.
+//
+
+#pragma once
+
+#include <list>
+#include <stddef.h>
+#include <stdint.h>
+#include <unordered_map>
+#include <utility>
+
+// FNV-1a over the key's words, for any container of uint32_t.
+struct WordKeyHash
+{
+	template <typename Key>
+	size_t operator()(const Key& key) const
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		for (uint32_t word : key)
+			hash = (hash ^ word) * 0x100000001b3ull;
+		return (size_t)hash;
+	}
+};
+
+// Most recently used first.
+template <typename Key, typename Value, typename Hash = WordKeyHash>
+class LruCache
+{
+public:
+	explicit LruCache(size_t capacity) : m_capacity(capacity ? capacity : 1) {}
+
+	// A hit becomes the most recently used entry.
+	Value* Find(const Key& key)
+	{
+		auto it = m_index.find(key);
+		if (it == m_index.end())
+			return nullptr;
+		m_order.splice(m_order.begin(), m_order, it->second);
+		return &it->second->second;
+	}
+
+	// key must not be present.  Counts an entry dropped to stay within capacity in evicted.
+	Value& Insert(const Key& key, Value value, uint64_t* evicted)
+	{
+		if (m_order.size() >= m_capacity)
+		{
+			m_index.erase(m_order.back().first);
+			m_order.pop_back();
+			(*evicted)++;
+		}
+		m_order.emplace_front(key, std::move(value));
+		m_index[key] = m_order.begin();
+		return m_order.front().second;
+	}
+
+	void Clear()
+	{
+		m_index.clear();
+		m_order.clear();
+	}
+
+	size_t Size() const { return m_order.size(); }
+
+private:
+	typedef std::list<std::pair<Key, Value>> Order;
+
+	size_t                                                  m_capacity;
+	Order                                                   m_order;
+	std::unordered_map<Key, typename Order::iterator, Hash> m_index;
+};
@@ -0,0 +1,141 @@
+//
+// PQCodeTable.cpp
+//
+
+#include "ColorSpaces.h"
+#include "Half.h"
+#include "PQCodeTable.h"
+#include "ThreadPool.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+	// FP16 values tried on each side of the naive one.  The slider and the 709 to 2020
+	// rotation move the result by a few FP16 steps at most; a 10-bit code spans at least
+	// a dozen steps and a 12-bit code at least three, away from the very top.
+	const int SearchRadius = 32;
+
+	const uint16_t HalfMax = 0x7BFF;		// 65504
+
+	// The PQ signal of each channel of a gray FP16 value as it is scanned out.
+	float3 ScanoutSignal(float cccs, float sliderFactor)
+	{
+		float c = HalfToFloat(FloatToHalf(cccs)) * sliderFactor;
+		return Linear709ToHDR10(float3(c, c, c));
+	}
+}
+
+uint32_t ScanoutPQCode(float cccs, float sliderFactor, int bits, uint32_t* codes)
+{
+	float maxCode = (float)((1u << bits) - 1);
+	float3 signal = ScanoutSignal(cccs, sliderFactor);
+
+	uint32_t rgb[3] =
+	{
+		(uint32_t)roundf(signal.r * maxCode),
+		(uint32_t)roundf(signal.g * maxCode),
+		(uint32_t)roundf(signal.b * maxCode)
+	};
+	if (codes)
+		memcpy(codes, rgb, sizeof(rgb));
+	return std::min(rgb[0], std::min(rgb[1], rgb[2]));
+}
+
+PQCodeTable::PQCodeTable() :
+	m_bits(0),
+	m_maxCode(0),
+	m_sliderFactor(1.0f)
+{
+}
+
+PQCodeTable::PQCodeTable(int bits, float sliderFactor, ThreadPool* pool) :
+	m_bits(bits),
+	m_maxCode((1u << bits) - 1),
+	m_sliderFactor(ValidSliderFactor(sliderFactor))
+{
+	if (!pool)
+		pool = &ThreadPool::Default();
+
+	m_entries.resize(m_maxCode + 1);
+	pool->ParallelFor(0, m_entries.size(), [this](size_t code)
+	{
+		m_entries[code] = Solve((uint32_t)code);
+	}, 64);
+}
+
+float PQCodeTable::ValidSliderFactor(float sliderFactor)
+{
+	return sliderFactor > 0.0f && sliderFactor <= FLT_MAX ? sliderFactor : 1.0f;
+}
+
+const PQCodeEntry& PQCodeTable::GetEntry(uint32_t code) const
+{
+	static const PQCodeEntry black = { 0, 0.0f, true };
+	if (m_entries.empty())
+		return black;
+	return m_entries[code < m_maxCode ? code : m_maxCode];
+}
+
+uint32_t PQCodeTable::GetCode(float nits) const
+{
+	float signal = Apply2084(std::min(std::max(nits / 10000.f, 0.0f), 1.0f));
+	return (uint32_t)roundf(signal * (float)m_maxCode);
+}
+
+size_t PQCodeTable::GetInexactCount() const
+{
+	size_t count = 0;
+	for (auto& entry : m_entries)
+		count += !entry.exact;
+	return count;
+}
+
+// Ranks the candidates by how many codes they miss by on the worst channel, then by the
+// distance of the worst channel's signal from the code, then by how far they are from
+// the naive value.
+PQCodeEntry PQCodeTable::Solve(uint32_t code) const
+{
+	float maxCode = (float)m_maxCode;
+	float naive = Remove2084((float)code / maxCode) * 125.0f / m_sliderFactor;
+	int center = FloatToHalf(naive);
+
+	int first = std::max(center - SearchRadius, 0);
+	int last = std::min(center + SearchRadius, (int)HalfMax);
+
+	uint16_t bestHalf = (uint16_t)center;
+	uint32_t bestMiss = UINT32_MAX;
+	float bestError = INFINITY;
+	int bestDistance = INT32_MAX;
+
+	for (int h = first; h <= last; h++)
+	{
+		float cccs = HalfToFloat((uint16_t)h);
+		float3 signal = ScanoutSignal(cccs, m_sliderFactor);
+
+		uint32_t miss = 0;
+		float error = 0.0f;
+		for (float channel : { signal.r, signal.g, signal.b })
+		{
+			float scaled = channel * maxCode;
+			int32_t quantized = (int32_t)roundf(scaled);
+			miss = std::max(miss, (uint32_t)abs(quantized - (int32_t)code));
+			error = std::max(error, fabsf(scaled - (float)code));
+		}
+		int distance = abs(h - center);
+
+		if (miss < bestMiss || (miss == bestMiss && (error < bestError ||
+			(error == bestError && distance < bestDistance))))
+		{
+			bestHalf = (uint16_t)h;
+			bestMiss = miss;
+			bestError = error;
+			bestDistance = distance;
+		}
+	}
+
+	PQCodeEntry entry = { bestHalf, HalfToFloat(bestHalf), bestMiss == 0 };
+	return entry;
+}
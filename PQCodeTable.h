@@ -0,0 +1,72 @@
+//
+// PQCodeTable.h
+//
+// The FP16 scRGB value to draw for each PQ code, so that a gray patch meant to be HDR10
+// code N leaves the display pipeline as code N.  Computing nitstoCCCS(Remove2084(N))
+// and dividing by the brightness slider in float lands a code or so off, since the value
+// is rounded to FP16 in the swap chain, scaled back up by the slider and re-encoded with
+// Linear709ToHDR10() before it is quantized for scan-out.
+//
+// The table models that round trip for each code and searches the FP16 values around the
+// naive one for those that come back as exactly N on all three channels, keeping the one
+// whose PQ signal is closest to the code's center.  The few codes no FP16 value can reach
+// (at 12 bits, near black and near 10,000 nits) get the closest value and are reported
+// as inexact.  The codes are solved in parallel on a ThreadPool.  A table is built per
+// bit depth and slider factor; TestPatterns keeps the 10-bit one for the current output.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class ThreadPool;
+
+// HDR10 codes for a gray scRGB brush value at the given bit depth: the value is stored as
+// FP16, multiplied by the slider factor, passed through Linear709ToHDR10() and rounded.
+// Returns the smallest of the three channel codes; codes receives all three if not null.
+uint32_t ScanoutPQCode(float cccs, float sliderFactor, int bits, uint32_t* codes = nullptr);
+
+struct PQCodeEntry
+{
+	uint16_t half;			// FP16 bits to draw
+	float    cccs;			// the same value as a float, 1.0 = 80 nits before the slider
+	bool     exact;			// whether it scans out as the code on all three channels
+};
+
+class PQCodeTable
+{
+public:
+	PQCodeTable();
+
+	// bits is 10 or 12.  sliderFactor is the raw peak over the reported one, as
+	// BRIGHTNESS_SLIDER_FACTOR, and goes through ValidSliderFactor().  pool == nullptr
+	// uses ThreadPool::Default().
+	PQCodeTable(int bits, float sliderFactor, ThreadPool* pool = nullptr);
+
+	// sliderFactor, or 1 (no slider) if it is not finite and positive, as when an output
+	// reports no luminance and the factor divides by zero.
+	static float ValidSliderFactor(float sliderFactor);
+
+	// Codes past the top are clamped.  An empty table returns black.
+	const PQCodeEntry& GetEntry(uint32_t code) const;
+	float GetCCCS(uint32_t code) const { return GetEntry(code).cccs; }
+
+	// The nearest code to a luminance in nits.
+	uint32_t GetCode(float nits) const;
+
+	int GetBits() const { return m_bits; }
+	uint32_t GetMaxCode() const { return m_maxCode; }
+	float GetSliderFactor() const { return m_sliderFactor; }
+	size_t GetInexactCount() const;
+	bool IsEmpty() const { return m_entries.empty(); }
+
+private:
+	PQCodeEntry Solve(uint32_t code) const;
+
+	int                      m_bits;
+	uint32_t                 m_maxCode;
+	float                    m_sliderFactor;
+	std::vector<PQCodeEntry> m_entries;
+};
@@ -0,0 +1,168 @@
+//
+// PQVerify.cpp
+//
+// Command-line front end to HalfPQSweep: pushes every FP16 value through the scRGB to
+// HDR10 conversion at 10 and 12 bits, gray and each primary, with and without the 709
+// to 2020 rotation, and prints gaps, non-monotonic steps and the worst error against a
+// double precision evaluation.  Exits with 1 if any sweep fails, so it can run after
+// every change to ColorSpaces.h.  Not part of the app project; build it directly, e.g.
+//
+//   g++ -std=c++17 -O2 -mavx2 -mfma -pthread PQVerify.cpp HalfPQSweep.cpp ThreadPool.cpp -o pqverify
+//   cl /std:c++17 /O2 /arch:AVX2 /EHsc PQVerify.cpp HalfPQSweep.cpp ThreadPool.cpp /Fe:pqverify.exe
+//
+// Usage: pqverify [--bits 10|12] [--no-rotate] [--rotate] [--input gray|red|green|blue]
+//                 [--threads N] [--map]
+//
+// By default every combination is swept.  --map prints the inverse map, the range of
+// halves landing on each code, for the sweeps selected.
+//
+
+#include "Half.h"
+#include "HalfPQSweep.h"
+#include "SimdMath.h"
+#include "ThreadPool.h"
+
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+	const char* InputNames[] = { "gray", "red", "green", "blue" };
+	const char* ChannelNames[] = { "R", "G", "B" };
+
+	// Up to this many gaps or non-monotonic halves are listed per channel.
+	const size_t MaxListed = 8;
+
+	void PrintList(const char* what, const std::vector<uint32_t>& codes)
+	{
+		printf("      %zu %s:", codes.size(), what);
+		for (size_t i = 0; i < codes.size() && i < MaxListed; i++)
+			printf(" %u", codes[i]);
+		printf(codes.size() > MaxListed ? " ...\n" : "\n");
+	}
+
+	void PrintReport(const HalfPQReport& report, bool map)
+	{
+		const HalfPQOptions& options = report.options;
+		printf("%2d-bit  %-5s  %-9s  %7.2f ms  %s\n", options.bits, InputNames[(int)options.input],
+			   options.rotate ? "709->2020" : "2020", report.milliseconds, report.Passed() ? "pass" : "FAIL");
+
+		for (int c = 0; c < 3; c++)
+		{
+			const HalfPQChannel& channel = report.channels[c];
+			printf("    %s  codes %4u..%-4u  worst err %.4f codes at half 0x%04x (%g)  %u misrounded\n",
+				   ChannelNames[c], channel.lowest, channel.highest, channel.worstError,
+				   channel.worstHalf, HalfToFloat(channel.worstHalf), channel.misrounded);
+			if (!channel.gaps.empty())
+				PrintList("gaps at codes", channel.gaps);
+			if (!channel.nonMonotonic.empty())
+			{
+				std::vector<uint32_t> halves(channel.nonMonotonic.begin(), channel.nonMonotonic.end());
+				PrintList("non-monotonic steps at halves", halves);
+			}
+
+			if (map)
+			{
+				for (uint32_t code = channel.lowest; code <= channel.highest; code++)
+				{
+					const HalfPQCodeRange& range = channel.ranges[code];
+					if (range.count)
+						printf("      %4u  0x%04x..0x%04x  %-12g .. %-12g %u\n", code, range.first, range.last,
+							   HalfToFloat(range.first), HalfToFloat(range.last), range.count);
+					else
+						printf("      %4u  -\n", code);
+				}
+			}
+		}
+
+		if (report.halfDecodeErrors || report.badNegatives || report.badInfinities)
+			printf("    %u half decode errors, %u negatives off code 0, %u infinities off the top code\n",
+				   report.halfDecodeErrors, report.badNegatives, report.badInfinities);
+		if (report.nanSignals)
+			printf("    %u NaN halves give a NaN signal\n", report.nanSignals);
+	}
+
+	void Usage()
+	{
+		fprintf(stderr,
+				"usage: pqverify [--bits 10|12] [--no-rotate] [--rotate] [--input gray|red|green|blue]\n"
+				"                [--threads N] [--map]\n"
+				"  --bits       sweep one bit depth (default 10 and 12)\n"
+				"  --rotate     only the Linear709ToHDR10() path\n"
+				"  --no-rotate  only the path without the 709 to 2020 rotation\n"
+				"  --input      which channels the half drives (default all four)\n"
+				"  --threads    worker count including the caller (default: one per hardware thread)\n"
+				"  --map        print the codes each half range lands on\n");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<int> bits = { 10, 12 };
+	std::vector<bool> rotations = { true, false };
+	std::vector<HalfPQInput> inputs = { HalfPQInput::Gray, HalfPQInput::Red, HalfPQInput::Green, HalfPQInput::Blue };
+	unsigned threads = 0;
+	bool map = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		bool hasValue = i + 1 < argc;
+		if (!strcmp(arg, "--bits") && hasValue && (atoi(argv[i + 1]) == 10 || atoi(argv[i + 1]) == 12))
+			bits = { atoi(argv[++i]) };
+		else if (!strcmp(arg, "--rotate"))
+			rotations = { true };
+		else if (!strcmp(arg, "--no-rotate"))
+			rotations = { false };
+		else if (!strcmp(arg, "--input") && hasValue)
+		{
+			const char* name = argv[++i];
+			int found = -1;
+			for (int n = 0; n < 4; n++)
+				if (!strcmp(name, InputNames[n]))
+					found = n;
+			if (found < 0)
+			{
+				Usage();
+				return 2;
+			}
+			inputs = { (HalfPQInput)found };
+		}
+		else if (!strcmp(arg, "--threads") && hasValue)
+			threads = (unsigned)atoi(argv[++i]);
+		else if (!strcmp(arg, "--map"))
+			map = true;
+		else
+		{
+			Usage();
+			return 2;
+		}
+	}
+
+	std::unique_ptr<ThreadPool> pool(new ThreadPool(threads));
+	printf("%u threads, %s\n", pool->Size(), simd::PathName());
+
+	bool passed = true;
+	double total = 0.0;
+	HalfPQReport report;
+	for (int b : bits)
+	{
+		for (bool rotate : rotations)
+		{
+			for (HalfPQInput input : inputs)
+			{
+				HalfPQOptions options = { b, rotate, input };
+				SweepHalfToPQ(options, &report, pool.get());
+				PrintReport(report, map);
+				passed = passed && report.Passed();
+				total += report.milliseconds;
+			}
+		}
+	}
+
+	printf("%s in %.1f ms\n", passed ? "all sweeps pass" : "FAILED", total);
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+//
+// PanelColorModel.cpp
+//
+
+#include "CodeValues.h"
+#include "ColorSpaces.h"
+#include "PanelColorModel.h"
+
+namespace
+{
+	const float SdrWhiteLevels[4] = { 80.0f, 160.0f, 240.0f, 320.0f };
+
+	// XYZ of a primary at chromaticity xy with the given luminance.
+	float3 PrimaryXYZ(float2 xy, float Y)
+	{
+		float3 XYZ;
+		XYZ.y = Y;
+		XYZ.x = XYZ.y*xy.x / xy.y;
+		XYZ.z = XYZ.y*(1.0f - xy.x - xy.y) / xy.y;
+		return XYZ;
+	}
+
+	// Twice the signed area of the xy triangle: zero when the primaries do not span a
+	// gamut and the panel matrix cannot be inverted (inv() aborts), as for an output
+	// that reports no primaries.  Those panels get black patches.
+	float TriangleArea(float2 a, float2 b, float2 c)
+	{
+		return (b.x - a.x)*(c.y - a.y) - (c.x - a.x)*(b.y - a.y);
+	}
+}
+
+PanelColorModel::PanelColorModel() :
+	m_maxLuminance(0.0f),
+	m_sliderFactor(1.0f)
+{
+	for (int i = 0; i < PatchCount; i++)
+	{
+		m_patches[i] = PanelPatch();
+		m_maxPatches[i] = PanelPatch();
+	}
+	for (int i = 0; i < 4; i++)
+		m_sdrWhiteCCCS[i] = nitstoCCCS(SdrWhiteLevels[i]);
+}
+
+PanelColorModel::PanelColorModel(float2 red, float2 green, float2 blue, float2 white, float maxLuminance,
+								 float sliderFactor) :
+	PanelColorModel()
+{
+	m_maxLuminance = maxLuminance;
+	m_sliderFactor = sliderFactor;
+
+	const float2 xy[PatchCount] = { red, green, blue, white };
+	for (int i = 0; i < PatchCount; i++)
+		m_patches[i].xy = xy[i];
+
+	const float WhiteLevel = 1.0f;				// reference value only
+	float3 WhiteCol = xytoXYZ(white, WhiteLevel);
+	float3 RedCol   = xytoXYZ(red, WhiteLevel);
+	float3 GreenCol = xytoXYZ(green, WhiteLevel);
+	float3 BlueCol  = xytoXYZ(blue, WhiteLevel);
+
+	m_panelMatrix = float3x3(
+		RedCol.x, GreenCol.x, BlueCol.x,
+		RedCol.y, GreenCol.y, BlueCol.y,
+		RedCol.z, GreenCol.z, BlueCol.z
+	);
+
+	float K = maxLuminance / 10000.f;
+
+	// Each primary scaled so that the three add up to the white point at peak.  The
+	// outline does the same over the BT.2020 primaries.
+	bool spansGamut = red.y > 0.0f && green.y > 0.0f && blue.y > 0.0f && fabsf(TriangleArea(red, green, blue)) > 1.0e-6f;
+	if (spansGamut)
+	{
+		m_invPanelMatrix = inv(m_panelMatrix);
+		float3 Yrow = m_invPanelMatrix*WhiteCol*K;
+		float3 Yrow2020 = inv(XYZ_to_BT2020RGB)*WhiteCol*K;
+
+		float3 W2020 = XYZ_to_BT2020RGB*WhiteCol*K;
+		m_patches[Red].bt2020   = XYZ_to_BT2020RGB*PrimaryXYZ(red, Yrow.x);
+		m_patches[Green].bt2020 = XYZ_to_BT2020RGB*PrimaryXYZ(green, Yrow.y);
+		m_patches[Blue].bt2020  = XYZ_to_BT2020RGB*PrimaryXYZ(blue, Yrow.z);
+		m_patches[White].bt2020 = W2020;
+
+		float3 outline2020[PatchCount] =
+		{
+			XYZ_to_BT2020RGB*PrimaryXYZ(red, Yrow2020.x),
+			XYZ_to_BT2020RGB*PrimaryXYZ(green, Yrow2020.y),
+			XYZ_to_BT2020RGB*PrimaryXYZ(blue, Yrow2020.z),
+			W2020
+		};
+
+		for (int i = 0; i < PatchCount; i++)
+		{
+			PanelPatch& patch = m_patches[i];
+			patch.hdr10 = Apply2084(patch.bt2020);
+			patch.cccs = HDR10ToLinear709(patch.hdr10);
+			patch.displayCode = Apply2084(patch.bt2020*sliderFactor)*PqCode<10>::Scale;
+			patch.outlineCCCS = HDR10ToLinear709(Apply2084(outline2020[i]));
+		}
+		m_patches[Blue].outlineCCCS.r = 0.f;
+	}
+
+	// 6.b MAX: BT.2020 primaries at PQ code 636 (about 1000 nits) on every channel.
+	const float2 maxXY[PatchCount] = { primaryR_2020, primaryG_2020, primaryB_2020, D6500White };
+	const float signal = PqCode<10>::Signal(636u);
+	const float3 maxSpec[PatchCount] =
+	{
+		float3(signal, 0.0f, 0.0f),
+		float3(0.0f, signal, 0.0f),
+		float3(0.0f, 0.0f, signal),
+		float3(signal, signal, signal),
+	};
+	for (int i = 0; i < PatchCount; i++)
+	{
+		PanelPatch& patch = m_maxPatches[i];
+		patch.xy = maxXY[i];
+		patch.hdr10 = maxSpec[i];
+		patch.bt2020 = float3(Remove2084(patch.hdr10.x), Remove2084(patch.hdr10.y), Remove2084(patch.hdr10.z));
+		patch.cccs = HDR10ToLinear709(patch.hdr10);
+
+		float3 hdr10 = Linear709ToHDR10(patch.cccs)*PqCode<10>::Scale;
+		patch.displayCode = float3(roundf(std::max(hdr10.x, 0.0f)), roundf(std::max(hdr10.y, 0.0f)),
+								   roundf(std::max(hdr10.z, 0.0f)));
+	}
+}
+
+float PanelColorModel::GetSdrWhiteLevel(int index)
+{
+	return SdrWhiteLevels[index];
+}
@@ -0,0 +1,74 @@
+//
+// PanelColorModel.h
+//
+// The colors the color patch tests draw, worked out once per panel instead of on every
+// frame.  For red, green, blue and white of test 6 this holds the patch at the panel's
+// reported peak (the primary's chromaticity, scaled so the three sum to the white point
+// at that luminance, through BT.2020 and PQ and back to CCCS as the compositor would
+// decode it), the HDR10 code values the test prints at the brightness slider, and the
+// outline that marks where BT.2020 primaries would clip.  It also holds the fixed
+// 6.b MAX patches and the SDR white levels of the 709 patches.
+//
+// Built from plain numbers, so it has no DXGI dependency.  TestPatterns rebuilds it with
+// UpdatePanelColorModel() whenever the output description changes, which the app does
+// in Game::UpdateDxgiColorimetryInfo().  The patch colors do not depend on the on-pixel
+// ratio, only the patch size and metadata do.
+//
+
+#pragma once
+
+#include "BasicMath.h"
+
+struct PanelPatch
+{
+	float2 xy;				// chromaticity
+	float3 bt2020;			// linear BT.2020 at the patch level, 1.0 = 10,000 nits
+	float3 hdr10;			// PQ code values, 0..1
+	float3 cccs;			// drawn color: hdr10 decoded to linear 709, 1.0 = 80 nits
+	float3 displayCode;		// 10-bit code values as printed, at the brightness slider
+	float3 outlineCCCS;		// clip limit outline (test 6 only)
+};
+
+class PanelColorModel
+{
+public:
+	enum Patch
+	{
+		Red,
+		Green,
+		Blue,
+		White,
+		PatchCount
+	};
+
+	PanelColorModel();
+
+	// Chromaticities in CIE 1931 xy.  maxLuminance is the peak the OS reports, after the
+	// brightness slider; sliderFactor is the raw peak over it.
+	PanelColorModel(float2 red, float2 green, float2 blue, float2 white, float maxLuminance, float sliderFactor);
+
+	// Test 6: the panel's own primaries and white.
+	const PanelPatch& GetPatch(int patch) const { return m_patches[patch]; }
+	// Test 6.b MAX: BT.2020 primaries and D65 at PQ code 636, whatever the panel.
+	const PanelPatch& GetMaxPatch(int patch) const { return m_maxPatches[patch]; }
+
+	// 709 patches: white level index 0..3 in nits, and as a CCCS channel value.
+	static float GetSdrWhiteLevel(int index);
+	float GetSdrWhiteCCCS(int index) const { return m_sdrWhiteCCCS[index]; }
+
+	// Panel RGB (each primary at Y = 1) to XYZ, and back.
+	const float3x3& GetPanelMatrix() const { return m_panelMatrix; }
+	const float3x3& GetInversePanelMatrix() const { return m_invPanelMatrix; }
+
+	float GetMaxLuminance() const { return m_maxLuminance; }
+	float GetSliderFactor() const { return m_sliderFactor; }
+
+private:
+	float3x3   m_panelMatrix;
+	float3x3   m_invPanelMatrix;
+	float      m_maxLuminance;
+	float      m_sliderFactor;
+	PanelPatch m_patches[PatchCount];
+	PanelPatch m_maxPatches[PatchCount];
+	float      m_sdrWhiteCCCS[4];
+};
@@ -0,0 +1,138 @@
+//
+// PanelThermal.cpp
+//
+// Two-node thermal model and backlight limiter.  See PanelThermal.h.
+//
+
+#include "PanelThermal.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <math.h>
+
+namespace
+{
+	// Fraction of the backlight the limiter aims for at an LED temperature.
+	float DerateTarget(const PanelThermalSettings& settings, float ledTemperature)
+	{
+		if (ledTemperature <= settings.derateStart)
+			return 1.0f;
+		if (ledTemperature >= settings.derateEnd || settings.derateEnd <= settings.derateStart)
+			return settings.derateFloor;
+		float f = (ledTemperature - settings.derateStart) / (settings.derateEnd - settings.derateStart);
+		return 1.0f + (settings.derateFloor - 1.0f) * f;
+	}
+
+	// x relaxes toward target with time constant tau for dt.
+	float Relax(float x, float target, float tau, float dt)
+	{
+		return tau > 0.0f ? target + (x - target) * expf(-dt / tau) : target;
+	}
+}
+
+PanelThermalSettings MakePanelThermalSettings(const VirtualPanelSettings& panel)
+{
+	PanelThermalSettings settings;
+	settings.panel = panel;
+	settings.ambientTemperature = 25.0f;
+	settings.idlePower = 15.0f;
+	settings.fullFramePower = 60.0f;
+	settings.ledResistance = 0.5f;
+	settings.ledTimeConstant = 120.0f;
+	settings.chassisResistance = 0.5f;
+	settings.chassisTimeConstant = 1200.0f;
+	settings.derateStart = 70.0f;
+	settings.derateEnd = 90.0f;
+	settings.derateFloor = 0.7f;
+	settings.limiterTimeConstant = 20.0f;
+	settings.timeStep = 0.5f;
+	return settings;
+}
+
+ThermalSummary SimulatePanelThermal(const PanelThermalSettings& settings, const std::vector<LoadSegment>& segments,
+									std::vector<ThermalSample>* curve, float sampleInterval)
+{
+	const VirtualPanelSettings& panel = settings.panel;
+	float wattsPerNit = panel.maxFullFrameLuminance > 0.0f ? settings.fullFramePower / panel.maxFullFrameLuminance : 0.0f;
+
+	float chassis = settings.ambientTemperature + settings.idlePower * settings.chassisResistance;
+	float led = chassis;
+	float scale = 1.0f;
+	float time = 0.0f;
+	float nextSample = 0.0f;
+
+	ThermalSummary summary = {};
+	summary.minimumMargin = 1e30f;
+	summary.failTime = -1.0f;
+	summary.peakLedTemperature = led;
+	summary.peakChassisTemperature = chassis;
+	if (curve)
+		curve->clear();
+
+	bool first = true;
+	float luminance = 0.0f;
+	for (const LoadSegment& segment : segments)
+	{
+		// The power limit only depends on the segment, the limiter on the temperature.
+		float abl = panel.maxLuminance > 0.0f ? std::min(GetPowerLimit(panel, segment.load.averageDrive) / panel.maxLuminance, 1.0f) : 1.0f;
+		float power = wattsPerNit * segment.load.averageDrive * panel.maxLuminance * abl;
+
+		// Whole steps of at most timeStep that end on the segment's end.
+		float start = time;
+		float duration = std::max(segment.duration, 0.0f);
+		size_t steps = settings.timeStep > 0.0f ? (size_t)ceilf(duration / settings.timeStep) : 1;
+		float dt = steps ? duration / steps : 0.0f;
+		for (size_t step = 0;; step++)
+		{
+			luminance = segment.load.spotLuminance * abl * scale;
+			if (first)
+			{
+				summary.startLuminance = luminance;
+				first = false;
+			}
+			if (segment.requiredLuminance > 0.0f)
+			{
+				summary.minimumMargin = std::min(summary.minimumMargin, luminance / segment.requiredLuminance);
+				if (luminance < segment.requiredLuminance && summary.failTime < 0.0f)
+					summary.failTime = time;
+			}
+			if (curve && time >= nextSample)
+			{
+				curve->push_back({ time, luminance, led, chassis, scale });
+				nextSample += sampleInterval;
+			}
+			if (step >= steps)
+				break;
+
+			// Each node relaxes toward the temperature its heat flow would hold it at with
+			// the other node where it is.
+			float heat = power * scale;
+			led = Relax(led, chassis + heat * settings.ledResistance, settings.ledTimeConstant, dt);
+			float chassisTarget = settings.ambientTemperature + (settings.idlePower + heat) * settings.chassisResistance;
+			chassis = Relax(chassis, chassisTarget, settings.chassisTimeConstant, dt);
+			scale = Relax(scale, DerateTarget(settings, led), settings.limiterTimeConstant, dt);
+			time = start + dt * (step + 1);
+
+			summary.peakLedTemperature = std::max(summary.peakLedTemperature, led);
+			summary.peakChassisTemperature = std::max(summary.peakChassisTemperature, chassis);
+		}
+		if (curve && (curve->empty() || curve->back().time < time))
+			curve->push_back({ time, luminance, led, chassis, scale });
+	}
+
+	summary.finalLuminance = luminance;
+	if (summary.minimumMargin == 1e30f)
+		summary.minimumMargin = 0.0f;
+	return summary;
+}
+
+std::vector<ThermalSummary> SweepPanelThermal(const std::vector<PanelThermalSettings>& variants,
+											  const std::vector<LoadSegment>& segments, ThreadPool* pool)
+{
+	std::vector<ThermalSummary> results(variants.size());
+	(pool ? *pool : ThreadPool::Default()).ParallelFor(0, variants.size(), [&](size_t i)
+	{
+		results[i] = SimulatePanelThermal(variants[i], segments);
+	});
+	return results;
+}
@@ -0,0 +1,98 @@
+//
+// PanelThermal.h
+//
+// A time-stepped model of how a panel's luminance sags over a long test, for the
+// patterns that are held for minutes: WarmUp (30 minutes), TenPercentPeak,
+// FullFramePeak and LongDurationWhite (1,800 s each).  It takes the patterns as a
+// sequence of segments, each the load a pattern puts on the backlight for as long as it
+// is shown, and predicts the luminance at the measured spot against time:
+//
+//   ABL             the instantaneous power limit of VirtualPanelSettings, from the
+//                   segment's APL, as VirtualPanel applies it
+//   heat            the backlight's electrical power, in proportion to the light it
+//                   puts out, heats the LEDs, which lose it to the chassis, which loses
+//                   it to the room; two thermal RC nodes, plus the electronics' idle
+//                   power into the chassis
+//   thermal limit   past a start temperature the firmware derates the backlight
+//                   linearly down to a floor, following its target with a time
+//                   constant, as monitors do to protect the LEDs
+//
+// Time is virtual: each step integrates both nodes exactly for a fixed time with the
+// other node held, so steps can be long next to the time constants, and a 30 minute
+// test is a few thousand steps, well under a millisecond.  SweepPanelThermal() runs one
+// simulation per variant of the settings across the thread pool, to find which panel
+// parameters fail a sustained-luminance requirement before a panel goes to the lab.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "VirtualPanel.h"
+
+class ThreadPool;
+
+// What a pattern asks of the panel, before the power and thermal limits.
+struct PanelLoad
+{
+	float averageDrive;					// mean zone drive, 0 to 1 of maxLuminance (APL)
+	float spotLuminance;				// nits at the measured spot
+};
+
+struct LoadSegment
+{
+	float     duration;					// seconds
+	PanelLoad load;
+	float     requiredLuminance;		// nits the spot must hold, or 0 for none
+};
+
+struct PanelThermalSettings
+{
+	VirtualPanelSettings panel;						// luminances and power limit
+	float ambientTemperature;						// degrees C
+	float idlePower;								// W, electronics, into the chassis
+	float fullFramePower;							// W, backlight at maxFullFrameLuminance full screen
+	float ledResistance;							// C/W, LEDs to chassis
+	float ledTimeConstant;							// s
+	float chassisResistance;						// C/W, chassis to room
+	float chassisTimeConstant;						// s
+	float derateStart;								// LED temperature at which the limit starts
+	float derateEnd;								// and where it reaches derateFloor
+	float derateFloor;								// fraction of the backlight left
+	float limiterTimeConstant;						// s, of the firmware following its target
+	float timeStep;									// s of virtual time per step
+};
+
+// A monitor backlight around panel: 60 W at full frame white and a limiter that derates
+// from 70 C on the LEDs.  From cold in a 25 C room, 30 minutes of full frame white take
+// the LEDs near 80 C and sag the light by about 14%; a 10% window stays under 50 C.
+PanelThermalSettings MakePanelThermalSettings(const VirtualPanelSettings& panel);
+
+struct ThermalSample
+{
+	float time;							// s since the first segment started
+	float luminance;					// nits at the spot
+	float ledTemperature;
+	float chassisTemperature;
+	float thermalScale;					// the limiter's, 1 when cold
+};
+
+struct ThermalSummary
+{
+	float startLuminance;				// at the spot, at time 0
+	float finalLuminance;
+	float minimumMargin;				// lowest luminance / required, over segments with one; 0 for none
+	float failTime;						// first time below the requirement, or -1
+	float peakLedTemperature;
+	float peakChassisTemperature;
+};
+
+// Runs segments in order from a panel at equilibrium with the room, idle.  With curve,
+// it receives a sample at time 0, every sampleInterval s and at the end of each
+// segment.
+ThermalSummary SimulatePanelThermal(const PanelThermalSettings& settings, const std::vector<LoadSegment>& segments,
+									std::vector<ThermalSample>* curve = nullptr, float sampleInterval = 10.0f);
+
+// One simulation per variant, in parallel.  pool == nullptr uses ThreadPool::Default().
+std::vector<ThermalSummary> SweepPanelThermal(const std::vector<PanelThermalSettings>& variants,
+											  const std::vector<LoadSegment>& segments, ThreadPool* pool = nullptr);
@@ -0,0 +1,129 @@
+//
+// PatternCanvas.h
+//
+// The drawing interface the test patterns are written against.  It is the small subset
+// of ID2D1DeviceContext the patterns actually use -- solid rectangles, rectangle and
+// ellipse outlines, a linear gradient, text, the three custom effects and 1:1 images --
+// with colors passed by value instead of through brushes.
+//
+// D2DCanvas implements it on the swap chain for the app; CpuCanvas implements it on a
+// CPU-side FP16 scRGB framebuffer so the patterns can be rendered and checked without
+// D3D/D2D.  Coordinates are DIPs, which the app pins to pixels by running at 96 DPI.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+// Left, top, right, bottom, like D2D1_RECT_F.
+struct RectF
+{
+	float left;
+	float top;
+	float right;
+	float bottom;
+
+	RectF() {}
+	RectF(float l, float t, float r, float b) : left(l), top(t), right(r), bottom(b) {}
+};
+
+struct PointF
+{
+	float x;
+	float y;
+
+	PointF() {}
+	PointF(float x_, float y_) : x(x_), y(y_) {}
+};
+
+// Same layout as D2D1_ELLIPSE so the patterns can brace-initialize it.
+struct EllipseF
+{
+	PointF point;
+	float  radiusX;
+	float  radiusY;
+};
+
+// Linear scRGB: 1.0 is 80 nits.  Components may exceed 1 or go negative.
+struct ColorF
+{
+	// Named colors as 0xRRGGBB, as D2D1::ColorF::Enum.
+	enum Enum
+	{
+		Black = 0x000000,
+		White = 0xFFFFFF,
+		Red   = 0xFF0000,
+	};
+
+	float r;
+	float g;
+	float b;
+	float a;
+
+	ColorF() : r(0.0f), g(0.0f), b(0.0f), a(1.0f) {}
+	ColorF(float r_, float g_, float b_, float a_ = 1.0f) : r(r_), g(g_), b(b_), a(a_) {}
+	ColorF(Enum rgb, float a_ = 1.0f)
+		: r(((rgb >> 16) & 0xFF) / 255.0f), g(((rgb >> 8) & 0xFF) / 255.0f), b((rgb & 0xFF) / 255.0f), a(a_) {}
+};
+
+struct GradientStop
+{
+	float  position;
+	ColorF color;
+};
+
+// Stands in for the three IDWriteTextFormats the app creates.
+enum class TextStyle
+{
+	Small,			// Segoe UI 14
+	Large,			// Segoe UI 24
+	Monospace,		// Consolas 18
+};
+
+// The custom D2D effects.  Each is a generator with no input that covers the target.
+enum class PatternEffect
+{
+	None,
+	SineSweep,			// SineSweepEffect.hlsl
+	ToneSpike,			// ToneSpikeEffect.hlsl
+	BandedGradient,		// BandedGradientEffect.hlsl
+};
+
+// Union of the effect properties; each effect reads the ones it declares.
+struct EffectConstants
+{
+	PointF center;						// SineSweep, ToneSpike
+	float  initialWavelength;			// SineSweep, ToneSpike
+	float  wavelengthHalvingDistance;	// SineSweep, ToneSpike
+	float  whiteLevelMultiplier;		// SineSweep, ToneSpike
+	PointF outputSize;					// BandedGradient
+};
+
+class PatternCanvas
+{
+public:
+	virtual ~PatternCanvas() {}
+
+	virtual RectF GetLogicalSize() const = 0;		// DIPs
+	virtual RectF GetOutputSize() const = 0;		// pixels
+	virtual float GetDpi() const = 0;
+
+	virtual void FillRectangle(const RectF& rect, const ColorF& color) = 0;
+	virtual void DrawRectangle(const RectF& rect, const ColorF& color, float strokeWidth = 1.0f) = 0;
+	virtual void DrawEllipse(const EllipseF& ellipse, const ColorF& color, float strokeWidth = 1.0f) = 0;
+
+	// Fills rect with a gradient along start->end, clamped beyond the end stops.  As the
+	// app's gradient brush, stop colors are sRGB-encoded and interpolated in sRGB, and the
+	// result is converted to linear scRGB.
+	virtual void FillLinearGradient(const RectF& rect, PointF start, PointF end,
+									const GradientStop* stops, size_t count) = 0;
+
+	// textPos is { left, top, width, height } as in Game::RenderText().
+	virtual void DrawString(const std::wstring& text, TextStyle style, const RectF& textPos, const ColorF& color) = 0;
+
+	// Both return false, drawing nothing, when the effect or image is not available.
+	virtual bool DrawEffect(PatternEffect effect, const EffectConstants& constants) = 0;
+	virtual bool DrawImage(const std::wstring& filename) = 0;		// centered at 1:1
+};
@@ -0,0 +1,523 @@
+//
+// SimdMath.h
+//
+// Thin portable wrapper over the SIMD instruction sets we build for, so the batch
+// kernels (transfer functions, pattern generators, image conversions) can be written
+// once in HLSL-like style and compiled for whichever vector unit the target has.
+//
+// The path is chosen at compile time:
+//    AVX2    8 lanes   (/arch:AVX2, -mavx2 -mfma)
+//    SSE4.1  4 lanes   (-msse4.1, or /arch:AVX)
+//    SSE2    4 lanes   (any x64 build, /arch:SSE2 on x86)
+//    NEON    4 lanes   (AArch64)
+//    scalar  1 lane    (everything else)
+//
+
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#define SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE4_1__) || defined(__AVX__)
+#define SIMD_SSE
+#define SIMD_SSE41
+#include <smmintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_NEON
+#include <arm_neon.h>
+#else
+#define SIMD_SCALAR
+#endif
+
+namespace simd
+{
+
+#if defined(SIMD_AVX2)
+
+const int width = 8;
+inline const char* PathName() { return "AVX2"; }
+
+struct vfloat { __m256  v; vfloat() {} vfloat(__m256 x)  : v(x) {} vfloat(float s) : v(_mm256_set1_ps(s)) {} };
+struct vint   { __m256i v; vint() {}   vint(__m256i x)   : v(x) {} vint(int32_t s)  : v(_mm256_set1_epi32(s)) {} };
+struct vmask  { __m256  v; vmask() {}  vmask(__m256 x)   : v(x) {} };
+
+inline vfloat load(const float* p)            { return _mm256_loadu_ps(p); }
+inline void   store(float* p, vfloat a)       { _mm256_storeu_ps(p, a.v); }
+inline vint   loadi(const int32_t* p)         { return _mm256_loadu_si256((const __m256i*)p); }
+inline void   storei(int32_t* p, vint a)      { _mm256_storeu_si256((__m256i*)p, a.v); }
+inline vfloat ramp()                          { return _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7); }
+
+inline vfloat operator+(vfloat a, vfloat b)   { return _mm256_add_ps(a.v, b.v); }
+inline vfloat operator-(vfloat a, vfloat b)   { return _mm256_sub_ps(a.v, b.v); }
+inline vfloat operator*(vfloat a, vfloat b)   { return _mm256_mul_ps(a.v, b.v); }
+inline vfloat operator/(vfloat a, vfloat b)   { return _mm256_div_ps(a.v, b.v); }
+inline vfloat operator-(vfloat a)             { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); }
+inline vfloat min(vfloat a, vfloat b)         { return _mm256_min_ps(a.v, b.v); }
+inline vfloat max(vfloat a, vfloat b)         { return _mm256_max_ps(a.v, b.v); }
+inline vfloat abs(vfloat a)                   { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+inline vfloat sqrt(vfloat a)                  { return _mm256_sqrt_ps(a.v); }
+inline vfloat floor(vfloat a)                 { return _mm256_floor_ps(a.v); }
+#if defined(__FMA__)
+inline vfloat mad(vfloat a, vfloat b, vfloat c) { return _mm256_fmadd_ps(a.v, b.v, c.v); }
+#else
+inline vfloat mad(vfloat a, vfloat b, vfloat c) { return _mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v); }
+#endif
+
+inline vmask operator< (vfloat a, vfloat b)   { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline vmask operator<=(vfloat a, vfloat b)   { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); }
+inline vmask operator> (vfloat a, vfloat b)   { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+inline vmask operator>=(vfloat a, vfloat b)   { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+inline vmask operator&(vmask a, vmask b)      { return _mm256_and_ps(a.v, b.v); }
+inline vmask operator|(vmask a, vmask b)      { return _mm256_or_ps(a.v, b.v); }
+inline bool  any(vmask m)                     { return _mm256_movemask_ps(m.v) != 0; }
+inline vfloat select(vmask m, vfloat a, vfloat b) { return _mm256_blendv_ps(b.v, a.v, m.v); }	// m ? a : b
+
+inline vint   toint(vfloat a)                 { return _mm256_cvttps_epi32(a.v); }		// truncate
+inline vint   roundint(vfloat a)              { return _mm256_cvtps_epi32(a.v); }		// round to nearest even
+inline vfloat tofloat(vint a)                 { return _mm256_cvtepi32_ps(a.v); }
+inline vint   asint(vfloat a)                 { return _mm256_castps_si256(a.v); }
+inline vfloat asfloat(vint a)                 { return _mm256_castsi256_ps(a.v); }
+inline vint operator+(vint a, vint b)         { return _mm256_add_epi32(a.v, b.v); }
+inline vint operator-(vint a, vint b)         { return _mm256_sub_epi32(a.v, b.v); }
+inline vint operator&(vint a, vint b)         { return _mm256_and_si256(a.v, b.v); }
+inline vint operator|(vint a, vint b)         { return _mm256_or_si256(a.v, b.v); }
+inline vint min(vint a, vint b)               { return _mm256_min_epi32(a.v, b.v); }
+inline vint max(vint a, vint b)               { return _mm256_max_epi32(a.v, b.v); }
+template <int N> inline vint shl(vint a)      { return _mm256_slli_epi32(a.v, N); }
+template <int N> inline vint shr(vint a)      { return _mm256_srli_epi32(a.v, N); }	// logical
+inline vfloat gather(const float* base, vint idx) { return _mm256_i32gather_ps(base, idx.v, 4); }
+
+// Interleaved x, y, z triples <-> one vector per channel, width triples at a time.  Each
+// 128-bit half holds four consecutive triples, shuffled as on the SSE path.
+inline void load3(const float* p, vfloat& x, vfloat& y, vfloat& z)
+{
+	__m256 a = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)), _mm_loadu_ps(p + 12), 1);
+	__m256 b = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 4)), _mm_loadu_ps(p + 16), 1);
+	__m256 c = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + 8)), _mm_loadu_ps(p + 20), 1);
+	__m256 t0 = _mm256_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));
+	__m256 t1 = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));
+	x = _mm256_shuffle_ps(a, t0, _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm256_shuffle_ps(t1, t0, _MM_SHUFFLE(3, 1, 2, 0));
+	z = _mm256_shuffle_ps(t1, c, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+inline void store3(float* p, vfloat x, vfloat y, vfloat z)
+{
+	__m256 a = _mm256_shuffle_ps(_mm256_shuffle_ps(x.v, y.v, _MM_SHUFFLE(0, 0, 0, 0)), _mm256_shuffle_ps(z.v, x.v, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+	__m256 b = _mm256_shuffle_ps(_mm256_shuffle_ps(y.v, z.v, _MM_SHUFFLE(1, 1, 1, 1)), _mm256_shuffle_ps(x.v, y.v, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+	__m256 c = _mm256_shuffle_ps(_mm256_shuffle_ps(z.v, x.v, _MM_SHUFFLE(3, 3, 2, 2)), _mm256_shuffle_ps(y.v, z.v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+	_mm_storeu_ps(p,      _mm256_castps256_ps128(a));
+	_mm_storeu_ps(p + 4,  _mm256_castps256_ps128(b));
+	_mm_storeu_ps(p + 8,  _mm256_castps256_ps128(c));
+	_mm_storeu_ps(p + 12, _mm256_extractf128_ps(a, 1));
+	_mm_storeu_ps(p + 16, _mm256_extractf128_ps(b, 1));
+	_mm_storeu_ps(p + 20, _mm256_extractf128_ps(c, 1));
+}
+
+#elif defined(SIMD_SSE)
+
+const int width = 4;
+#if defined(SIMD_SSE41)
+inline const char* PathName() { return "SSE4.1"; }
+#else
+inline const char* PathName() { return "SSE2"; }
+#endif
+
+struct vfloat { __m128  v; vfloat() {} vfloat(__m128 x)  : v(x) {} vfloat(float s) : v(_mm_set1_ps(s)) {} };
+struct vint   { __m128i v; vint() {}   vint(__m128i x)   : v(x) {} vint(int32_t s)  : v(_mm_set1_epi32(s)) {} };
+struct vmask  { __m128  v; vmask() {}  vmask(__m128 x)   : v(x) {} };
+
+inline vfloat load(const float* p)            { return _mm_loadu_ps(p); }
+inline void   store(float* p, vfloat a)       { _mm_storeu_ps(p, a.v); }
+inline vint   loadi(const int32_t* p)         { return _mm_loadu_si128((const __m128i*)p); }
+inline void   storei(int32_t* p, vint a)      { _mm_storeu_si128((__m128i*)p, a.v); }
+inline vfloat ramp()                          { return _mm_setr_ps(0, 1, 2, 3); }
+
+inline vfloat operator+(vfloat a, vfloat b)   { return _mm_add_ps(a.v, b.v); }
+inline vfloat operator-(vfloat a, vfloat b)   { return _mm_sub_ps(a.v, b.v); }
+inline vfloat operator*(vfloat a, vfloat b)   { return _mm_mul_ps(a.v, b.v); }
+inline vfloat operator/(vfloat a, vfloat b)   { return _mm_div_ps(a.v, b.v); }
+inline vfloat operator-(vfloat a)             { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); }
+inline vfloat min(vfloat a, vfloat b)         { return _mm_min_ps(a.v, b.v); }
+inline vfloat max(vfloat a, vfloat b)         { return _mm_max_ps(a.v, b.v); }
+inline vfloat abs(vfloat a)                   { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); }
+inline vfloat sqrt(vfloat a)                  { return _mm_sqrt_ps(a.v); }
+inline vfloat mad(vfloat a, vfloat b, vfloat c) { return _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v); }
+
+inline vmask operator< (vfloat a, vfloat b)   { return _mm_cmplt_ps(a.v, b.v); }
+inline vmask operator<=(vfloat a, vfloat b)   { return _mm_cmple_ps(a.v, b.v); }
+inline vmask operator> (vfloat a, vfloat b)   { return _mm_cmpgt_ps(a.v, b.v); }
+inline vmask operator>=(vfloat a, vfloat b)   { return _mm_cmpge_ps(a.v, b.v); }
+inline vmask operator&(vmask a, vmask b)      { return _mm_and_ps(a.v, b.v); }
+inline vmask operator|(vmask a, vmask b)      { return _mm_or_ps(a.v, b.v); }
+inline bool  any(vmask m)                     { return _mm_movemask_ps(m.v) != 0; }
+#if defined(SIMD_SSE41)
+inline vfloat select(vmask m, vfloat a, vfloat b) { return _mm_blendv_ps(b.v, a.v, m.v); }
+inline vfloat floor(vfloat a)                 { return _mm_floor_ps(a.v); }
+#else
+inline vfloat select(vmask m, vfloat a, vfloat b) { return _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)); }
+inline vfloat floor(vfloat a)					// valid for |a| < 2^31, which covers every use here
+{
+	__m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+	return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a.v), _mm_set1_ps(1.0f)));
+}
+#endif
+
+inline vint   toint(vfloat a)                 { return _mm_cvttps_epi32(a.v); }
+inline vint   roundint(vfloat a)              { return _mm_cvtps_epi32(a.v); }
+inline vfloat tofloat(vint a)                 { return _mm_cvtepi32_ps(a.v); }
+inline vint   asint(vfloat a)                 { return _mm_castps_si128(a.v); }
+inline vfloat asfloat(vint a)                 { return _mm_castsi128_ps(a.v); }
+inline vint operator+(vint a, vint b)         { return _mm_add_epi32(a.v, b.v); }
+inline vint operator-(vint a, vint b)         { return _mm_sub_epi32(a.v, b.v); }
+inline vint operator&(vint a, vint b)         { return _mm_and_si128(a.v, b.v); }
+inline vint operator|(vint a, vint b)         { return _mm_or_si128(a.v, b.v); }
+#if defined(SIMD_SSE41)
+inline vint min(vint a, vint b)               { return _mm_min_epi32(a.v, b.v); }
+inline vint max(vint a, vint b)               { return _mm_max_epi32(a.v, b.v); }
+#else
+inline vint min(vint a, vint b)               { __m128i m = _mm_cmplt_epi32(a.v, b.v); return _mm_or_si128(_mm_and_si128(m, a.v), _mm_andnot_si128(m, b.v)); }
+inline vint max(vint a, vint b)               { __m128i m = _mm_cmpgt_epi32(a.v, b.v); return _mm_or_si128(_mm_and_si128(m, a.v), _mm_andnot_si128(m, b.v)); }
+#endif
+template <int N> inline vint shl(vint a)      { return _mm_slli_epi32(a.v, N); }
+template <int N> inline vint shr(vint a)      { return _mm_srli_epi32(a.v, N); }
+inline vfloat gather(const float* base, vint idx)
+{
+	alignas(16) int32_t i[4];
+	_mm_store_si128((__m128i*)i, idx.v);
+	return _mm_setr_ps(base[i[0]], base[i[1]], base[i[2]], base[i[3]]);
+}
+
+// Interleaved x, y, z triples <-> one vector per channel, width triples at a time.  The
+// three loads are x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3.
+inline void load3(const float* p, vfloat& x, vfloat& y, vfloat& z)
+{
+	__m128 a = _mm_loadu_ps(p), b = _mm_loadu_ps(p + 4), c = _mm_loadu_ps(p + 8);
+	__m128 t0 = _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 1, 3, 2));		// x2 y2 x3 y3
+	__m128 t1 = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 2, 1));		// y0 z0 y1 z1
+	x = _mm_shuffle_ps(a, t0, _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm_shuffle_ps(t1, t0, _MM_SHUFFLE(3, 1, 2, 0));
+	z = _mm_shuffle_ps(t1, c, _MM_SHUFFLE(3, 0, 3, 1));
+}
+
+inline void store3(float* p, vfloat x, vfloat y, vfloat z)
+{
+	_mm_storeu_ps(p,     _mm_shuffle_ps(_mm_shuffle_ps(x.v, y.v, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(z.v, x.v, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(p + 4, _mm_shuffle_ps(_mm_shuffle_ps(y.v, z.v, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x.v, y.v, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(p + 8, _mm_shuffle_ps(_mm_shuffle_ps(z.v, x.v, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y.v, z.v, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+#elif defined(SIMD_NEON)
+
+const int width = 4;
+inline const char* PathName() { return "NEON"; }
+
+struct vfloat { float32x4_t v; vfloat() {} vfloat(float32x4_t x) : v(x) {} vfloat(float s) : v(vdupq_n_f32(s)) {} };
+struct vint   { int32x4_t   v; vint() {}   vint(int32x4_t x)     : v(x) {} vint(int32_t s)  : v(vdupq_n_s32(s)) {} };
+struct vmask  { uint32x4_t  v; vmask() {}  vmask(uint32x4_t x)   : v(x) {} };
+
+inline vfloat load(const float* p)            { return vld1q_f32(p); }
+inline void   store(float* p, vfloat a)       { vst1q_f32(p, a.v); }
+inline vint   loadi(const int32_t* p)         { return vld1q_s32(p); }
+inline void   storei(int32_t* p, vint a)      { vst1q_s32(p, a.v); }
+inline vfloat ramp()                          { const float r[4] = { 0, 1, 2, 3 }; return vld1q_f32(r); }
+
+inline vfloat operator+(vfloat a, vfloat b)   { return vaddq_f32(a.v, b.v); }
+inline vfloat operator-(vfloat a, vfloat b)   { return vsubq_f32(a.v, b.v); }
+inline vfloat operator*(vfloat a, vfloat b)   { return vmulq_f32(a.v, b.v); }
+inline vfloat operator/(vfloat a, vfloat b)   { return vdivq_f32(a.v, b.v); }
+inline vfloat operator-(vfloat a)             { return vnegq_f32(a.v); }
+inline vfloat min(vfloat a, vfloat b)         { return vminq_f32(a.v, b.v); }
+inline vfloat max(vfloat a, vfloat b)         { return vmaxq_f32(a.v, b.v); }
+inline vfloat abs(vfloat a)                   { return vabsq_f32(a.v); }
+inline vfloat sqrt(vfloat a)                  { return vsqrtq_f32(a.v); }
+inline vfloat floor(vfloat a)                 { return vrndmq_f32(a.v); }
+inline vfloat mad(vfloat a, vfloat b, vfloat c) { return vfmaq_f32(c.v, a.v, b.v); }
+
+inline vmask operator< (vfloat a, vfloat b)   { return vcltq_f32(a.v, b.v); }
+inline vmask operator<=(vfloat a, vfloat b)   { return vcleq_f32(a.v, b.v); }
+inline vmask operator> (vfloat a, vfloat b)   { return vcgtq_f32(a.v, b.v); }
+inline vmask operator>=(vfloat a, vfloat b)   { return vcgeq_f32(a.v, b.v); }
+inline vmask operator&(vmask a, vmask b)      { return vandq_u32(a.v, b.v); }
+inline vmask operator|(vmask a, vmask b)      { return vorrq_u32(a.v, b.v); }
+inline bool  any(vmask m)                     { return vmaxvq_u32(m.v) != 0; }
+inline vfloat select(vmask m, vfloat a, vfloat b) { return vbslq_f32(m.v, a.v, b.v); }
+
+inline vint   toint(vfloat a)                 { return vcvtq_s32_f32(a.v); }
+inline vint   roundint(vfloat a)              { return vcvtnq_s32_f32(a.v); }
+inline vfloat tofloat(vint a)                 { return vcvtq_f32_s32(a.v); }
+inline vint   asint(vfloat a)                 { return vreinterpretq_s32_f32(a.v); }
+inline vfloat asfloat(vint a)                 { return vreinterpretq_f32_s32(a.v); }
+inline vint operator+(vint a, vint b)         { return vaddq_s32(a.v, b.v); }
+inline vint operator-(vint a, vint b)         { return vsubq_s32(a.v, b.v); }
+inline vint operator&(vint a, vint b)         { return vandq_s32(a.v, b.v); }
+inline vint operator|(vint a, vint b)         { return vorrq_s32(a.v, b.v); }
+inline vint min(vint a, vint b)               { return vminq_s32(a.v, b.v); }
+inline vint max(vint a, vint b)               { return vmaxq_s32(a.v, b.v); }
+template <int N> inline vint shl(vint a)      { return vshlq_n_s32(a.v, N); }
+template <int N> inline vint shr(vint a)      { return vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(a.v), N)); }
+inline vfloat gather(const float* base, vint idx)
+{
+	int32_t i[4];
+	vst1q_s32(i, idx.v);
+	const float g[4] = { base[i[0]], base[i[1]], base[i[2]], base[i[3]] };
+	return vld1q_f32(g);
+}
+
+// Interleaved x, y, z triples <-> one vector per channel, width triples at a time.
+inline void load3(const float* p, vfloat& x, vfloat& y, vfloat& z)
+{
+	float32x4x3_t t = vld3q_f32(p);
+	x = t.val[0]; y = t.val[1]; z = t.val[2];
+}
+
+inline void store3(float* p, vfloat x, vfloat y, vfloat z)
+{
+	float32x4x3_t t = { { x.v, y.v, z.v } };
+	vst3q_f32(p, t);
+}
+
+#else // SIMD_SCALAR
+
+const int width = 1;
+inline const char* PathName() { return "scalar"; }
+
+struct vfloat { float   v; vfloat() {} vfloat(float s)   : v(s) {} };
+struct vint   { int32_t v; vint() {}   vint(int32_t s)   : v(s) {} };
+struct vmask  { bool    v; vmask() {}  vmask(bool s)     : v(s) {} };
+
+inline vfloat load(const float* p)            { return *p; }
+inline void   store(float* p, vfloat a)       { *p = a.v; }
+inline vint   loadi(const int32_t* p)         { return *p; }
+inline void   storei(int32_t* p, vint a)      { *p = a.v; }
+inline vfloat ramp()                          { return 0.0f; }
+
+inline vfloat operator+(vfloat a, vfloat b)   { return a.v + b.v; }
+inline vfloat operator-(vfloat a, vfloat b)   { return a.v - b.v; }
+inline vfloat operator*(vfloat a, vfloat b)   { return a.v * b.v; }
+inline vfloat operator/(vfloat a, vfloat b)   { return a.v / b.v; }
+inline vfloat operator-(vfloat a)             { return -a.v; }
+inline vfloat min(vfloat a, vfloat b)         { return a.v < b.v ? a.v : b.v; }
+inline vfloat max(vfloat a, vfloat b)         { return a.v > b.v ? a.v : b.v; }
+inline vfloat abs(vfloat a)                   { return fabsf(a.v); }
+inline vfloat sqrt(vfloat a)                  { return sqrtf(a.v); }
+inline vfloat floor(vfloat a)                 { return floorf(a.v); }
+inline vfloat mad(vfloat a, vfloat b, vfloat c) { return a.v * b.v + c.v; }
+
+inline vmask operator< (vfloat a, vfloat b)   { return a.v <  b.v; }
+inline vmask operator<=(vfloat a, vfloat b)   { return a.v <= b.v; }
+inline vmask operator> (vfloat a, vfloat b)   { return a.v >  b.v; }
+inline vmask operator>=(vfloat a, vfloat b)   { return a.v >= b.v; }
+inline vmask operator&(vmask a, vmask b)      { return a.v && b.v; }
+inline vmask operator|(vmask a, vmask b)      { return a.v || b.v; }
+inline bool  any(vmask m)                     { return m.v; }
+inline vfloat select(vmask m, vfloat a, vfloat b) { return m.v ? a : b; }
+
+inline vint   toint(vfloat a)                 { return (int32_t)a.v; }
+inline vint   roundint(vfloat a)              { return (int32_t)nearbyintf(a.v); }
+inline vfloat tofloat(vint a)                 { return (float)a.v; }
+inline vint   asint(vfloat a)                 { int32_t i; memcpy(&i, &a.v, 4); return i; }
+inline vfloat asfloat(vint a)                 { float f; memcpy(&f, &a.v, 4); return f; }
+inline vint operator+(vint a, vint b)         { return a.v + b.v; }
+inline vint operator-(vint a, vint b)         { return a.v - b.v; }
+inline vint operator&(vint a, vint b)         { return a.v & b.v; }
+inline vint operator|(vint a, vint b)         { return a.v | b.v; }
+inline vint min(vint a, vint b)               { return a.v < b.v ? a.v : b.v; }
+inline vint max(vint a, vint b)               { return a.v > b.v ? a.v : b.v; }
+template <int N> inline vint shl(vint a)      { return (int32_t)((uint32_t)a.v << N); }
+template <int N> inline vint shr(vint a)      { return (int32_t)((uint32_t)a.v >> N); }
+inline vfloat gather(const float* base, vint idx) { return base[idx.v]; }
+inline void   load3(const float* p, vfloat& x, vfloat& y, vfloat& z) { x = p[0]; y = p[1]; z = p[2]; }
+inline void   store3(float* p, vfloat x, vfloat y, vfloat z) { p[0] = x.v; p[1] = y.v; p[2] = z.v; }
+
+#endif
+
+// ISA-independent helpers built on the primitives above.
+
+inline vfloat clamp(vfloat x, vfloat lo, vfloat hi) { return min(max(x, lo), hi); }
+inline vfloat saturate(vfloat x) { return min(max(x, vfloat(0.0f)), vfloat(1.0f)); }
+inline vfloat lerp(vfloat a, vfloat b, vfloat t) { return mad(b - a, t, a); }
+
+// log2 of a positive normal float.  Splits off the exponent, centers the mantissa
+// on [sqrt(0.5), sqrt(2)) and evaluates ln via the atanh series.  Abs error < 1e-6.
+inline vfloat log2(vfloat x)
+{
+	vint bits = asint(x);
+	vint e = shr<23>(bits) - vint(127);
+	vfloat m = asfloat((bits & vint(0x007FFFFF)) | vint(0x3F800000));	// [1, 2)
+	vmask big = m > vfloat(1.41421356f);
+	m = select(big, m * vfloat(0.5f), m);
+	vfloat ef = tofloat(e) + select(big, vfloat(1.0f), vfloat(0.0f));
+
+	vfloat t = (m - vfloat(1.0f)) / (m + vfloat(1.0f));
+	vfloat t2 = t * t;
+	vfloat p = mad(t2, vfloat(1.0f / 9.0f), vfloat(1.0f / 7.0f));
+	p = mad(p, t2, vfloat(1.0f / 5.0f));
+	p = mad(p, t2, vfloat(1.0f / 3.0f));
+	p = mad(p, t2, vfloat(1.0f));
+	vfloat lnm = vfloat(2.0f) * t * p;
+	return mad(lnm, vfloat(1.44269504f), ef);
+}
+
+// 2^x, clamped to the normal float range.  Degree-7 Taylor series on the fractional
+// part in [-0.5, 0.5] then scaled by the integer part via the exponent bits.  Rel error ~1 ulp.
+inline vfloat exp2(vfloat x)
+{
+	x = clamp(x, vfloat(-126.0f), vfloat(127.99f));
+	vfloat fi = floor(x + vfloat(0.5f));
+	vfloat y = (x - fi) * vfloat(0.693147181f);
+
+	vfloat p = mad(y, vfloat(1.0f / 5040.0f), vfloat(1.0f / 720.0f));
+	p = mad(p, y, vfloat(1.0f / 120.0f));
+	p = mad(p, y, vfloat(1.0f / 24.0f));
+	p = mad(p, y, vfloat(1.0f / 6.0f));
+	p = mad(p, y, vfloat(0.5f));
+	p = mad(p, y, vfloat(1.0f));
+	p = mad(p, y, vfloat(1.0f));
+	return asfloat(asint(p) + shl<23>(toint(fi)));
+}
+
+// x^y for x >= 0.  Returns 0 for x == 0 like powf does for positive y.
+inline vfloat pow(vfloat x, vfloat y)
+{
+	vfloat r = exp2(y * log2(x));
+	return select(x > vfloat(0.0f), r, vfloat(0.0f));
+}
+
+// sin(x) for |x| < 8192.  Cody-Waite reduction by pi/2 (the first part has 8 mantissa
+// bits, so q * part is exact), then the sin or cos minimax polynomial on [-pi/4, pi/4]
+// picked by quadrant.  Abs error < 2e-7 of the reduced argument.
+inline vfloat sin(vfloat x)
+{
+	vfloat q = floor(x * vfloat(0.636619772f) + vfloat(0.5f));
+	vfloat r = mad(q, vfloat(-1.5703125f), x);
+	r = mad(q, vfloat(-4.837512969970703125e-4f), r);
+	r = mad(q, vfloat(-7.549789948768648e-8f), r);
+	vfloat r2 = r * r;
+
+	vfloat s = mad(r2, vfloat(-1.9515295891e-4f), vfloat(8.3321608736e-3f));
+	s = mad(s, r2, vfloat(-1.6666654611e-1f));
+	s = mad(s * r2, r, r);
+
+	vfloat c = mad(r2, vfloat(2.443315711809948e-5f), vfloat(-1.388731625493765e-3f));
+	c = mad(c, r2, vfloat(4.166664568298827e-2f));
+	c = mad(c * r2, r2, mad(r2, vfloat(-0.5f), vfloat(1.0f)));
+
+	vint quadrant = toint(q);
+	vfloat v = select(tofloat(quadrant & vint(1)) > vfloat(0.0f), c, s);
+	return select(tofloat(quadrant & vint(2)) > vfloat(0.0f), -v, v);
+}
+
+// atan2(y, x) in [-pi, pi], as the C runtime's.  Folds into the first octant, reduces
+// past tan(pi/8) via (a - 1) / (a + 1), and uses the Cephes atanf polynomial there.
+// Abs error < 3e-7; atan2(0, 0) is 0.
+inline vfloat atan2(vfloat y, vfloat x)
+{
+	vfloat ax = abs(x), ay = abs(y);
+	vfloat hi = max(ax, ay);
+	vfloat a = min(ax, ay) / select(hi > vfloat(0.0f), hi, vfloat(1.0f));
+
+	vmask far = a > vfloat(0.414213562f);
+	a = select(far, (a - vfloat(1.0f)) / (a + vfloat(1.0f)), a);
+	vfloat z = a * a;
+	vfloat p = mad(z, vfloat(8.05374449538e-2f), vfloat(-1.38776856032e-1f));
+	p = mad(p, z, vfloat(1.99777106478e-1f));
+	p = mad(p, z, vfloat(-3.33329491539e-1f));
+	vfloat r = mad(p * z, a, a) + select(far, vfloat(0.785398163f), vfloat(0.0f));
+
+	r = select(ay > ax, vfloat(1.57079633f) - r, r);
+	r = select(x < vfloat(0.0f), vfloat(3.14159265f) - r, r);
+	return select(y < vfloat(0.0f), -r, r);
+}
+
+// float -> IEEE 754 half, bits in the low 16 of each lane.  Round to nearest even, exact
+// subnormals, overflow to infinity and NaN to a quiet NaN, as F16C's VCVTPS2PH and as
+// FloatToHalf() in Half.h, the one-value version.
+inline vint tohalf(vfloat x)
+{
+	vint sign = shr<16>(asint(x)) & vint(0x8000);
+	vfloat a = abs(x);
+	vint bits = asint(a);
+
+	// Normal: rebias the exponent and round off the 13 low mantissa bits.
+	vint odd = shr<13>(bits) & vint(1);
+	vint normal = shr<13>(bits + vint((int32_t)((uint32_t)(15 - 127) << 23)) + vint(0xFFF) + odd);
+
+	// Subnormal: adding 0.5, whose ulp is 2^-24, makes the FPU round to the half step.
+	vint subnormal = asint(a + vfloat(0.5f)) - vint(0x3F000000);
+
+	vfloat h = select(a < vfloat(6.103515625e-05f), asfloat(subnormal), asfloat(normal));
+	h = select(a >= vfloat(65520.0f), asfloat(vint(0x7C00)), h);
+	h = select(a <= vfloat(INFINITY), h, asfloat(vint(0x7E00)));		// NaN fails the compare
+	return asint(h) | sign;
+}
+
+// IEEE 754 half in the low 16 bits of each lane -> float.  Exact for every half,
+// subnormals, infinities and NaNs included, as F16C's VCVTPH2PS and HalfToFloat().
+inline vfloat fromhalf(vint h)
+{
+	vint sign = shl<16>(h & vint(0x8000));
+	vint bits = h & vint(0x7FFF);
+	vfloat magnitude = tofloat(bits);				// exact, bits < 2^15
+
+	vfloat normal = asfloat(shl<13>(bits) + vint((127 - 15) << 23));
+	vfloat subnormal = magnitude * vfloat(5.9604644775390625e-08f);		// 2^-24
+	vfloat special = asfloat(shl<13>(bits) | vint(0x7F800000));			// infinity, NaN
+
+	vfloat f = select(magnitude < vfloat(1024.0f), subnormal, normal);
+	f = select(magnitude >= vfloat(31744.0f), special, f);					// exponent 31
+	return asfloat(asint(f) | sign);
+}
+
+// Runs kernel over count floats, vector by vector.  The ragged tail is copied into a
+// padded block so it goes through exactly the same code as the body.
+template <class Kernel>
+inline void ForEach(const float* in, float* out, size_t count, Kernel kernel)
+{
+	size_t i = 0;
+	for (; i + width <= count; i += width)
+		store(out + i, kernel(load(in + i)));
+
+	if (i < count)
+	{
+		float tmp[width] = {};
+		memcpy(tmp, in + i, (count - i) * sizeof(float));
+		store(tmp, kernel(load(tmp)));
+		memcpy(out + i, tmp, (count - i) * sizeof(float));
+	}
+}
+
+// ForEach for interleaved x, y, z triples: kernel(x, y, z) gets one vector per channel
+// and updates them in place.  count is in triples.
+template <class Kernel>
+inline void ForEach3(const float* in, float* out, size_t count, Kernel kernel)
+{
+	vfloat x, y, z;
+	size_t i = 0;
+	for (; i + width <= count; i += width)
+	{
+		load3(in + 3 * i, x, y, z);
+		kernel(x, y, z);
+		store3(out + 3 * i, x, y, z);
+	}
+
+	if (i < count)
+	{
+		float tmp[3 * width] = {};
+		memcpy(tmp, in + 3 * i, (count - i) * 3 * sizeof(float));
+		load3(tmp, x, y, z);
+		kernel(x, y, z);
+		store3(tmp, x, y, z);
+		memcpy(out + 3 * i, tmp, (count - i) * 3 * sizeof(float));
+	}
+}
+
+} // namespace simd
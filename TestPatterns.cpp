@@ -0,0 +1,3918 @@
+//
+// TestPatterns.cpp
+//
+// The test patterns and their control logic, drawn through PatternCanvas.  This is the
+// code that used to live in Game; Game now owns the window, the device and the D2D
+// canvas and forwards frames and key presses here.
+//
+
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string.h>
+#include <wchar.h>
+
+#include "CodeValues.h"
+#include "ColorSpaces.h"
+#include "GamutPolygon.h"
+#include "TestPatterns.h"
+
+#define BRIGHTNESS_SLIDER_FACTOR (m_rawOutDesc.MaxLuminance / m_outputDesc.MaxLuminance)
+
+namespace
+{
+	// Formats numbers with fixed precision, as DX::to_string_with_precision.
+	template <typename T>
+	std::wstring to_string_with_precision(const T a_value, const int n = 4)
+	{
+		std::wstringstream out;
+		out << std::setprecision(n) << a_value;
+		return out.str();
+	}
+
+	// FNV-1a, for display list keys.
+	uint64_t Hash(const void* data, size_t size, uint64_t hash = 0xcbf29ce484222325ull)
+	{
+		const uint8_t* p = (const uint8_t*)data;
+		for (size_t i = 0; i < size; i++)
+			hash = (hash ^ p[i]) * 0x100000001b3ull;
+		return hash;
+	}
+}
+
+TestPatterns::TestPatterns(const wchar_t* appTitle)
+{
+    m_appTitle = appTitle;
+
+    m_currentTest = TestPattern::StartOfTest;
+    m_cachedTest = TestPattern::StartOfTest;
+    m_currentColor = 0;			// Which of R/G/B to test.
+	m_currentProfileTile = 0;	// which intensity profile tile we are on
+	m_maxPQCode = 1;
+	m_maxProfileTile = 1;
+
+    m_gradientColor = ColorF(0.25f, 0.25f, 0.25f);
+    m_gradientStops[0] = { 0.0f, ColorF(ColorF::Black, 1) };
+    m_gradientStops[1] = { 1.0f, ColorF(ColorF::Black, 1) };
+    m_gradientAnimationBase = 0.25f;
+    m_flashOn = false;
+    m_testingTier = DisplayHDR400;
+    m_outputDesc = {};
+	m_rawOutDesc.MaxLuminance = 0.f;
+	m_rawOutDesc.MaxFullFrameLuminance = 0.f;
+	m_rawOutDesc.MinLuminance = 0.f;
+	m_totalTime = 0;
+    m_showExplanatoryText = true;
+    m_testTimeRemainingSec = 0.0f;
+    m_gamutVolume = 0.0f;
+	m_volumeCoverageDCIP3 = 0.0f;
+	m_volumeCoverage2100 = 0.0f;
+	m_colorVolumeJND = 0.0;
+	m_panelColorModelBuilt = false;
+	m_newTestSelected = true;
+	m_Metadata = {};
+	m_displayListsEnabled = true;
+	m_displayListValid = false;
+	m_displayListGeneration = 0;
+	m_displayListHits = 0;
+	m_displayListMisses = 0;
+	m_MetadataGamut = GAMUT_Native;
+
+//	These are sRGB code values for HDR10:
+	m_maxEffectivesRGBValue = -1;	// not set yet
+	m_maxFullFramesRGBValue = -1;
+	m_minEffectivesRGBValue = -1;
+
+	//	These are PQ code values for HDR10:
+	m_maxEffectivePQValue = -1;	// not set yet
+	m_maxFullFramePQValue = -1;
+	m_minEffectivePQValue = -1;
+
+	// enable adjustment to tests 5.1 and 5.2 for active dimming
+	m_activeDimming50PQValue = 0.0f;
+	m_activeDimming05PQValue = 0.0f;
+
+    m_testPatternResources[TestPattern::BitDepthPrecision] = TestPatternResources{ std::wstring(L"7. Bit-Depth/Precision")                    , std::wstring()                                , std::wstring(L"BandedGradientEffect.cso")    , PatternEffect::BandedGradient };
+    m_testPatternResources[TestPattern::SharpeningFilter]  = TestPatternResources{ std::wstring(L"Fresnel zone plate (sharpening test)")      , std::wstring()                                , std::wstring(L"SineSweepEffect.cso")         , PatternEffect::SineSweep };
+	m_testPatternResources[TestPattern::ToneMapSpike]      = TestPatternResources{ std::wstring(L"ST.2084 Spike (Tone map test)")             , std::wstring()                                , std::wstring(L"ToneSpikeEffect.cso")         , PatternEffect::ToneSpike };
+	m_testPatternResources[TestPattern::OnePixelLinesBW]   = TestPatternResources{ std::wstring(L"Single pixel lines (black/white)")          , std::wstring(L"OnePixelLinesBW1200x700.png")  , std::wstring()                               , PatternEffect::None };
+    m_testPatternResources[TestPattern::OnePixelLinesRG]   = TestPatternResources{ std::wstring(L"Single pixel lines (red/green)")            , std::wstring(L"OnePixelLinesRG1200x700.png")  , std::wstring()                               , PatternEffect::None };
+    m_testPatternResources[TestPattern::TextQuality]       = TestPatternResources{ std::wstring(L"Antialiased text (ClearType and grayscale)"), std::wstring(L"CalibriBoth96Dpi.png")         , std::wstring()                               , PatternEffect::None };
+
+    m_hideTextString = std::wstring(L"Press SPACE to hide this text.");
+
+    UpdateTextLayout(RectF(0.0f, 0.0f, 1280.0f, 720.0f));
+}
+
+// Returns whether the reported display metadata consists of
+// default values generated by Windows.
+bool TestPatterns::CheckForDefaults()
+{
+    return (
+        // Default SDR display values (RS2)
+        (270.0f == m_rawOutDesc.MaxLuminance &&
+         270.0f == m_rawOutDesc.MaxFullFrameLuminance &&
+         0.5f == m_rawOutDesc.MinLuminance) ||
+        // Default HDR display values (RS2)
+        (550.0f == m_rawOutDesc.MaxLuminance &&
+         450.0f == m_rawOutDesc.MaxFullFrameLuminance &&
+         0.5f == m_rawOutDesc.MinLuminance) ||
+        // Default HDR display values (RS3)
+        (1499.0f == m_rawOutDesc.MaxLuminance &&
+         799.0f == m_rawOutDesc.MaxFullFrameLuminance &&
+         0.01f == m_rawOutDesc.MinLuminance)
+        );
+}
+
+// Default to tier based on what the EDID specified
+TestPatterns::TestingTier TestPatterns::GetTestingTier()
+{
+#define SAFETY (0.970)
+         if (m_rawOutDesc.MaxLuminance >= SAFETY * 10000.0f)
+        return TestingTier::DisplayHDR10000;
+    else if (m_rawOutDesc.MaxLuminance >= SAFETY * 6000.0f)
+        return TestingTier::DisplayHDR6000;
+    else if (m_rawOutDesc.MaxLuminance >= SAFETY * 4000.0f)
+        return TestingTier::DisplayHDR4000;
+	else if (m_rawOutDesc.MaxLuminance >= SAFETY * 3000.0f)
+		return TestingTier::DisplayHDR3000;
+	else if (m_rawOutDesc.MaxLuminance >= SAFETY * 2000.0f)
+        return TestingTier::DisplayHDR2000;
+    else if (m_rawOutDesc.MaxLuminance >= SAFETY * 1400.0f)
+        return TestingTier::DisplayHDR1400;
+    else if (m_rawOutDesc.MaxLuminance >= SAFETY * 1000.0f)
+        return TestingTier::DisplayHDR1000;
+    else if (m_rawOutDesc.MaxLuminance >= SAFETY * 600.0f)
+        return TestingTier::DisplayHDR600;
+	else if (m_rawOutDesc.MaxLuminance >= SAFETY * 500.0f)
+			 return TestingTier::DisplayHDR500;
+	else
+        return TestingTier::DisplayHDR400;
+}
+
+const wchar_t* TestPatterns::GetTierName(TestPatterns::TestingTier tier)
+{
+         if (tier == DisplayHDR400)   return L"DisplayHDR400";
+	else if (tier == DisplayHDR500)   return L"DisplayHDR500";
+	else if (tier == DisplayHDR600)   return L"DisplayHDR600";
+	else if (tier == DisplayHDR1000)  return L"DisplayHDR1000";
+	else if (tier == DisplayHDR1400)  return L"DisplayHDR1400";
+    else if (tier == DisplayHDR2000)  return L"DisplayHDR2000";
+	else if (tier == DisplayHDR3000)  return L"DisplayHDR3000";
+	else if (tier == DisplayHDR4000)  return L"DisplayHDR4000";
+    else if (tier == DisplayHDR6000)  return L"DisplayHDR6000";
+    else if (tier == DisplayHDR10000) return L"DisplayHDR10000";
+    else return L"Unsupported DisplayHDR Tier";
+}
+
+float TestPatterns::GetTierLuminance(TestPatterns::TestingTier tier)
+{
+	     if (tier == DisplayHDR400)	  return  400.f;
+	else if (tier == DisplayHDR500)   return  500.f;
+	else if (tier == DisplayHDR600)   return  600.f;
+	else if (tier == DisplayHDR1000)  return  1015.27f;
+	else if (tier == DisplayHDR1400)  return  1400.f;
+	else if (tier == DisplayHDR2000)  return  2000.f;
+	else if (tier == DisplayHDR3000)  return  3000.f;
+	else if (tier == DisplayHDR4000)  return  4000.f;
+	else if (tier == DisplayHDR6000)  return  6000.f;
+	else if (tier == DisplayHDR10000) return 10000.f;
+	else return -1.0f;
+}
+
+void TestPatterns::InitEffectiveValues()
+{
+	if (m_maxEffectivePQValue < 0.0)
+	{
+		float val = PqCode<10>::Code(Apply2084(m_rawOutDesc.MaxLuminance / 10000.f));
+		m_maxEffectivePQValue = val - 5.0f;
+	}
+	if (m_maxFullFramePQValue < 0.0)
+	{
+		float val = PqCode<10>::Code(Apply2084(m_rawOutDesc.MaxFullFrameLuminance / 10000.f));
+		m_maxFullFramePQValue = val - 5.0f;
+	}
+	if (m_minEffectivePQValue < 0.0)
+	{
+		float val = PqCode<10>::Code(Apply2084(m_rawOutDesc.MinLuminance / 10000.f));
+		m_minEffectivePQValue = val + 5.0f;
+	}
+
+	if (m_maxEffectivesRGBValue < 0.0)
+	{
+		float val = SrgbCode<8>::Max;
+		m_maxEffectivesRGBValue = val - 5.0f;
+	}
+	if (m_maxFullFramesRGBValue < 0.0)
+	{
+		float val = SrgbCode<8>::Max;
+		m_maxFullFramesRGBValue = val - 5.0f;
+	}
+	if (m_minEffectivesRGBValue < 0.0)
+	{
+		float val = 10;
+		m_minEffectivesRGBValue = val + 5.0f;
+	}
+}
+
+void TestPatterns::UpdatePanelColorModel()
+{
+	// The app refreshes the description every frame on PanelCharacteristics; rebuilding
+	// then would cost a display list miss per frame.
+	if (m_panelColorModelBuilt && !memcmp(&m_modelOutputDesc, &m_outputDesc, sizeof(m_outputDesc)) &&
+		!memcmp(&m_modelRawOutDesc, &m_rawOutDesc, sizeof(m_rawOutDesc)))
+		return;
+	m_modelOutputDesc = m_outputDesc;
+	m_modelRawOutDesc = m_rawOutDesc;
+	m_panelColorModelBuilt = true;
+
+	m_panelColorModel = PanelColorModel(m_outputDesc.RedPrimary, m_outputDesc.GreenPrimary, m_outputDesc.BluePrimary,
+										m_outputDesc.WhitePoint, m_outputDesc.MaxLuminance, BRIGHTNESS_SLIDER_FACTOR);
+
+	// The codes only depend on the slider, and take milliseconds to solve.
+	float sliderFactor = PQCodeTable::ValidSliderFactor(BRIGHTNESS_SLIDER_FACTOR);
+	if (m_pqCodes10.IsEmpty() || m_pqCodes10.GetSliderFactor() != sliderFactor)
+		m_pqCodes10 = PQCodeTable(10, sliderFactor);
+	InvalidateDisplayList();
+}
+
+#pragma region Frame Update
+// Advances the timers and animations of the current test.  Refreshing the panel
+// description is up to the host.
+void TestPatterns::UpdateTestPattern(float totalTimeSec, float elapsedSec)
+{
+    m_totalTime = totalTimeSec;
+
+    ColorF endColor = ColorF(ColorF::Black, 1);
+
+    switch (m_currentTest)
+    {
+    case TestPattern::WarmUp:
+        if (m_newTestSelected)
+        {
+            m_testTimeRemainingSec = 60.0f*30.0f;	// 30 minutes
+        }
+        else
+        {
+            m_testTimeRemainingSec -= elapsedSec;
+            m_testTimeRemainingSec = std::max(0.0f, m_testTimeRemainingSec);
+        }
+        break;
+
+    case TestPattern::Cooldown:
+        if (m_newTestSelected)
+        {
+            m_testTimeRemainingSec = 60.0f;		// One minute
+        }
+        else
+        {
+            m_testTimeRemainingSec -= elapsedSec;
+            m_testTimeRemainingSec = std::max(0.0f, m_testTimeRemainingSec);
+        }
+        if (m_testTimeRemainingSec <= 0.0f)
+            SetTestPattern(m_cachedTest);
+        break;
+
+    case TestPattern::FlashTest:
+    case TestPattern::FlashTestMAX:
+        if (m_newTestSelected)
+        {
+            m_testTimeRemainingSec = 4.0f; // 4 seconds
+            m_flashOn = false;
+        }
+        else
+        {
+            // TODO make this show 10ths of a second.
+            m_testTimeRemainingSec -= elapsedSec;
+            m_testTimeRemainingSec = std::max(0.0f, m_testTimeRemainingSec);
+            if (m_testTimeRemainingSec <= 0.0001)
+            {
+                if (!m_flashOn)
+                {
+                    m_flashOn = true;
+                    m_testTimeRemainingSec = 2;
+                }
+                else if (m_flashOn)
+                {
+                    m_flashOn = false;
+                    m_testTimeRemainingSec = 10;
+                }
+            }
+        }
+        break;
+
+    case TestPattern::LongDurationWhite:
+    case TestPattern::FullFramePeak:
+        if (m_newTestSelected)
+        {
+            m_testTimeRemainingSec = 1800.0f; // 30 minutes
+        }
+        else
+        {
+            m_testTimeRemainingSec -= elapsedSec;
+            m_testTimeRemainingSec = std::max(0.0f, m_testTimeRemainingSec);
+        }
+        break;
+
+    case TestPattern::TenPercentPeak:				// test 1.
+    case TestPattern::TenPercentPeakMAX:			// test 1.MAX
+        if (m_newTestSelected)
+        {
+            m_testTimeRemainingSec = 1800.0f; // 30 minutes
+        }
+        else
+        {
+            m_testTimeRemainingSec -= elapsedSec;
+            m_testTimeRemainingSec = std::max(0.0f, m_testTimeRemainingSec);
+        }
+        break;
+
+	case TestPattern::ActiveDimming: break;
+	case TestPattern::ActiveDimmingDark: break;
+
+
+    case TestPattern::BitDepthPrecision:
+        // TODO: How exactly are we choosing this to correspond with expected banding?
+        // We don't know what internal EOTF is being used by the display, so how
+        // do we draw a ruler that matches with anything but sRGB?
+        endColor = ColorF(0.25f, 0.25f, 0.25f);
+        break;
+
+    case TestPattern::RiseFallTime:
+        if (m_newTestSelected)
+        {
+            m_testTimeRemainingSec = 3.0f;
+        }
+        else
+        {
+            m_testTimeRemainingSec -= elapsedSec;
+            m_testTimeRemainingSec = std::max(0.0f, m_testTimeRemainingSec);
+            if (m_testTimeRemainingSec <= 0.0001)
+            {
+                if (!m_flashOn)
+                {
+                    m_flashOn = true;
+                    m_testTimeRemainingSec = 5;
+                }
+                else if (m_flashOn)
+                {
+                    m_flashOn = false;
+                    m_testTimeRemainingSec = 5;
+                }
+            }
+        }
+        break;
+
+    case TestPattern::StaticGradient:
+        endColor = m_gradientColor;
+        break;
+
+    case TestPattern::AnimatedGrayGradient:
+        // Color channels vary between 0.0 and 2 * m_gradientEndPoint.
+        endColor = ColorF(
+            m_gradientAnimationBase * sin(m_totalTime) + m_gradientAnimationBase,
+            m_gradientAnimationBase * sin(m_totalTime) + m_gradientAnimationBase,
+            m_gradientAnimationBase * sin(m_totalTime) + m_gradientAnimationBase);
+        break;
+
+    case TestPattern::AnimatedColorGradient:
+        // Color channels vary between 0.0 and 2 * m_gradientEndPoint.
+        endColor = ColorF(
+            m_gradientAnimationBase * sin(m_totalTime * 2.0f) + m_gradientAnimationBase,
+            m_gradientAnimationBase * sin(m_totalTime * 1.0f) + m_gradientAnimationBase,
+            m_gradientAnimationBase * sin(m_totalTime * 0.5f) + m_gradientAnimationBase);
+        break;
+
+    default:
+        // Not all test patterns have animations, so not implemented is fine.
+        break;
+    }
+
+    // Shared by the gradient test patterns.
+    m_gradientStops[0].color = ColorF(ColorF::Black, 1);
+    m_gradientStops[0].position = 0.0f;
+    m_gradientStops[1].color = endColor;
+    m_gradientStops[1].position = 1.0f;
+}
+
+// reset metadata to default state (same as panel properties) so it need do no tone mapping
+// Note: OS does this on boot and on app exit.
+void TestPatterns::SetMetadataNeutral()
+{
+    InvalidateDisplayList();
+
+    m_Metadata.MaxContentLightLevel      = static_cast<uint16_t>(m_rawOutDesc.MaxLuminance);
+    m_Metadata.MaxFrameAverageLightLevel = static_cast<uint16_t>(m_rawOutDesc.MaxFullFrameLuminance);
+    m_Metadata.MaxMasteringLuminance     = static_cast<unsigned int>(m_rawOutDesc.MaxLuminance);
+    m_Metadata.MinMasteringLuminance     = static_cast<unsigned int>(m_rawOutDesc.MinLuminance * 10000.0f);
+
+	m_MetadataGamut = ColorGamut::GAMUT_Native;
+	m_Metadata.RedPrimary[0]  = static_cast<uint16_t>(m_outputDesc.RedPrimary[0]   * 50000.0f);
+    m_Metadata.RedPrimary[1]  = static_cast<uint16_t>(m_outputDesc.RedPrimary[1]   * 50000.0f);
+    m_Metadata.GreenPrimary[0]= static_cast<uint16_t>(m_outputDesc.GreenPrimary[0] * 50000.0f);
+    m_Metadata.GreenPrimary[1]= static_cast<uint16_t>(m_outputDesc.GreenPrimary[1] * 50000.0f);
+    m_Metadata.BluePrimary[0] = static_cast<uint16_t>(m_outputDesc.BluePrimary[0]  * 50000.0f);
+    m_Metadata.BluePrimary[1] = static_cast<uint16_t>(m_outputDesc.BluePrimary[1]  * 50000.0f);
+    m_Metadata.WhitePoint[0]  = static_cast<uint16_t>(m_outputDesc.WhitePoint[0]   * 50000.0f);
+    m_Metadata.WhitePoint[1]  = static_cast<uint16_t>(m_outputDesc.WhitePoint[1]   * 50000.0f);
+
+    ApplyMetadata();
+}
+
+void TestPatterns::SetMetadata(float max, float avg, ColorGamut gamut)
+{
+    m_Metadata.MaxContentLightLevel = static_cast<uint16_t>(max);
+    m_Metadata.MaxFrameAverageLightLevel = static_cast<uint16_t>(avg);
+    m_Metadata.MaxMasteringLuminance = static_cast<unsigned int>(max);
+    m_Metadata.MinMasteringLuminance = static_cast<unsigned int>(0.0 * 10000.0f);
+
+    switch (gamut)
+    {
+    case GAMUT_Native:
+		m_MetadataGamut = ColorGamut::GAMUT_Native;
+		m_Metadata.RedPrimary[0]   = static_cast<uint16_t>(m_outputDesc.RedPrimary[0]   * 50000.0f);
+        m_Metadata.RedPrimary[1]   = static_cast<uint16_t>(m_outputDesc.RedPrimary[1]   * 50000.0f);
+        m_Metadata.GreenPrimary[0] = static_cast<uint16_t>(m_outputDesc.GreenPrimary[0] * 50000.0f);
+        m_Metadata.GreenPrimary[1] = static_cast<uint16_t>(m_outputDesc.GreenPrimary[1] * 50000.0f);
+        m_Metadata.BluePrimary[0]  = static_cast<uint16_t>(m_outputDesc.BluePrimary[0]  * 50000.0f);
+        m_Metadata.BluePrimary[1]  = static_cast<uint16_t>(m_outputDesc.BluePrimary[1]  * 50000.0f);
+		break;
+    case GAMUT_sRGB:
+		m_MetadataGamut = ColorGamut::GAMUT_sRGB;
+		m_Metadata.RedPrimary[0]   = static_cast<uint16_t>(primaryR_709.x * 50000.0f);
+        m_Metadata.RedPrimary[1]   = static_cast<uint16_t>(primaryR_709.y * 50000.0f);
+        m_Metadata.GreenPrimary[0] = static_cast<uint16_t>(primaryG_709.x * 50000.0f);
+        m_Metadata.GreenPrimary[1] = static_cast<uint16_t>(primaryG_709.y * 50000.0f);
+        m_Metadata.BluePrimary[0]  = static_cast<uint16_t>(primaryB_709.x * 50000.0f);
+        m_Metadata.BluePrimary[1]  = static_cast<uint16_t>(primaryB_709.y * 50000.0f);
+        break;
+    case GAMUT_Adobe:
+		m_MetadataGamut = ColorGamut::GAMUT_Adobe;
+		m_Metadata.RedPrimary[0]   = static_cast<uint16_t>(primaryR_Adobe.x * 50000.0f);
+        m_Metadata.RedPrimary[1]   = static_cast<uint16_t>(primaryR_Adobe.y * 50000.0f);
+        m_Metadata.GreenPrimary[0] = static_cast<uint16_t>(primaryG_Adobe.x * 50000.0f);
+        m_Metadata.GreenPrimary[1] = static_cast<uint16_t>(primaryG_Adobe.y * 50000.0f);
+        m_Metadata.BluePrimary[0]  = static_cast<uint16_t>(primaryB_Adobe.x * 50000.0f);
+        m_Metadata.BluePrimary[1]  = static_cast<uint16_t>(primaryB_Adobe.y * 50000.0f);
+		break;
+    case GAMUT_DCIP3:
+		m_MetadataGamut = ColorGamut::GAMUT_DCIP3;
+		m_Metadata.RedPrimary[0]   = static_cast<uint16_t>(primaryR_DCIP3.x * 50000.0f);
+        m_Metadata.RedPrimary[1]   = static_cast<uint16_t>(primaryR_DCIP3.y * 50000.0f);
+        m_Metadata.GreenPrimary[0] = static_cast<uint16_t>(primaryG_DCIP3.x * 50000.0f);
+        m_Metadata.GreenPrimary[1] = static_cast<uint16_t>(primaryG_DCIP3.y * 50000.0f);
+        m_Metadata.BluePrimary[0]  = static_cast<uint16_t>(primaryB_DCIP3.x * 50000.0f);
+        m_Metadata.BluePrimary[1]  = static_cast<uint16_t>(primaryB_DCIP3.y * 50000.0f);
+		break;
+    case GAMUT_BT2100:
+		m_MetadataGamut = ColorGamut::GAMUT_BT2100;
+		m_Metadata.RedPrimary[0]   = static_cast<uint16_t>(primaryR_2020.x * 50000.0f);
+        m_Metadata.RedPrimary[1]   = static_cast<uint16_t>(primaryR_2020.y * 50000.0f);
+        m_Metadata.GreenPrimary[0] = static_cast<uint16_t>(primaryG_2020.x * 50000.0f);
+        m_Metadata.GreenPrimary[1] = static_cast<uint16_t>(primaryG_2020.y * 50000.0f);
+        m_Metadata.BluePrimary[0]  = static_cast<uint16_t>(primaryB_2020.x * 50000.0f);
+        m_Metadata.BluePrimary[1]  = static_cast<uint16_t>(primaryB_2020.y * 50000.0f);
+		break;
+    }
+
+    m_Metadata.WhitePoint[0] = static_cast<uint16_t>(D6500White.x * 50000.0f);
+    m_Metadata.WhitePoint[1] = static_cast<uint16_t>(D6500White.y * 50000.0f);
+
+    ApplyMetadata();
+}
+
+// dump out the metadata to a string for display
+void TestPatterns::PrintMetadata( PatternCanvas* ctx, bool blackText /* = false */ )
+{
+	std::wstringstream text;
+	// print luminance levels
+	text << "MaxCLL: ";
+	text << std::to_wstring((int)m_Metadata.MaxContentLightLevel);
+	text << "  MaxFALL: ";
+	text << std::to_wstring((int)m_Metadata.MaxFrameAverageLightLevel);
+	text << "  MinCLL: ";
+	text << std::to_wstring(m_Metadata.MinMasteringLuminance / 10000.0f);
+
+	// print gamut in use
+	text << "  Gamut: ";
+	switch ( m_MetadataGamut )
+	{
+	case GAMUT_Native:
+		text << "Native\n";
+		break;
+	case GAMUT_sRGB:
+		text << "sRGB\n";
+		break;
+	case GAMUT_Adobe:
+		text << "Adobe\n";
+		break;
+	case GAMUT_DCIP3:
+		text << "DCI-P3\n";
+		break;
+	case GAMUT_BT2100:
+		text << "bt.2100\n";
+		break;
+	}
+
+	RenderText(ctx, TextStyle::Large, text.str(), m_MetadataTextRect, blackText);
+}
+
+void TestPatterns::GenerateTestPattern_StartOfTest(PatternCanvas* ctx)
+{
+    std::wstringstream text;
+
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    text << m_appTitle;
+    text << L"\n\nVersion 1.10\n\n";
+    //text << L"ALT-ENTER: Toggle fullscreen: all measurements should be made in fullscreen\n";
+	text << L"->, PAGE DN:       Move to next test\n";
+	text << L"<-, PAGE UP:        Move to previous test\n";
+    text << L"NUMBER KEY:	Jump to test number\n";
+    text << L"SPACE:		Hide text and target circle\n";
+    text << L"C:		Start 60s cool-down\n";
+    text << L"ALT-ENTER:	Toggle fullscreen\n";
+    text << L"ESCAPE:		Exit fullscreen\n";
+    text << L"ALT-F4:		Exit app\n";
+    text << L"\nCopyright \u00A9 VESA\nLast updated: " << __DATE__;
+
+    RenderText(ctx, TextStyle::Large, text.str(), m_largeTextRect);
+
+    if (m_showExplanatoryText)
+    {
+
+        std::wstringstream title;
+        title << L"Home.   Start Screen\n" << m_hideTextString;
+
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect);
+    }
+    m_newTestSelected = false;
+
+}
+
+bool TestPatterns::CheckHDR_On()
+{
+	// TODO this should query an HDR bit if one is available
+	bool HDR_On = false;
+	switch (m_outputDesc.ColorSpace)
+	{
+	case ColorSpace_sRGB: // sRGB
+		break;
+
+	case ColorSpace_HDR10: // HDR10 PC
+		HDR_On = true;
+		break;
+
+	default:
+		break;
+	}
+
+	return HDR_On;
+}
+
+void TestPatterns::GenerateTestPattern_ConnectionProperties(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    std::wstringstream text;
+
+	text << L"\n\nConnection to: ";
+	wchar_t *DisplayName = wcsrchr(m_outputDesc.DeviceName, '\\');
+	text << ++DisplayName;
+
+	text << L"\n\nConnection bit depth: ";
+    text << std::to_wstring(m_outputDesc.BitsPerColor);
+
+    text << L"\n\nConnection colorspace: [";
+	text << std::to_wstring(m_outputDesc.ColorSpace);
+	switch (m_outputDesc.ColorSpace)
+	{
+	case ColorSpace_sRGB: // sRGB
+		text << L"] sRGB/SDR";
+		break;
+
+	case ColorSpace_HDR10: // HDR10 PC
+		text << L"] HDR/advanced color on";
+		break;
+	default:
+		text << L"] Unknown";
+		break;
+	}
+
+    bool HDR_On = CheckHDR_On();
+
+	if (!HDR_On)
+    {
+        text << L"\n\nBefore starting tests, make sure \"HDR and Advanced color\"";
+        text << L"\n is enabled in the Display settings panel.";
+    }
+
+	if ( HDR_On )
+	{
+		text << L"\n\nSupported PQ Values - ";
+		text << L"\nMax Effective Value: ";
+		text << std::to_wstring((int)m_maxEffectivePQValue);
+		text << L" (";
+		text << std::to_wstring(PqCode<10>::Nits(m_maxEffectivePQValue));
+		text << L" nits)";
+
+		text << L"\nMax FullFrame Value: ";
+		text << std::to_wstring((int)m_maxFullFramePQValue);
+		text << L" (";
+		text << std::to_wstring(PqCode<10>::Nits(m_maxFullFramePQValue));
+		text << L" nits)";
+
+		text << L"\nMin Effective Value: ";
+		text << std::to_wstring((int)m_minEffectivePQValue);
+		text << L" (  ";
+		text << std::to_wstring(PqCode<10>::Nits(m_minEffectivePQValue));
+		text << L" nits)";
+	}
+	else
+	{
+		text << L"\n\nSupported sRGB Values - ";
+		text << L"\nMax Effective Value: ";
+		text << std::to_wstring((int)m_maxEffectivesRGBValue);
+		text << L" (";
+		text << std::to_wstring(SrgbCode<8>::Nits(m_maxEffectivesRGBValue));
+		text << L" nits)";
+
+		text << L"\nMax FullFrame Value: ";
+		text << std::to_wstring((int)m_maxFullFramesRGBValue);
+		text << L" (";
+		text << std::to_wstring(SrgbCode<8>::Nits(m_maxFullFramesRGBValue));
+		text << L" nits)";
+
+		text << L"\nMin Effective Value: ";
+		text << std::to_wstring((int)m_minEffectivesRGBValue);
+		text << L" (  ";
+		text << std::to_wstring(SrgbCode<8>::Nits(m_minEffectivesRGBValue));
+		text << L" nits)";
+	}
+    RenderText(ctx, TextStyle::Monospace, text.str(), m_largeTextRect);
+
+    if (m_showExplanatoryText)
+    {
+        std::wstring title = L"Connection properties:\nPress SPACE to hide this text\n";
+        RenderText(ctx, TextStyle::Large, title, m_testTitleRect);
+    }
+
+    m_newTestSelected = false;
+}
+
+void TestPatterns::GenerateTestPattern_PanelCharacteristics(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    std::wstringstream text;
+	text << fixed << setw(9) << setprecision(2);
+
+	// TODO: ensure these values are up to date.
+	if (CheckForDefaults())
+	{
+		text << L"***WARNING: These are OS-provided defaults. Display did not provide any data.***\n";
+	}
+	// else
+	{
+		text << L"\nHDR Testing Tier: " << GetTierName(m_testingTier);
+		text << L" - Change using Up/Down Arrow Keys" << L"\n";
+	}
+	
+	
+	//	text << m_outputDesc.DeviceName;
+
+	text << L"\nBase Levels:";
+    text << L"\n  Max peak luminance:          ";
+    text << m_rawOutDesc.MaxLuminance;
+    text << L"\n  Max frame-average luminance: ";
+    text << m_rawOutDesc.MaxFullFrameLuminance;
+	text << L"\n  Min luminance:                 ";
+	text << setprecision(5);
+	text << m_rawOutDesc.MinLuminance;
+	text << L"\nAdjusted Levels:";
+	text << L"\n  Max peak luminance:          ";
+	text << setprecision(2);
+	text << m_outputDesc.MaxLuminance;
+	text << L"\n  Max frame-average luminance: ";
+	text << m_outputDesc.MaxFullFrameLuminance;
+	text << L"\n  Min luminance:                 ";
+	text << setprecision(5);
+	text << m_outputDesc.MinLuminance;
+	text << L"\nCurr. Brightness Slider Factor:  ";
+	text << BRIGHTNESS_SLIDER_FACTOR;
+
+//  text << L"\nContrast ratio (peak/min):   ";
+//  text << std::to_wstring(m_outputDesc.MaxLuminance / m_outputDesc.MinLuminance );
+    text << L"\n";
+
+    // Compute area of this device's gamut in uv coordinates
+
+    // first, get primaries of display in 1931 xy coordinates
+    float2 red_xy, grn_xy, blu_xy, wht_xy;
+    red_xy = m_outputDesc.RedPrimary;
+    grn_xy = m_outputDesc.GreenPrimary;
+    blu_xy = m_outputDesc.BluePrimary;
+    wht_xy = m_outputDesc.WhitePoint;
+
+	text << L"\nCIE 1931          x         y";
+    text << L"\nRed Primary  :  " << std::to_wstring(red_xy.x) << L"  " << std::to_wstring(red_xy.y);
+    text << L"\nGreen Primary:  " << std::to_wstring(grn_xy.x) << L"  " << std::to_wstring(grn_xy.y);
+    text << L"\nBlue Primary :  " << std::to_wstring(blu_xy.x) << L"  " << std::to_wstring(blu_xy.y);
+    text << L"\nWhite Point  :  " << std::to_wstring(wht_xy.x) << L"  " << std::to_wstring(wht_xy.y);
+
+    float gamutAreaDevice = ComputeGamutArea(red_xy, grn_xy, blu_xy);
+
+    // rec.709/sRGB gamut area in uv coordinates
+    float gamutAreasRGB = ComputeGamutArea(primaryR_709, primaryG_709, primaryB_709);
+
+    // AdobeRGB gamut area in uv coordinates
+    float GamutAreaAdobe = ComputeGamutArea(primaryR_Adobe, primaryG_Adobe, primaryB_Adobe);
+
+    // DCI-P3 gamut area in uv coordinates
+    float gamutAreaDCIP3 = ComputeGamutArea(primaryR_DCIP3, primaryG_DCIP3, primaryB_DCIP3);
+
+    // BT.2020 gamut area in uv coordinates
+    float gamutAreaBT2100 = ComputeGamutArea(primaryR_2020, primaryG_2020, primaryB_2020);
+
+    // ACES gamut area in uv coordinates
+    float gamutAreaACES = ComputeGamutArea(primaryR_ACES, primaryG_ACES, primaryB_ACES);
+
+    // Compute extent that this device gamut covers known popular ones:
+    float coverageSRGB  = ComputeGamutCoverage(red_xy, grn_xy, blu_xy, primaryR_709,   primaryG_709,   primaryB_709);
+    float coverageAdobe = ComputeGamutCoverage(red_xy, grn_xy, blu_xy, primaryR_Adobe, primaryG_Adobe, primaryB_Adobe);
+    float coverageDCIP3 = ComputeGamutCoverage(red_xy, grn_xy, blu_xy, primaryR_DCIP3, primaryG_DCIP3, primaryB_DCIP3);
+    float coverage2100  = ComputeGamutCoverage(red_xy, grn_xy, blu_xy, primaryR_2020,  primaryG_2020,  primaryB_2020);
+    float coverageACES  = ComputeGamutCoverage(red_xy, grn_xy, blu_xy, primaryR_ACES,  primaryG_ACES,  primaryB_ACES);
+    float coverageHuman = ComputeLocusCoverage(red_xy, grn_xy, blu_xy);	// CIE 1931 spectral locus
+
+    // display coverage values
+    text << L"\n\nGamut Coverage based on reported primaries";
+    text << L"\n        % sRGB : " << std::to_wstring(coverageSRGB*100.f);
+    text << L"\n    % AdobeRGB : " << std::to_wstring(coverageAdobe*100.f);
+    text << L"\n      % DCI-P3 : " << std::to_wstring(coverageDCIP3*100.f);
+    text << L"\n     % BT.2100 : " << std::to_wstring(coverage2100*100.f);
+    text << L"\n   % Human eye : " << std::to_wstring(coverageHuman*100.f);
+
+    // 3D coverage, computed in UpdateDxgiColorimetryInfo()
+    text << L"\n\nColor Volume Coverage (ICtCp, 0-10,000 nits)";
+    text << L"\n      % DCI-P3 : " << std::to_wstring(m_volumeCoverageDCIP3*100.f);
+    text << L"\n     % BT.2100 : " << std::to_wstring(m_volumeCoverage2100*100.f);
+    text << L"\n Volume (M JND^3): " << std::to_wstring(m_colorVolumeJND*1e-6);
+
+    // test code:
+    float theory = gamutAreaDevice / gamutAreaBT2100;
+    //	text << L"\n     %  Theory : " << std::to_wstring( theory*100.f);
+    //	text << L"\n       % Error : " << std::to_wstring((coverage2100 - theory) / theory * 100.f);
+
+    RenderText(ctx, TextStyle::Monospace, text.str(), m_largeTextRect);
+
+    if (m_showExplanatoryText)
+    {
+        std::wstring title = L"Reported Panel Characteristics\n" + m_hideTextString;
+        RenderText(ctx, TextStyle::Large, title, m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+
+    m_newTestSelected = false;
+
+    // TODO should bail here if no valid data
+}
+
+
+void TestPatterns::GenerateTestPattern_ResetInstructions(PatternCanvas* ctx)
+{
+	if (m_newTestSelected)
+	{
+
+		SetMetadataNeutral();
+
+// This works but we don't know what to set it to.
+// So it is commented out until we do
+//		setBrightnessSliderPercent(33);
+// EDID settings don't update afterwards anyway until next app run
+	}
+
+    if (m_showExplanatoryText)
+    {
+        std::wstring title = L"Start of performance tests\n" + m_hideTextString;
+        RenderText(ctx, TextStyle::Large, title, m_testTitleRect);
+    }
+    std::wstringstream text;
+    text << L"For external displays, use their OSD to reset\n";
+    text << L"all settings to the default or factory state.\n\n";
+
+	text << L"For internal panels, set the OS \'Brightness\' slider to default.\n";
+	text << L"Set the \'SDR color appearance\' slider to the leftmost point.\n";
+	text << L"DO NOT CHANGE BRIGHTNESS SLIDERS AFTER APP START.\n\n";
+
+	text << L"Be sure the \'Night light' setting is off.\n";
+
+	text << L"Disable any Ambient Light Sensor capability.\n\n";
+
+	text << L"The display should be at normal operating temperature.\n";
+    text << L"   This can take as much as 30 minutes for some panels.\n";
+
+    text << L"   Also note, ambient temperature may affect scores.\n\n";
+
+    text << L"Use the following screen to check correct brightness levels";
+
+    RenderText(ctx, TextStyle::Large, text.str(), m_largeTextRect);
+    m_newTestSelected = false;
+}
+
+void TestPatterns::DrawLogo(PatternCanvas* ctx, float c)
+{
+	ColorF centerBrush = ColorF(c, c, c);
+	auto logSize = ctx->GetLogicalSize();
+	float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+	size = size * sqrtf(0.10);  // dimension of a square of 10% screen area
+	size = size * 0.3333333f;
+
+	float2 center;
+	center.x = (logSize.right - logSize.left)*0.50f;
+	center.y = (logSize.bottom - logSize.top)*0.50f;
+
+	RectF centerSquare1 =
+	{
+		center.x - size * 1.03f,
+		center.y - size * 1.03f,
+		center.x - size * 0.03f,
+		center.y - size * 0.03f
+	};
+	ctx->FillRectangle(centerSquare1, centerBrush);
+
+	RectF centerSquare2 =
+	{
+		center.x + size * 0.03f,
+		center.y - size * 1.03f,
+		center.x + size * 1.03f,
+		center.y - size * 0.03f
+	};
+	ctx->FillRectangle(centerSquare2, centerBrush);
+
+	RectF centerSquare3 =
+	{
+		center.x - size * 1.03f,
+		center.y + size * 0.03f,
+		center.x - size * 0.03f,
+		center.y + size * 1.03f
+	};
+	ctx->FillRectangle(centerSquare3, centerBrush);
+
+	RectF centerSquare4 =
+	{
+		center.x + size * 0.03f,
+		center.y + size * 0.03f,
+		center.x + size * 1.03f,
+		center.y + size * 1.03f
+	};
+	ctx->FillRectangle(centerSquare4, centerBrush);
+}
+
+void TestPatterns::GenerateTestPattern_CalibrateMaxEffectiveValue(PatternCanvas* ctx) // Detect white crush (MaxTML)
+{
+	// outer box
+	float outerNits = m_outputDesc.MaxLuminance;
+	float avg = 600.0f;
+	if (m_newTestSelected) SetMetadata(outerNits, avg, GAMUT_Native);
+	float c = nitstoCCCS(outerNits);
+
+	ColorF outerBrush = ColorF(c, c, c);
+
+	auto logSize = ctx->GetLogicalSize();
+	float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+	size = size * sqrtf(0.10);  // dimension of a square of 10% screen area
+	float2 center;
+	center.x = (logSize.right - logSize.left) * 0.50f;
+	center.y = (logSize.bottom - logSize.top) * 0.50f;
+	RectF outerSquare =
+	{
+		center.x - size * 0.50f,
+		center.y - size * 0.50f,
+		center.x + size * 0.50f,
+		center.y + size * 0.50f
+	};
+
+	ctx->FillRectangle(outerSquare, outerBrush);
+
+	// inner boxes
+	float nits = 0;
+	if (CheckHDR_On())
+	{
+		nits = PqCode<10>::Nits(m_maxEffectivePQValue);
+		c = nitstoCCCS(nits);
+	}
+	else
+	{
+		c = SrgbCode<8>::Signal(m_maxEffectivesRGBValue);
+		nits = RemoveSRGBCurve(c) * 80.0f;
+	}
+	ColorF centerBrush = ColorF(c, c, c);
+
+	size = size * 0.3333333f;
+	RectF centerSquare1 =
+	{
+		center.x - size * 1.03f,
+		center.y - size * 1.03f,
+		center.x - size * 0.03f,
+		center.y - size * 0.03f
+	};
+	ctx->FillRectangle(centerSquare1, centerBrush);
+
+	RectF centerSquare2 =
+	{
+		center.x + size * 0.03f,
+		center.y - size * 1.03f,
+		center.x + size * 1.03f,
+		center.y - size * 0.03f
+	};
+	ctx->FillRectangle(centerSquare2, centerBrush);
+
+	RectF centerSquare3 =
+	{
+		center.x - size * 1.03f,
+		center.y + size * 0.03f,
+		center.x - size * 0.03f,
+		center.y + size * 1.03f
+	};
+	ctx->FillRectangle(centerSquare3, centerBrush);
+
+	RectF centerSquare4 =
+	{
+		center.x + size * 0.03f,
+		center.y + size * 0.03f,
+		center.x + size * 1.03f,
+		center.y + size * 1.03f
+	};
+	ctx->FillRectangle(centerSquare4, centerBrush);
+
+	if( m_showExplanatoryText )
+	{
+		std::wstringstream title;
+		title << L"Calibrate Max Tone Mapped Luminance Value: ";
+		if (CheckHDR_On())
+		{
+			title << L"\nHDR10: ";
+			title << static_cast<unsigned int>(m_maxEffectivePQValue);
+			title << L"  Nits: ";
+			title << nits;
+		}
+		else
+		{
+			title << L"\nsRGB: ";
+			title << static_cast<unsigned int>(m_maxEffectivesRGBValue);
+			title << L"  Nits: ";
+			title << nits;
+		}
+
+		title << L"\nAdjust brightness using Up/Down arrows";
+		title << L"\n  until inner boxes just barely disappear";
+		RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+}
+
+	m_newTestSelected = false;
+
+}
+
+void TestPatterns::GenerateTestPattern_CalibrateMaxFullFrameValue(PatternCanvas* ctx) // Verify MaxFALL (MaxFF TML)
+{
+	// set up background (clear full screen)
+	float backNits = m_outputDesc.MaxFullFrameLuminance;
+	float avg = backNits;
+	if (m_newTestSelected) SetMetadata(backNits, avg, GAMUT_Native);
+	float c = nitstoCCCS(backNits);
+	ColorF backBrush = ColorF(c, c, c);
+	auto logSize = ctx->GetLogicalSize();
+	ctx->FillRectangle(logSize, backBrush);
+	float2 center;
+	center.x = (logSize.right - logSize.left)*0.50f;
+	center.y = (logSize.bottom - logSize.top)*0.50f;
+	float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+
+	// inner boxes
+	float nits = 0;
+	if (CheckHDR_On())
+	{
+		nits = PqCode<10>::Nits(m_maxFullFramePQValue);
+		c = nitstoCCCS(nits);
+	}
+	else
+	{
+		c = SrgbCode<8>::Signal(m_maxFullFramesRGBValue);
+		nits = RemoveSRGBCurve(c)*80.0f;
+	}
+	ColorF centerBrush = ColorF(c, c, c);
+
+	size = size * 0.333333333f;
+	size = size * 0.333333333f;
+	RectF centerSquare1 =
+	{
+		center.x - size * 1.03f,
+		center.y - size * 1.03f,
+		center.x - size * 0.03f,
+		center.y - size * 0.03f
+	};
+	ctx->FillRectangle(centerSquare1, centerBrush);
+
+	RectF centerSquare2 =
+	{
+		center.x + size * 0.03f,
+		center.y - size * 1.03f,
+		center.x + size * 1.03f,
+		center.y - size * 0.03f
+	};
+	ctx->FillRectangle(centerSquare2, centerBrush);
+
+	RectF centerSquare3 =
+	{
+		center.x - size * 1.03f,
+		center.y + size * 0.03f,
+		center.x - size * 0.03f,
+		center.y + size * 1.03f
+	};
+	ctx->FillRectangle(centerSquare3, centerBrush);
+
+	RectF centerSquare4 =
+	{
+		center.x + size * 0.03f,
+		center.y + size * 0.03f,
+		center.x + size * 1.03f,
+		center.y + size * 1.03f
+	};
+	ctx->FillRectangle(centerSquare4, centerBrush);
+
+	if (m_showExplanatoryText)
+	{
+		std::wstringstream title;
+		title << L"Calibrate Max Full Frame Luminance Value: ";
+		if (CheckHDR_On())
+		{
+			title << L"\nHDR10: ";
+			title << static_cast<unsigned int>(m_maxFullFramePQValue);
+			title << L"  Nits: ";
+			title << nits;
+		}
+		else
+		{
+			title << L"\nsRGB: ";
+			title << static_cast<unsigned int>(m_maxEffectivesRGBValue);
+			title << L"  Nits: ";
+			title << nits;
+		}
+
+		title << L"\nAdjust brightness using Up/Down arrows";
+		title << L"\n  until inner boxes just barely disappear";
+		RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true);
+	}
+
+	m_newTestSelected = false;
+
+}
+
+
+void TestPatterns::GenerateTestPattern_CalibrateMinEffectiveValue(PatternCanvas* ctx) // Detect Black Crush
+{
+	// set up background
+	float backNits = 2.0f;
+	float avg = backNits*0.90f;
+	if (m_newTestSelected) SetMetadata(backNits, avg, GAMUT_Native);
+	float c = nitstoCCCS(backNits);
+	ColorF backBrush = ColorF(c, c, c);
+	auto logSize = ctx->GetLogicalSize();
+	ctx->FillRectangle(logSize, backBrush);
+
+	// draw 10% square in pure black
+	float outerNits = 0.0f;
+	c = nitstoCCCS(outerNits);
+	ColorF outerBrush = ColorF(c, c, c);
+
+	float size = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top));
+	size = size*sqrtf(0.10);  // dimension of a square of 10% screen area
+	float2 center;
+	center.x = (logSize.right - logSize.left)*0.50f;
+	center.y = (logSize.bottom - logSize.top)*0.50f;
+	RectF outerSquare =
+	{
+		center.x - size*0.50f,
+		center.y - size*0.50f,
+		center.x + size*0.50f,
+		center.y + size*0.50f
+	};
+
+	ctx->FillRectangle(outerSquare, outerBrush);
+
+	// inner boxes
+	float nits = 0;
+	if (CheckHDR_On())
+	{
+		nits = PqCode<10>::Nits(m_minEffectivePQValue);
+		c = nitstoCCCS(nits);
+	}
+	else
+	{
+		c = SrgbCode<8>::Signal(m_minEffectivesRGBValue);
+		nits = RemoveSRGBCurve(c)*80.0f;
+	}
+
+	ColorF centerBrush = ColorF(c, c, c);
+
+	size = size*0.3333333f;
+	RectF centerSquare1 =
+	{
+		center.x - size*1.03f,
+		center.y - size*1.03f,
+		center.x - size*0.03f,
+		center.y - size*0.03f
+	};
+	ctx->FillRectangle(centerSquare1, centerBrush);
+
+	RectF centerSquare2 =
+	{
+		center.x + size*0.03f,
+		center.y - size*1.03f,
+		center.x + size*1.03f,
+		center.y - size*0.03f
+	};
+	ctx->FillRectangle(centerSquare2, centerBrush);
+
+	RectF centerSquare3 =
+	{
+		center.x - size*1.03f,
+		center.y + size*0.03f,
+		center.x - size*0.03f,
+		center.y + size*1.03f
+	};
+	ctx->FillRectangle(centerSquare3, centerBrush);
+
+	RectF centerSquare4 =
+	{
+		center.x + size*0.03f,
+		center.y + size*0.03f,
+		center.x + size*1.03f,
+		center.y + size*1.03f
+	};
+	ctx->FillRectangle(centerSquare4, centerBrush);
+
+	if (m_showExplanatoryText)
+	{
+		std::wstringstream title;
+		title << L"Calibrate Min Tone-Mapped Luminance Level: ";
+		if (CheckHDR_On())
+		{
+			title << L"\nHDR10: ";
+			title << static_cast<unsigned int>(m_minEffectivePQValue);
+			title << L"  Nits: ";
+			title << nits;
+		}
+		else
+		{
+			title << L"\nsRGB: ";
+			title << static_cast<unsigned int>(m_minEffectivesRGBValue);
+			title << L"  Nits: ";
+			title << nits;
+		}
+
+		title << L"\nAdjust brightness using Up/Down arrows";
+		title << L"\n  until inner boxes just barely disappear";
+		RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+
+	m_newTestSelected = false;
+}
+
+
+void TestPatterns::GenerateTestPattern_PQLevelsInNits(PatternCanvas* ctx)		// 
+{
+
+
+    if (m_newTestSelected) SetMetadata(10000.0, 180.0, GAMUT_Native);
+
+    // Grayscale patches at the PQ code nearest to each of these levels, drawn with the
+    // FP16 value that scans out as that code under the brightness slider (m_pqCodes10):
+    // PQ Code	Nits	CCCS
+    // 0		0		0.0f
+    // 153		1		0.0125f
+    // 193		2		0.025f
+    // 206		2.5		0.03125f
+    // 254		5		0.0625f
+    // 307		10		0.125f
+    // 365		20		0.25f
+    // 429		40		0.5f
+    // 497		80		1.0f
+    // 569		160		2.0f
+    // 643		320		4.0f
+    // 719		640		8.0f
+    // 769		1000	12.5f
+    // 846		2000	25.0f
+    // 923		4000	50.0f
+    // 1023		10000	125.0f
+    const float levels[16] =
+    {
+        0.0f, 1.0f, 2.0f, 2.5f, 5.0f, 10.0f, 20.0f, 40.0f,
+        80.0f, 160.0f, 320.0f, 640.0f, 1000.0f, 2000.0f, 4000.0f, 10000.0f
+    };
+
+    // We only render small patches of each color to limit power consumption.
+    auto rect = ctx->GetLogicalSize();
+    auto w = (rect.right - rect.left) / 4.0f; // Divide screen in 4x4 grid.
+    auto h = (rect.bottom - rect.top) / 4.0f;
+    auto w1 = w * 0.2f; // Left/top edge of each patch offset.
+    auto h1 = h * 0.2f;
+    auto w2 = w * 0.8f; // Right/bottom edge of each patch offset.
+    auto h2 = h * 0.8f;
+
+    for (int i = 0; i < 16; i++)
+    {
+        float x = w * (float)(i % 4);
+        float y = h * (float)(i / 4);
+        float c = m_pqCodes10.GetCCCS(m_pqCodes10.GetCode(levels[i]));
+        ctx->FillRectangle(RectF(x + w1, y + h1, x + w2, y + h2), ColorF(c, c, c));
+    }
+
+    if (m_showExplanatoryText)
+    {
+        for (int i = 0; i < 16; i++)
+        {
+            float x = w * (float)(i % 4);
+            float y = h * (float)(i / 4 + 1);
+
+            std::wstringstream label;
+            label << L"PQ:" << left << setw(5) << m_pqCodes10.GetCode(levels[i]) << L"Nits:" << levels[i];
+            RenderText(ctx, TextStyle::Large, label.str(), { x + w1, y - h1, i == 15 ? 250.0f : 200.0f, 30.0f });
+        }
+
+        std::wstring title = L"PQ/ST 2084 levels in nits\n" + m_hideTextString;
+        RenderText(ctx, TextStyle::Large, title, m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+    m_newTestSelected = false;
+
+}
+
+void TestPatterns::GenerateTestPattern_WarmUp(PatternCanvas* ctx)
+{
+    float nits = 180.0f; // warm up level
+    if (m_newTestSelected) SetMetadata(nits, nits, GAMUT_Native);
+    float c = nitstoCCCS(nits)/BRIGHTNESS_SLIDER_FACTOR;
+
+    ColorF peakBrush = ColorF(c, c, c);
+
+    auto logSize = ctx->GetLogicalSize();
+    ctx->FillRectangle(logSize, peakBrush);
+
+    if (m_showExplanatoryText)
+    {
+        std::wstringstream title;
+		title << L"Warm-Up: ";
+		title << fixed << setw(8) << setprecision(2);
+		if (0.0f != m_testTimeRemainingSec)
+        {
+            title << m_testTimeRemainingSec;
+            title << L" seconds remaining";
+            title << L"\nNits: ";
+			title << nits;
+            title << L"  HDR10: ";
+			title << setprecision(0);
+            title << PqCode<10>::Code(Apply2084(c*80.f / 10000.f));
+            title << L"\n" << m_hideTextString;
+        }
+        else
+        {
+            title << L" done.";
+        }
+
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true);
+    }
+    m_newTestSelected = false;
+}
+
+// this is invoked via the C key
+// it just draws a black screen for 60seconds.
+void TestPatterns::GenerateTestPattern_Cooldown(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    if (m_showExplanatoryText)
+    {
+        std::wstringstream title;
+        title << L"Cool-down: ";
+        if (0.0f != m_testTimeRemainingSec)
+        {
+            title << static_cast<unsigned int>(m_testTimeRemainingSec);
+            title << L" seconds remaining\n" << m_hideTextString;
+        }
+        else
+        {
+            title << L" done.";
+        }
+
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+    m_newTestSelected = false;
+
+}
+
+#define randf()((float)rand()/(float(RAND_MAX)+1.0f))
+#define JITTER_RADIUS 10.0f
+
+// A small random offset for the patches that move a little every frame.  The dice are
+// rolled even when disabled so the sequence after srand() does not depend on it.
+PointF TestPatterns::NextJitter(float dpi, bool enabled)
+{
+	PointF jitter;
+	float radius = JITTER_RADIUS * dpi / 96.0f;
+
+	do {
+		jitter.x = radius * (randf() * 2.f - 1.f);
+		jitter.y = radius * (randf() * 2.f - 1.f);
+	} while ((jitter.x * jitter.x + jitter.y * jitter.y) > radius);
+
+	return enabled ? jitter : PointF(0.0f, 0.0f);
+}
+
+// Returns the offset to add to what is drawn until EndJitter().  While a display list is
+// being recorded that is zero, and the list applies a fresh offset on every replay.
+PointF TestPatterns::BeginJitter(PatternCanvas* ctx, bool enabled)
+{
+	PointF jitter = NextJitter(ctx->GetDpi(), enabled);
+	if (ctx != &m_displayList)
+		return jitter;
+
+	m_displayList.BeginJitter(enabled, jitter);
+	return PointF(0.0f, 0.0f);
+}
+
+void TestPatterns::EndJitter(PatternCanvas* ctx)
+{
+	if (ctx == &m_displayList)
+		m_displayList.EndJitter();
+}
+
+void TestPatterns::GenerateTestPattern_TenPercentPeak(PatternCanvas* ctx) //********************** 1.
+{
+    // "tone map" PQ limit of 10k nits down to panel maxLuminance in CCCS
+    float nits = m_outputDesc.MaxLuminance;
+    float avg = nits * 0.1f;								// 10% screen area
+    if (m_newTestSelected) {
+		SetMetadata(nits, avg, GAMUT_Native);
+		srand(314159);										// seed the jitter rnd
+	}
+
+//	nits = 4.0;
+    float c = nitstoCCCS(nits);
+
+    ColorF peakBrush = ColorF(c, c, c);
+
+    auto logSize = ctx->GetLogicalSize();
+	PointF jitter = BeginJitter(ctx);
+
+	RectF tenPercentRect =
+	{
+		(logSize.right - logSize.left) * (0.5f - sqrtf(0.1) / 2.0f) + jitter.x,
+		(logSize.bottom - logSize.top) * (0.5f - sqrtf(0.1) / 2.0f) + jitter.y,
+		(logSize.right - logSize.left) * (0.5f + sqrtf(0.1) / 2.0f) + jitter.x,
+		(logSize.bottom - logSize.top) * (0.5f + sqrtf(0.1) / 2.0f) + jitter.y
+    };
+
+    ctx->FillRectangle(tenPercentRect, peakBrush);
+    EndJitter(ctx);
+
+    if (m_showExplanatoryText)
+    {
+		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top)*0.04f);	// 4% screen area colorimeter box
+		float2 center = float2(logSize.right*0.5f, logSize.bottom*0.5f);
+
+		EllipseF ellipse =
+		{
+			PointF(center.x, center.y),
+			fRad * 0.35f,						// TODO: make target diameter 27mm using DPI data
+			fRad * 0.35f
+		};
+
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red), 1 );
+
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+        title << L"1.a Peak Luminance  10% Screen Area\nWait before taking measurements: ";
+        title << m_testTimeRemainingSec;
+        title << L" seconds remaining";
+        title << L"\nNits: ";
+        title << nits*BRIGHTNESS_SLIDER_FACTOR;
+        title << L"  HDR10: ";
+		title << setprecision(0);
+        title << PqCode<10>::Code(Apply2084(c*80.f * BRIGHTNESS_SLIDER_FACTOR / 10000.f));
+        title << L"\n" << m_hideTextString;
+
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+    }
+    m_newTestSelected = false;
+
+}
+
+// aka 1.b from v1.0
+void TestPatterns::GenerateTestPattern_TenPercentPeakMAX(PatternCanvas* ctx) //**************** 1.MAX
+{
+    // MAX version uses 10,000 nits as peak
+    float nits = 10000.0f;		// max PQ value
+    float avg =   1000.0f;		// maxFALL
+
+	if (m_newTestSelected) {
+		SetMetadata(nits, avg, GAMUT_Native);
+		srand(314159);
+	}
+
+    float c = nitstoCCCS(nits);
+
+    ColorF peakBrush = ColorF(c, c, c);
+
+    auto logSize = ctx->GetLogicalSize();
+
+	PointF jitter = BeginJitter(ctx);
+
+    RectF tenPercentRect =
+    {
+		(logSize.right - logSize.left) * (0.5f - sqrtf(0.1) / 2.0f) + jitter.x,
+		(logSize.bottom - logSize.top) * (0.5f - sqrtf(0.1) / 2.0f) + jitter.y,
+		(logSize.right - logSize.left) * (0.5f + sqrtf(0.1) / 2.0f) + jitter.x,
+		(logSize.bottom - logSize.top) * (0.5f + sqrtf(0.1) / 2.0f) + jitter.y
+    };
+
+
+    ctx->FillRectangle(tenPercentRect, peakBrush);
+    EndJitter(ctx);
+
+    if (m_showExplanatoryText)
+    {
+		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top)*0.04f);	// 4% screen area colorimeter box
+		float2 center = float2(logSize.right*0.5f, logSize.bottom*0.5f);
+
+		EllipseF ellipse =
+		{
+			PointF(center.x, center.y),
+			fRad * 0.35f,						// TODO: make target diameter 27mm using DPI data
+			fRad * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red), 2 );
+
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+        title << L"1.b Peak Luminance MAX  10% Screen Area\nWait before taking measurements: ";
+        title << m_testTimeRemainingSec;
+        title << L" seconds remaining";
+        title << L"\nNits: ";
+        title << nits;
+        title << L"  HDR10: ";
+		title << setprecision(0);
+        title << PqCode<10>::Code(Apply2084(c*80.f / 10000.f));
+        title << L"\n" << m_hideTextString;
+
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+    m_newTestSelected = false;
+
+}
+
+void TestPatterns::GenerateTestPattern_FlashTest(PatternCanvas* ctx) //************************** 2.a
+{
+
+    // We "tone map" down to the maxLuminance reported by panel
+    float nits = m_outputDesc.MaxLuminance;
+    float avg = nits * 0.1f;
+    if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+    float c = nitstoCCCS(nits);
+
+    ColorF peakFFWhite, blackBrush;
+    peakFFWhite = ColorF(c, c, c);
+    blackBrush = ColorF(0.0f, 0.0f, 0.0f);
+
+    std::wstringstream title;
+	title << fixed << setw(8) << setprecision(2);
+
+    if (m_flashOn)
+    {
+        title << "2.a Flash Test On\n";
+        ctx->FillRectangle(ctx->GetLogicalSize(), peakFFWhite);
+    }
+    else
+    {
+        title << "2.a Flash Test Off\n";
+        ctx->FillRectangle(ctx->GetLogicalSize(), blackBrush);
+    }
+
+    if (m_showExplanatoryText)
+    {
+        // TODO make this show 10ths of a second.
+        title << static_cast<unsigned int>(m_testTimeRemainingSec);
+        title << L" seconds remaining\nTests peak power throughput rendering at reported peak level";
+        title << L"\nNits: ";
+        title << nits*BRIGHTNESS_SLIDER_FACTOR;
+        title << L"  HDR10: ";
+		title << setprecision(0);
+        title << PqCode<10>::Code(Apply2084(c*80.f * BRIGHTNESS_SLIDER_FACTOR / 10000.f));
+        title << L"\n" << m_hideTextString;
+
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect, m_flashOn);
+
+		PrintMetadata(ctx, m_flashOn);
+	}
+    m_newTestSelected = false;
+}
+
+void TestPatterns::GenerateTestPattern_FlashTestMAX(PatternCanvas* ctx) //********************* 2.MAX
+{
+    // MAX version shoots for 10,000 nits
+    float nits = 10000.0f;		// Max PQ Value
+    float avg  =  1000.0f;		// MaxFALL
+    if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+    float c = nitstoCCCS(nits);
+
+    ColorF peakFFWhite, blackBrush;
+    peakFFWhite = ColorF(c, c, c);
+    blackBrush = ColorF(0.0f, 0.0f, 0.0f);
+
+    std::wstringstream title;
+	title << fixed << setw(8) << setprecision(2);
+
+    if (m_flashOn)
+    {
+        title << "2.b MAX Flash Test On\n";
+        ctx->FillRectangle(ctx->GetLogicalSize(), peakFFWhite);
+    }
+    else
+    {
+        title << "2.b MAX Flash Test Off\n";
+        ctx->FillRectangle(ctx->GetLogicalSize(), blackBrush);
+    }
+
+    if (m_showExplanatoryText)
+    {
+        // TODO make this show 10ths of a second.
+        title << static_cast<unsigned int>(m_testTimeRemainingSec);
+        title << L" seconds remaining\nTests peak power throughput rendering MAX PQ";
+        title << L"\nNits: ";
+        title << nits;
+        title << L"  HDR10: ";
+		title << setprecision(0);
+        title << PqCode<10>::Code(Apply2084(c*80.f / 10000.f));
+        title << L"\n" << m_hideTextString;
+
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect, m_flashOn);
+
+		PrintMetadata(ctx, m_flashOn);
+	}
+    m_newTestSelected = false;
+
+}
+
+void TestPatterns::GenerateTestPattern_LongDurationWhite(PatternCanvas* ctx) //******************* 3.
+{
+    float nits = m_outputDesc.MaxLuminance;
+    float avg = nits;								// Full frame means 100% of Max.
+    if (m_newTestSelected)
+		SetMetadata(nits, avg, GAMUT_Native);		// Effectively same as calling SetMetadataNeutral();
+    float c = nitstoCCCS(nits);						// This test is for MaxFALL
+
+    ColorF peakFFWhite = ColorF(c, c, c);
+
+    ctx->FillRectangle(ctx->GetLogicalSize(), peakFFWhite);
+
+    if (m_showExplanatoryText)
+    {
+
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+        title << L"3.a Full-frame white for 30 minutes: ";
+        if (0.0f != m_testTimeRemainingSec)
+        {
+            title << static_cast<unsigned int>(m_testTimeRemainingSec);
+            title << L" seconds remaining\nTests cooling solution by rendering reported MaxFALL";
+            title << L"\nNits: ";
+            title << nits*BRIGHTNESS_SLIDER_FACTOR;
+            title << L"  HDR10: ";
+			title << setprecision(0);
+            title << PqCode<10>::Code(Apply2084(c*80.f*BRIGHTNESS_SLIDER_FACTOR / 10000.f));
+            title << L"\n" << m_hideTextString;
+        }
+        else
+        {
+            title << L" done.";
+        }
+
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect, true);
+		PrintMetadata(ctx, true);
+	}
+    m_newTestSelected = false;
+
+}
+
+void TestPatterns::GenerateTestPattern_FullFramePeak(PatternCanvas* ctx)	//******************** 3.MAX
+{
+    // Renders 10,000 nits. This is 125.0f in CCCS or 1023 HDR10 PQ.
+    float nits = 10000.0f;
+    float avg  = 10000.0f;   // full frame
+    if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+    float c = nitstoCCCS(nits)/BRIGHTNESS_SLIDER_FACTOR;
+
+    ColorF peakBrush = ColorF(c, c, c);
+
+    ctx->FillRectangle(ctx->GetLogicalSize(), peakBrush);
+
+    if (m_showExplanatoryText)
+    {
+
+        //	ColorF blackBrush;
+        //	blackBrush = ColorF(0.0f, 0.0f, 0.0f);
+        //	ctx->FillRectangle(m_testTitleRect, blackBrush);
+
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+        title << L"3.b Full-frame white for 30 minutes: ";
+        if (0.0f != m_testTimeRemainingSec)
+        {
+            title << static_cast<unsigned int>(m_testTimeRemainingSec);
+            title << L" seconds remaining";
+            title << L"\nRenders HDR10 max (10,000 nits)";
+            title << L"\nNits: ";
+            title << nits;
+            title << L"  HDR10: ";
+			title << setprecision(0);
+            title << PqCode<10>::Max;
+            title << L"\n" << m_hideTextString;
+        }
+        else
+        {
+            title << L" done.";
+        }
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true);
+	}
+    m_newTestSelected = false;
+
+}
+
+// Original 4-corner box test from v1.0
+void TestPatterns::GenerateTestPattern_BlackLevelHdrCorners(PatternCanvas* ctx) //**************** 4. legacy
+{
+	// Renders 10,000 nits. This is 125.0f CCCS or 1024 HDR10.
+	ColorF cornerBrush;
+
+	// Compute box intensity based on EDID
+	float nits = m_outputDesc.MaxLuminance; // set to value from EDID ("tone map")
+	if (nits > 600.0f)
+		nits = 600.0f;                      // clamp to max of 600.0 per spec (712)
+	if (nits < 400.0f)
+		nits = 400.0f;						// clamp to min of 400.0 per spec (668)
+
+	float avg = nits * 0.1f;                // 10% screen area
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+
+	float c = nitstoCCCS(nits);
+	cornerBrush = ColorF(c, c, c);
+
+	auto logSize = ctx->GetLogicalSize();
+	float fSize = sqrt(2.5f / 100.0f); // % screen area of each corner box
+
+	RectF upperLeftRect =
+	{
+		(logSize.right - logSize.left) * 0.0f,
+		(logSize.bottom - logSize.top) * 0.0f,
+		(logSize.right - logSize.left) * fSize,
+		(logSize.bottom - logSize.top) * fSize
+	};
+
+
+	RectF upperRightRect =
+	{
+		(logSize.right - logSize.left) * (1.0f - fSize),
+		(logSize.bottom - logSize.top) * 0.0f,
+		(logSize.right - logSize.left) * 1.0f,
+		(logSize.bottom - logSize.top) * fSize
+	};
+
+	RectF lowerLeftRect =
+	{
+		(logSize.right - logSize.left) * 0.0f,
+		(logSize.bottom - logSize.top) * (1.0f - fSize),
+		(logSize.right - logSize.left) * fSize,
+		(logSize.bottom - logSize.top) * 1.0f
+	};
+
+	RectF lowerRightRect =
+	{
+		(logSize.right - logSize.left) * (1.0f - fSize),
+		(logSize.bottom - logSize.top) * (1.0f - fSize),
+		(logSize.right - logSize.left) * 1.0f,
+		(logSize.bottom - logSize.top) * 1.0f
+	};
+
+	ctx->FillRectangle(upperLeftRect, cornerBrush);
+	ctx->FillRectangle(upperRightRect, cornerBrush);
+	ctx->FillRectangle(lowerLeftRect, cornerBrush);
+	ctx->FillRectangle(lowerRightRect, cornerBrush);
+
+	// Everything below this point should be hidden for actual measurements.
+	if (m_showExplanatoryText)
+	{
+		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top) * 0.04f);	// 4% screen area colorimeter box
+		float2 center = float2(logSize.right * 0.5f, logSize.bottom * 0.5f);
+
+		RectF centerRect =
+		{
+			center.x - fRad * 0.5f,
+			center.y - fRad * 0.5f,
+			center.x + fRad * 0.5f,
+			center.y + fRad * 0.5f
+		};
+		ctx->DrawRectangle(centerRect, ColorF(ColorF::White));
+#if 0
+		EllipseF ellipse =
+		{
+			PointF(center.x, center.y),
+			fRad * 0.5f,
+			fRad * 0.5f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+#endif
+
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"4. Corner test for HDR black level\nMeasure in the center box";
+		title << L"\nNits: ";
+		title << nits * BRIGHTNESS_SLIDER_FACTOR;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << PqCode<10>::Code(Apply2084(c * 80.f * BRIGHTNESS_SLIDER_FACTOR / 10000.f));
+		title << L"\n" << m_hideTextString;
+
+		// Shift title text to the right to avoid the corner.
+		RectF textRect = m_testTitleRect;
+		textRect.left = (logSize.right - logSize.left) * fSize;
+		RenderText(ctx, TextStyle::Large, title.str(), textRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+
+#if 1
+void TestPatterns::GenerateTestPattern_DualCornerBox(PatternCanvas* ctx)	//************************ 4.
+{
+	// Renders 10,000 nits. This is 125.0f CCCS or 1024 HDR10.
+	ColorF cornerBrush;
+
+	// Compute box intensity based on EDID
+	float nits = m_outputDesc.MaxLuminance; // set to value from EDID ("tone map")
+	float avg = nits * 0.1f;                // 10% screen area
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+
+	float c = nitstoCCCS(nits);
+	cornerBrush = ColorF(c, c, c);
+
+	auto logSize = ctx->GetLogicalSize();
+	float fSize = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top) * 0.05f);  // 5% screen area corner box
+	RectF upperRightRect =
+	{
+		logSize.right - fSize,
+		0.0f,
+		logSize.right,
+		fSize
+	};
+	ctx->FillRectangle(upperRightRect, cornerBrush);
+
+	RectF lowerLeftRect =
+	{
+		0.0f,
+		logSize.bottom - fSize,
+		fSize,
+		logSize.bottom
+	};
+	ctx->FillRectangle(lowerLeftRect, cornerBrush);
+
+	// Everything below this point should be hidden for actual measurements.
+	if (m_showExplanatoryText)
+	{
+		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top) * 0.04f);	// 4% screen area colorimeter box
+		float2 center = float2(logSize.right * 0.5f, logSize.bottom * 0.5f);
+
+		EllipseF ellipse =
+		{
+			PointF(center.x, center.y),
+			fRad * 0.35f,						// TODO: make target diameter 27mm using DPI data
+			fRad * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+
+
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"4. Corner test for Total Contrast\nMeasure in the center box";
+		title << L"\nNits: ";
+		title << nits * BRIGHTNESS_SLIDER_FACTOR;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << PqCode<10>::Code(Apply2084(c * 80.f * BRIGHTNESS_SLIDER_FACTOR / 10000.f));
+		title << L"\n" << m_hideTextString;
+
+		// Shift title text to the right to avoid the corner.
+		RectF textRect = m_testTitleRect;
+		RenderText(ctx, TextStyle::Large, title.str(), textRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+
+#else
+/* How this should work:
+	select PQ codes for test from CTS doc
+	convert to nits for metadata
+	convert to CCCS color for brush
+	be sure to scale this down so that brightness control has no effect.
+*/
+
+void TestPatterns::GenerateTestPattern_DualCornerBox(PatternCanvas* ctx)	//************************ 4.
+{
+	// from CTS doc
+	float PQCode = 668;
+	if (m_testingTier > TestingTier::DisplayHDR400)
+		PQCode =712;
+
+	float nits = PqCode<10>::Nits(PQCode);						// go to linear space
+
+	float avg = nits * 0.1f;                // 10% screen area
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+	// TODO: metadata needs to handle brightness slider factor
+
+	ColorF cornerBrush;
+	float c = nitstoCCCS(nits / BRIGHTNESS_SLIDER_FACTOR);		// scale by 80 and slider
+	cornerBrush = ColorF(c, c, c);
+
+	auto logSize = ctx->GetLogicalSize();
+	float fSize = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top)*0.05f );  // 5% screen area corner box
+	RectF upperRightRect =
+	{
+		logSize.right - fSize,
+		0.0f,
+		logSize.right,
+		fSize
+	};
+	ctx->FillRectangle(upperRightRect, cornerBrush);
+
+	RectF lowerLeftRect =
+	{
+		0.0f,
+		logSize.bottom - fSize,
+		fSize,
+		logSize.bottom
+	};
+	ctx->FillRectangle(lowerLeftRect, cornerBrush);
+
+	// Everything below this point should be hidden for actual measurements.
+	if (m_showExplanatoryText)
+	{
+		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top)*0.04f);	// 4% screen area colorimeter box
+		float2 center = float2(logSize.right*0.5f, logSize.bottom*0.5f);
+
+		EllipseF ellipse =
+		{
+			PointF(center.x, center.y),
+			fRad * 0.35f,						// TODO: make target diameter 27mm using DPI data
+			fRad * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+
+
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"4. Corner test for Total Contrast\nMeasure in the center box";
+		title << L"\nNits: ";
+		title << nits;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << PQCode;
+		title << L"\n" << m_hideTextString;
+
+		// Shift title text to the right to avoid the corner.
+		RectF textRect = m_testTitleRect;
+		RenderText(ctx, TextStyle::Large, title.str(), textRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+#endif
+
+void TestPatterns::GenerateTestPattern_StaticContrastRatio(PatternCanvas* ctx) //**************** 5.
+{
+	RectF logSize = ctx->GetLogicalSize();
+	ColorF whiteBrush;			// brush for the "white" color
+
+	float nits = m_outputDesc.MaxLuminance;             // for metadata
+	float avg = nits*0.50f;								// half of peak
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+
+	float color = nitstoCCCS(nits);
+	whiteBrush = ColorF(color, color, color);
+
+	// draw the "white" boxes on the black background
+	const int nCols = 6;
+	const int nRows = 4;
+	float2 step;
+	step.x = (logSize.right - logSize.left) / nCols;
+	step.y = (logSize.bottom - logSize.top) / nRows;
+	for (int jRow = 0; jRow < nRows; jRow++)
+	{
+		for (int iCol = 0; iCol < nCols; iCol++)
+		{
+			if ((iCol + jRow) & 0x01)
+			{
+				RectF rect =
+				{
+					iCol*step.x,
+					jRow*step.y,
+					(iCol+1)*step.x,
+					(jRow+1)*step.y
+				};
+				ctx->FillRectangle(rect, whiteBrush);
+			}
+		}
+	}
+
+	// Everything below this point should be hidden during actual measurements.
+	if (m_showExplanatoryText)
+	{
+		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top)*0.04f);	// 4% screen area colorimeter box
+		float2 center = float2( logSize.right*0.5f, logSize.bottom*0.5f );
+
+#if 0
+		RectF centerRect =
+		{
+			center.x - fRad * 0.5f,
+			center.y - fRad * 0.5f,
+			center.x + fRad * 0.5f,
+			center.y + fRad * 0.5f
+		};
+		ctx->DrawRectangle(centerRect, ColorF(ColorF::Red));
+#endif
+
+		EllipseF ellipse;
+		ellipse =
+		{
+			PointF(center.x + step.x*0.5f, center.y + step.y*0.5f),
+			step.y * 0.35f,											// TODO: make target diameter 27mm using DPI data
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red) );
+		ellipse =
+		{
+			PointF(center.x + step.x*0.5f, center.y - step.y*0.5f),
+			step.y * 0.35f,
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+		ellipse =
+		{
+			PointF(center.x - step.x*0.5f, center.y - step.y*0.5f),
+			step.y * 0.35f,
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+		ellipse =
+		{
+			PointF(center.x - step.x*0.5f, center.y + step.y*0.5f),
+			step.y * 0.35f,
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"5. Static Contrast Ratio\nMeasure black vs white";
+		title << L"\nNits: ";
+		title << nits*BRIGHTNESS_SLIDER_FACTOR;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << PqCode<10>::Code(Apply2084(color*80.f*BRIGHTNESS_SLIDER_FACTOR / 10000.f));
+		title << L"\n" << m_hideTextString;
+
+		RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect );
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+
+void TestPatterns::GenerateTestPattern_ActiveDimming(PatternCanvas* ctx)	//********************** 5.1
+{
+	RectF logSize = ctx->GetLogicalSize();
+	ColorF whiteBrush;			// brush for the "white" color
+
+	float nits = m_outputDesc.MaxLuminance;             // for metadata
+	float avg = nits * 0.50f;							// half of peak
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+
+	float HDR10 = m_activeDimming50PQValue;
+	nits = PqCode<10>::Nits((uint32_t)HDR10);			// "white" checker brightness
+
+	float c = m_pqCodes10.GetCCCS((uint32_t)HDR10);		// FP16 value that scans out as HDR10
+	whiteBrush = ColorF(c, c, c);
+
+	// draw the "white" boxes on the black background
+	const int nCols = 6;
+	const int nRows = 4;
+	float2 step;
+	step.x = (logSize.right - logSize.left) / nCols;
+	step.y = (logSize.bottom - logSize.top) / nRows;
+	for (int jRow = 0; jRow < nRows; jRow++)
+	{
+		for (int iCol = 0; iCol < nCols; iCol++)
+		{
+			if ((iCol + jRow) & 0x01)
+			{
+				RectF rect =
+				{
+					iCol*step.x,
+					jRow*step.y,
+					(iCol + 1)*step.x,
+					(jRow + 1)*step.y
+				};
+				ctx->FillRectangle(rect, whiteBrush);
+			}
+		}
+	}
+
+	// Everything below this point should be hidden during actual measurements.
+	if (m_showExplanatoryText)
+	{
+		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top)*0.04f);	// 4% screen area colorimeter box
+		float2 center = float2(logSize.right*0.5f, logSize.bottom*0.5f);
+
+#if 0
+		RectF centerRect =
+		{
+			center.x - fRad * 0.5f,
+			center.y - fRad * 0.5f,
+			center.x + fRad * 0.5f,
+			center.y + fRad * 0.5f
+		};
+		ctx->DrawRectangle(centerRect, ColorF(ColorF::Red));
+#endif
+
+		EllipseF ellipse;
+		ellipse =
+		{
+			PointF(center.x + step.x*0.5f, center.y + step.y*0.5f),
+			step.y * 0.35f,											// TODO: make target diameter 27mm using DPI data
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+		ellipse =
+		{
+			PointF(center.x + step.x*0.5f, center.y - step.y*0.5f),
+			step.y * 0.35f,
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+		ellipse =
+		{
+			PointF(center.x - step.x*0.5f, center.y - step.y*0.5f),
+			step.y * 0.35f,
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+		ellipse =
+		{
+			PointF(center.x - step.x*0.5f, center.y + step.y*0.5f),
+			step.y * 0.35f,
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"5.1 Active Dimming\nMeasure black vs white\n";
+		title << L"Nits: ";
+		title << nits;
+		title << L" Adjust using up/down arrows\n";
+		title << L"HDR10: ";
+		title << setprecision(0);
+		title << HDR10;
+		title << L"\n" << m_hideTextString;
+
+		RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+
+void TestPatterns::GenerateTestPattern_ActiveDimmingDark(PatternCanvas* ctx) //****************** 5.2
+{
+	RectF logSize = ctx->GetLogicalSize();
+	ColorF whiteBrush;			// brush for the "white" color
+
+	float nits = m_outputDesc.MaxLuminance;             // for metadata
+	float avg = nits * 0.50f;							// half of peak
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+
+	float HDR10 = m_activeDimming05PQValue;
+	nits = PqCode<10>::Nits((uint32_t)HDR10);
+
+	float c = m_pqCodes10.GetCCCS((uint32_t)HDR10);		// FP16 value that scans out as HDR10
+	whiteBrush = ColorF(c, c, c);
+
+	// draw the "white" boxes on the black background
+	const int nCols = 6;
+	const int nRows = 4;
+	float2 step;
+	step.x = (logSize.right - logSize.left) / nCols;
+	step.y = (logSize.bottom - logSize.top) / nRows;
+	for (int jRow = 0; jRow < nRows; jRow++)
+	{
+		for (int iCol = 0; iCol < nCols; iCol++)
+		{
+			if ((iCol + jRow) & 0x01)
+			{
+				RectF rect =
+				{
+					iCol*step.x,
+					jRow*step.y,
+					(iCol + 1)*step.x,
+					(jRow + 1)*step.y
+				};
+				ctx->FillRectangle(rect, whiteBrush);
+			}
+		}
+	}
+
+	// Everything below this point should be hidden during actual measurements.
+	if (m_showExplanatoryText)
+	{
+		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top)*0.04f);	// 4% screen area colorimeter box
+		float2 center = float2(logSize.right*0.5f, logSize.bottom*0.5f);
+
+#if 0
+		RectF centerRect =
+		{
+			center.x - fRad * 0.5f,
+			center.y - fRad * 0.5f,
+			center.x + fRad * 0.5f,
+			center.y + fRad * 0.5f
+		};
+		ctx->DrawRectangle(centerRect, ColorF(ColorF::Red));
+#endif
+
+		EllipseF ellipse;
+		ellipse =
+		{
+			PointF(center.x + step.x*0.5f, center.y + step.y*0.5f),
+			step.y * 0.35f,											// TODO: make target diameter 27mm using DPI data
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+		ellipse =
+		{
+			PointF(center.x + step.x*0.5f, center.y - step.y*0.5f),
+			step.y * 0.35f,
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+		ellipse =
+		{
+			PointF(center.x - step.x*0.5f, center.y - step.y*0.5f),
+			step.y * 0.35f,
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+		ellipse =
+		{
+			PointF(center.x - step.x*0.5f, center.y + step.y*0.5f),
+			step.y * 0.35f,
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(3);
+
+		title << L"5.2 Active Dimming Dark\nMeasure black vs white\n";
+		title << L"Nits: ";
+		title << nits;
+		title << L" Adjust using up/down arrows\n";
+		title << L"HDR10: ";
+		title << setprecision(0);
+		title << HDR10;
+		title << L"\n" << m_hideTextString;
+
+		RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+
+void TestPatterns::GenerateTestPattern_ActiveDimmingSplit(PatternCanvas* ctx) //***************** 5.3
+{
+	RectF logSize = ctx->GetLogicalSize();
+	ColorF whiteBrush;			// brush for the "white" color
+
+	float nits = m_outputDesc.MaxLuminance;             // for metadata
+	float avg = nits * 0.50f;							// half of peak
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+
+	nits = 50.0f;							// "white" checker brightness
+	float HDR10 = PqCode<10>::Code(Apply2084(nits / 10000.f));	// PQ code
+	float c = nitstoCCCS(nits)/BRIGHTNESS_SLIDER_FACTOR;
+	whiteBrush = ColorF(c, c, c);
+
+	// draw the "white" boxes on the black background
+	const int nCols = 6;
+	const int nRows = 4;
+	float2 step;
+	step.x = (logSize.right - logSize.left) / nCols;
+	step.y = (logSize.bottom - logSize.top) / nRows;
+	for (int jRow = 0; jRow < nRows; jRow++)
+	{
+		for (int iCol = 0; iCol < 3; iCol++)
+		{
+			if ((iCol + jRow) & 0x01)
+			{
+				RectF rect =
+				{
+					iCol*step.x,
+					jRow*step.y,
+					(iCol + 1)*step.x,
+					(jRow + 1)*step.y
+				};
+				ctx->FillRectangle(rect, whiteBrush);
+			}
+		}
+	}
+
+	nits = 5.0f;					       // less "white" checker brightness
+	HDR10 = PqCode<10>::Code(Apply2084(nits / 10000.f));	// PQ Code
+	c = nitstoCCCS(nits)/BRIGHTNESS_SLIDER_FACTOR;
+	whiteBrush = ColorF(c, c, c);
+
+	// draw the "white" boxes on the black background
+	step.x = (logSize.right - logSize.left) / nCols;
+	step.y = (logSize.bottom - logSize.top) / nRows;
+	for (int jRow = 0; jRow < nRows; jRow++)
+	{
+		for (int iCol = 3; iCol < nCols; iCol++)
+		{
+			if ((iCol + jRow) & 0x01)
+			{
+				RectF rect =
+				{
+					iCol*step.x,
+					jRow*step.y,
+					(iCol + 1)*step.x,
+					(jRow + 1)*step.y
+				};
+				ctx->FillRectangle(rect, whiteBrush);
+			}
+		}
+	}
+	// Everything below this point should be hidden during actual measurements.
+	if (m_showExplanatoryText)
+	{
+		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top)*0.04f);	// 4% screen area colorimeter box
+		float2 center = float2(logSize.right*0.5f, logSize.bottom*0.5f);
+
+#if 0
+		RectF centerRect =
+		{
+			center.x - fRad * 0.5f,
+			center.y - fRad * 0.5f,
+			center.x + fRad * 0.5f,
+			center.y + fRad * 0.5f
+		};
+		ctx->DrawRectangle(centerRect, ColorF(ColorF::Red));
+#endif
+
+		EllipseF ellipse;
+		ellipse =
+		{
+			PointF(center.x + step.x*0.5f, center.y + step.y*0.5f),
+			step.y * 0.35f,											// TODO: make target diameter 27mm using DPI data
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+		ellipse =
+		{
+			PointF(center.x + step.x*0.5f, center.y - step.y*0.5f),
+			step.y * 0.35f,
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+		ellipse =
+		{
+			PointF(center.x - step.x*0.5f, center.y - step.y*0.5f),
+			step.y * 0.35f,
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+		ellipse =
+		{
+			PointF(center.x - step.x*0.5f, center.y + step.y*0.5f),
+			step.y * 0.35f,
+			step.y * 0.35f
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red));
+
+		nits = 50.0f;		// either 50 or 5 should be displayed
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"5.3 Active Dimming Splitscreen\nMeasure black vs white\n";
+		title << L"Nits: ";
+		title << nits;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << HDR10;
+		title << L"\n" << m_hideTextString;
+ 
+		RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+	m_newTestSelected = false;
+
+}
+
+#define NUMBOXES 32
+void TestPatterns::GenerateTestPattern_BlackLevelSdrTunnel(PatternCanvas* ctx) //**************** 5. Original v1.0 Tunnel Test
+{
+	RectF logSize = ctx->GetLogicalSize();
+	float fBox, fBoxMin, fBoxMax, fBoxDelta;            // box dimension
+	fBoxMin = sqrt(4.0f / 100.0f);                      // 4% screen area of center box
+	fBoxMax = 1.f;
+	fBoxDelta = (fBoxMax - fBoxMin) / NUMBOXES;         // increment for each step
+
+	float nits = 96.0f;                                 // outer brightness
+	float avg = 26.0f;
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native); // average was computed by hand
+	float codeMax = 515;                                // outer border set at 96 nits
+
+	ColorF brushBox;              // brush for the current color
+	float codeDelta;
+	codeDelta = codeMax / NUMBOXES;
+
+    // standard pattern is 32 nested boxes
+    for (int i = 0; i < NUMBOXES; i++)
+    {
+        fBox = fBoxMax - fBoxDelta*i;
+        float code = codeMax - codeDelta*i;
+        float signal = PqCode<10>::Signal(code);
+        float3 vCode = float3(signal, signal, signal);
+        float3 C = HDR10ToLinear709(vCode);			  // aka c. Represented in CCCS
+
+        if (i >= (NUMBOXES - 1))
+            C = 0.0; // make sure center is black
+
+        RectF centerRect =
+        {
+            (logSize.right - logSize.left) * (0.5f - fBox*0.5f),
+            (logSize.bottom - logSize.top) * (0.5f - fBox*0.5f),
+            (logSize.right - logSize.left) * (0.5f + fBox*0.5f),
+            (logSize.bottom - logSize.top) * (0.5f + fBox*0.5f)
+        };
+
+        brushBox = ColorF(C.x, C.y, C.z);
+        ctx->FillRectangle(centerRect, brushBox);
+    }
+
+    // Everything below this point should be hidden during actual measurements.
+    if (m_showExplanatoryText)
+    {
+
+        // draw the white outline where the sensor goes
+        fBox = sqrt(4.0f / 100.0f);
+        RectF centerRect =
+        {
+            (logSize.right - logSize.left) * (0.5f - fBox*0.5f),
+            (logSize.bottom - logSize.top) * (0.5f - fBox*0.5f),
+            (logSize.right - logSize.left) * (0.5f + fBox*0.5f),
+            (logSize.bottom - logSize.top) * (0.5f + fBox*0.5f)
+        };
+        ctx->DrawRectangle(centerRect, ColorF(ColorF::White));
+
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+        title << L"5. Tunnel for SDR black level\nMeasure in the center box";
+        title << L"\nNits: ";
+        title << nits;
+        title << L"  HDR10: ";
+		title << setprecision(0);
+        title << codeMax;
+        title << L"\n" << m_hideTextString;
+
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true);
+	}
+    m_newTestSelected = false;
+
+}
+
+void TestPatterns::GenerateTestPattern_BlackLevelSdrTunnelTrueBlack(PatternCanvas* ctx) //******** 5. Legacy
+{
+	RectF logSize = ctx->GetLogicalSize();
+	float fBox, fBoxMin, fBoxMax, fBoxDelta;            // box dimension
+	fBoxMin = sqrt(4.0f / 100.0f);                      // 4% screen area of center box
+	fBoxMax = 1.f;
+	fBoxDelta = (fBoxMax - fBoxMin) / NUMBOXES;         // increment for each step
+
+	float nits = 80.0f;                                 // outer brightness
+	float avg = 68.0f;
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native); // average was computed by hand
+
+	ColorF brushBox;              // brush for the current color
+	unsigned int codeSet[14] = { 16, 32, 48, 64, 80, 97, 113, 129, 145, 161, 177, 193, 209, 225 };
+	float codeMax = 497;                                // outer border set at 96 nits
+	float code;
+
+	// standard pattern is 32 nested boxes
+	for (int i = 0; i < NUMBOXES; i++)
+	{
+		int ri = NUMBOXES - i - 1;				// reverse order
+		fBox = fBoxMax - fBoxDelta * i;
+		if (ri < 14)
+			code = (float) codeSet[ri];
+		else
+			code = codeMax;
+
+		float signal = PqCode<10>::Signal(code);
+		float3 vCode = float3(signal, signal, signal);
+		float3 C = HDR10ToLinear709(vCode);			  // aka c. Represented in CCCS
+
+		if (i >= (NUMBOXES - 1))
+			C = 0.0; // make sure center is black
+
+		RectF centerRect =
+		{
+			(logSize.right - logSize.left) * (0.5f - fBox * 0.5f),
+			(logSize.bottom - logSize.top) * (0.5f - fBox * 0.5f),
+			(logSize.right - logSize.left) * (0.5f + fBox * 0.5f),
+			(logSize.bottom - logSize.top) * (0.5f + fBox * 0.5f)
+		};
+
+		brushBox = ColorF(C.x, C.y, C.z);
+		ctx->FillRectangle(centerRect, brushBox);
+	}
+
+	// Everything below this point should be hidden during actual measurements.
+	if (m_showExplanatoryText)
+	{
+
+		// draw the red outline where the sensor goes
+		fBox = sqrt(4.0f / 100.0f);
+		RectF centerRect =
+		{
+			(logSize.right - logSize.left) * (0.5f - fBox * 0.5f),
+			(logSize.bottom - logSize.top) * (0.5f - fBox * 0.5f),
+			(logSize.right - logSize.left) * (0.5f + fBox * 0.5f),
+			(logSize.bottom - logSize.top) * (0.5f + fBox * 0.5f)
+		};
+		ctx->DrawRectangle(centerRect, ColorF(ColorF::Red));
+
+		EllipseF ellipse =
+		{
+			PointF(100.f, 100.f),
+			75.f,
+			50.f
+		};
+
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red) );
+
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+		title << L"5. Tunnel for SDR black level\nMeasure in the center box";
+		title << L"\nNits: ";
+		title << nits;
+		title << L"  HDR10: ";
+		title << setprecision(0);
+		title << codeMax;
+		title << L"\n" << m_hideTextString;
+
+		RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true);
+	}
+	m_newTestSelected = false;
+
+}
+
+/*
+std::wstring colorString(float3 color)
+{
+	std:wstring str[512];
+
+	wsprintf( str, );
+	float3 code = Linear709ToHDR10(code)*PqCode<10>::Scale;	// convert to HDR10
+	int wHDR10r = (int)roundf(code.r);
+	int wHDR10g = (int)roundf(code.g);
+	int wHDR10b = (int)roundf(code.b);
+
+	return str;
+}
+*/
+
+float3 roundf3(float3 in)
+{
+	float3 out;
+	if (in.x < 0) in.x = 0;
+	if (in.y < 0) in.y = 0;
+	if (in.z < 0) in.z = 0;
+
+	out.x = roundf(in.x);
+	out.y = roundf(in.y);
+	out.z = roundf(in.z);
+	return out;
+}
+
+// Test Pattern 6.
+void TestPatterns::GenerateTestPattern_ColorPatches			//******************************************* 6.
+(
+	PatternCanvas* ctx,
+	float OPR										// On-Pixel-Ratio	% of screen to cover
+)
+{
+	float nits;										// Equivalent brightness (for white)
+	nits = m_outputDesc.MaxLuminance;				// for 10% OPR case
+
+	bool blackText = true;
+	if (OPR < 0.9f)
+		blackText = false;
+
+    if (m_newTestSelected)
+	{
+		SetMetadata(nits, nits*OPR, GAMUT_Native);	// max and average
+		srand(318179);								// seed the jitter
+	}
+    // Patch colors for the panel's reported primaries, from UpdatePanelColorModel().
+    const wchar_t* patchNames[PanelColorModel::PatchCount] =
+    {
+        L"Red Chromaticity Point", L"Green Chromaticity Point", L"Blue Chromaticity Point", L"White Point"
+    };
+    const PanelPatch& patch = m_panelColorModel.GetPatch(m_currentColor);
+
+    std::wstringstream title;
+	title << fixed << setw(8) << setprecision(2);
+
+    title << L"6. Checking ";	// show test number
+
+	float fSize = sqrt(OPR);
+	RectF logSize = ctx->GetLogicalSize();
+
+	PointF jitter = BeginJitter(ctx, OPR <= 0.99);
+
+	RectF centerRect =
+	{
+		(logSize.right - logSize.left) * (0.5f - fSize * 0.5f) + jitter.x,
+		(logSize.bottom - logSize.top) * (0.5f - fSize * 0.5f) + jitter.y,
+		(logSize.right - logSize.left) * (0.5f + fSize * 0.5f) + jitter.x,
+		(logSize.bottom - logSize.top) * (0.5f + fSize * 0.5f) + jitter.y
+	};
+
+    ctx->FillRectangle(centerRect, ColorF(patch.cccs.r, patch.cccs.g, patch.cccs.b));
+    title << patchNames[m_currentColor] << L"\n xy:    ";
+    title << setprecision(5) << patch.xy.x << ", " << patch.xy.y << "\n";
+    title << L"CCCS:  ";
+    title << setprecision(3) << patch.cccs.r << ", " << patch.cccs.g << ", " << patch.cccs.b << "\n";
+    title << L"HDR10: ";
+    title << setprecision(0) << patch.displayCode.r << ", " << patch.displayCode.g << ", " << patch.displayCode.b;
+
+	// Draw outline/borders to track clipped limit (like old v1.0 color 6.B test)
+    if (m_showExplanatoryText)
+		ctx->DrawRectangle(centerRect, ColorF(patch.outlineCCCS.r, patch.outlineCCCS.g, patch.outlineCCCS.b), 12);
+	EndJitter(ctx);
+
+    if (m_showExplanatoryText)
+    {
+		title << L"\nUp & Down arrow keys rotate between RGBW colors\n";
+
+		RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect, blackText);
+
+		PrintMetadata(ctx, blackText);
+
+	}
+    m_newTestSelected = false;
+
+}
+
+void TestPatterns::GenerateTestPattern_ColorPatches709(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();    // This simulates desktop content where default metadata is used.
+
+    // Overload the color selector to allow selecting the desired SDR white level.
+    if (m_currentColor < 0 || m_currentColor > 3)
+        throw std::invalid_argument("Invalid color selection");
+    float nits = PanelColorModel::GetSdrWhiteLevel(m_currentColor);
+    float level = m_panelColorModel.GetSdrWhiteCCCS(m_currentColor);
+
+    ColorF redBrush, greenBrush, blueBrush;
+
+    // Generating the colors is trivial since 709 primaries == CCCS primaries and we are emulating
+    // SDR boost which simply scales RGB colors linearly.
+    redBrush = ColorF(level, 0.0f, 0.0f);
+    greenBrush = ColorF(0.0f, level, 0.0f);
+    blueBrush = ColorF(0.0f, 0.0f, level);
+
+    auto full = ctx->GetLogicalSize();
+    // Divide screen into thirds.
+    // RectF: Left, Top, Right, Bottom
+    RectF redRect   = { full.left, (full.bottom - full.top) * 0.0f / 3.0f , full.right, (full.bottom - full.top) * 1.0f / 3.0f };
+    RectF greenRect = { full.left, (full.bottom - full.top) * 1.0f / 3.0f , full.right, (full.bottom - full.top) * 2.0f / 3.0f };
+    RectF blueRect  = { full.left, (full.bottom - full.top) * 2.0f / 3.0f , full.right, (full.bottom - full.top) * 3.0f / 3.0f };
+
+    ctx->FillRectangle(redRect, redBrush);
+    ctx->FillRectangle(greenRect, greenBrush);
+    ctx->FillRectangle(blueRect, blueBrush);
+
+    if (m_showExplanatoryText)
+    {
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+        title << L"709 primaries\nUsing reference level of: " << nits;
+        title << " nits.\nUp & Down arrow keys select white level.\n";
+
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true);
+	}
+
+    m_newTestSelected = false;
+}
+
+// aka 6.b from v1.0
+void TestPatterns::GenerateTestPattern_ColorPatchesMAX(PatternCanvas* ctx, float OPR) // *******6.MAX
+{
+    // BT.2020 primaries at a fixed PQ code, from UpdatePanelColorModel().
+    const wchar_t* patchNames[PanelColorModel::PatchCount] =
+    {
+        L"Red Chromaticity Point", L"Green Chromaticity Point", L"Blue Chromaticity Point", L"White Point"
+    };
+    const PanelPatch& patch = m_panelColorModel.GetMaxPatch(m_currentColor);
+
+ // const float nits = 300.0f;								// white level should be 300 cd/m2
+	const float nits = m_outputDesc.MaxLuminance;			// set to value from EDID 10% peak
+    if (m_newTestSelected) SetMetadata(nits, nits*OPR, GAMUT_BT2100); // max and average are same for full screen
+
+    std::wstringstream title;
+	title << fixed << setw(8) << setprecision(2);
+
+    title << L"6.b Checking ";	// show test number
+
+	float fSize = sqrt(OPR);
+	RectF logSize = ctx->GetLogicalSize();
+	RectF centerRect =
+	{
+		(logSize.right - logSize.left) * (0.5f - fSize * 0.5f),
+		(logSize.bottom - logSize.top) * (0.5f - fSize * 0.5f),
+		(logSize.right - logSize.left) * (0.5f + fSize * 0.5f),
+		(logSize.bottom - logSize.top) * (0.5f + fSize * 0.5f)
+	};
+
+    const float3& C = patch.cccs;
+    const float3& HDR10 = patch.displayCode;
+    ctx->FillRectangle(centerRect, ColorF(C.r, C.g, C.b));
+    title << patchNames[m_currentColor] << L"\n xy: ";
+    title << std::to_wstring(patch.xy.x) << ", " << std::to_wstring(patch.xy.y);
+    title << (m_currentColor == PanelColorModel::White ? L"\nCCCS:    " : L"\n");
+    title << std::to_wstring(C.r) << ", " << std::to_wstring(C.g) << ", " << std::to_wstring(C.b);
+    title << (m_currentColor == PanelColorModel::White ? L"\nHDR10: " : L"\n");
+    title << std::to_wstring((int)HDR10.r) << ", " << std::to_wstring((int)HDR10.g) << ", " << std::to_wstring((int)HDR10.b);
+
+    if (m_showExplanatoryText)
+    {
+        title << L"\nUp & Down arrow keys rotate between RGBW colors\n";
+
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true);
+	}
+    m_newTestSelected = false;
+
+}
+
+
+#if 0
+void TestPatterns::GenerateTestPattern_ColorPatches(PatternCanvas* ctx)
+{
+    // Create colors for 50% sRGB, 100% sRGB, DCI-P3, and Rec. 2020.
+    ColorF red50, redSrgb, redP3, red2020;
+    ColorF green50, greenSrgb, greenP3, green2020;
+    ColorF blue50, blueSrgb, blueP3, blue2020;
+
+    // CCCS values are reverse engineered from FV2 tool test patterns.
+    red50 = ColorF( 0.994f,  0.498f,  0.515f);
+    redSrgb = ColorF( 1.000f,  0.000f,  0.000f);
+    redP3 = ColorF( 1.132f, -0.039f, -0.017f);
+    red2020 = ColorF( 3.172f, -0.234f, -0.033f);
+
+    green50 = ColorF( 0.522f,  0.989f,  0.513f);
+    greenSrgb = ColorF( 0.000f,  1.000f,  0.000f);
+    greenP3 = ColorF(-0.221f,  1.062f, -0.079f);
+    green2020 = ColorF(-0.433f,  0.822f, -0.074f);
+
+    blue50 = ColorF( 0.512f,  0.493f,  1.000f);
+    blueSrgb = ColorF( 0.000f,  0.000f,  1.000f);
+    blueP3 = ColorF( 0.000f,  0.000f,  1.000f);
+    blue2020 = ColorF(-0.609f, -0.065f,  9.297f);
+
+    // Divide pattern in a 3x4 grid.
+    auto rect = ctx->GetLogicalSize();
+    auto w = (rect.right - rect.left) / 4.0f;
+    auto h = (rect.bottom - rect.top) / 3.0f;
+    auto w1 = w * 0.2f; // Left/top edge of each patch offset.
+    auto h1 = h * 0.2f;
+    auto w2 = w * 0.8f; // Right/bottom edge of each patch offset.
+    auto h2 = h * 0.8f;
+
+    ctx->FillRectangle(RectF(w * 0.0f + w1, h * 0.0f + h1, w * 0.0f + w2, h * 0.0f + h2), red50);
+    ctx->FillRectangle(RectF(w * 1.0f + w1, h * 0.0f + h1, w * 1.0f + w2, h * 0.0f + h2), redSrgb);
+    ctx->FillRectangle(RectF(w * 2.0f + w1, h * 0.0f + h1, w * 2.0f + w2, h * 0.0f + h2), redP3);
+    // TODO: Unsure if the Rec. 2020 colors are indeed correct. Double check and add them back.
+    //ctx->FillRectangle(RectF(w * 3.0f + w1, h * 0.0f + h1, w * 3.0f + w2, h * 0.0f + h2), red2020);
+    ctx->FillRectangle(RectF(w * 0.0f + w1, h * 1.0f + h1, w * 0.0f + w2, h * 1.0f + h2), green50);
+    ctx->FillRectangle(RectF(w * 1.0f + w1, h * 1.0f + h1, w * 1.0f + w2, h * 1.0f + h2), greenSrgb);
+    ctx->FillRectangle(RectF(w * 2.0f + w1, h * 1.0f + h1, w * 2.0f + w2, h * 1.0f + h2), greenP3);
+    //ctx->FillRectangle(RectF(w * 3.0f + w1, h * 1.0f + h1, w * 3.0f + w2, h * 1.0f + h2), green2020);
+    ctx->FillRectangle(RectF(w * 0.0f + w1, h * 2.0f + h1, w * 0.0f + w2, h * 2.0f + h2), blue50);
+    ctx->FillRectangle(RectF(w * 1.0f + w1, h * 2.0f + h1, w * 1.0f + w2, h * 2.0f + h2), blueSrgb);
+    ctx->FillRectangle(RectF(w * 2.0f + w1, h * 2.0f + h1, w * 2.0f + w2, h * 2.0f + h2), blueP3);
+    //ctx->FillRectangle(RectF(w * 3.0f + w1, h * 2.0f + h1, w * 3.0f + w2, h * 2.0f + h2), blue2020);
+
+    // Everything below this point should be hidden for actual measurements.
+    if (!m_showExplanatoryText)
+    {
+        return;
+    }
+
+    RenderText(ctx, TextStyle::Small, L"Red: 50% sRGB   ", { w * 0.0f + w1, h * 1.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, TextStyle::Small, L"Red: 100% sRGB  ", { w * 1.0f + w1, h * 1.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, TextStyle::Small, L"Red: DCI-P3     ", { w * 2.0f + w1, h * 1.0f - h1 / 1.0f, 200.0f, 30.0f });
+    //RenderText(ctx, TextStyle::Small, L"Red: Rec. 2020  ", { w * 3.0f + w1, h * 1.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, TextStyle::Small, L"Green: 50% sRGB ", { w * 0.0f + w1, h * 2.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, TextStyle::Small, L"Green: 100% sRGB", { w * 1.0f + w1, h * 2.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, TextStyle::Small, L"Green: DCI-P3   ", { w * 2.0f + w1, h * 2.0f - h1 / 1.0f, 200.0f, 30.0f });
+    //RenderText(ctx, TextStyle::Small, L"Green: Rec. 2020", { w * 3.0f + w1, h * 2.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, TextStyle::Small, L"Blue: 50% sRGB  ", { w * 0.0f + w1, h * 3.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, TextStyle::Small, L"Blue: 100% sRGB ", { w * 1.0f + w1, h * 3.0f - h1 / 1.0f, 200.0f, 30.0f });
+    RenderText(ctx, TextStyle::Small, L"Blue: DCI-P3    ", { w * 2.0f + w1, h * 3.0f - h1 / 1.0f, 200.0f, 30.0f });
+    //RenderText(ctx, TextStyle::Small, L"Blue: Rec. 2020 ", { w * 3.0f + w1, h * 3.0f - h1 / 1.0f, 200.0f, 30.0f });
+
+    std::wstring text = L"RGB color patches\n" << m_hideTextString;
+    RenderText(ctx, TextStyle::Large, text, m_testTitleRect);
+}
+#endif
+
+void TestPatterns::GenerateTestPattern_BitDepthPrecision(PatternCanvas* ctx) //******************* 7.
+{
+    if (m_newTestSelected)
+		SetMetadata( m_outputDesc.MaxLuminance, 2.0f, GAMUT_Native);
+
+    // TODO: merge into common effect test pattern generator.
+    auto rsc = m_testPatternResources[TestPattern::BitDepthPrecision];
+
+    std::wstringstream title;
+    auto rect = ctx->GetOutputSize();
+
+    EffectConstants constants = {};
+    constants.outputSize = PointF((float)rect.right - rect.left, (float)rect.bottom - rect.top);
+
+    if (!ctx->DrawEffect(rsc.effect, constants))
+    {
+        title << L"\nERROR: BandedGradientEffect.cso is missing\n";
+    }
+
+    // Everything below this point should be hidden for actual measurements.
+    if (m_showExplanatoryText)
+    {
+        title << rsc.testTitle << L"\n" << m_hideTextString;
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect);
+
+        // Text labels are manually aligned with offsets from BandedGradientEffect.hlsl
+
+        RectF text10Rect = { 0.0f, (rect.bottom - rect.top) * 0.1f, 300.0f, 50.0f };
+        RectF text30Rect = { 0.0f, (rect.bottom - rect.top) * 0.3f, 300.0f, 50.0f };
+        RectF text50Rect = { 0.0f, (rect.bottom - rect.top) * 0.5f, 300.0f, 50.0f };
+        RectF text70Rect = { 0.0f, (rect.bottom - rect.top) * 0.7f, 300.0f, 50.0f };
+        RectF text90Rect = { 0.0f, (rect.bottom - rect.top) * 0.9f, 300.0f, 50.0f };
+
+        RenderText(ctx, TextStyle::Large, L"6-bit quantization", text10Rect);
+        RenderText(ctx, TextStyle::Large, L"Display-native", text30Rect);
+        //	RenderText(ctx, TextStyle::Large, L"6+2 dither 2x2",		text30Rect);
+        RenderText(ctx, TextStyle::Large, L"8-bit quantization", text50Rect);
+        RenderText(ctx, TextStyle::Large, L"Display-native", text70Rect);
+        RenderText(ctx, TextStyle::Large, L"10-bit quantization", text90Rect);
+
+		PrintMetadata(ctx);
+	}
+
+    m_newTestSelected = false;
+}
+
+void TestPatterns::GenerateTestPattern_RiseFallTime(PatternCanvas* ctx) //************************ 8.
+{
+//  "tone map" PQ limit of 10k nits down to panel maxLuminance in CCCS
+//  float nits = m_outputDesc.MaxLuminance;
+//	float avg = nits * 0.1f; // 10% screen area
+	float nits = m_outputDesc.MaxLuminance;
+	float avg = m_outputDesc.MaxLuminance*0.10f;
+	if (m_newTestSelected) SetMetadata(nits, avg, GAMUT_Native);
+    float c = nitstoCCCS( nits );
+
+    ColorF peakBrush = ColorF(c, c, c);
+
+    auto logSize = ctx->GetLogicalSize();
+    RectF tenPercentRect =
+    {
+        (logSize.right - logSize.left) * (0.5f - sqrtf(0.1) / 2.0f),
+        (logSize.bottom - logSize.top) * (0.5f - sqrtf(0.1) / 2.0f),
+        (logSize.right - logSize.left) * (0.5f + sqrtf(0.1) / 2.0f),
+        (logSize.bottom - logSize.top) * (0.5f + sqrtf(0.1) / 2.0f)
+    };
+
+    if (m_flashOn)
+        ctx->FillRectangle(tenPercentRect, peakBrush);
+
+    if (m_showExplanatoryText)
+    {
+
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+
+        title << L"8. Rise/Fall Time";
+        title << L"\nNits: ";
+        title << nits*BRIGHTNESS_SLIDER_FACTOR;
+        title << L"  HDR10: ";
+		title << setprecision(0);
+        title << PqCode<10>::Code(Apply2084(c*80.f*BRIGHTNESS_SLIDER_FACTOR / 10000.f));
+        title << L"\n";
+        title << m_testTimeRemainingSec;
+        title << L" seconds remaining";
+        title << L"\n" << m_hideTextString;
+
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+    m_newTestSelected = false;
+}
+
+void TestPatterns::GenerateTestPattern_ProfileCurve(PatternCanvas* ctx)  //*********************** 9.
+{
+#define NPQCODES 44
+	uint PQCodes[NPQCODES] =
+	{
+		1023,
+		0,
+		8,
+		16,
+		24,
+		36,
+		48,
+		56,
+		64,
+		120,
+		156,
+		256,
+		340,
+		384,
+		452,
+		488,
+		520,
+		592,
+		616,
+		636,
+		660,
+		664,
+		668,
+		692,
+		704,
+		708,
+		712,
+		728,
+		744,
+		756,
+		760,
+		764,
+		768,
+		788,
+		804,
+		808,
+		812,
+		828,
+		840,
+		844,
+		872,
+		892,
+		920,
+		1023
+	};
+
+	if (m_newTestSelected)
+	{
+		SetMetadata( m_outputDesc.MaxLuminance, m_outputDesc.MaxLuminance*0.10f, GAMUT_Native );
+		srand(318179);								// seed the jitter
+	}
+
+	// find the brightest tile we need to test on this panel
+	for (int i = 3; i < NPQCODES; i++)
+	{
+		m_maxProfileTile = i;
+		if (PQCodes[i] > m_maxPQCode)
+			break;
+	}
+	// get current intensity value to display on tile
+	unsigned int PQCode = PQCodes[m_currentProfileTile];
+	if (PQCode > m_maxPQCode) PQCode = m_maxPQCode;				// clamp to max reported possible
+
+	float nits = PqCode<10>::Nits(PQCode);						// go to linear space
+	float c = m_pqCodes10.GetCCCS(PQCode);						// FP16 value that scans out as PQCode
+
+	ColorF peakBrush = ColorF(c, c, c);
+
+	auto logSize = ctx->GetLogicalSize();
+
+	PointF jitter = BeginJitter(ctx);
+
+	RectF tenPercentRect =
+	{
+		(logSize.right - logSize.left) * (0.5f - sqrtf(0.1) / 2.0f) + jitter.x,
+		(logSize.bottom - logSize.top) * (0.5f - sqrtf(0.1) / 2.0f) + jitter.y,
+		(logSize.right - logSize.left) * (0.5f + sqrtf(0.1) / 2.0f) + jitter.x,
+		(logSize.bottom - logSize.top) * (0.5f + sqrtf(0.1) / 2.0f) + jitter.y
+	};
+	ctx->FillRectangle(tenPercentRect, peakBrush);
+	EndJitter(ctx);
+
+	uint32_t PQcheck = ScanoutPQCode(c, BRIGHTNESS_SLIDER_FACTOR, 10);
+
+	if (m_showExplanatoryText)
+	{
+		float fRad = sqrt((logSize.right - logSize.left) * (logSize.bottom - logSize.top) * 0.04f);	// 4% screen area colorimeter box
+		float2 center = float2(logSize.right * 0.5f, logSize.bottom * 0.5f);
+
+		EllipseF ellipse =
+		{
+			PointF(center.x, center.y),
+			fRad * 0.35f,						// TODO: make target diameter 27mm using DPI data
+			fRad * 0.35f
+		};
+
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red), 1 );
+
+		std::wstringstream title;
+		title << fixed << setw(8) << setprecision(0);
+
+		title << L"9. Validating 2084 Profile Curve in nits\n";
+		title << L"Subtest#: ";
+		title << m_currentProfileTile;
+		title << L"   HDR10: ";
+		title << PQCode;
+		title << L"   Nits: ";
+		title << setprecision(4) << nits;
+//		title << L"   HDR10b: ";
+//		title << PQcheck;		// echo input to validate precision
+		title << L"\n";
+		title << m_hideTextString;
+
+		RenderText( ctx, TextStyle::Large, title.str(), m_testTitleRect );
+
+		PrintMetadata(ctx);
+	}
+
+#if 0
+	std::wstringstream title;
+	title << L"3.b Full-frame white for 30 minutes: ";
+	if (0.0f != m_testTimeRemainingSec)
+	{
+		title << static_cast<unsigned int>(m_testTimeRemainingSec);
+		title << L" seconds remaining";
+		title << L"\nRenders HDR10 max (10,000 nits)";
+		title << L"\nNits: ";
+		title << nits;
+		title << L"  HDR10: ";
+		title << static_cast<unsigned int>(PqCode<10>::Code(Apply2084(c*80.f / 10000.f)));
+		title << L"\n" << m_hideTextString;
+	}
+	else
+	{
+		title << L" done.";
+	}
+	RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect, true);
+#endif
+	m_newTestSelected = false;
+
+}
+
+void TestPatterns::GenerateTestPattern_EndOfMandatoryTests(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    std::wstringstream text;
+    text << L"This is the end of mandatory test content.\n";
+    text << L"Optional/informative tests follow.";
+
+    RenderText(ctx, TextStyle::Large, text.str(), m_largeTextRect);
+    m_newTestSelected = false;
+}
+
+void TestPatterns::GenerateTestPattern_SharpeningFilter(PatternCanvas* ctx)
+{
+	auto rsc = m_testPatternResources[TestPattern::SharpeningFilter];
+
+	// Overload the color selector to allow selecting the desired SDR white level.
+	float nits = 80.0f;
+	switch (m_currentColor)
+	{
+	case 0:
+		nits = 80.0f;
+		break;
+	case 1:
+		nits = 160.0f;
+		break;
+	case 2:
+		nits = 240.0f;
+		break;
+	case 3:
+		nits = 320.0f;
+		break;
+	default:
+		throw std::invalid_argument("Invalid color selection");
+		break;
+	}
+	if (m_newTestSelected)
+		SetMetadata(m_outputDesc.MaxLuminance, nits * 0.50f, GAMUT_Native); SetMetadataNeutral();
+
+	std::wstringstream title;
+
+	// TODO: Convert to a generalized custom effect pipeline.
+	auto out = ctx->GetOutputSize();
+
+	EffectConstants constants = {};
+	constants.center = PointF((out.right - out.left) / 2.0f, (out.bottom - out.top) / 2.0f);
+
+	// Initial wavelength of sine wave at the centerpoint.
+	constants.initialWavelength = 30.0f;
+
+	// How many pixels before the wavelength halves.
+	constants.wavelengthHalvingDistance = (out.right - out.left) / 4.0f;
+
+	constants.whiteLevelMultiplier = nitstoCCCS(nits);
+
+	if (!ctx->DrawEffect(rsc.effect, constants))
+	{
+		title << L"\nERROR: " << rsc.effectShaderFilename << L" is missing\n";
+	}
+
+	if (m_showExplanatoryText)
+	{
+		ColorF blackBrush = ColorF(0.0f, 0.0f, 0.0f);
+		ctx->FillRectangle(m_testTitleRect, blackBrush);
+		title << fixed << setw(8) << setprecision(2);
+		title << rsc.testTitle << "\nUsing reference level of : " << nits;
+		title << " nits.\nUp & Down arrow keys select white level.\n";
+		RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+
+	m_newTestSelected = false;
+}
+
+void TestPatterns::GenerateTestPattern_ToneMapSpike(PatternCanvas* ctx)
+{
+    auto rsc = m_testPatternResources[TestPattern::ToneMapSpike];
+
+    // Overload the color selector to set the level we tone map the content to
+    float nits = 80.0f;
+    switch (m_currentColor)
+    {
+    case 0:
+//		nits = m_outputDesc.MaxLuminance;
+		nits = 350.0f;
+		SetMetadata(nits, nits*0.1f, GAMUT_Native);
+        break;
+    case 1:
+        nits = 700.0f;
+		SetMetadata(nits, nits * 0.1f, GAMUT_Native);
+		break;
+    case 2:
+        nits = 1015.0f;
+		SetMetadata(nits, nits * 0.1f, GAMUT_Native);
+		break;
+    case 3:
+        nits = 10000.0f;
+		SetMetadata(nits, nits * 0.1f, GAMUT_Native);
+        break;
+    default:
+        throw std::invalid_argument("Invalid color selection");
+        break;
+    }
+//	if (m_newTestSelected)
+//		SetMetadata(m_outputDesc.MaxLuminance, nits*0.50f, GAMUT_Native); SetMetadataNeutral();
+
+    std::wstringstream title;
+
+    // TODO: Convert to a generalized custom effect pipeline.
+	PointF center;
+	center.x = 640.f;
+	center.y = 360.f;
+
+	auto out = ctx->GetOutputSize();
+
+	EffectConstants constants = {};
+	constants.center = PointF((out.right - out.left) / 2.0f, (out.bottom - out.top) / 2.0f);
+
+	// Initial wavelength of sine wave at the centerpoint.
+	constants.initialWavelength = 30.0f;
+
+	// How many pixels before the wavelength halves.
+	constants.wavelengthHalvingDistance = (out.right - out.left) / 4.0f;
+
+	constants.whiteLevelMultiplier = nits;
+
+	if (!ctx->DrawEffect(rsc.effect, constants))
+    {
+        title << L"\nERROR: " << rsc.effectShaderFilename << L" is missing\n";
+    }
+    else
+    {
+        center = constants.center;
+    }
+
+    if (m_showExplanatoryText)
+    {
+		auto logSize = ctx->GetLogicalSize();
+
+		float fRad = sqrtf(center.x * center.y *4.0f / M_PI_F);	// 100% screen area circle
+		EllipseF ellipse =
+		{
+			center, fRad, fRad
+		};
+		ctx->DrawEllipse(ellipse, ColorF(ColorF::Red), 1);
+
+		float OPR = 0.10f;									// 10% screen area for maxLuminance
+		float fR = fRad * sqrt(OPR);
+		EllipseF ellipse10 =
+		{
+			center, fR, fR
+		};
+		ctx->DrawEllipse(ellipse10, ColorF(ColorF::Red), 2);
+
+		OPR = 0.0001f;									// 0.01% screen area for sun (noise rejection  limit)
+		fR = fRad * sqrt(OPR);
+		EllipseF ellipse0001 =
+		{
+			center, fR, fR
+		};
+		ctx->DrawEllipse(ellipse0001, ColorF(ColorF::Red), 3);
+		
+		ColorF blackBrush = ColorF(0.0f, 0.0f, 0.0f);
+        ctx->FillRectangle(m_testTitleRect, blackBrush);
+		title << fixed << setw(8) << setprecision(0);
+        title << rsc.testTitle << "\nTone Mapping to : "  << nits;
+        title << " nits.\nUp & Down arrow keys select level.\n";
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+
+    m_newTestSelected = false;
+}
+
+void TestPatterns::GenerateTestPattern_StaticGradient(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    // TODO: All of the gradients share the below 2 lines.
+    auto rect = ctx->GetLogicalSize();
+    ctx->FillLinearGradient(rect, PointF(0, 0), PointF(rect.right, 0), m_gradientStops, 2);
+
+    // Everything below this point should be hidden for actual measurements.
+    if (m_showExplanatoryText)
+    {
+
+        std::wstringstream text;
+        text << L"Static Gradient: R(" << to_string_with_precision(m_gradientColor.r)
+            << L") G(" << to_string_with_precision(m_gradientColor.g)
+            << L") B(" << to_string_with_precision(m_gradientColor.b)
+            << L")\n";
+        text << L"A/S: increment gradient color\n" << m_hideTextString;
+
+        RenderText(ctx, TextStyle::Large, text.str(), m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+    m_newTestSelected = false;
+
+}
+
+void TestPatterns::GenerateTestPattern_AnimatedGrayGradient(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    // TODO: All of the gradients share the below 2 lines.
+    auto rect = ctx->GetLogicalSize();
+    ctx->FillLinearGradient(rect, PointF(0, 0), PointF(rect.right, 0), m_gradientStops, 2);
+
+    // Everything below this point should be hidden for actual measurements.
+    if (m_showExplanatoryText)
+    {
+
+        std::wstring text = L"Animated Gray Gradient\n" + m_hideTextString;
+        RenderText(ctx, TextStyle::Large, text, m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+    m_newTestSelected = false;
+
+}
+
+void TestPatterns::GenerateTestPattern_AnimatedColorGradient(PatternCanvas* ctx)
+{
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    // TODO: All of the gradients share the below 2 lines.
+    auto rect = ctx->GetLogicalSize();
+    ctx->FillLinearGradient(rect, PointF(0, 0), PointF(rect.right, 0), m_gradientStops, 2);
+
+    // Everything below this point should be hidden for actual measurements.
+    if (m_showExplanatoryText)
+    {
+
+        std::wstring text = L"Animated Color Gradient\n" + m_hideTextString;
+        RenderText(ctx, TextStyle::Large, text, m_testTitleRect);
+
+		PrintMetadata(ctx);
+	}
+    m_newTestSelected = false;
+
+}
+
+void TestPatterns::GenerateTestPattern_FullFrameSDRWhite(PatternCanvas* ctx)
+{
+    // Default metadata is used because this simulates a desktop environment.
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    // Overload the color selector to allow selecting the desired SDR white level.
+    float nits = 80.0f;
+    switch (m_currentColor)
+    {
+    case 0:
+        nits = 80.0f;
+        break;
+    case 1:
+        nits = 160.0f;
+        break;
+    case 2:
+        nits = 240.0f;
+        break;
+    case 3:
+        nits = 320.0f;
+        break;
+    default:
+        throw std::invalid_argument("Invalid color selection");
+        break;
+    }
+
+    ColorF whiteBrush = ColorF(nitstoCCCS(nits), nitstoCCCS(nits), nitstoCCCS(nits));
+    ctx->FillRectangle(ctx->GetLogicalSize(), whiteBrush);
+
+    if (m_showExplanatoryText)
+    {
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+        title << L"Full frame SDR white\nUsing reference level of: " << nits;
+        title << " nits.\nUp & Down arrow keys select white level.\n";
+
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true);
+	}
+
+    m_newTestSelected = false;
+}
+
+void TestPatterns::GenerateTestPattern_FullFrameSDRWhiteWithHDR(PatternCanvas* ctx)
+{
+    // Default metadata is used because this simulates a desktop environment.
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    // Overload the color selector to allow selecting the desired HDR highlight level.
+    float nits = 80.0f;
+    switch (m_currentColor)
+    {
+    case 0:
+        // Default case is to use the display's reported max nits.
+        nits = m_outputDesc.MaxLuminance;
+        break;
+    case 1:
+        nits = 600.0f;
+        break;
+    case 2:
+        nits = 1000.0f;
+        break;
+    case 3:
+        nits = 1400.0f;
+        break;
+    default:
+        throw std::invalid_argument("Invalid color selection");
+        break;
+    }
+
+    // SDR full frame background is locked at 240 nits.
+    float sdrNits = 240.0f;
+
+    ColorF sdrBrush = ColorF(nitstoCCCS(sdrNits), nitstoCCCS(sdrNits), nitstoCCCS(sdrNits));
+
+    ColorF hdrBrush = ColorF(nitstoCCCS(nits), nitstoCCCS(nits), nitstoCCCS(nits));
+
+    auto logSize = ctx->GetLogicalSize();
+    RectF tenPercentRect =
+    {
+        (logSize.right - logSize.left) * (0.5f - sqrtf(0.1) / 2.0f),
+        (logSize.bottom - logSize.top) * (0.5f - sqrtf(0.1) / 2.0f),
+        (logSize.right - logSize.left) * (0.5f + sqrtf(0.1) / 2.0f),
+        (logSize.bottom - logSize.top) * (0.5f + sqrtf(0.1) / 2.0f)
+    };
+
+    ctx->FillRectangle(logSize, sdrBrush);
+    ctx->FillRectangle(tenPercentRect, hdrBrush);
+
+    if (m_showExplanatoryText)
+    {
+        std::wstringstream title;
+		title << fixed << setw(8) << setprecision(2);
+        title << L"Full frame SDR white with 10% HDR window (" << nits;
+        title << " nits).\nUp & Down arrow keys select HDR nits.\n";
+
+        RenderText(ctx, TextStyle::Large, title.str(), m_testTitleRect, true);
+
+		PrintMetadata(ctx, true );
+	}
+
+    m_newTestSelected = false;
+}
+
+
+// Common method to render an image test pattern to the screen.
+void TestPatterns::GenerateTestPattern_ImageCommon(PatternCanvas* ctx, TestPatternResources resources)
+{
+    // SetMetadata depending on if we tone mapped the image or not
+    if (m_newTestSelected) SetMetadataNeutral();
+
+    // Center the image, draw at 1.0x (pixel) zoom.
+    // TODO: Currently we force all D2D rendering to 96 DPI regardless of display DPI.
+    // Therefore DIPs = pixels.
+    bool imageIsValid = ctx->DrawImage(resources.imageFilename);
+
+    // Everything below this point should be hidden for actual measurements.
+    if (m_showExplanatoryText)
+    {
+        std::wstringstream text;
+        text << resources.testTitle << L"\n" << m_hideTextString;
+
+        if (imageIsValid == false)
+        {
+            text << L"\nERROR: " << resources.imageFilename << " is missing.";
+        }
+
+        RenderText(ctx, TextStyle::Large, text.str(), m_testTitleRect);
+    }
+
+    m_newTestSelected = false;
+}
+
+void TestPatterns::GenerateTestPattern_EndOfTest(PatternCanvas* ctx)
+{
+    std::wstringstream text;
+    text << L"This is the end of the test content.\n";
+    text << L"Press ALT-F4 to quit.";
+
+    RenderText(ctx, TextStyle::Large, text.str(), m_largeTextRect);
+    m_newTestSelected = false;
+
+}
+#pragma endregion
+
+#pragma region Frame Render
+// Draws the current test pattern.
+// Most patterns are held for minutes while they are measured, so the first frame of one
+// is recorded and replayed until its key changes.  Replaying skips the pattern code and
+// still draws every primitive, so a replayed frame is the frame the pattern would draw.
+void TestPatterns::RenderTestPattern(PatternCanvas* ctx)
+{
+    DisplayListKey key;
+    if (!m_displayListsEnabled || !GetDisplayListKey(ctx, &key))
+    {
+        DrawTestPattern(ctx);
+        return;
+    }
+
+    if (m_displayListValid && key == m_displayListKey)
+    {
+        m_displayListHits++;
+        m_displayList.Replay(ctx, [this, ctx](bool enabled) { return NextJitter(ctx->GetDpi(), enabled); });
+        return;
+    }
+
+    m_displayListMisses++;
+    m_displayListValid = false;
+    m_displayList.Record(ctx);
+    try
+    {
+        DrawTestPattern(&m_displayList);
+    }
+    catch (...)
+    {
+        m_displayList.EndRecord();
+        throw;
+    }
+    m_displayList.EndRecord();
+
+    m_displayListKey = key;
+    m_displayListValid = true;
+}
+
+void TestPatterns::EnableDisplayLists(bool enable)
+{
+    m_displayListsEnabled = enable;
+    InvalidateDisplayList();
+}
+
+void TestPatterns::InvalidateDisplayList()
+{
+    m_displayListGeneration++;
+}
+
+// Returns false for the patterns that change every frame, which are not worth recording.
+bool TestPatterns::GetDisplayListKey(PatternCanvas* ctx, DisplayListKey* key)
+{
+    // What the pattern shows that changes with time rather than input: the countdown as
+    // it is printed, and the flash phase.
+    uint64_t timer = 0;
+    switch (m_currentTest)
+    {
+    case TestPattern::AnimatedGrayGradient:
+    case TestPattern::AnimatedColorGradient:
+        return false;
+
+    case TestPattern::WarmUp:							// printed to 1/100 s
+    case TestPattern::TenPercentPeak:
+    case TestPattern::TenPercentPeakMAX:
+    case TestPattern::RiseFallTime:
+        timer = Hash(&m_testTimeRemainingSec, sizeof(m_testTimeRemainingSec));
+        break;
+
+    case TestPattern::Cooldown:							// whole seconds, then "done."
+    case TestPattern::FlashTest:
+    case TestPattern::FlashTestMAX:
+    case TestPattern::LongDurationWhite:
+    case TestPattern::FullFramePeak:
+        timer = static_cast<unsigned int>(m_testTimeRemainingSec) * 2ull + (0.0f != m_testTimeRemainingSec);
+        break;
+
+    default:
+        break;
+    }
+
+    uint64_t output = Hash(&m_outputDesc, sizeof(m_outputDesc));
+    output = Hash(&m_rawOutDesc, sizeof(m_rawOutDesc), output);
+    output = Hash(&m_gamutVolume, sizeof(m_gamutVolume), output);
+    output = Hash(&m_volumeCoverageDCIP3, sizeof(m_volumeCoverageDCIP3), output);
+    output = Hash(&m_volumeCoverage2100, sizeof(m_volumeCoverage2100), output);
+    output = Hash(&m_colorVolumeJND, sizeof(m_colorVolumeJND), output);
+
+    key->pattern = m_currentTest;
+    key->subtest = m_currentColor;
+    key->profileTile = m_currentProfileTile;
+    key->logicalSize = ctx->GetLogicalSize();
+    key->outputSize = ctx->GetOutputSize();
+    key->dpi = ctx->GetDpi();
+    key->outputHash = output;
+    key->frameState = (m_showExplanatoryText ? timer * 2 : 0) + (0.0f != m_flashOn);
+    key->generation = m_displayListGeneration;
+    return true;
+}
+
+void TestPatterns::DrawTestPattern(PatternCanvas* ctx)
+{
+    switch (m_currentTest)
+    {
+    case TestPattern::StartOfTest:
+        GenerateTestPattern_StartOfTest(ctx);
+        break;
+    case TestPattern::ConnectionProperties:
+        GenerateTestPattern_ConnectionProperties(ctx);
+        break;
+    case TestPattern::PanelCharacteristics:
+        GenerateTestPattern_PanelCharacteristics(ctx);
+        break;
+    case TestPattern::ResetInstructions:
+        GenerateTestPattern_ResetInstructions(ctx);
+        break;
+	case TestPattern::PQLevelsInNits:
+        GenerateTestPattern_PQLevelsInNits(ctx);
+        break;
+    case TestPattern::WarmUp:
+        GenerateTestPattern_WarmUp(ctx);
+        break;
+    case TestPattern::TenPercentPeak:									// 1.
+        GenerateTestPattern_TenPercentPeak(ctx);
+        break;
+    case TestPattern::TenPercentPeakMAX:								// 1.MAX
+        GenerateTestPattern_TenPercentPeakMAX(ctx);
+        break;
+    case TestPattern::FlashTest:										// 2.
+        GenerateTestPattern_FlashTest(ctx);
+        break;
+    case TestPattern::FlashTestMAX:										// 2.MAX
+        GenerateTestPattern_FlashTestMAX(ctx);
+        break;
+	case TestPattern::LongDurationWhite:								// 3.
+		GenerateTestPattern_LongDurationWhite(ctx);
+		break;
+	case TestPattern::FullFramePeak:									// 3.MAX
+        GenerateTestPattern_FullFramePeak(ctx);
+        break;
+    case TestPattern::BlackLevelHdrCorners:								// legacy
+        GenerateTestPattern_BlackLevelHdrCorners(ctx);
+        break;
+	case TestPattern::DualCornerBox:									// 4.
+		GenerateTestPattern_DualCornerBox(ctx);
+		break;
+	case TestPattern::StaticContrastRatio:								// 5.
+        GenerateTestPattern_StaticContrastRatio(ctx);
+        break;
+	case TestPattern::ActiveDimming:									// 5.1
+		GenerateTestPattern_ActiveDimming(ctx);
+		break;
+	case TestPattern::ActiveDimmingDark:								// 5.2
+		GenerateTestPattern_ActiveDimmingDark(ctx);
+		break;
+	case TestPattern::ActiveDimmingSplit:								// 5.3
+		GenerateTestPattern_ActiveDimmingSplit(ctx);
+		break;
+	case TestPattern::ColorPatches10:									// 6. with 10% screen coverage
+		GenerateTestPattern_ColorPatches(ctx, 0.10f);
+		break;
+	case TestPattern::ColorPatches:										// 6. with 100% screen coverage
+		GenerateTestPattern_ColorPatches(ctx, 1.00f);
+		break;
+    case TestPattern::BitDepthPrecision:								// 7.
+        GenerateTestPattern_BitDepthPrecision(ctx);
+        break;
+    case TestPattern::RiseFallTime:										// 8.
+        GenerateTestPattern_RiseFallTime(ctx);
+        break;
+	case TestPattern::ProfileCurve:										// 9.
+		GenerateTestPattern_ProfileCurve(ctx);
+		break;
+	case TestPattern::EndOfMandatoryTests:								// 
+        GenerateTestPattern_EndOfMandatoryTests(ctx);
+        break;
+    case TestPattern::SharpeningFilter:									// Sine Sweep Effect
+        GenerateTestPattern_SharpeningFilter(ctx);
+        break;
+	case TestPattern::ToneMapSpike:										// test tone mapping
+		GenerateTestPattern_ToneMapSpike(ctx);
+		break;
+	case TestPattern::TextQuality:
+        GenerateTestPattern_ImageCommon(ctx, m_testPatternResources[TestPattern::TextQuality]);
+        break;
+    case TestPattern::OnePixelLinesBW:
+        GenerateTestPattern_ImageCommon(ctx, m_testPatternResources[TestPattern::OnePixelLinesBW]);
+        break;
+    case TestPattern::OnePixelLinesRG:
+        GenerateTestPattern_ImageCommon(ctx, m_testPatternResources[TestPattern::OnePixelLinesRG]);
+        break;
+    case TestPattern::ColorPatches709:
+        GenerateTestPattern_ColorPatches709(ctx);
+        break;
+    case TestPattern::FullFrameSDRWhite:
+        GenerateTestPattern_FullFrameSDRWhite(ctx);
+        break;
+    case TestPattern::FullFrameSDRWhiteWithHDR:
+        GenerateTestPattern_FullFrameSDRWhiteWithHDR(ctx);
+        break;
+	case TestPattern::CalibrateMaxEffectiveValue:						// detect white crush
+		GenerateTestPattern_CalibrateMaxEffectiveValue(ctx);
+		break;
+	case TestPattern::CalibrateMaxEffectiveFullFrameValue:				// check profile at FALL
+		GenerateTestPattern_CalibrateMaxFullFrameValue(ctx);
+		break;
+	case TestPattern::CalibrateMinEffectiveValue:						// detect black crush
+		GenerateTestPattern_CalibrateMinEffectiveValue(ctx);
+		break;
+    case TestPattern::StaticGradient:
+        GenerateTestPattern_StaticGradient(ctx);
+        break;
+    case TestPattern::AnimatedGrayGradient:
+        GenerateTestPattern_AnimatedGrayGradient(ctx);
+        break;
+    case TestPattern::AnimatedColorGradient:
+        GenerateTestPattern_AnimatedColorGradient(ctx);
+        break;
+	case TestPattern::BlackLevelSdrTunnel:
+		GenerateTestPattern_BlackLevelSdrTunnel(ctx);
+		break;
+	case TestPattern::ColorPatchesMAX:									// 6.MAX	legacy
+		GenerateTestPattern_ColorPatchesMAX(ctx, 1.00);
+		break;
+	case TestPattern::EndOfTest:
+        GenerateTestPattern_EndOfTest(ctx);
+        break;
+    case TestPattern::Cooldown:
+        GenerateTestPattern_Cooldown(ctx);
+        break;
+    default:
+        throw std::logic_error("Test pattern not implemented");
+        break;
+    }
+}
+
+// Note: textPos is interpreted as { Left, Top, ***Width***, ***Height*** } which is different from the
+// definition of RectF
+void TestPatterns::RenderText(PatternCanvas* ctx, TextStyle style, std::wstring text, RectF textPos, bool useBlackText /* = false */)
+{
+    if (useBlackText)
+    {
+        ctx->DrawString(text, style, textPos, ColorF(0.0f, 0.0f, 0.0f));
+    }
+    else
+    {
+        ctx->DrawString(text, style, textPos, ColorF(ColorF::White));
+    }
+}
+
+void TestPatterns::UpdateTextLayout(const RectF& logicalSize)
+{
+    InvalidateDisplayList();
+
+    // RectF is defined as: Left, Top, Right, Bottom
+    // But we will interpret the struct members as: Left, Top, Width, Height
+    // This lets us pack the size (for IDWriteTextLayout) and offset (for DrawText)
+    // into a single struct.
+    m_testTitleRect = { 0.0f, 0.0f, 800.0f, 100.0f };
+
+    m_largeTextRect =
+    {
+        (logicalSize.right - logicalSize.left) * 0.15f,
+        (logicalSize.bottom - logicalSize.top) * 0.15f,
+        (logicalSize.right - logicalSize.left) * 0.75f,
+        (logicalSize.bottom - logicalSize.top) * 0.75f
+    };
+
+	m_MetadataTextRect =
+	{
+		logicalSize.right - 700.0f,
+		logicalSize.bottom - 35.0f,
+		logicalSize.right,
+		logicalSize.bottom
+	};
+}
+#pragma endregion
+
+#pragma region Test pattern control
+// Set increment = true to go up, false to go down.
+void TestPatterns::SetTestPattern(TestPattern testPattern)
+{
+    InvalidateDisplayList();
+
+    // save previous pattern in cache
+    if (testPattern == TestPattern::Cooldown
+        && m_currentTest != TestPattern::Cooldown)
+        m_cachedTest = m_currentTest;
+
+    if (TestPattern::StartOfTest <= testPattern)
+    {
+
+        if (TestPattern::Cooldown >= testPattern)
+            {
+            m_currentTest = testPattern;
+        }
+    }
+
+    //	m_showExplanatoryText = true;
+    m_newTestSelected = true;
+}
+// Set increment = true to go up, false to go down.
+void TestPatterns::ChangeTestPattern(bool increment)
+{
+    InvalidateDisplayList();
+
+    if (TestPattern::Cooldown == m_currentTest)
+    {
+        m_currentTest = m_cachedTest;
+        return;
+    }
+
+    if (increment)
+    {
+        if (TestPattern::EndOfTest == m_currentTest)
+        {
+            // Clamp to the end of the list.
+        }
+        else
+        {
+            unsigned int testInt = static_cast<unsigned int>(m_currentTest) + 1;
+            m_currentTest = static_cast<TestPattern>(testInt);
+        }
+    }
+    else
+    {
+        if (TestPattern::StartOfTest == m_currentTest)
+        {
+            // Clamp to the start of the list.
+        }
+        else
+        {
+            unsigned int testInt = static_cast<unsigned int>(m_currentTest) - 1;
+            m_currentTest = static_cast<TestPattern>(testInt);
+        }
+    }
+
+    //	m_showExplanatoryText = true;
+    m_newTestSelected = true;
+}
+
+float clamp(float v, float min, float max)
+{
+	if (v > max)
+		v = max; else
+	if (v < min)
+		v = min;
+	return v;
+}
+
+void TestPatterns::ChangeSubtest(bool increment)
+{
+	InvalidateDisplayList();
+
+	int testTier;
+	switch (m_currentTest)
+	{
+	case TestPattern::PanelCharacteristics:
+		testTier = (int)m_testingTier;
+		testTier += (increment ? 1 : -1);
+		testTier = clamp(testTier, (int)TestingTier::DisplayHDR400, (int)TestingTier::DisplayHDR10000);
+		m_testingTier = (TestingTier)testTier;
+		break;
+
+	case TestPattern::ActiveDimming:
+		m_activeDimming50PQValue -= (increment ? 4 : -4 );
+		m_activeDimming50PQValue = clamp(m_activeDimming50PQValue, 420, 488);	// 35..75 nits
+		break;
+
+	case TestPattern::ActiveDimmingDark:
+		m_activeDimming05PQValue -= (increment ? 4 : -4 );
+		m_activeDimming05PQValue = clamp(m_activeDimming05PQValue, 208, 292);	// 2.5..8.0 nits
+		break;
+
+	case TestPattern::CalibrateMaxEffectiveValue:
+		if (CheckHDR_On())
+		{
+			m_maxEffectivePQValue -= (increment ? 1 : -1);
+			m_maxEffectivePQValue = clamp(m_maxEffectivePQValue, 0.0f, 10000.0f);
+		}
+		else
+		{
+			m_maxEffectivesRGBValue -= (increment ? 1 : -1);
+			m_maxEffectivesRGBValue = clamp(m_maxEffectivesRGBValue, 0.0f, SrgbCode<8>::Scale);
+		}
+		break;
+
+	case TestPattern::CalibrateMaxEffectiveFullFrameValue:
+		if (CheckHDR_On())
+		{
+			m_maxFullFramePQValue -= (increment ? 1 : -1);
+			m_maxFullFramePQValue = clamp(m_maxFullFramePQValue, 0.0f, 10000.0f);
+		}
+		else
+		{
+			m_maxFullFramesRGBValue -= (increment ? 1 : -1);
+			m_maxFullFramesRGBValue = clamp(m_maxFullFramesRGBValue, 0.0f, SrgbCode<8>::Scale);
+		}
+		break;
+
+	case TestPattern::CalibrateMinEffectiveValue:
+		if (CheckHDR_On())
+		{
+			m_minEffectivePQValue -= (increment ? 1 : -1);
+			m_minEffectivePQValue = clamp(m_minEffectivePQValue, 0.0f, 10000.0f);
+		}
+		else
+		{
+			m_minEffectivesRGBValue -= (increment ? 1 : -1);
+			m_minEffectivesRGBValue = clamp(m_minEffectivesRGBValue, 0.0f, SrgbCode<8>::Scale);
+		}
+		break;
+
+	case TestPattern::ColorPatches:
+	case TestPattern::ColorPatches10:
+	case TestPattern::ColorPatchesMAX:
+	case TestPattern::ColorPatches709:
+	case TestPattern::FullFrameSDRWhite:
+	case TestPattern::FullFrameSDRWhiteWithHDR:
+	case TestPattern::SharpeningFilter:
+	case TestPattern::ToneMapSpike:
+		if (increment)
+		{
+			m_currentColor++;
+			if (m_currentColor > 3)
+				m_currentColor = 0;
+		}
+		else
+		{
+			m_currentColor--;
+			if (m_currentColor < 0)
+				m_currentColor = 3;
+		}
+		m_currentColor = m_currentColor % 4;
+		break;
+
+	case TestPattern::ProfileCurve:
+		if (increment)
+		{
+			m_currentProfileTile++;
+			if (m_currentProfileTile > (m_maxProfileTile))
+				m_currentProfileTile = 0;
+		}
+		else
+		{
+			m_currentProfileTile--;
+			if (m_currentProfileTile < 0)
+				m_currentProfileTile = m_maxProfileTile;
+		}
+		break;
+	}
+}
+
+void TestPatterns::ChangeGradientColor(float deltaR, float deltaG, float deltaB)
+{
+    InvalidateDisplayList();
+
+    m_gradientColor.r += deltaR;
+    m_gradientColor.g += deltaG;
+    m_gradientColor.b += deltaB;
+}
+
+void TestPatterns::StartTestPattern(void)
+{
+    InvalidateDisplayList();
+
+    m_currentTest = TestPattern::StartOfTest;
+    // m_showExplanatoryText = true;
+}
+
+// Many test patterns can be affected by the presence of explanatory text.
+// Allow user to toggle visibility on/off for each test pattern.
+// Returns whether the visibility is true or false after the update.
+bool TestPatterns::ToggleInfoTextVisible()
+{
+    InvalidateDisplayList();
+
+    m_showExplanatoryText = !m_showExplanatoryText;
+    return m_showExplanatoryText;
+}
+
+#pragma endregion
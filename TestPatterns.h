@@ -0,0 +1,323 @@
+//
+// TestPatterns.h
+//
+// The compliance test patterns and the state they run on, independent of any graphics
+// API.  Every GenerateTestPattern_* routine draws through a PatternCanvas, so the same
+// code renders to the swap chain in the app (Game, via D2DCanvas) and to a CPU
+// framebuffer headless (CpuCanvas).  The panel is described by OutputDesc, filled from
+// DXGI_OUTPUT_DESC1 by the app or synthesized by a headless host.
+//
+
+#pragma once
+
+#include <map>
+#include <stdint.h>
+#include <string>
+#include "BasicMath.h"
+#include "DisplayList.h"
+#include "PanelColorModel.h"
+#include "PQCodeTable.h"
+#include "PatternCanvas.h"
+
+struct rawOutputDesc
+{
+	float MaxLuminance;
+	float MaxFullFrameLuminance;
+	float MinLuminance;
+};
+
+// The fields of DXGI_OUTPUT_DESC1 the patterns read, under the same names.
+struct OutputDesc
+{
+	wchar_t  DeviceName[32];
+	uint32_t BitsPerColor;
+	uint32_t ColorSpace;		// DXGI_COLOR_SPACE_TYPE
+	float    RedPrimary[2];
+	float    GreenPrimary[2];
+	float    BluePrimary[2];
+	float    WhitePoint[2];
+	float    MinLuminance;
+	float    MaxLuminance;
+	float    MaxFullFrameLuminance;
+};
+
+// The DXGI_COLOR_SPACE_TYPE values the patterns distinguish.
+const uint32_t ColorSpace_sRGB  = 0;		// DXGI_COLOR_SPACE_RGB_FULL_G22_NONE_P709
+const uint32_t ColorSpace_HDR10 = 12;		// DXGI_COLOR_SPACE_RGB_FULL_G2084_NONE_P2020
+
+// Same fields as DXGI_HDR_METADATA_HDR10.
+struct HdrMetadata
+{
+	uint16_t RedPrimary[2];
+	uint16_t GreenPrimary[2];
+	uint16_t BluePrimary[2];
+	uint16_t WhitePoint[2];
+	uint32_t MaxMasteringLuminance;
+	uint32_t MinMasteringLuminance;
+	uint16_t MaxContentLightLevel;
+	uint16_t MaxFrameAverageLightLevel;
+};
+
+class TestPatterns
+{
+public:
+	enum class TestPattern
+	{
+		StartOfTest, // Must always be first.
+		ConnectionProperties,
+		PanelCharacteristics,
+		ResetInstructions,
+        PQLevelsInNits,
+        WarmUp,
+        TenPercentPeak,             // 1.
+        TenPercentPeakMAX,          // 1. MAX
+        FlashTest,                  // 2.
+        FlashTestMAX,               // 2. MAX
+        LongDurationWhite,          // 3.
+        FullFramePeak,              // 3. MAX
+		DualCornerBox,				// 4. Total contrast test for TrueBlack
+		StaticContrastRatio,		// 5. was tunnel
+		ActiveDimming,				// 5.1
+		ActiveDimmingDark,			// 5.2
+		ActiveDimmingSplit,			// 5.3
+		ColorPatches10,             // 6.  10% OPR
+		ColorPatches,               // 6. 100% OPR
+		BitDepthPrecision,          // 7. Uses custom effect.
+        RiseFallTime,               // 8.
+		ProfileCurve,               // 9. Validate tracking of 2084 profile
+		EndOfMandatoryTests,        //
+        SharpeningFilter,           // Uses custom Sine Sweep effect.
+		ToneMapSpike,				// Uses custom Tone Spike effect
+        TextQuality,                // Uses image.
+        //PQLevelsInNitsDynamic,
+        OnePixelLinesBW,            // Uses image.
+        OnePixelLinesRG,            // Uses image.
+        ColorPatches709,
+        FullFrameSDRWhite,
+        FullFrameSDRWhiteWithHDR,
+		CalibrateMaxEffectiveValue,		// max value to send that has any effect
+		CalibrateMaxEffectiveFullFrameValue,	// MaxFALL after tone mapping
+		CalibrateMinEffectiveValue,		// minimal value that is still visible by user
+        StaticGradient,
+        AnimatedGrayGradient,
+        AnimatedColorGradient,
+		BlackLevelHdrCorners,       // 4.
+		BlackLevelSdrTunnel,        // 5. Tunnel test Moved here from v1.0. Replaced with StaticContrastRatio in v1.1
+		ColorPatchesMAX,            // 6. MAX
+		EndOfTest, // Must always be last.
+        Cooldown,
+    };
+
+    TestPatterns(const wchar_t* appTitle);
+    virtual ~TestPatterns() {}
+
+    // Test pattern control
+    void SetTestPattern(TestPattern testPattern);
+    void ChangeTestPattern(bool increment);
+    void ChangeSubtest(bool increment);
+    void StartTestPattern(void);
+    void ChangeGradientColor(float deltaR, float deltaG, float deltaB);
+    bool ToggleInfoTextVisible();
+    void SetMetadataNeutral(); // OS defaults
+	void PrintMetadata(PatternCanvas* ctx, bool blackText = false);
+
+    // Advances the timers and animations of the current test by elapsedSec.
+    void UpdateTestPattern(float totalTimeSec, float elapsedSec);
+
+    // Places the title, body and metadata text for a target of the given logical size.
+    void UpdateTextLayout(const RectF& logicalSize);
+
+    // Draws the current test pattern.  The target is expected to be cleared to black.
+    void RenderTestPattern(PatternCanvas* ctx);
+
+    // Static frames are recorded into a display list and replayed until a control method
+    // above, UpdateTextLayout(), InvalidateDisplayList() or a new target size or output
+    // description makes them stale.  On by default.
+    void EnableDisplayLists(bool enable);
+    void InvalidateDisplayList();
+    uint64_t GetDisplayListHits() const { return m_displayListHits; }
+    uint64_t GetDisplayListMisses() const { return m_displayListMisses; }
+
+protected:
+    enum TestingTier
+    {
+        DisplayHDR400   = 0,
+		DisplayHDR500   = 1,
+		DisplayHDR600   = 2,
+        DisplayHDR1000  = 3,
+        DisplayHDR1400  = 4,
+		DisplayHDR2000  = 5,
+		DisplayHDR3000  = 6,
+        DisplayHDR4000  = 7,
+        DisplayHDR6000  = 8,
+        DisplayHDR10000 = 9
+    };
+
+    enum ColorGamut
+    {
+        GAMUT_Native = 0,
+        GAMUT_sRGB   = 1,
+        GAMUT_Adobe  = 2,
+        GAMUT_DCIP3  = 3,
+        GAMUT_BT2100 = 4,
+        GAMUT_ACES   = 5,
+    };
+
+    // Used by any test that draws a custom effect or an image from file.
+    struct TestPatternResources
+    {
+        std::wstring testTitle; // Mandatory.
+        std::wstring imageFilename; // Empty means no image is needed for this test.
+        std::wstring effectShaderFilename; // Empty means no shader is needed for this test.
+        PatternEffect effect;
+    };
+
+    // Identifies the frame the display list holds.
+    struct DisplayListKey
+    {
+        TestPattern pattern;
+        int32_t     subtest;		// m_currentColor
+        int32_t     profileTile;
+        RectF       logicalSize;
+        RectF       outputSize;
+        float       dpi;
+        uint64_t    outputHash;		// the output description and what is derived from it
+        uint64_t    frameState;		// countdown and flash phase, as drawn
+        uint32_t    generation;
+
+        bool operator==(const DisplayListKey& o) const
+        {
+            return pattern == o.pattern && subtest == o.subtest && profileTile == o.profileTile &&
+                logicalSize.left == o.logicalSize.left && logicalSize.top == o.logicalSize.top &&
+                logicalSize.right == o.logicalSize.right && logicalSize.bottom == o.logicalSize.bottom &&
+                outputSize.left == o.outputSize.left && outputSize.top == o.outputSize.top &&
+                outputSize.right == o.outputSize.right && outputSize.bottom == o.outputSize.bottom &&
+                dpi == o.dpi && outputHash == o.outputHash && frameState == o.frameState &&
+                generation == o.generation;
+        }
+    };
+
+    // Hands m_Metadata to the display.  Headless hosts have nowhere to send it.
+    virtual void ApplyMetadata() {}
+
+	void InitEffectiveValues();
+	// Rebuilds m_panelColorModel and m_pqCodes10 from m_outputDesc and m_rawOutDesc; call
+	// when either may have changed.  Does nothing if neither has since the last build.
+	void UpdatePanelColorModel();
+    void SetMetadata(float max, float avg, ColorGamut gamut);
+	bool CheckHDR_On();
+    bool CheckForDefaults();
+	void DrawLogo(PatternCanvas* ctx, float c);
+    TestingTier GetTestingTier();
+    const wchar_t* GetTierName(TestingTier tier);
+	float GetTierLuminance(TestingTier tier);
+	bool GetDisplayListKey(PatternCanvas* ctx, DisplayListKey* key);
+	PointF NextJitter(float dpi, bool enabled);
+	PointF BeginJitter(PatternCanvas* ctx, bool enabled = true);
+	void EndJitter(PatternCanvas* ctx);
+
+    // The switch over the patterns, without the display list.
+    void DrawTestPattern(PatternCanvas* ctx);
+
+    // Drawing code specific for each test pattern.
+    void GenerateTestPattern_StartOfTest(PatternCanvas* ctx);
+    void GenerateTestPattern_ConnectionProperties(PatternCanvas* ctx);
+    void GenerateTestPattern_PanelCharacteristics(PatternCanvas* ctx);
+    void GenerateTestPattern_ResetInstructions(PatternCanvas* ctx);
+	void GenerateTestPattern_CalibrateMaxEffectiveValue(PatternCanvas* ctx);
+	void GenerateTestPattern_CalibrateMaxFullFrameValue(PatternCanvas* ctx);
+	void GenerateTestPattern_CalibrateMinEffectiveValue(PatternCanvas* ctx);
+	void GenerateTestPattern_PQLevelsInNits(PatternCanvas* ctx);
+    void GenerateTestPattern_WarmUp(PatternCanvas* ctx);
+    void GenerateTestPattern_Cooldown(PatternCanvas* ctx);
+    void GenerateTestPattern_TenPercentPeak(PatternCanvas* ctx);						// 1
+    void GenerateTestPattern_TenPercentPeakMAX(PatternCanvas* ctx);					// 1.0b MAX
+    void GenerateTestPattern_FlashTest(PatternCanvas* ctx);							// 2
+    void GenerateTestPattern_FlashTestMAX(PatternCanvas* ctx);						// 2. Max
+	void GenerateTestPattern_LongDurationWhite(PatternCanvas* ctx);					// 3
+	void GenerateTestPattern_DualCornerBox(PatternCanvas* ctx);						// 4
+	void GenerateTestPattern_StaticContrastRatio(PatternCanvas* ctx);				// 5
+	void GenerateTestPattern_ActiveDimming(PatternCanvas* ctx);						// 5.1
+	void GenerateTestPattern_ActiveDimmingDark(PatternCanvas* ctx);					// 5.2
+	void GenerateTestPattern_ActiveDimmingSplit(PatternCanvas* ctx);					// 5.3
+    void GenerateTestPattern_ColorPatches(   PatternCanvas* ctx, float OPR );			// 6
+    void GenerateTestPattern_ColorPatchesMAX(PatternCanvas* ctx, float OPR );			// 6.b MAX legacy
+    void GenerateTestPattern_BitDepthPrecision(PatternCanvas* ctx);					// 7
+	void GenerateTestPattern_RiseFallTime(PatternCanvas* ctx);						// 8
+	void GenerateTestPattern_ProfileCurve(PatternCanvas* ctx);						// 9
+	void GenerateTestPattern_EndOfMandatoryTests(PatternCanvas* ctx);
+    void GenerateTestPattern_FullFramePeak(PatternCanvas* ctx);						// 3.b MAX legacy
+	void GenerateTestPattern_BlackLevelHdrCorners(PatternCanvas* ctx);				// 4 legacy
+	void GenerateTestPattern_SharpeningFilter(PatternCanvas* ctx);
+	void GenerateTestPattern_ToneMapSpike(PatternCanvas* ctx);
+	void GenerateTestPattern_FullFrameSDRWhite(PatternCanvas* ctx);
+    void GenerateTestPattern_FullFrameSDRWhiteWithHDR(PatternCanvas* ctx);
+    void GenerateTestPattern_ColorPatches709(PatternCanvas* ctx);
+    void GenerateTestPattern_StaticGradient(PatternCanvas* ctx);
+    void GenerateTestPattern_AnimatedGrayGradient(PatternCanvas* ctx);
+    void GenerateTestPattern_AnimatedColorGradient(PatternCanvas* ctx);
+	void GenerateTestPattern_BlackLevelSdrTunnel(PatternCanvas* ctx);
+	void GenerateTestPattern_BlackLevelSdrTunnelTrueBlack(PatternCanvas* ctx);
+	void GenerateTestPattern_EndOfTest(PatternCanvas* ctx);
+
+    // Generalized routine for all tests that involve loading an image.
+    void GenerateTestPattern_ImageCommon(PatternCanvas* ctx, TestPatternResources resources);
+
+    // Common rendering subroutines.
+    void RenderText(PatternCanvas* ctx, TextStyle style, std::wstring text, RectF textPos, bool useBlackText = false);
+
+    OutputDesc                                              m_outputDesc;
+	rawOutputDesc											m_rawOutDesc;		// base values from OS before scaling due to brightness setting
+
+    RectF                                                   m_testTitleRect; // Where to draw each test's title
+    RectF                                                   m_largeTextRect; // Where to draw large text for the test, if applicable
+	RectF													m_MetadataTextRect;
+    TestingTier                                             m_testingTier;
+    TestPattern                                             m_currentTest;
+    TestPattern                                             m_cachedTest;
+    int32_t                                                 m_currentColor;
+	int32_t													m_currentProfileTile;
+	uint32_t												m_maxPQCode;		// PQ code of maxLuminance
+	int32_t													m_maxProfileTile;	// highest tile worth testing on this panel
+    float                                                   m_flashOn;
+    ColorF                                                  m_gradientColor;
+    GradientStop                                            m_gradientStops[2];	// black to the animated end color
+    float                                                   m_gradientAnimationBase;
+    bool                                                    m_showExplanatoryText;
+    float                                                   m_testTimeRemainingSec;
+    float                                                   m_gamutVolume;
+	float													m_volumeCoverageDCIP3;	// ICtCp color volume coverage, 0-10,000 nits
+	float													m_volumeCoverage2100;
+	double													m_colorVolumeJND;		// panel color volume in cubic JND
+	PanelColorModel											m_panelColorModel;		// color patch test colors for this panel
+	PQCodeTable												m_pqCodes10;			// FP16 value per 10-bit code at the slider
+	OutputDesc												m_modelOutputDesc;		// descriptions the two above were built from
+	rawOutputDesc											m_modelRawOutDesc;
+	bool													m_panelColorModelBuilt;
+	float													m_maxEffectivesRGBValue;		// Code levels via manual test
+	float													m_maxFullFramesRGBValue;
+	float													m_minEffectivesRGBValue;
+	float													m_maxEffectivePQValue;
+	float													m_maxFullFramePQValue;
+	float													m_minEffectivePQValue;
+	float													m_activeDimming50PQValue;
+	float													m_activeDimming05PQValue;
+	bool                                                    m_newTestSelected; // Used for one-time initialization of test variables.
+	HdrMetadata												m_Metadata;
+	ColorGamut												m_MetadataGamut;
+
+    // TODO: integrate this with the other test resources
+    std::map<TestPattern, TestPatternResources>             m_testPatternResources;
+    std::wstring                                            m_hideTextString;
+
+    float                                                   m_totalTime;
+    const wchar_t*                                          m_appTitle;
+
+    DisplayList                                             m_displayList;
+    DisplayListKey                                          m_displayListKey;
+    bool                                                    m_displayListsEnabled;
+    bool                                                    m_displayListValid;
+    uint32_t                                                m_displayListGeneration;
+    uint64_t                                                m_displayListHits;
+    uint64_t                                                m_displayListMisses;
+};
@@ -0,0 +1,138 @@
+//
+// ThreadPool.cpp
+//
+
+#include "ThreadPool.h"
+
+namespace
+{
+	thread_local bool t_insidePool = false;
+}
+
+ThreadPool::ThreadPool(unsigned threadCount) :
+	m_generation(0),
+	m_busy(0),
+	m_stop(false),
+	m_fn(nullptr),
+	m_end(0),
+	m_grain(1),
+	m_next(0)
+{
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency();
+	if (threadCount == 0)
+		threadCount = 1;
+
+	for (unsigned i = 1; i < threadCount; i++)
+		m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+	for (auto& worker : m_workers)
+		worker.join();
+}
+
+ThreadPool& ThreadPool::Default()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::ParallelFor(size_t begin, size_t end, const std::function<void(size_t)>& fn, size_t grain)
+{
+	if (begin >= end)
+		return;
+	if (grain == 0)
+		grain = 1;
+
+	// Nested or tiny ranges are not worth waking anyone for.
+	if (t_insidePool || m_workers.empty() || end - begin <= grain)
+	{
+		for (size_t i = begin; i < end; i++)
+			fn(i);
+		return;
+	}
+
+	std::lock_guard<std::mutex> dispatch(m_dispatch);
+
+	m_fn = &fn;
+	m_end = end;
+	m_grain = grain;
+	m_next = begin;
+	m_error = nullptr;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_busy = (unsigned)m_workers.size();
+		m_generation++;
+	}
+	m_wake.notify_all();
+
+	t_insidePool = true;
+	RunChunks();
+	t_insidePool = false;
+
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_done.wait(lock, [this] { return m_busy == 0; });
+	}
+
+	m_fn = nullptr;
+	if (m_error)
+		std::rethrow_exception(m_error);
+}
+
+void ThreadPool::RunChunks()
+{
+	for (;;)
+	{
+		size_t first = m_next.fetch_add(m_grain);
+		if (first >= m_end)
+			break;
+		size_t last = first + m_grain < m_end ? first + m_grain : m_end;
+
+		try
+		{
+			for (size_t i = first; i < last; i++)
+				(*m_fn)(i);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(m_errorMutex);
+			if (!m_error)
+				m_error = std::current_exception();
+			m_next = m_end;		// abandon the rest of the range
+		}
+	}
+}
+
+void ThreadPool::WorkerLoop()
+{
+	t_insidePool = true;
+	uint64_t seen = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+			if (m_stop)
+				return;
+			seen = m_generation;
+		}
+
+		RunChunks();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (--m_busy == 0)
+				m_done.notify_one();
+		}
+	}
+}
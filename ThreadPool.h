@@ -0,0 +1,61 @@
+//
+// ThreadPool.h
+//
+// Small fixed-size worker pool for the CPU-side batch work (gamut analysis, headless
+// pattern rendering, image conversion).  Work is handed out as index ranges; the
+// calling thread joins in, and ParallelFor blocks until every index has run.
+//
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+	// threadCount == 0 means one thread per hardware thread (the caller counts as one).
+	explicit ThreadPool(unsigned threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// Total threads that take part in a ParallelFor, including the caller.
+	unsigned Size() const { return (unsigned)m_workers.size() + 1; }
+
+	// Calls fn(i) for every i in [begin, end).  Indices are claimed grain at a time.
+	// Calls made from inside a pool task run serially on that thread rather than deadlock.
+	// The first exception thrown by fn is rethrown here once the range has drained.
+	void ParallelFor(size_t begin, size_t end, const std::function<void(size_t)>& fn, size_t grain = 1);
+
+	// Shared pool sized to the machine, created on first use.
+	static ThreadPool& Default();
+
+private:
+	void WorkerLoop();
+	void RunChunks();
+
+	std::vector<std::thread>            m_workers;
+	std::mutex                          m_dispatch;		// one ParallelFor at a time
+	std::mutex                          m_mutex;
+	std::condition_variable             m_wake;
+	std::condition_variable             m_done;
+	uint64_t                            m_generation;
+	unsigned                            m_busy;
+	bool                                m_stop;
+
+	// Current job
+	const std::function<void(size_t)>*  m_fn;
+	size_t                              m_end;
+	size_t                              m_grain;
+	std::atomic<size_t>                 m_next;
+	std::exception_ptr                  m_error;
+	std::mutex                          m_errorMutex;
+};
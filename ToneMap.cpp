@@ -0,0 +1,155 @@
+//
+// ToneMap.cpp
+//
+// Tone curves and their table cache.  See ToneMap.h.
+//
+
+#include "ToneMap.h"
+#include "ColorSpaces.h"
+#include "TransferTables.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+	// Where ACESFilm() reaches 1: the root of 0.08x^2 - 0.56x - 0.14.
+	const double ACESWhite = (0.56 + sqrt(0.56 * 0.56 + 4.0 * 0.08 * 0.14)) / (2.0 * 0.08);
+
+	double ACESFilm(double x)
+	{
+		const double a = 2.51, b = 0.03, c = 2.43, d = 0.59, e = 0.14;
+		return std::min((x * (a * x + b)) / (x * (c * x + d) + e), 1.0);
+	}
+
+	// The BT.2390 EETF with the source black at 0 and no lift at the target black, on
+	// PQ signals normalized to the source peak.
+	double EETF(double nits, double inputPeak, double outputPeak)
+	{
+		double sourcePQ = Apply2084Reference(inputPeak / 10000.0);
+		double maxLum = Apply2084Reference(outputPeak / 10000.0) / sourcePQ;
+		if (maxLum >= 1.0)
+			return nits;
+
+		double e = Apply2084Reference(nits / 10000.0) / sourcePQ;
+		double ks = std::max(1.5 * maxLum - 0.5, 0.0);
+		if (e > ks)
+		{
+			double t = (e - ks) / (1.0 - ks);
+			double t2 = t * t, t3 = t2 * t;
+			e = (2.0 * t3 - 3.0 * t2 + 1.0) * ks + (t3 - 2.0 * t2 + t) * (1.0 - ks) + (-2.0 * t3 + 3.0 * t2) * maxLum;
+		}
+		return Remove2084Reference(e * sourcePQ) * 10000.0;
+	}
+
+	// The curve on x = nits / inputPeak in [0,1], to nits / outputPeak.
+	double Normalized(ToneCurve curve, double x, double inputPeak, double outputPeak)
+	{
+		switch (curve)
+		{
+		case ToneCurve::Profile:
+		{
+			float p = (float)(inputPeak / outputPeak);
+			return ToneMapProfile(p, (float)(x * p));
+		}
+		case ToneCurve::ACESFilmic:
+			return ACESFilm(x * ACESWhite);
+		case ToneCurve::BT2390:
+			return EETF(x * inputPeak, inputPeak, outputPeak) / outputPeak;
+		}
+		return x;
+	}
+
+	uint32_t Bits(float f)
+	{
+		uint32_t bits;
+		memcpy(&bits, &f, sizeof(bits));
+		return bits;
+	}
+}
+
+const char* GetToneCurveName(ToneCurve curve)
+{
+	switch (curve)
+	{
+	case ToneCurve::Profile:    return "profile";
+	case ToneCurve::ACESFilmic: return "aces";
+	case ToneCurve::BT2390:     return "bt2390";
+	}
+	return nullptr;
+}
+
+float ToneMap(ToneCurve curve, float nits, float inputPeak, float outputPeak)
+{
+	double x = (double)nits / inputPeak;
+	double low = CurveTable::Low();
+	if (x < low)
+		return (float)(x * Normalized(curve, low, inputPeak, outputPeak) / low * outputPeak);
+	return (float)(Normalized(curve, std::min(x, 1.0), inputPeak, outputPeak) * outputPeak);
+}
+
+#pragma region ToneMapCache
+
+ToneMapCache::ToneMapCache(size_t capacity) :
+	m_tables(capacity),
+	m_stats()
+{
+}
+
+std::shared_ptr<const CurveTable> ToneMapCache::GetTable(ToneCurve curve, float inputPeak, float outputPeak)
+{
+	Key key = { { (uint32_t)curve, Bits(inputPeak), Bits(outputPeak) } };
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		if (auto* table = m_tables.Find(key))
+		{
+			m_stats.reused++;
+			return *table;
+		}
+	}
+
+	// Built outside the lock; two threads that miss together both build, and the second
+	// insert finds the first.
+	auto table = std::make_shared<const CurveTable>([&](double x) { return Normalized(curve, x, inputPeak, outputPeak); });
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	if (auto* built = m_tables.Find(key))
+		return *built;
+
+	m_stats.built++;
+	return m_tables.Insert(key, table, &m_stats.evicted);
+}
+
+void ToneMapCache::Append(ImageConverter& steps, ToneCurve curve, float inputPeak, float outputPeak, float unitNits)
+{
+	steps.Scale(unitNits / inputPeak)
+		 .Curve(GetTable(curve, inputPeak, outputPeak))
+		 .Scale(outputPeak / unitNits);
+}
+
+void ToneMapCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_tables.Clear();
+}
+
+size_t ToneMapCache::Size() const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_tables.Size();
+}
+
+ToneMapCacheStats ToneMapCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_stats;
+}
+
+ToneMapCache& ToneMapCache::Default()
+{
+	static ToneMapCache cache;
+	return cache;
+}
+
+#pragma endregion
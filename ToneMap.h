@@ -0,0 +1,82 @@
+//
+// ToneMap.h
+//
+// The tone curves a display or app uses to fit content mastered to one peak into a
+// panel with another, on the CPU:
+//
+//   Profile     the profile()/shoulder() curve of ToneSpikeEffect.hlsl (ToneMapProfile()
+//               in ColorSpaces.h): identity up to a knee, a rational shoulder to the
+//               panel peak, clipped above the content peak.  The curve the ToneMapSpike
+//               pattern draws on its bottom half.
+//   ACESFilmic  the ACESFilm() fit of ToneSpikeEffect.hlsl, scaled so the content peak
+//               lands where the fit reaches 1.  A filmic look rather than a fit: it bends
+//               the whole range, not just the highlights.
+//   BT2390      the ITU-R BT.2390 EETF: a Hermite spline shoulder in the PQ domain from
+//               the knee KS = 1.5 * maxLum - 0.5 up, with no black level lift.
+//
+// Each curve is baked for a pair of peaks into a CurveTable (ImageConvert.h) and applied
+// to each channel as an ImageConverter stage, so it runs with SIMD, fused into the pass
+// around it.  The tables are kept in an LRU keyed by curve and peaks: an app retunes to a
+// few display peaks over a session, and a tone map per frame then costs no table builds.
+//
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include "ImageConvert.h"
+#include "LruCache.h"
+
+enum class ToneCurve
+{
+	Profile,
+	ACESFilmic,
+	BT2390,
+};
+
+// "profile", "aces" or "bt2390".
+const char* GetToneCurveName(ToneCurve curve);
+
+// The exact curve at one luminance, all in nits.  Input above inputPeak maps to
+// outputPeak; negative input, out of gamut in scRGB, goes on as a line through the origin
+// as it does in the tables.
+float ToneMap(ToneCurve curve, float nits, float inputPeak, float outputPeak);
+
+struct ToneMapCacheStats
+{
+	uint64_t built;
+	uint64_t reused;
+	uint64_t evicted;			// dropped to stay within capacity
+};
+
+// Thread safe; the tables it hands out stay valid while referenced, evicted or not.
+class ToneMapCache
+{
+public:
+	explicit ToneMapCache(size_t capacity = 32);
+
+	// The curve from inputPeak to outputPeak, normalized: x = nits / inputPeak in, nits /
+	// outputPeak out.
+	std::shared_ptr<const CurveTable> GetTable(ToneCurve curve, float inputPeak, float outputPeak);
+
+	// Appends the curve to steps, for linear light where 1.0 is unitNits (80 for CCCS):
+	// a scale to the input peak, the table, and a scale from the output peak, which fold
+	// into the matrices on either side.
+	void Append(ImageConverter& steps, ToneCurve curve, float inputPeak, float outputPeak, float unitNits = 80.0f);
+
+	void Clear();
+	size_t Size() const;
+	ToneMapCacheStats GetStats() const;
+
+	// Shared by Image_ToneMap() and the pipeline.
+	static ToneMapCache& Default();
+
+private:
+	typedef std::array<uint32_t, 3> Key;						// curve, then the peaks' bits
+
+	LruCache<Key, std::shared_ptr<const CurveTable>>    m_tables;
+	ToneMapCacheStats                                   m_stats;
+	mutable std::mutex                                  m_lock;
+};
@@ -0,0 +1,80 @@
+//
+// TransferBatch.cpp
+//
+// Vectorized ST.2084 encode/decode.  See TransferBatch.h for the accuracy contract.
+//
+
+#include "TransferBatch.h"
+#include "SimdMath.h"
+
+using namespace simd;
+
+namespace
+{
+	// SMPTE ST 2084 constants, same values as ColorSpaces.h and the effect shaders
+	const float m1 = 2610.0f / 4096.0f / 4;
+	const float m2 = 2523.0f / 4096.0f * 128;
+	const float c1 = 3424.0f / 4096.0f;
+	const float c2 = 2413.0f / 4096.0f * 32;
+	const float c3 = 2392.0f / 4096.0f * 32;
+
+	inline vfloat Apply2084Kernel(vfloat L)
+	{
+		L = saturate(L);
+		vfloat Lp = pow(L, vfloat(m1));
+		return pow((vfloat(c1) + vfloat(c2) * Lp) / (vfloat(1.0f) + vfloat(c3) * Lp), vfloat(m2));
+	}
+
+	inline vfloat Remove2084Kernel(vfloat N)
+	{
+		N = saturate(N);
+		vfloat Np = pow(N, vfloat(1.0f / m2));
+		vfloat num = max(Np - vfloat(c1), vfloat(0.0f));
+		return pow(num / (vfloat(c2) - vfloat(c3) * Np), vfloat(1.0f / m1));
+	}
+}
+
+void Apply2084(const float* in, float* out, size_t count)
+{
+	ForEach(in, out, count, [](vfloat x) { return Apply2084Kernel(x); });
+}
+
+void Remove2084(const float* in, float* out, size_t count)
+{
+	ForEach(in, out, count, [](vfloat x) { return Remove2084Kernel(x); });
+}
+
+// float3 is three packed floats, and the curve is per channel, so AoS data can be
+// streamed through the scalar-span kernel unchanged.
+void Apply2084(const float3* in, float3* out, size_t count)
+{
+	static_assert(sizeof(float3) == 3 * sizeof(float), "float3 must be tightly packed");
+	Apply2084(&in->x, &out->x, count * 3);
+}
+
+void Remove2084(const float3* in, float3* out, size_t count)
+{
+	static_assert(sizeof(float3) == 3 * sizeof(float), "float3 must be tightly packed");
+	Remove2084(&in->x, &out->x, count * 3);
+}
+
+void Apply2084(const float* inR, const float* inG, const float* inB,
+			   float* outR, float* outG, float* outB, size_t count)
+{
+	Apply2084(inR, outR, count);
+	Apply2084(inG, outG, count);
+	Apply2084(inB, outB, count);
+}
+
+void Remove2084(const float* inR, const float* inG, const float* inB,
+				float* outR, float* outG, float* outB, size_t count)
+{
+	Remove2084(inR, outR, count);
+	Remove2084(inG, outG, count);
+	Remove2084(inB, outB, count);
+}
+
+const char* TransferBatchPath()
+{
+	return PathName();
+}
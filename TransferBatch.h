@@ -0,0 +1,44 @@
+//
+// TransferBatch.h
+//
+// Span versions of the ST.2084 (PQ) transfer functions from ColorSpaces.h for whole
+// scanlines, captures and code sweeps.  Same curve and constants as the scalar
+// Apply2084()/Remove2084(), evaluated with vectorized log2/exp2 (see SimdMath.h).
+//
+// Inputs are clamped to [0,1] first, as the float3 overloads and Linear709ToHDR10()
+// already do.
+//
+// Accuracy: both the scalar powf code and these kernels are limited by cancellation in
+// the PQ formula itself when evaluated in float, and against an exact (double) evaluation
+// they have the same error: < 2e-5 relative for Apply2084 of normal floats, < 6e-5
+// relative for Remove2084 on signals above 0.001.  Near a signal of 1, Remove2084 divides
+// by c2 - c3 * E^(1/m2), which cancels to 0.164, and the 1/m1 power then magnifies a
+// rounding of E^(1/m2) about 750 times.  The two implementations round differently, so
+// against the scalar functions directly, on the same inputs, results differ by at most
+// 400 ulp for Apply2084 (2.4e-5 absolute on a signal up to 1: under 0.03 of a 10-bit /
+// 0.1 of a 12-bit code step) and 1200 ulp for Remove2084 (up to 1200 * 2^-23, about
+// 1.4e-4 relative).  For denormal linear values and signals below 0.001 they differ by
+// less than 1e-9.  TransferBenchmark --check verifies all of these.
+//
+// In-place operation (in == out) is allowed.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include "BasicMath.h"
+
+// Linear (1.0 = 10,000 nits) to PQ signal
+void Apply2084(const float* in, float* out, size_t count);
+void Apply2084(const float3* in, float3* out, size_t count);
+void Apply2084(const float* inR, const float* inG, const float* inB,
+			   float* outR, float* outG, float* outB, size_t count);		// planar
+
+// PQ signal to linear (1.0 = 10,000 nits)
+void Remove2084(const float* in, float* out, size_t count);
+void Remove2084(const float3* in, float3* out, size_t count);
+void Remove2084(const float* inR, const float* inG, const float* inB,
+				float* outR, float* outG, float* outB, size_t count);		// planar
+
+// Which instruction set the batch kernels were compiled for, for logs and reports.
+const char* TransferBatchPath();
@@ -0,0 +1,375 @@
+//
+// TransferBenchmark.cpp
+//
+// Stand-alone benchmark of the PQ transfer function paths: scalar powf (ColorSpaces.h),
+// the SIMD span kernels (TransferBatch.h) and the table paths (TransferTables.h).
+// Sweeps every code at 10, 12 and 16 bits and reports throughput and worst error in
+// code steps, then times the 709 to 2020 rotation and the whole scRGB to HDR10 conversion
+// per pixel (generic and SIMD) and through the span mul() of BasicMath.h, and a whole FP16
+// frame to HDR10 through ImageConverter.
+//
+// With --check it times nothing and instead holds the span kernels to the accuracy
+// TransferBatch.h documents, over a sweep of the floats in [0, 1]: ulp from the scalar
+// functions, and relative error from a double evaluation of the PQ formula.  It prints the
+// worst case of each and exits with 1 if any is over its bound, so it can run after every
+// change to TransferBatch.cpp or SimdMath.h.  Not part of the app project; build it
+// directly, e.g.
+//
+//   g++ -std=c++17 -O2 -mavx2 -mfma -pthread TransferBenchmark.cpp BasicMath.cpp ImageConvert.cpp ThreadPool.cpp TransferBatch.cpp TransferTables.cpp -o transferbench
+//   cl /std:c++17 /O2 /arch:AVX2 /EHsc /constexpr:steps100000000 TransferBenchmark.cpp BasicMath.cpp ImageConvert.cpp ThreadPool.cpp TransferBatch.cpp TransferTables.cpp
+//
+
+#include "ColorSpaces.h"
+#include "Half.h"
+#include "ImageConvert.h"
+#include "ThreadPool.h"
+#include "TransferBatch.h"
+#include "TransferTables.h"
+
+#include <chrono>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <stdio.h>
+#include <vector>
+
+namespace
+{
+	const int Repeats = 200;
+
+	// Runs fn repeats times and returns nanoseconds per value.
+	template <class Fn>
+	double TimeIt(size_t count, Fn fn, int repeats = Repeats)
+	{
+		auto start = std::chrono::high_resolution_clock::now();
+		for (int r = 0; r < repeats; r++)
+			fn();
+		auto end = std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::nano>(end - start).count() / ((double)count * repeats);
+	}
+
+	// Worst error and number of codes that no longer round back to themselves.
+	void Report(const char* name, double ns, const std::vector<float>& out, int bits)
+	{
+		const double scale = (double)((1 << bits) - 1);
+		double worst = 0.0;
+		int wrong = 0;
+		for (size_t code = 0; code < out.size(); code++)
+		{
+			double e = fabs(out[code] * scale - (double)code);
+			worst = e > worst ? e : worst;
+			if ((size_t)lround(out[code] * scale) != code)
+				wrong++;
+		}
+		printf("  %-22s %7.2f ns/value   max err %.4f codes   %d codes off\n", name, ns, worst, wrong);
+	}
+
+	void BenchmarkEncode(int bits)
+	{
+		const size_t count = (size_t)1 << bits;
+		std::vector<float> linear(count), out(count);
+		for (size_t code = 0; code < count; code++)
+			linear[code] = Remove2084((float)code / (float)(count - 1));
+
+		printf("PQ encode, %d-bit code sweep (%zu values, %s)\n", bits, count, TransferBatchPath());
+
+		double ns = TimeIt(count, [&] { for (size_t i = 0; i < count; i++) out[i] = Apply2084(linear[i]); });
+		Report("Apply2084 (powf)", ns, out, bits);
+
+		ns = TimeIt(count, [&] { Apply2084(linear.data(), out.data(), count); });
+		Report("Apply2084 span", ns, out, bits);
+
+		ns = TimeIt(count, [&] { for (size_t i = 0; i < count; i++) out[i] = Apply2084_Table(linear[i]); });
+		Report("Apply2084_Table", ns, out, bits);
+
+		ns = TimeIt(count, [&] { Apply2084_Table(linear.data(), out.data(), count); });
+		Report("Apply2084_Table span", ns, out, bits);
+	}
+
+	template <size_t N>
+	void BenchmarkDecode(int bits, const std::array<float, N>& table)
+	{
+		std::vector<float> out(N);
+		volatile float sink = 0.0f;
+
+		printf("PQ decode, %d-bit codes (%zu values)\n", bits, N);
+
+		double ns = TimeIt(N, [&] { for (size_t c = 0; c < N; c++) out[c] = Remove2084((float)c / (float)(N - 1)); });
+		double powfWorst = 0.0;
+		for (size_t c = 0; c < N; c++)
+			powfWorst = fmax(powfWorst, fabs(out[c] - table[c]) / fmax(table[c], 1e-30f));
+		printf("  %-22s %7.2f ns/value   max rel diff from table %.3g\n", "Remove2084 (powf)", ns, powfWorst);
+
+		ns = TimeIt(N, [&] { for (size_t c = 0; c < N; c++) out[c] = table[c]; });
+		sink = out[N / 2];
+		printf("  %-22s %7.2f ns/value\n", "table", ns);
+		(void)sink;
+	}
+
+	// The generic Vector3<T> mul() of BasicMath.h, which the float specialization replaces,
+	// as the baseline for it and the span.
+	float3 GenericMul(const float3x3& m, const float3& v)
+	{
+		return float3(v.x * m._11 + v.y * m._12 + v.z * m._13,
+					  v.x * m._21 + v.y * m._22 + v.z * m._23,
+					  v.x * m._31 + v.y * m._32 + v.z * m._33);
+	}
+
+	// A 256x256 tile of scRGB pixels, through the rotation alone and through the whole of
+	// Linear709ToHDR10().  The span chain folds the 1/125 into the matrix.
+	void BenchmarkConversion()
+	{
+		const size_t count = 256 * 256;
+		std::vector<float3> in(count), out(count), ref(count);
+		for (size_t i = 0; i < count; i++)
+			in[i] = float3((float)(i % 251) / 25.0f, (float)(i % 241) / 24.0f, (float)(i % 239) / 23.0f);
+
+		printf("scRGB to BT.2020, 256x256 tile (%s)\n", TransferBatchPath());
+
+		double ns = TimeIt(count, [&] { for (size_t i = 0; i < count; i++) out[i] = GenericMul(mat709to2020, in[i]); });
+		printf("  %-22s %7.2f ns/pixel\n", "generic mul()", ns);
+		ns = TimeIt(count, [&] { for (size_t i = 0; i < count; i++) ref[i] = mul(mat709to2020, in[i]); });
+		printf("  %-22s %7.2f ns/pixel   %s\n", "mul() per pixel", ns,
+			   memcmp(out.data(), ref.data(), count * sizeof(float3)) ? "differs from generic" : "same bits");
+		ns = TimeIt(count, [&] { mul(mat709to2020, in.data(), out.data(), count); });
+		printf("  %-22s %7.2f ns/pixel   %s\n", "mul() span", ns,
+			   memcmp(out.data(), ref.data(), count * sizeof(float3)) ? "differs from per pixel" : "same bits");
+
+		float3x3 toHDR10 = mat709to2020;
+		for (int r = 0; r < 3; r++)
+			for (int c = 0; c < 3; c++)
+				toHDR10[r][c] *= 0.008f;
+
+		ns = TimeIt(count, [&] { for (size_t i = 0; i < count; i++) ref[i] = Linear709ToHDR10(in[i]); });
+		printf("  %-22s %7.2f ns/pixel\n", "Linear709ToHDR10", ns);
+		ns = TimeIt(count, [&]
+		{
+			mul(toHDR10, in.data(), out.data(), count);
+			Apply2084(out.data(), out.data(), count);
+		});
+		double worst = 0.0;
+		for (size_t i = 0; i < count; i++)
+		{
+			worst = fmax(worst, fabs(out[i].x - ref[i].x));
+			worst = fmax(worst, fabs(out[i].y - ref[i].y));
+			worst = fmax(worst, fabs(out[i].z - ref[i].z));
+		}
+		printf("  %-22s %7.2f ns/pixel   max err %.4f 10-bit codes\n", "mul() + Apply2084 span", ns, worst * 1023.0);
+	}
+
+	// A 1920x1080 R16G16B16A16_FLOAT capture to an R10G10B10A2_UNORM HDR10 frame: decode,
+	// Linear709ToHDR10() and pack per pixel, against ImageConverter on one thread and on
+	// the default pool.
+	void BenchmarkFrame()
+	{
+		const uint32_t width = 1920, height = 1080;
+		const size_t count = (size_t)width * height;
+		const int frames = 10;
+		std::vector<uint16_t> in(4 * count);
+		std::vector<uint32_t> out(count), ref(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			in[4 * i]     = FloatToHalf((float)(i % 251) / 25.0f);
+			in[4 * i + 1] = FloatToHalf((float)(i % 241) / 24.0f);
+			in[4 * i + 2] = FloatToHalf((float)(i % 239) / 23.0f);
+			in[4 * i + 3] = FloatToHalf(1.0f);
+		}
+
+		ImageConverter converter;
+		converter.Then(ColorStep::Linear709ToHDR10);
+		ImageBuffer src = { in.data(), width, height, width * 8, ImageFormat::R16G16B16A16_FLOAT };
+		ImageBuffer dst = { out.data(), width, height, width * 4, ImageFormat::R10G10B10A2_UNORM };
+
+		printf("scRGB FP16 to HDR10 R10G10B10A2, 1920x1080 frame\n");
+		double ns = TimeIt(count, [&]
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				float3 c = Linear709ToHDR10(float3(HalfToFloat(in[4 * i]), HalfToFloat(in[4 * i + 1]), HalfToFloat(in[4 * i + 2])));
+				ref[i] = (uint32_t)roundf(c.x * 1023.0f) | (uint32_t)roundf(c.y * 1023.0f) << 10 |
+						 (uint32_t)roundf(c.z * 1023.0f) << 20 | 0xC0000000u;
+			}
+		}, frames);
+		printf("  %-22s %7.2f ns/pixel\n", "per pixel", ns);
+
+		ThreadPool single(1);
+		ns = TimeIt(count, [&] { converter.Convert(src, dst, &single); }, frames);
+		size_t differ = 0;
+		for (size_t i = 0; i < count; i++)
+			differ += out[i] != ref[i];
+		printf("  %-22s %7.2f ns/pixel   %zu pixels off by a code\n", "ImageConverter", ns, differ);
+		ns = TimeIt(count, [&] { converter.Convert(src, dst); }, frames);
+		printf("  %-22s %7.2f ns/pixel   %u threads\n", "ImageConverter", ns, ThreadPool::Default().Size());
+	}
+
+	// The PQ formula of ColorSpaces.h in double, as the reference for --check.
+	const double M1 = 2610.0 / 4096.0 / 4, M2 = 2523.0 / 4096.0 * 128;
+	const double C1 = 3424.0 / 4096.0, C2 = 2413.0 / 4096.0 * 32, C3 = 2392.0 / 4096.0 * 32;
+
+	double Apply2084Exact(double L)
+	{
+		double Lp = pow(L, M1);
+		return pow((C1 + C2 * Lp) / (1.0 + C3 * Lp), M2);
+	}
+
+	double Remove2084Exact(double N)
+	{
+		double Np = pow(N, 1.0 / M2);
+		return pow(fmax(Np - C1, 0.0) / (C2 - C3 * Np), 1.0 / M1);
+	}
+
+	// Distance in representable floats; both are non-negative.
+	uint32_t UlpDistance(float a, float b)
+	{
+		uint32_t ua, ub;
+		memcpy(&ua, &a, sizeof(ua));
+		memcpy(&ub, &b, sizeof(ub));
+		return ua > ub ? ua - ub : ub - ua;
+	}
+
+	// Worst case of a span kernel over the sweep.
+	struct AccuracyWorst
+	{
+		uint32_t ulp;
+		float    ulpInput;
+		double   relative;
+		float    relativeInput;
+		double   absolute;
+		bool     planarMatches;				// the float3 and planar overloads give the same bits
+	};
+
+	// One span kernel against its bounds.
+	struct AccuracyCheck
+	{
+		const char*   name;
+		float         floor;				// inputs below are only held to absoluteBound
+		uint32_t      ulpBound;				// from the scalar function
+		double        relativeBound;		// from the double evaluation
+		double        absoluteBound;		// from the scalar function, below floor
+		AccuracyWorst worst;
+
+		bool Passed() const
+		{
+			return worst.ulp <= ulpBound && worst.relative <= relativeBound && worst.absolute <= absoluteBound &&
+				   worst.planarMatches;
+		}
+	};
+
+	template <class Span, class Scalar, class Exact>
+	void SweepAccuracy(AccuracyCheck& check, Span span, Scalar scalar, Exact exact)
+	{
+		// Every 251st float in [0, 1], and 1 itself: all exponents, scattered mantissas.
+		const uint32_t one = 0x3F800000u, stride = 251;
+		const size_t block = 3 * 65536;
+		std::vector<float> in, out(block), out3(block), outR(block / 3), outG(block / 3), outB(block / 3);
+		in.reserve(block);
+
+		AccuracyWorst& worst = check.worst;
+		worst = AccuracyWorst();
+		worst.planarMatches = true;
+		for (uint64_t bits = 0; bits <= one;)
+		{
+			in.clear();
+			for (; bits <= one && in.size() < block; bits = bits + stride > one && bits < one ? one : bits + stride)
+			{
+				uint32_t b = (uint32_t)bits;
+				float x;
+				memcpy(&x, &b, sizeof(x));
+				in.push_back(x);
+			}
+			while (in.size() % 3)
+				in.push_back(in.back());
+
+			size_t count = in.size(), pixels = count / 3;
+			span(in.data(), out.data(), count);
+			span((const float3*)in.data(), (float3*)out3.data(), pixels);
+			for (size_t i = 0; i < pixels; i++)
+			{
+				outR[i] = in[3 * i];
+				outG[i] = in[3 * i + 1];
+				outB[i] = in[3 * i + 2];
+			}
+			span(outR.data(), outG.data(), outB.data(), outR.data(), outG.data(), outB.data(), pixels);
+			for (size_t i = 0; i < pixels; i++)
+			{
+				if (memcmp(&out3[3 * i], &out[3 * i], 3 * sizeof(float)) ||
+					outR[i] != out[3 * i] || outG[i] != out[3 * i + 1] || outB[i] != out[3 * i + 2])
+					worst.planarMatches = false;
+			}
+
+			for (size_t i = 0; i < count; i++)
+			{
+				float expected = scalar(in[i]);
+				if (in[i] < check.floor)
+				{
+					worst.absolute = fmax(worst.absolute, fabs((double)out[i] - expected));
+					continue;
+				}
+
+				uint32_t ulp = UlpDistance(out[i], expected);
+				if (ulp > worst.ulp)
+				{
+					worst.ulp = ulp;
+					worst.ulpInput = in[i];
+				}
+				double ref = exact((double)in[i]);
+				double relative = ref > 0.0 ? fabs(out[i] - ref) / ref : fabs((double)out[i]);
+				if (relative > worst.relative)
+				{
+					worst.relative = relative;
+					worst.relativeInput = in[i];
+				}
+			}
+		}
+	}
+
+	bool CheckAccuracy()
+	{
+		printf("PQ span kernels against TransferBatch.h's bounds (%s)\n", TransferBatchPath());
+
+		AccuracyCheck checks[] =
+		{
+			{ "Apply2084 span",  FLT_MIN, 400,  2e-5, 1e-9, {} },
+			{ "Remove2084 span", 0.001f,  1200, 6e-5, 1e-9, {} },
+		};
+		SweepAccuracy(checks[0],
+					  [](auto... args) { Apply2084(args...); },
+					  [](float x) { return Apply2084(x); }, Apply2084Exact);
+		SweepAccuracy(checks[1],
+					  [](auto... args) { Remove2084(args...); },
+					  [](float x) { return Remove2084(x); }, Remove2084Exact);
+
+		bool passed = true;
+		for (const AccuracyCheck& check : checks)
+		{
+			printf("  %-16s %5u ulp at %-12g (bound %u)   rel err %.3g at %-12g (bound %.0e)\n",
+				   check.name, check.worst.ulp, check.worst.ulpInput, check.ulpBound, check.worst.relative,
+				   check.worst.relativeInput, check.relativeBound);
+			printf("  %-16s below %g: abs err %.3g (bound %.0e)   overloads %s   %s\n", "", check.floor,
+				   check.worst.absolute, check.absoluteBound, check.worst.planarMatches ? "match" : "DIFFER",
+				   check.Passed() ? "pass" : "FAIL");
+			passed = passed && check.Passed();
+		}
+		return passed;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc == 2 && !strcmp(argv[1], "--check"))
+		return CheckAccuracy() ? 0 : 1;
+	if (argc != 1)
+	{
+		fprintf(stderr, "usage: transferbench [--check]\n");
+		return 2;
+	}
+
+	BenchmarkDecode(10, PQ10ToLinear);
+	BenchmarkDecode(12, PQ12ToLinear);
+	BenchmarkEncode(10);
+	BenchmarkEncode(12);
+	BenchmarkEncode(16);
+	BenchmarkConversion();
+	BenchmarkFrame();
+	return 0;
+}
@@ -0,0 +1,168 @@
+//
+// TransferTables.cpp
+//
+// Compile-time generation of the transfer function tables declared in TransferTables.h.
+//
+// The curves are evaluated in double with constexpr log/exp, since the <cmath> functions
+// are not constexpr.  Generating the larger tables takes a few million constexpr steps, so
+// MSVC needs /constexpr:steps raised for this file (set in the project).
+//
+
+#include "TransferTables.h"
+#include "SimdMath.h"
+
+namespace
+{
+	// constexpr natural log for x > 0: scale into [0.75, 1.5), then the atanh series.
+	constexpr double LogC(double x)
+	{
+		double k = 0.0;
+		while (x < 1.0 / 65536) { x *= 65536.0; k -= 16.0; }
+		while (x >= 1.5)  { x *= 0.5; k += 1.0; }
+		while (x <  0.75) { x *= 2.0; k -= 1.0; }
+		double t = (x - 1.0) / (x + 1.0);
+		double t2 = t * t;
+		double term = t;
+		double sum = 0.0;
+		for (int n = 1; n < 28; n += 2)			// |t| <= 0.2, so 14 terms reach 1e-19
+		{
+			sum += term / n;
+			term *= t2;
+		}
+		return 2.0 * sum + k * 0.69314718055994530942;
+	}
+
+	// constexpr e^x: split off a power of two, Taylor series on the rest.
+	constexpr double ExpC(double x)
+	{
+		const double ln2 = 0.69314718055994530942;
+		double kf = x / ln2;
+		int k = (int)(kf < 0 ? kf - 0.5 : kf + 0.5);
+		double r = x - k * ln2;
+		double term = 1.0;
+		double sum = 1.0;
+		for (int n = 1; n < 18; n++)			// |r| <= ln2/2
+		{
+			term *= r / n;
+			sum += term;
+		}
+		for (; k >= 16; k -= 16) sum *= 65536.0;
+		for (; k <= -16; k += 16) sum *= 1.0 / 65536;
+		for (; k > 0; k--) sum *= 2.0;
+		for (; k < 0; k++) sum *= 0.5;
+		return sum;
+	}
+
+	constexpr double PowC(double x, double y)
+	{
+		return x <= 0.0 ? 0.0 : ExpC(y * LogC(x));
+	}
+
+	// SMPTE ST 2084, same constants as ColorSpaces.h
+	constexpr double m1 = 2610.0 / 4096.0 / 4;
+	constexpr double m2 = 2523.0 / 4096.0 * 128;
+	constexpr double c1 = 3424.0 / 4096.0;
+	constexpr double c2 = 2413.0 / 4096.0 * 32;
+	constexpr double c3 = 2392.0 / 4096.0 * 32;
+
+	constexpr double Apply2084C(double L)
+	{
+		double Lp = PowC(L, m1);
+		return PowC((c1 + c2 * Lp) / (1.0 + c3 * Lp), m2);
+	}
+
+	constexpr double Remove2084C(double N)
+	{
+		double Np = PowC(N, 1.0 / m2);
+		double num = Np - c1;
+		if (num < 0.0) num = 0.0;
+		return PowC(num / (c2 - c3 * Np), 1.0 / m1);
+	}
+
+	constexpr double ApplySRGBCurveC(double x)
+	{
+		return x < 0.0031308 ? 12.92 * x : 1.055 * PowC(x, 1.0 / 2.4) - 0.055;
+	}
+
+	constexpr double RemoveSRGBCurveC(double x)
+	{
+		return x < 0.04045 ? x / 12.92 : PowC((x + 0.055) / 1.055, 2.4);
+	}
+
+	template <size_t N, class Curve>
+	constexpr std::array<float, N> MakeDecodeTable(Curve curve)
+	{
+		std::array<float, N> table{};
+		for (size_t code = 0; code < N; code++)
+			table[code] = (float)curve((double)code / (double)(N - 1));
+		return table;
+	}
+
+	// Entry i sits at the float whose top bits are i + ((127 - octaves) << segmentBits),
+	// i.e. 2^(e - 127) * (1 + m / 128).  The last entry is duplicated so that x == 1.0
+	// can interpolate without a bounds check.
+	template <size_t N, class Curve>
+	constexpr std::array<float, N> MakeEncodeTable(int octaves, Curve curve)
+	{
+		std::array<float, N> table{};
+		const int segments = 1 << EncodeTableSegmentBits;
+		for (size_t i = 0; i + 1 < N; i++)
+		{
+			int octave = (int)i / segments - octaves;		// -octaves .. 0
+			double x = 1.0 + (double)(i % segments) / segments;
+			for (int k = octave; k < 0; k++) x *= 0.5;		// exact
+			table[i] = (float)curve(x);
+		}
+		table[N - 1] = table[N - 2];
+		return table;
+	}
+}
+
+constexpr std::array<float, 1024> PQ10ToLinear   = MakeDecodeTable<1024>(Remove2084C);
+constexpr std::array<float, 4096> PQ12ToLinear   = MakeDecodeTable<4096>(Remove2084C);
+constexpr std::array<float, 256>  sRGB8ToLinear  = MakeDecodeTable<256>(RemoveSRGBCurveC);
+constexpr std::array<float, 1024> sRGB10ToLinear = MakeDecodeTable<1024>(RemoveSRGBCurveC);
+
+constexpr std::array<float, (PQEncodeOctaves << EncodeTableSegmentBits) + 2> PQEncodeTable =
+	MakeEncodeTable<(PQEncodeOctaves << EncodeTableSegmentBits) + 2>(PQEncodeOctaves, Apply2084C);
+constexpr std::array<float, (sRGBEncodeOctaves << EncodeTableSegmentBits) + 2> sRGBEncodeTable =
+	MakeEncodeTable<(sRGBEncodeOctaves << EncodeTableSegmentBits) + 2>(sRGBEncodeOctaves, ApplySRGBCurveC);
+
+double Apply2084Reference(double L)  { return Apply2084C(L); }
+double Remove2084Reference(double N) { return Remove2084C(N); }
+
+using namespace simd;
+
+namespace
+{
+	// Vector form of EncodeTableLookup; x must already be clamped to the table range.
+	template <size_t N>
+	inline vfloat EncodeTableLookup(const std::array<float, N>& table, int octaves, vfloat x)
+	{
+		vint bits = asint(x);
+		vint idx = shr<EncodeTableShift>(bits) - vint((127 - octaves) << EncodeTableSegmentBits);
+		vfloat frac = tofloat(bits & vint((1 << EncodeTableShift) - 1)) * vfloat(1.0f / (1 << EncodeTableShift));
+		vfloat a = gather(table.data(), idx);
+		vfloat b = gather(table.data() + 1, idx);
+		return mad(b - a, frac, a);
+	}
+}
+
+void Apply2084_Table(const float* in, float* out, size_t count)
+{
+	ForEach(in, out, count, [](vfloat L)
+	{
+		L = clamp(L, vfloat(5.42101086e-20f), vfloat(1.0f));
+		return EncodeTableLookup(PQEncodeTable, PQEncodeOctaves, L);
+	});
+}
+
+void ApplySRGBCurve_Table(const float* in, float* out, size_t count)
+{
+	ForEach(in, out, count, [](vfloat x)
+	{
+		vfloat linear = max(x, vfloat(0.0f)) * vfloat(12.92f);
+		vfloat curve = EncodeTableLookup(sRGBEncodeTable, sRGBEncodeOctaves, clamp(x, vfloat(0.0031308f), vfloat(1.0f)));
+		return select(x < vfloat(0.0031308f), linear, curve);
+	});
+}
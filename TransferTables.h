@@ -0,0 +1,79 @@
+//
+// TransferTables.h
+//
+// Table-driven versions of the transfer functions in ColorSpaces.h for the two cases
+// the tests hit constantly:
+//
+//  Decode of an integer code value (PQ 10/12-bit, sRGB 8/10-bit).  Every code has a
+//  precomputed entry generated at compile time in double precision, so these are
+//  exact (correctly rounded float) rather than the few-ulp float powf result.
+//
+//  Encode of a linear float.  The table is indexed by the top bits of the float itself
+//  (exponent plus 7 mantissa bits, so 128 segments per octave) and linearly interpolated,
+//  which keeps the segments short where the curves are steep near black.
+//      Apply2084_Table:       max abs error 1e-6 over [0,1]  (< 0.07 of a 16-bit code)
+//      ApplySRGBCurve_Table:  max abs error 2e-6 over [0,1]  (< 0.13 of a 16-bit code)
+//
+
+#pragma once
+
+#include <array>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Decode tables, indexed directly by code value.
+extern const std::array<float, 1024> PQ10ToLinear;		// Remove2084(code/1023)
+extern const std::array<float, 4096> PQ12ToLinear;		// Remove2084(code/4095)
+extern const std::array<float, 256>  sRGB8ToLinear;		// RemoveSRGBCurve(code/255)
+extern const std::array<float, 1024> sRGB10ToLinear;	// RemoveSRGBCurve(code/1023)
+
+inline float Remove2084_10bit(uint32_t code)       { return PQ10ToLinear[code < 1023 ? code : 1023]; }
+inline float Remove2084_12bit(uint32_t code)       { return PQ12ToLinear[code < 4095 ? code : 4095]; }
+inline float RemoveSRGBCurve_8bit(uint32_t code)   { return sRGB8ToLinear[code < 255 ? code : 255]; }
+inline float RemoveSRGBCurve_10bit(uint32_t code)  { return sRGB10ToLinear[code < 1023 ? code : 1023]; }
+
+// Encode tables, indexed by float bits.  See the .cpp for the layout.
+const int      EncodeTableSegmentBits = 7;						// 128 segments per octave
+const int      EncodeTableShift       = 23 - EncodeTableSegmentBits;
+const int      PQEncodeOctaves        = 64;						// 2^-64 .. 1
+const int      sRGBEncodeOctaves      = 9;						// 2^-9 .. 1, linear segment below
+extern const std::array<float, (PQEncodeOctaves   << EncodeTableSegmentBits) + 2> PQEncodeTable;
+extern const std::array<float, (sRGBEncodeOctaves << EncodeTableSegmentBits) + 2> sRGBEncodeTable;
+
+// Interpolate an encode table at x, which must already be clamped to [2^-octaves, 1].
+template <size_t N>
+inline float EncodeTableLookup(const std::array<float, N>& table, int octaves, float x)
+{
+	uint32_t bits;
+	memcpy(&bits, &x, sizeof(bits));
+	uint32_t idx = (bits >> EncodeTableShift) - ((uint32_t)(127 - octaves) << EncodeTableSegmentBits);
+	float frac = (float)(bits & ((1u << EncodeTableShift) - 1)) * (1.0f / (1u << EncodeTableShift));
+	return table[idx] + (table[idx + 1] - table[idx]) * frac;
+}
+
+// Linear (1.0 = 10,000 nits) to PQ via table.  Input is clamped to [0,1].
+inline float Apply2084_Table(float L)
+{
+	const float lo = 5.42101086e-20f;							// 2^-64, encodes within 3e-7 of Apply2084(0)
+	L = L < lo ? lo : (L > 1.0f ? 1.0f : L);
+	return EncodeTableLookup(PQEncodeTable, PQEncodeOctaves, L);
+}
+
+// Linear to sRGB via table.  Input is clamped to [0,1].
+inline float ApplySRGBCurve_Table(float x)
+{
+	if (x < 0.0031308f)
+		return x > 0.0f ? 12.92f * x : 0.0f;
+	return EncodeTableLookup(sRGBEncodeTable, sRGBEncodeOctaves, x > 1.0f ? 1.0f : x);
+}
+
+// Span versions of the table encoders (gather-based on AVX2).
+void Apply2084_Table(const float* in, float* out, size_t count);
+void ApplySRGBCurve_Table(const float* in, float* out, size_t count);
+
+// The double precision PQ curve the tables are generated from.  It uses plain arithmetic
+// rather than pow(), so it gives the same bits with every compiler and C library, which
+// makes it the generator for ROM images that must match between builds (FixedPointPQ.h).
+double Apply2084Reference(double L);
+double Remove2084Reference(double N);
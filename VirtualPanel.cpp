@@ -0,0 +1,369 @@
+//
+// VirtualPanel.cpp
+//
+// Local dimming, power limiting and LCD transmission.  See VirtualPanel.h.
+//
+
+#include "VirtualPanel.h"
+#include "SimdMath.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace simd;
+
+namespace
+{
+	const uint32_t GridStep = 8;			// pixels between backlight samples; a multiple of every SIMD width
+	const uint32_t BandRows = 16;			// pixel rows per ParallelFor index
+
+	// Largest channel over [x0, x1) of one row.
+	float RangeMax(const float* r, const float* g, const float* b, uint32_t x0, uint32_t x1)
+	{
+		vfloat peak = 0.0f;
+		uint32_t x = x0;
+		for (; x + width <= x1; x += width)
+			peak = max(peak, max(max(load(r + x), load(g + x)), load(b + x)));
+
+		float lanes[width];
+		store(lanes, peak);
+		float result = 0.0f;
+		for (size_t i = 0; i < width; i++)
+			result = std::max(result, lanes[i]);
+		for (; x < x1; x++)
+			result = std::max(result, std::max(std::max(r[x], g[x]), b[x]));
+		return result;
+	}
+
+	// Linear interpolation of a row of the summed-area table at u, clamped to its ends.
+	double Lerp(const double* row, size_t last, double u)
+	{
+		u = std::min(std::max(u, 0.0), (double)last);
+		size_t i = std::min((size_t)u, last - 1);
+		double f = u - i;
+		return row[i] + (row[i + 1] - row[i]) * f;
+	}
+}
+
+VirtualPanelSettings MakeVirtualPanelSettings(float maxLuminance, float maxFullFrameLuminance, float minLuminance,
+											  uint32_t zonesX, uint32_t zonesY)
+{
+	VirtualPanelSettings settings;
+	settings.zonesX = std::max(zonesX, 1u);
+	settings.zonesY = std::max(zonesY, 1u);
+	settings.maxLuminance = maxLuminance;
+	settings.maxFullFrameLuminance = maxFullFrameLuminance;
+	settings.minLuminance = minLuminance;
+	settings.nativeContrast = 1500.0f;
+	settings.solveIterations = 3;
+
+	const float radius[VirtualPanelPsfBoxes] = { 0.5f, 1.5f, 3.0f };
+	const float weight[VirtualPanelPsfBoxes] = { 0.6f, 0.3f, 0.1f };
+	for (int i = 0; i < VirtualPanelPsfBoxes; i++)
+	{
+		settings.psfRadius[i] = radius[i];
+		settings.psfWeight[i] = weight[i];
+	}
+
+	// Constant power: full peak up to the APL whose light the full frame level allows,
+	// then maxFullFrameLuminance / APL.
+	float knee = maxLuminance > 0.0f ? std::min(maxFullFrameLuminance / maxLuminance, 1.0f) : 1.0f;
+	settings.powerLimit.push_back(float2(0.0f, maxLuminance));
+	settings.powerLimit.push_back(float2(knee, maxLuminance));
+	const int steps = 16;
+	for (int i = 1; i <= steps && knee < 1.0f; i++)
+	{
+		float apl = knee + (1.0f - knee) * i / steps;
+		settings.powerLimit.push_back(float2(apl, maxFullFrameLuminance / apl));
+	}
+	return settings;
+}
+
+float GetPowerLimit(const VirtualPanelSettings& settings, float averageDrive)
+{
+	const std::vector<float2>& curve = settings.powerLimit;
+	if (curve.empty())
+		return settings.maxLuminance;
+	if (averageDrive <= curve.front().x)
+		return curve.front().y;
+
+	for (size_t i = 1; i < curve.size(); i++)
+	{
+		if (averageDrive <= curve[i].x)
+		{
+			float f = (averageDrive - curve[i - 1].x) / (curve[i].x - curve[i - 1].x);
+			return curve[i - 1].y + (curve[i].y - curve[i - 1].y) * f;
+		}
+	}
+	return curve.back().y;
+}
+
+VirtualPanel::VirtualPanel(const VirtualPanelSettings& settings, ThreadPool* pool) :
+	m_settings(settings),
+	m_pool(pool ? pool : &ThreadPool::Default()),
+	m_width(0),
+	m_height(0),
+	m_target((size_t)settings.zonesX * settings.zonesY),
+	m_drive(m_target.size()),
+	m_next(m_target.size()),
+	m_table((size_t)(settings.zonesX + 1) * (settings.zonesY + 1)),
+	m_gridWidth(0),
+	m_averageDrive(0.0f),
+	m_powerScale(1.0f)
+{
+}
+
+void VirtualPanel::Show(Image& frame, Image& displayed)
+{
+	PlanarBuffer in = frame.GetPlanes();
+	m_width = in.width;
+	m_height = in.height;
+	if (&displayed != &frame && (displayed.GetWidth() != m_width || displayed.GetHeight() != m_height))
+		displayed = Image(m_width, m_height, frame.GetPool());
+	PlanarBuffer out = displayed.GetPlanes();
+
+	FindTargets(in);
+	Solve();
+	BuildBacklight(in.stride);
+	Transmit(in, out);
+}
+
+float VirtualPanel::GetBacklight(uint32_t x, uint32_t y) const
+{
+	if (m_backlight.empty() || x >= m_width || y >= m_height)
+		return 0.0f;
+	const float* row = &m_backlight[(y / GridStep) * m_gridWidth];
+	float fx = (float)(x % GridStep) / GridStep, fy = (float)(y % GridStep) / GridStep;
+	size_t i = x / GridStep;
+	float top = row[i] + (row[i + 1] - row[i]) * fx;
+	float bottom = row[m_gridWidth + i] + (row[m_gridWidth + i + 1] - row[m_gridWidth + i]) * fx;
+	return top + (bottom - top) * fy;
+}
+
+#pragma region Zones
+
+// Each zone's brightest channel, as a drive level.
+void VirtualPanel::FindTargets(const PlanarBuffer& frame)
+{
+	uint32_t zonesX = m_settings.zonesX, zonesY = m_settings.zonesY;
+	float scale = 80.0f / m_settings.maxLuminance;
+	m_pool->ParallelFor(0, zonesY, [&](size_t zy)
+	{
+		float* target = &m_target[zy * zonesX];
+		std::fill(target, target + zonesX, 0.0f);
+
+		uint32_t y0 = (uint32_t)(zy * m_height / zonesY), y1 = (uint32_t)((zy + 1) * m_height / zonesY);
+		for (uint32_t y = y0; y < y1; y++)
+		{
+			size_t row = y * frame.stride;
+			for (uint32_t zx = 0; zx < zonesX; zx++)
+			{
+				uint32_t x0 = (uint32_t)((uint64_t)zx * m_width / zonesX), x1 = (uint32_t)((uint64_t)(zx + 1) * m_width / zonesX);
+				target[zx] = std::max(target[zx], RangeMax(frame.r + row, frame.g + row, frame.b + row, x0, x1));
+			}
+		}
+		for (uint32_t zx = 0; zx < zonesX; zx++)
+			target[zx] = std::min(target[zx] * scale, 1.0f);
+	});
+}
+
+// Starts each zone at its target and corrects it by how far the light at its center,
+// spill from the neighbours included, is off.  Zones with nothing to show stay dark.
+// Then the power limit scales every zone by the peak it allows at the mean drive.
+void VirtualPanel::Solve()
+{
+	uint32_t zonesX = m_settings.zonesX, zonesY = m_settings.zonesY;
+	m_drive = m_target;
+	for (int iteration = 0; iteration < m_settings.solveIterations; iteration++)
+	{
+		BuildTable(m_drive);
+		m_pool->ParallelFor(0, zonesY, [&](size_t zy)
+		{
+			for (uint32_t zx = 0; zx < zonesX; zx++)
+			{
+				size_t z = zy * zonesX + zx;
+				float light = Spread(zx + 0.5f, zy + 0.5f);
+				m_next[z] = m_target[z] > 0.0f ? std::min(m_drive[z] * m_target[z] / std::max(light, 1e-6f), 1.0f) : 0.0f;
+			}
+		});
+		m_drive.swap(m_next);
+	}
+
+	double sum = 0.0;
+	for (float drive : m_drive)
+		sum += drive;
+	m_averageDrive = (float)(sum / m_drive.size());
+	m_powerScale = std::min(GetPowerLimit(m_settings, m_averageDrive) / m_settings.maxLuminance, 1.0f);
+	for (float& drive : m_drive)
+		drive *= m_powerScale;
+	BuildTable(m_drive);
+}
+
+void VirtualPanel::BuildTable(const std::vector<float>& drive)
+{
+	size_t columns = m_settings.zonesX + 1;
+	std::fill(m_table.begin(), m_table.begin() + columns, 0.0);
+	for (uint32_t zy = 0; zy < m_settings.zonesY; zy++)
+	{
+		const float* zone = &drive[zy * m_settings.zonesX];
+		const double* above = &m_table[zy * columns];
+		double* row = &m_table[(zy + 1) * columns];
+		double sum = 0.0;
+		row[0] = 0.0;
+		for (uint32_t zx = 0; zx < m_settings.zonesX; zx++)
+		{
+			sum += zone[zx];
+			row[zx + 1] = above[zx + 1] + sum;
+		}
+	}
+}
+
+// The boxes of the spread, each the mean drive over its part of the screen: light is not
+// lost off the edges, as the reflectors around a real backlight keep it in.
+float VirtualPanel::Spread(float u, float v) const
+{
+	double light = 0.0;
+	for (int k = 0; k < VirtualPanelPsfBoxes; k++)
+	{
+		double r = m_settings.psfRadius[k];
+		double u0 = std::max(u - r, 0.0), u1 = std::min(u + r, (double)m_settings.zonesX);
+		double v0 = std::max(v - r, 0.0), v1 = std::min(v + r, (double)m_settings.zonesY);
+		double area = (u1 - u0) * (v1 - v0);
+		if (area <= 0.0)
+			continue;
+
+		double sum = Table(u1, v1) - Table(u0, v1) - Table(u1, v0) + Table(u0, v0);
+		light += m_settings.psfWeight[k] * sum / area;
+	}
+	return (float)light;
+}
+
+// The table interpolated between rows, then along the row.
+double VirtualPanel::Table(double u, double v) const
+{
+	size_t columns = m_settings.zonesX + 1;
+	size_t j = std::min((size_t)v, (size_t)m_settings.zonesY - 1);
+	double f = v - j;
+	const double* top = &m_table[j * columns];
+	double a = Lerp(top, m_settings.zonesX, u), b = Lerp(top + columns, m_settings.zonesX, u);
+	return a + (b - a) * f;
+}
+
+// The table interpolated at v1 less at v0, for every column.
+void VirtualPanel::InterpolateRows(double v0, double v1, double* row) const
+{
+	size_t columns = m_settings.zonesX + 1;
+	size_t j0 = std::min((size_t)v0, (size_t)m_settings.zonesY - 1);
+	size_t j1 = std::min((size_t)v1, (size_t)m_settings.zonesY - 1);
+	double f0 = v0 - j0, f1 = v1 - j1;
+	const double* a0 = &m_table[j0 * columns];
+	const double* a1 = &m_table[j1 * columns];
+	for (size_t i = 0; i < columns; i++)
+		row[i] = (a1[i] + (a1[i + columns] - a1[i]) * f1) - (a0[i] + (a0[i + columns] - a0[i]) * f0);
+}
+
+#pragma endregion
+
+#pragma region Backlight and LCD
+
+// The spread on the grid of every 8th pixel, in nits, with a column and row past the last
+// pixel (padding included) so every pixel has four samples around it.
+void VirtualPanel::BuildBacklight(size_t stride)
+{
+	m_gridWidth = stride / GridStep + 2;
+	size_t gridHeight = m_height / GridStep + 2;
+	m_backlight.resize(m_gridWidth * gridHeight);
+
+	// The boxes are separable: along a grid row every box spans the same rows of zones, and
+	// down a grid column the same columns.  So each grid row takes, per box, the table
+	// interpolated at the box's bottom less at its top, and each sample is then the
+	// difference of two lookups in it at the column's ends of the box.
+	uint32_t zonesX = m_settings.zonesX, zonesY = m_settings.zonesY;
+	size_t columns = zonesX + 1;
+	double du = (double)zonesX / m_width, dv = (double)zonesY / m_height;
+	std::vector<double> ends(m_gridWidth * VirtualPanelPsfBoxes * 2);
+	for (size_t i = 0; i < m_gridWidth; i++)
+	{
+		double u = (i * GridStep + 0.5) * du;
+		for (int k = 0; k < VirtualPanelPsfBoxes; k++)
+		{
+			double* end = &ends[(i * VirtualPanelPsfBoxes + k) * 2];
+			end[0] = std::min(std::max(u - m_settings.psfRadius[k], 0.0), (double)zonesX);
+			end[1] = std::min(std::max(u + m_settings.psfRadius[k], 0.0), (double)zonesX);
+		}
+	}
+
+	m_pool->ParallelFor(0, gridHeight, [&](size_t j)
+	{
+		double v = (j * GridStep + 0.5) * dv;
+		std::vector<double> strip(columns * VirtualPanelPsfBoxes);
+		double weight[VirtualPanelPsfBoxes];
+		for (int k = 0; k < VirtualPanelPsfBoxes; k++)
+		{
+			double v0 = std::min(std::max(v - m_settings.psfRadius[k], 0.0), (double)zonesY);
+			double v1 = std::min(std::max(v + m_settings.psfRadius[k], 0.0), (double)zonesY);
+			weight[k] = v1 > v0 ? m_settings.psfWeight[k] * m_settings.maxLuminance / (v1 - v0) : 0.0;
+			InterpolateRows(v0, v1, &strip[k * columns]);
+		}
+
+		float* row = &m_backlight[j * m_gridWidth];
+		for (size_t i = 0; i < m_gridWidth; i++)
+		{
+			double light = 0.0;
+			for (int k = 0; k < VirtualPanelPsfBoxes; k++)
+			{
+				const double* end = &ends[(i * VirtualPanelPsfBoxes + k) * 2];
+				if (end[1] > end[0])
+				{
+					const double* table = &strip[k * columns];
+					light += weight[k] * (Lerp(table, zonesX, end[1]) - Lerp(table, zonesX, end[0])) / (end[1] - end[0]);
+				}
+			}
+			row[i] = (float)light;
+		}
+	});
+}
+
+// Each channel transmits target / backlight, between 1 / native contrast and 1, over the
+// backlight interpolated from the grid, and the panel never goes below its black floor.
+void VirtualPanel::Transmit(const PlanarBuffer& frame, const PlanarBuffer& displayed)
+{
+	static const float ramp[16] = { 0.0f / 8, 1.0f / 8, 2.0f / 8, 3.0f / 8, 4.0f / 8, 5.0f / 8, 6.0f / 8, 7.0f / 8 };
+	static_assert(GridStep % width == 0, "a vector must not straddle two grid cells");
+
+	vfloat floor = 1.0f / m_settings.nativeContrast;
+	vfloat black = m_settings.minLuminance / 80.0f;
+	vfloat toNits = 80.0f, toCCCS = 1.0f / 80.0f;
+	uint32_t bands = (m_height + BandRows - 1) / BandRows;
+	m_pool->ParallelFor(0, bands, [&](size_t band)
+	{
+		uint32_t end = std::min(m_height, (uint32_t)(band + 1) * BandRows);
+		for (uint32_t y = (uint32_t)band * BandRows; y < end; y++)
+		{
+			const float* top = &m_backlight[(y / GridStep) * m_gridWidth];
+			const float* bottom = top + m_gridWidth;
+			float fy = (float)(y % GridStep) / GridStep;
+			size_t row = y * frame.stride;
+			for (size_t x = 0; x < frame.stride; x += width)
+			{
+				size_t i = x / GridStep;
+				float b0 = top[i] + (bottom[i] - top[i]) * fy;
+				float b1 = top[i + 1] + (bottom[i + 1] - top[i + 1]) * fy;
+				vfloat light = max(vfloat(b0) + vfloat(b1 - b0) * load(ramp + x % GridStep), vfloat(1e-6f));
+				vfloat scale = light * toCCCS, inverse = toNits / light;
+
+				auto transmit = [&](const float* in, float* out)
+				{
+					vfloat t = clamp(load(in + row + x) * inverse, floor, vfloat(1.0f));
+					store(out + row + x, max(t * scale, black));
+				};
+				transmit(frame.r, displayed.r);
+				transmit(frame.g, displayed.g);
+				transmit(frame.b, displayed.b);
+			}
+		}
+	});
+}
+
+#pragma endregion